@@ -80,6 +80,7 @@
         '<(DEPTH)/processor/dump_object.cc',
         '<(DEPTH)/processor/logging.cc',
         '<(DEPTH)/processor/minidump.cc',
+        '<(DEPTH)/processor/minidump_page_cache.cc',
         '<(DEPTH)/processor/pathname_stripper.cc',
         '<(DEPTH)/processor/proc_maps_linux.cc',
       ]
@@ -0,0 +1,187 @@
+// Copyright (c) 2026 Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// arena.h: Arena, a simple bump allocator whose memory is all released at
+// once when it is destroyed, and ArenaAllocator, an STL allocator that
+// allocates from an Arena.
+
+#ifndef COMMON_ARENA_H_
+#define COMMON_ARENA_H_
+
+#include <stddef.h>
+
+#include <functional>
+#include <map>
+#include <new>
+#include <type_traits>
+
+namespace google_breakpad {
+
+// An Arena hands out memory from large blocks, and frees the blocks only
+// when it is destroyed. This makes allocation cheap and makes freeing
+// many small objects free, at the cost of never reusing memory; it suits
+// data that is built up and then discarded all at once.
+//
+// An Arena is not thread-safe.
+class Arena {
+ public:
+  // The largest size of the blocks an Arena allocates from. Allocations
+  // of more than a quarter of this get a block of their own.
+  static const size_t kBlockSize = 256 * 1024;
+
+  // The size of an Arena's first block. Each block after that is as large
+  // as all the blocks before it, up to kBlockSize, so that small Arenas
+  // stay small.
+  static const size_t kFirstBlockSize = 4 * 1024;
+
+  Arena() : next_(NULL), limit_(NULL), block_bytes_(0) { }
+
+  ~Arena() {
+    for (BlockMap::iterator it = blocks_.begin(); it != blocks_.end(); ++it)
+      ::operator delete(it->first);
+  }
+
+  // Return SIZE bytes of memory, suitably aligned for any type. The
+  // memory lasts as long as the Arena.
+  void *Alloc(size_t size) {
+    size = (size + kAlignment - 1) & ~(kAlignment - 1);
+    if (size > kBlockSize / 4)
+      return NewBlock(size);
+    if (size > static_cast<size_t>(limit_ - next_)) {
+      size_t block_size = block_bytes_ < kFirstBlockSize ? kFirstBlockSize :
+                          block_bytes_ < kBlockSize ? block_bytes_ :
+                          kBlockSize;
+      if (block_size < size)
+        block_size = size;
+      next_ = NewBlock(block_size);
+      limit_ = next_ + block_size;
+    }
+    char *memory = next_;
+    next_ += size;
+    return memory;
+  }
+
+  // Return true if P points into memory this Arena has handed out.
+  bool Contains(const void *p) const {
+    char *address = static_cast<char *>(const_cast<void *>(p));
+    BlockMap::const_iterator it = blocks_.upper_bound(address);
+    if (it == blocks_.begin())
+      return false;
+    --it;
+    return std::less<char *>()(address, it->first + it->second);
+  }
+
+  // Take over OTHER's blocks, leaving OTHER empty. The memory OTHER has
+  // handed out then lasts as long as this Arena does.
+  void TakeBlocks(Arena *other) {
+    blocks_.insert(other->blocks_.begin(), other->blocks_.end());
+    block_bytes_ += other->block_bytes_;
+    other->blocks_.clear();
+    other->next_ = other->limit_ = NULL;
+    other->block_bytes_ = 0;
+  }
+
+  // The number of bytes of blocks this Arena holds.
+  size_t block_bytes() const { return block_bytes_; }
+
+ private:
+  static const size_t kAlignment = 16;
+
+  // The sizes of this Arena's blocks, by their addresses.
+  typedef std::map<char *, size_t> BlockMap;
+
+  char *NewBlock(size_t size) {
+    char *block = static_cast<char *>(::operator new(size));
+    blocks_[block] = size;
+    block_bytes_ += size;
+    return block;
+  }
+
+  BlockMap blocks_;
+  char *next_, *limit_;
+  size_t block_bytes_;
+
+  // Disallow copy constructor and assignment operator.
+  Arena(const Arena &);
+  void operator=(const Arena &);
+};
+
+// An STL allocator that allocates from an Arena, and treats deallocation
+// as a no-op. A default-constructed ArenaAllocator has no Arena, and uses
+// the heap, so that containers using it can still be created anywhere.
+//
+// Copying a container gives the copy a heap allocator, so that the copy
+// doesn't depend on the original's Arena. Moving or swapping containers
+// carries their allocators along with their elements.
+template<typename T>
+class ArenaAllocator {
+ public:
+  typedef T value_type;
+  typedef std::true_type propagate_on_container_move_assignment;
+  typedef std::true_type propagate_on_container_swap;
+
+  ArenaAllocator() : arena_(NULL) { }
+  explicit ArenaAllocator(Arena *arena) : arena_(arena) { }
+  template<typename U>
+  ArenaAllocator(const ArenaAllocator<U> &other) : arena_(other.arena()) { }
+
+  T *allocate(size_t n) {
+    if (arena_)
+      return static_cast<T *>(arena_->Alloc(n * sizeof(T)));
+    return static_cast<T *>(::operator new(n * sizeof(T)));
+  }
+
+  void deallocate(T *p, size_t /* n */) {
+    if (!arena_)
+      ::operator delete(p);
+  }
+
+  ArenaAllocator select_on_container_copy_construction() const {
+    return ArenaAllocator();
+  }
+
+  Arena *arena() const { return arena_; }
+
+ private:
+  Arena *arena_;
+};
+
+template<typename T, typename U>
+bool operator==(const ArenaAllocator<T> &x, const ArenaAllocator<U> &y) {
+  return x.arena() == y.arena();
+}
+
+template<typename T, typename U>
+bool operator!=(const ArenaAllocator<T> &x, const ArenaAllocator<U> &y) {
+  return x.arena() != y.arena();
+}
+
+}  // namespace google_breakpad
+
+#endif  // COMMON_ARENA_H_
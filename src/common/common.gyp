@@ -60,6 +60,7 @@
         'android/testing/mkdtemp.h',
         'android/testing/pthread_fixes.h',
         'android/ucontext_constants.h',
+        'arena.h',
         'basictypes.h',
         'byte_cursor.h',
         'convert_UTF.c',
@@ -152,7 +152,7 @@ bool DwarfCFIToModule::Entry(size_t offset, uint64 address, uint64 length,
   // need to check them here.
 
   // Get ready to collect entries.
-  entry_ = new Module::StackFrameEntry;
+  entry_ = module_->NewStackFrameEntry();
   entry_->address = address;
   entry_->size = length;
   entry_offset_ = offset;
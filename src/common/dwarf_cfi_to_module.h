@@ -135,7 +135,7 @@ class DwarfCFIToModule: public CallFrameInfo::Handler {
       : module_(module), register_names_(register_names), reporter_(reporter),
         entry_(NULL), return_address_(-1), cfa_name_(".cfa"), ra_name_(".ra") {
   }
-  virtual ~DwarfCFIToModule() { delete entry_; }
+  virtual ~DwarfCFIToModule() { module_->DeleteStackFrameEntry(entry_); }
 
   virtual bool Entry(size_t offset, uint64 address, uint64 length,
                      uint8 version, const string &augmentation,
@@ -40,6 +40,7 @@
 
 #include <assert.h>
 #include <inttypes.h>
+#include <stdarg.h>
 #include <stdint.h>
 #include <stdio.h>
 
@@ -98,6 +99,8 @@ typedef map<uint64, AbstractOrigin> AbstractOriginByOffset;
 // Data global to the DWARF-bearing file that is private to the
 // DWARF-to-Module process.
 struct DwarfCUToModule::FilePrivate {
+  FilePrivate() : referred_to_earlier_cus(false) {}
+
   // A set of strings used in this CU. Before storing a string in one of
   // our data structures, insert it into this set, and then use the string
   // from the set.
@@ -123,6 +126,10 @@ struct DwarfCUToModule::FilePrivate {
   SpecificationByOffset specifications;
 
   AbstractOriginByOffset origins;
+
+  // True if a DW_AT_specification or DW_AT_abstract_origin was looked up
+  // in a compilation unit before the one referring to it.
+  bool referred_to_earlier_cus;
 };
 
 DwarfCUToModule::FileContext::FileContext(const string &filename,
@@ -151,6 +158,32 @@ DwarfCUToModule::FileContext::section_map() const {
   return section_map_;
 }
 
+void DwarfCUToModule::FileContext::TakeInterCUData(FileContext *other) {
+  FilePrivate *other_private = other->file_private_.get();
+  if (file_private_->specifications.empty()) {
+    file_private_->specifications.swap(other_private->specifications);
+  } else {
+    file_private_->specifications.insert(
+        other_private->specifications.begin(),
+        other_private->specifications.end());
+    other_private->specifications.clear();
+  }
+  if (file_private_->origins.empty()) {
+    file_private_->origins.swap(other_private->origins);
+  } else {
+    file_private_->origins.insert(other_private->origins.begin(),
+                                  other_private->origins.end());
+    other_private->origins.clear();
+  }
+  file_private_->referred_to_earlier_cus |=
+      other_private->referred_to_earlier_cus;
+  other_private->referred_to_earlier_cus = false;
+}
+
+bool DwarfCUToModule::FileContext::referred_to_earlier_cus() const {
+  return file_private_->referred_to_earlier_cus;
+}
+
 void DwarfCUToModule::FileContext::ClearSpecifications() {
   if (!handle_inter_cu_refs_)
     file_private_->specifications.clear();
@@ -175,7 +208,7 @@ struct DwarfCUToModule::CUContext {
   ~CUContext() {
     for (vector<Module::Function *>::iterator it = functions.begin();
          it != functions.end(); ++it) {
-      delete *it;
+      file_context->module_->DeleteFunction(*it);
     }
   };
 
@@ -314,6 +347,8 @@ void DwarfCUToModule::GenericDIEHandler::ProcessAttributeReference(
       // here, but it's better to leave the real work to our
       // EndAttribute member function, at which point we know we have
       // seen all the DIE's attributes.
+      if (data < cu_context_->reporter->cu_offset())
+        file_context->file_private_->referred_to_earlier_cus = true;
       SpecificationByOffset *specifications =
           &file_context->file_private_->specifications;
       SpecificationByOffset::iterator spec = specifications->find(data);
@@ -505,8 +540,11 @@ void DwarfCUToModule::FuncHandler::ProcessAttributeReference(
     uint64 data) {
   switch (attr) {
     case dwarf2reader::DW_AT_abstract_origin: {
-      const AbstractOriginByOffset& origins =
-          cu_context_->file_context->file_private_->origins;
+      FilePrivate *file_private =
+          cu_context_->file_context->file_private_.get();
+      if (data < cu_context_->reporter->cu_offset())
+        file_private->referred_to_earlier_cus = true;
+      const AbstractOriginByOffset& origins = file_private->origins;
       AbstractOriginByOffset::const_iterator origin = origins.find(data);
       if (origin != origins.end()) {
         abstract_origin_ = &(origin->second);
@@ -552,15 +590,16 @@ void DwarfCUToModule::FuncHandler::Finish() {
     }
 
     // Create a Module::Function based on the data we've gathered, and
-    // add it to the functions_ list.
-    scoped_ptr<Module::Function> func(new Module::Function(name, low_pc_));
-    func->size = high_pc_ - low_pc_;
-    func->parameter_size = 0;
-    if (func->address) {
-       // If the function address is zero this is a sign that this function
-       // description is just empty debug data and should just be discarded.
-       cu_context_->functions.push_back(func.release());
-     }
+    // add it to the functions_ list. If the function address is zero this
+    // is a sign that this function description is just empty debug data
+    // and should just be discarded.
+    if (low_pc_) {
+      Module::Function *func =
+          cu_context_->file_context->module_->NewFunction(name, low_pc_);
+      func->size = high_pc_ - low_pc_;
+      func->parameter_size = 0;
+      cu_context_->functions.push_back(func);
+    }
   } else if (inline_) {
     AbstractOrigin origin(name_);
     cu_context_->file_context->file_private_->origins[offset_] = origin;
@@ -602,51 +641,71 @@ dwarf2reader::DIEHandler *DwarfCUToModule::NamedScopeHandler::FindChildHandler(
   }
 }
 
+void DwarfCUToModule::WarningReporter::Print(const char *format, ...) {
+  va_list args;
+  va_start(args, format);
+  if (buffer_) {
+    va_list size_args;
+    va_copy(size_args, args);
+    int length = vsnprintf(NULL, 0, format, size_args);
+    va_end(size_args);
+    if (length > 0) {
+      size_t start = buffer_->size();
+      buffer_->resize(start + length + 1);
+      vsnprintf(&(*buffer_)[start], length + 1, format, args);
+      buffer_->resize(start + length);
+    }
+  } else {
+    vfprintf(stderr, format, args);
+  }
+  va_end(args);
+}
+
 void DwarfCUToModule::WarningReporter::CUHeading() {
   if (printed_cu_header_)
     return;
-  fprintf(stderr, "%s: in compilation unit '%s' (offset 0x%llx):\n",
-          filename_.c_str(), cu_name_.c_str(), cu_offset_);
+  Print("%s: in compilation unit '%s' (offset 0x%llx):\n",
+        filename_.c_str(), cu_name_.c_str(), cu_offset_);
   printed_cu_header_ = true;
 }
 
 void DwarfCUToModule::WarningReporter::UnknownSpecification(uint64 offset,
                                                             uint64 target) {
   CUHeading();
-  fprintf(stderr, "%s: the DIE at offset 0x%llx has a DW_AT_specification"
-          " attribute referring to the die at offset 0x%llx, which either"
-          " was not marked as a declaration, or comes later in the file\n",
-          filename_.c_str(), offset, target);
+  Print("%s: the DIE at offset 0x%llx has a DW_AT_specification"
+        " attribute referring to the die at offset 0x%llx, which either"
+        " was not marked as a declaration, or comes later in the file\n",
+        filename_.c_str(), offset, target);
 }
 
 void DwarfCUToModule::WarningReporter::UnknownAbstractOrigin(uint64 offset,
                                                              uint64 target) {
   CUHeading();
-  fprintf(stderr, "%s: the DIE at offset 0x%llx has a DW_AT_abstract_origin"
-          " attribute referring to the die at offset 0x%llx, which either"
-          " was not marked as an inline, or comes later in the file\n",
-          filename_.c_str(), offset, target);
+  Print("%s: the DIE at offset 0x%llx has a DW_AT_abstract_origin"
+        " attribute referring to the die at offset 0x%llx, which either"
+        " was not marked as an inline, or comes later in the file\n",
+        filename_.c_str(), offset, target);
 }
 
 void DwarfCUToModule::WarningReporter::MissingSection(const string &name) {
   CUHeading();
-  fprintf(stderr, "%s: warning: couldn't find DWARF '%s' section\n",
-          filename_.c_str(), name.c_str());
+  Print("%s: warning: couldn't find DWARF '%s' section\n",
+        filename_.c_str(), name.c_str());
 }
 
 void DwarfCUToModule::WarningReporter::BadLineInfoOffset(uint64 offset) {
   CUHeading();
-  fprintf(stderr, "%s: warning: line number data offset beyond end"
-          " of '.debug_line' section\n",
-          filename_.c_str());
+  Print("%s: warning: line number data offset beyond end"
+        " of '.debug_line' section\n",
+        filename_.c_str());
 }
 
 void DwarfCUToModule::WarningReporter::UncoveredHeading() {
   if (printed_unpaired_header_)
     return;
   CUHeading();
-  fprintf(stderr, "%s: warning: skipping unpaired lines/functions:\n",
-          filename_.c_str());
+  Print("%s: warning: skipping unpaired lines/functions:\n",
+        filename_.c_str());
   printed_unpaired_header_ = true;
 }
 
@@ -655,39 +714,39 @@ void DwarfCUToModule::WarningReporter::UncoveredFunction(
   if (!uncovered_warnings_enabled_)
     return;
   UncoveredHeading();
-  fprintf(stderr, "    function%s: %s\n",
-          function.size == 0 ? " (zero-length)" : "",
-          function.name.c_str());
+  Print("    function%s: %s\n",
+        function.size == 0 ? " (zero-length)" : "",
+        function.name.c_str());
 }
 
 void DwarfCUToModule::WarningReporter::UncoveredLine(const Module::Line &line) {
   if (!uncovered_warnings_enabled_)
     return;
   UncoveredHeading();
-  fprintf(stderr, "    line%s: %s:%d at 0x%" PRIx64 "\n",
-          (line.size == 0 ? " (zero-length)" : ""),
-          line.file->name.c_str(), line.number, line.address);
+  Print("    line%s: %s:%d at 0x%" PRIx64 "\n",
+        (line.size == 0 ? " (zero-length)" : ""),
+        line.file->name.c_str(), line.number, line.address);
 }
 
 void DwarfCUToModule::WarningReporter::UnnamedFunction(uint64 offset) {
   CUHeading();
-  fprintf(stderr, "%s: warning: function at offset 0x%llx has no name\n",
-          filename_.c_str(), offset);
+  Print("%s: warning: function at offset 0x%llx has no name\n",
+        filename_.c_str(), offset);
 }
 
 void DwarfCUToModule::WarningReporter::DemangleError(const string &input) {
   CUHeading();
-  fprintf(stderr, "%s: warning: failed to demangle %s\n",
-          filename_.c_str(), input.c_str());
+  Print("%s: warning: failed to demangle %s\n",
+        filename_.c_str(), input.c_str());
 }
 
 void DwarfCUToModule::WarningReporter::UnhandledInterCUReference(
     uint64 offset, uint64 target) {
   CUHeading();
-  fprintf(stderr, "%s: warning: the DIE at offset 0x%llx has a "
-                  "DW_FORM_ref_addr attribute with an inter-CU reference to "
-                  "0x%llx, but inter-CU reference handling is turned off.\n",
-                  filename_.c_str(), offset, target);
+  Print("%s: warning: the DIE at offset 0x%llx has a "
+        "DW_FORM_ref_addr attribute with an inter-CU reference to "
+        "0x%llx, but inter-CU reference handling is turned off.\n",
+        filename_.c_str(), offset, target);
 }
 
 DwarfCUToModule::DwarfCUToModule(FileContext *file_context,
@@ -94,6 +94,20 @@ class DwarfCUToModule: public dwarf2reader::RootDIEHandler {
 
     const dwarf2reader::SectionMap& section_map() const;
 
+    // Move the specifications and abstract origins recorded while
+    // processing compilation units with OTHER, a context for the same
+    // file, into this context, as though those units had been processed
+    // with this one, and forget them in OTHER. This lets units be
+    // processed separately, and their DIEs then be referred to by the
+    // units that follow them.
+    void TakeInterCUData(FileContext *other);
+
+    // True if a compilation unit processed with this context, or one whose
+    // data was taken by it, looked up a DIE in an earlier compilation
+    // unit. What such a unit contributes to the module depends on the
+    // units processed before it.
+    bool referred_to_earlier_cus() const;
+
    private:
     friend class DwarfCUToModule;
 
@@ -157,12 +171,17 @@ class DwarfCUToModule: public dwarf2reader::RootDIEHandler {
     WarningReporter(const string &filename, uint64 cu_offset)
         : filename_(filename), cu_offset_(cu_offset), printed_cu_header_(false),
           printed_unpaired_header_(false),
-          uncovered_warnings_enabled_(false) { }
+          uncovered_warnings_enabled_(false), buffer_(NULL) { }
     virtual ~WarningReporter() { }
 
     // Set the name of the compilation unit we're processing to NAME.
     virtual void SetCUName(const string &name) { cu_name_ = name; }
 
+    // Append warnings to BUFFER instead of writing them to stderr, so that
+    // warnings about compilation units processed at the same time can be
+    // printed one unit after another. If BUFFER is NULL, write to stderr.
+    void set_buffer(string *buffer) { buffer_ = buffer; }
+
     // Accessor and setter for uncovered_warnings_enabled_.
     // UncoveredFunction and UncoveredLine only report a problem if that is
     // true. By default, these warnings are disabled, because those
@@ -213,12 +232,16 @@ class DwarfCUToModule: public dwarf2reader::RootDIEHandler {
     }
 
    protected:
+    // Write a warning, formatted as by printf, to stderr or the buffer.
+    void Print(const char *format, ...);
+
     const string filename_;
     const uint64 cu_offset_;
     string cu_name_;
     bool printed_cu_header_;
     bool printed_unpaired_header_;
     bool uncovered_warnings_enabled_;
+    string *buffer_;
 
    private:
     // Print a per-CU heading, once.
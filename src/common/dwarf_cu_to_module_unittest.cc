@@ -32,6 +32,7 @@
 // dwarf_cu_to_module.cc: Unit tests for google_breakpad::DwarfCUToModule.
 
 #include <stdint.h>
+#include <string.h>
 
 #include <string>
 #include <utility>
@@ -56,6 +57,7 @@ using google_breakpad::Module;
 using ::testing::_;
 using ::testing::AtMost;
 using ::testing::Invoke;
+using ::testing::NiceMock;
 using ::testing::Return;
 using ::testing::Test;
 using ::testing::TestWithParam;
@@ -1713,6 +1715,140 @@ TEST_F(Specifications, PreferSpecificationParents) {
                0xbbd9d54dce3b95b7ULL, 0x39188b7b52b0899fULL);
 }
 
+// Tests for reading compilation units with contexts of their own, and
+// handing the DIEs they recorded on to the units after them, as dump_syms
+// does when it reads units on several threads.
+class InterCUData: public CUFixtureBase, public Test {
+ public:
+  typedef vector<std::pair<Module::Address, string> > FunctionList;
+
+  InterCUData() {
+    // Kludge: satisfy reporter_'s expectation. These tests give each unit
+    // a reporter of its own, at the unit's offset.
+    reporter_.SetCUName("compilation-unit-name");
+  }
+
+  // Read, with FILE_CONTEXT, a unit at offset 0x100 that declares a
+  // function and an inline function.
+  void ReadDeclaringCU(DwarfCUToModule::FileContext *file_context) {
+    NiceMock<MockWarningReporter> reporter("dwarf-filename", 0x100);
+    DwarfCUToModule root_handler(file_context, &line_reader_, &reporter);
+    ASSERT_TRUE(root_handler.StartCompilationUnit(0x100, 8, 4, 0xf0, 3));
+    ASSERT_TRUE(root_handler.StartRootDIE(0x10b,
+                                          dwarf2reader::DW_TAG_compile_unit));
+    ASSERT_TRUE(root_handler.EndAttributes());
+    DeclarationDIE(&root_handler, 0x110, dwarf2reader::DW_TAG_subprogram,
+                   "declared_func", "");
+    AbstractInstanceDIE(&root_handler, 0x120, dwarf2reader::DW_INL_inlined,
+                        0, "inline_func");
+    root_handler.Finish();
+  }
+
+  // Read, with FILE_CONTEXT, a unit at offset 0x200 that defines the
+  // functions the unit ReadDeclaringCU reads declares.
+  void ReadDefiningCU(DwarfCUToModule::FileContext *file_context) {
+    NiceMock<MockWarningReporter> reporter("dwarf-filename", 0x200);
+    DwarfCUToModule root_handler(file_context, &line_reader_, &reporter);
+    ASSERT_TRUE(root_handler.StartCompilationUnit(0x200, 8, 4, 0xf0, 3));
+    ASSERT_TRUE(root_handler.StartRootDIE(0x20b,
+                                          dwarf2reader::DW_TAG_compile_unit));
+    ASSERT_TRUE(root_handler.EndAttributes());
+    DefinitionDIE(&root_handler, dwarf2reader::DW_TAG_subprogram, 0x110, "",
+                  0x1000, 0x100);
+    DefineInlineInstanceDIE(&root_handler, "", 0x120, 0x2000, 0x100);
+    root_handler.Finish();
+  }
+
+  // Return the addresses and names of MODULE's functions.
+  FunctionList Functions(Module *module) {
+    vector<Module::Function *> functions;
+    module->GetFunctions(&functions, functions.end());
+    FunctionList list;
+    for (size_t i = 0; i < functions.size(); i++)
+      list.push_back(std::make_pair(functions[i]->address,
+                                    string(functions[i]->name)));
+    return list;
+  }
+};
+
+TEST_F(InterCUData, RereadMatchesSerial) {
+  // Read both units with one context, as a serial run does.
+  Module serial_module("module-name", "module-os", "module-arch", "module-id");
+  DwarfCUToModule::FileContext serial_context("dwarf-filename",
+                                              &serial_module, true);
+  ReadDeclaringCU(&serial_context);
+  ReadDefiningCU(&serial_context);
+  EXPECT_TRUE(serial_context.referred_to_earlier_cus());
+  FunctionList serial_functions = Functions(&serial_module);
+  ASSERT_EQ(2U, serial_functions.size());
+  EXPECT_EQ("declared_func", serial_functions[0].second);
+  EXPECT_EQ("inline_func", serial_functions[1].second);
+
+  // Read each unit with a context of its own. The second can't find the
+  // declarations the first recorded.
+  Module first_module("module-name", "module-os", "module-arch", "module-id");
+  DwarfCUToModule::FileContext first_context("dwarf-filename",
+                                             &first_module, true);
+  Module second_module("module-name", "module-os", "module-arch",
+                       "module-id");
+  DwarfCUToModule::FileContext second_context("dwarf-filename",
+                                              &second_module, true);
+  ReadDeclaringCU(&first_context);
+  ReadDefiningCU(&second_context);
+  EXPECT_FALSE(first_context.referred_to_earlier_cus());
+  EXPECT_TRUE(second_context.referred_to_earlier_cus());
+  EXPECT_NE(serial_functions, Functions(&second_module));
+
+  // Reread the second unit with a context that has taken the first unit's
+  // data, and get what the serial run did.
+  Module reread_module("module-name", "module-os", "module-arch",
+                       "module-id");
+  DwarfCUToModule::FileContext reread_context("dwarf-filename",
+                                              &reread_module, true);
+  reread_context.TakeInterCUData(&first_context);
+  EXPECT_FALSE(reread_context.referred_to_earlier_cus());
+  ReadDefiningCU(&reread_context);
+  EXPECT_EQ(serial_functions, Functions(&reread_module));
+}
+
+TEST_F(InterCUData, TakeInterCUData) {
+  Module declaring_module("module-name", "module-os", "module-arch",
+                          "module-id");
+  DwarfCUToModule::FileContext declaring_context("dwarf-filename",
+                                                 &declaring_module, true);
+  Module defining_module("module-name", "module-os", "module-arch",
+                         "module-id");
+  DwarfCUToModule::FileContext defining_context("dwarf-filename",
+                                                &defining_module, true);
+  ReadDeclaringCU(&declaring_context);
+  ReadDefiningCU(&defining_context);
+
+  // Take the data of both, the second into a context that already has
+  // some. Whether a unit referred to earlier ones is taken too.
+  DwarfCUToModule::FileContext taking_context("dwarf-filename", NULL, true);
+  taking_context.TakeInterCUData(&declaring_context);
+  taking_context.TakeInterCUData(&defining_context);
+  EXPECT_TRUE(taking_context.referred_to_earlier_cus());
+  EXPECT_FALSE(defining_context.referred_to_earlier_cus());
+
+  // The declarations are gone from the context they were taken from.
+  ReadDefiningCU(&declaring_context);
+  FunctionList functions = Functions(&declaring_module);
+  ASSERT_EQ(2U, functions.size());
+  EXPECT_NE("declared_func", functions[0].second);
+  EXPECT_NE("inline_func", functions[1].second);
+
+  // And can be used by a context that takes them in turn.
+  Module module("module-name", "module-os", "module-arch", "module-id");
+  DwarfCUToModule::FileContext file_context("dwarf-filename", &module, true);
+  file_context.TakeInterCUData(&taking_context);
+  ReadDefiningCU(&file_context);
+  functions = Functions(&module);
+  ASSERT_EQ(2U, functions.size());
+  EXPECT_EQ("declared_func", functions[0].second);
+  EXPECT_EQ("inline_func", functions[1].second);
+}
+
 class CUErrors: public CUFixtureBase, public Test { };
 
 TEST_F(CUErrors, BadStmtList) {
@@ -1848,5 +1984,26 @@ TEST_F(Reporter, UnnamedFunction) {
   reporter.UnnamedFunction(0x90c0baff9dedb2d9ULL);
 }
 
+TEST_F(Reporter, Buffered) {
+  string buffer;
+  reporter.set_buffer(&buffer);
+  reporter.UnknownSpecification(0x123456789abcdef1ULL, 0x323456789abcdef2ULL);
+  reporter.MissingSection("section name");
+
+  // The heading is printed once, ahead of both warnings.
+  const string heading = "filename: in compilation unit"
+      " 'compilation-unit-name' (offset 0x123456789abcdef0):\n";
+  EXPECT_EQ(0U, buffer.find(heading));
+  EXPECT_EQ(string::npos, buffer.find(heading, 1));
+  size_t specification = buffer.find("referring to the die at offset"
+                                     " 0x323456789abcdef2");
+  size_t section = buffer.find("couldn't find DWARF 'section name' section\n");
+  EXPECT_NE(string::npos, specification);
+  EXPECT_NE(string::npos, section);
+  EXPECT_LT(specification, section);
+  EXPECT_EQ(buffer.size(), section + strlen("couldn't find DWARF"
+                                            " 'section name' section\n"));
+}
+
 // Would be nice to also test:
 // - overlapping lines, functions
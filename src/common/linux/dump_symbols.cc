@@ -47,9 +47,12 @@
 #include <sys/stat.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <atomic>
 #include <iostream>
 #include <set>
 #include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 
@@ -230,11 +233,202 @@ class DumperLineToModule: public DwarfCUToModule::LineToModuleHandler {
   dwarf2reader::ByteReader *byte_reader_;
 };
 
+// Read the compilation unit at OFFSET in FILE_CONTEXT's .debug_info
+// section, adding what it describes to FILE_CONTEXT's module.  If WARNINGS
+// is not NULL, append warnings about the unit to it rather than printing
+// them.  Return the unit's size.
+uint64 ReadCompilationUnit(const string& dwarf_filename,
+                           DwarfCUToModule::FileContext* file_context,
+                           dwarf2reader::ByteReader* byte_reader,
+                           DumperLineToModule* line_to_module,
+                           uint64 offset,
+                           string* warnings) {
+  // Make a handler for the root DIE that populates MODULE with the
+  // data that was found.
+  DwarfCUToModule::WarningReporter reporter(dwarf_filename, offset);
+  reporter.set_buffer(warnings);
+  DwarfCUToModule root_handler(file_context, line_to_module, &reporter);
+  // Make a Dwarf2Handler that drives the DIEHandler.
+  dwarf2reader::DIEDispatcher die_dispatcher(&root_handler);
+  // Make a DWARF parser for the compilation unit at OFFSET.
+  dwarf2reader::CompilationUnit reader(dwarf_filename,
+                                       file_context->section_map(),
+                                       offset,
+                                       byte_reader,
+                                       &die_dispatcher);
+  // Process the entire compilation unit; get the offset of the next.
+  return reader.Start();
+}
+
+// Make a context for reading DWARF_FILENAME's compilation units into
+// MODULE, with the same sections as FILE_CONTEXT.
+DwarfCUToModule::FileContext* CopyFileContext(
+    const string& dwarf_filename,
+    const DwarfCUToModule::FileContext& file_context,
+    bool handle_inter_cu_refs,
+    Module* module) {
+  DwarfCUToModule::FileContext* copy =
+      new DwarfCUToModule::FileContext(dwarf_filename, module,
+                                       handle_inter_cu_refs);
+  const dwarf2reader::SectionMap& sections = file_context.section_map();
+  for (dwarf2reader::SectionMap::const_iterator it = sections.begin();
+       it != sections.end(); ++it) {
+    copy->AddSectionToSectionMap(it->first, it->second.first,
+                                 it->second.second);
+  }
+  return copy;
+}
+
+// What reading one compilation unit on its own produced.
+struct CompilationUnitResult {
+  CompilationUnitResult() : offset(0) {}
+
+  // The unit's offset in the .debug_info section.
+  uint64 offset;
+
+  // The unit's functions.
+  scoped_ptr<Module> module;
+
+  // The DIEs the unit recorded for later units to refer to.
+  scoped_ptr<DwarfCUToModule::FileContext> inter_cu_data;
+
+  // Warnings about the unit, printed once all units have been read.
+  string warnings;
+};
+
+// Read the compilation units in FILE_CONTEXT's .debug_info section into
+// MODULE on NUM_THREADS threads, leaving MODULE just as reading them one
+// after another with FILE_CONTEXT would.
+//
+// Each thread reads the units it claims one at a time, each into a module
+// of its own, and the units' functions are then added to MODULE in the
+// order the units appear in the section.  A unit that looked up DIEs in
+// earlier units is read again once the units before it have been, with a
+// context holding the DIEs they recorded.
+void LoadDwarfConcurrently(const string& dwarf_filename,
+                           const DwarfCUToModule::FileContext& file_context,
+                           bool handle_inter_cu_refs,
+                           dwarf2reader::Endianness endianness,
+                           unsigned int num_threads,
+                           Module* module) {
+  // Find where each unit starts, reading only their initial lengths.
+  dwarf2reader::SectionMap::const_iterator debug_info_entry =
+      file_context.section_map().find(".debug_info");
+  const uint8_t* debug_info = debug_info_entry->second.first;
+  uint64 debug_info_length = debug_info_entry->second.second;
+  std::vector<uint64> offsets;
+  {
+    dwarf2reader::ByteReader byte_reader(endianness);
+    for (uint64 offset = 0; offset < debug_info_length;) {
+      // Stop at a unit whose initial length, or whose contents, run past
+      // the end of the section, rather than read or index beyond it.
+      uint64 remaining = debug_info_length - offset;
+      size_t initial_length_size = 4;
+      if (remaining >= 4 &&
+          byte_reader.ReadFourBytes(debug_info + offset) == 0xffffffff)
+        initial_length_size = 12;
+      if (remaining < initial_length_size) {
+        fprintf(stderr, "%s: truncated compilation unit header at offset"
+                " 0x%llx in .debug_info\n", dwarf_filename.c_str(),
+                static_cast<unsigned long long>(offset));
+        break;
+      }
+      uint64 unit_length =
+          byte_reader.ReadInitialLength(debug_info + offset,
+                                        &initial_length_size);
+      if (unit_length > remaining - initial_length_size) {
+        fprintf(stderr, "%s: compilation unit at offset 0x%llx runs past"
+                " the end of .debug_info\n", dwarf_filename.c_str(),
+                static_cast<unsigned long long>(offset));
+        break;
+      }
+      offsets.push_back(offset);
+      offset += initial_length_size + unit_length;
+    }
+  }
+  std::vector<CompilationUnitResult> results(offsets.size());
+  for (size_t i = 0; i < offsets.size(); ++i)
+    results[i].offset = offsets[i];
+
+  // Each pool thread, and the calling thread, claims the next unit until
+  // none are left.
+  std::atomic<size_t> next_unit(0);
+  auto read_units = [&]() {
+    dwarf2reader::ByteReader byte_reader(endianness);
+    DumperLineToModule line_to_module(&byte_reader);
+    Module thread_module(module->name(), module->os(),
+                         module->architecture(), module->identifier());
+    thread_module.set_functions_on_heap(module->functions_on_heap());
+    scoped_ptr<DwarfCUToModule::FileContext> thread_context(
+        CopyFileContext(dwarf_filename, file_context, handle_inter_cu_refs,
+                        &thread_module));
+    size_t index;
+    while ((index = next_unit++) < results.size()) {
+      CompilationUnitResult& result = results[index];
+      ReadCompilationUnit(dwarf_filename, thread_context.get(), &byte_reader,
+                          &line_to_module, result.offset, &result.warnings);
+      result.module.reset(new Module(module->name(), module->os(),
+                                     module->architecture(),
+                                     module->identifier()));
+      result.module->TakeFunctions(&thread_module);
+      result.inter_cu_data.reset(new DwarfCUToModule::FileContext(
+          dwarf_filename, NULL, handle_inter_cu_refs));
+      result.inter_cu_data->TakeInterCUData(thread_context.get());
+    }
+  };
+  size_t pool_size = std::min<size_t>(num_threads, results.size());
+  std::vector<std::thread> pool;
+  for (size_t i = 1; i < pool_size; ++i)
+    pool.push_back(std::thread(read_units));
+  read_units();
+  for (size_t i = 0; i < pool.size(); ++i)
+    pool[i].join();
+
+  // Read the units that referred to earlier ones again, in order, with a
+  // context that has taken the DIEs recorded by every unit before them.
+  size_t rereads_end = 0;
+  for (size_t i = 0; i < results.size(); ++i) {
+    if (results[i].inter_cu_data->referred_to_earlier_cus())
+      rereads_end = i + 1;
+  }
+  if (rereads_end > 0) {
+    dwarf2reader::ByteReader byte_reader(endianness);
+    DumperLineToModule line_to_module(&byte_reader);
+    Module reread_module(module->name(), module->os(),
+                         module->architecture(), module->identifier());
+    reread_module.set_functions_on_heap(module->functions_on_heap());
+    scoped_ptr<DwarfCUToModule::FileContext> reread_context(
+        CopyFileContext(dwarf_filename, file_context, handle_inter_cu_refs,
+                        &reread_module));
+    for (size_t i = 0; i < rereads_end; ++i) {
+      CompilationUnitResult& result = results[i];
+      if (result.inter_cu_data->referred_to_earlier_cus()) {
+        result.warnings.clear();
+        ReadCompilationUnit(dwarf_filename, reread_context.get(), &byte_reader,
+                            &line_to_module, result.offset, &result.warnings);
+        result.module.reset(new Module(module->name(), module->os(),
+                                       module->architecture(),
+                                       module->identifier()));
+        result.module->TakeFunctions(&reread_module);
+      } else {
+        reread_context->TakeInterCUData(result.inter_cu_data.get());
+      }
+      result.inter_cu_data.reset();
+    }
+  }
+
+  for (size_t i = 0; i < results.size(); ++i) {
+    fputs(results[i].warnings.c_str(), stderr);
+    module->TakeFunctions(results[i].module.get());
+  }
+}
+
 template<typename ElfClass>
 bool LoadDwarf(const string& dwarf_filename,
                const typename ElfClass::Ehdr* elf_header,
                const bool big_endian,
                bool handle_inter_cu_refs,
+               unsigned int num_threads,
                Module* module) {
   typedef typename ElfClass::Shdr Shdr;
 
@@ -272,22 +466,15 @@ bool LoadDwarf(const string& dwarf_filename,
   // This should never have been called if the file doesn't have a
   // .debug_info section.
   assert(debug_info_section.first);
+  if (num_threads > 1) {
+    LoadDwarfConcurrently(dwarf_filename, file_context, handle_inter_cu_refs,
+                          endianness, num_threads, module);
+    return true;
+  }
   uint64 debug_info_length = debug_info_section.second;
   for (uint64 offset = 0; offset < debug_info_length;) {
-    // Make a handler for the root DIE that populates MODULE with the
-    // data that was found.
-    DwarfCUToModule::WarningReporter reporter(dwarf_filename, offset);
-    DwarfCUToModule root_handler(&file_context, &line_to_module, &reporter);
-    // Make a Dwarf2Handler that drives the DIEHandler.
-    dwarf2reader::DIEDispatcher die_dispatcher(&root_handler);
-    // Make a DWARF parser for the compilation unit at OFFSET.
-    dwarf2reader::CompilationUnit reader(dwarf_filename,
-                                         file_context.section_map(),
-                                         offset,
-                                         &byte_reader,
-                                         &die_dispatcher);
-    // Process the entire compilation unit; get the offset of the next.
-    offset += reader.Start();
+    offset += ReadCompilationUnit(dwarf_filename, &file_context, &byte_reader,
+                                  &line_to_module, offset, NULL);
   }
   return true;
 }
@@ -627,6 +814,85 @@ bool LoadSymbols(const string& obj_file,
   bool found_debug_info_section = false;
   bool found_usable_info = false;
 
+  // Dwarf Call Frame Information (CFI) is actually independent from
+  // the other DWARF debugging information, and can be used alone.
+  const Shdr* dwarf_cfi_section = NULL;
+  const Shdr* eh_frame_section = NULL;
+  const Shdr* got_section = NULL;
+  const Shdr* text_section = NULL;
+  if (options.symbol_data != NO_CFI) {
+    dwarf_cfi_section =
+        FindElfSectionByName<ElfClass>(".debug_frame", SHT_PROGBITS,
+                                       sections, names, names_end,
+                                       elf_header->e_shnum);
+
+    // .debug_frame section type is SHT_PROGBITS for mips on pnacl toolchains,
+    // but MIPS_DWARF for regular gnu toolchains, so both need to be checked
+    if (elf_header->e_machine == EM_MIPS && !dwarf_cfi_section) {
+      dwarf_cfi_section =
+          FindElfSectionByName<ElfClass>(".debug_frame", SHT_MIPS_DWARF,
+                                        sections, names, names_end,
+                                        elf_header->e_shnum);
+    }
+
+    // Linux C++ exception handling information can also provide
+    // unwinding data.
+    eh_frame_section =
+        FindElfSectionByName<ElfClass>(".eh_frame", SHT_PROGBITS,
+                                       sections, names, names_end,
+                                       elf_header->e_shnum);
+    if (eh_frame_section) {
+      // Pointers in .eh_frame data may be relative to the base addresses of
+      // certain sections. Provide those sections if present.
+      got_section =
+          FindElfSectionByName<ElfClass>(".got", SHT_PROGBITS,
+                                         sections, names, names_end,
+                                         elf_header->e_shnum);
+      text_section =
+          FindElfSectionByName<ElfClass>(".text", SHT_PROGBITS,
+                                         sections, names, names_end,
+                                         elf_header->e_shnum);
+    }
+  }
+
+  // Load the call frame information into CFI_MODULE. Ignore the return
+  // values of LoadDwarfCFI beyond noting whether anything was usable; even
+  // without call frame information, the other debugging information could
+  // be perfectly useful.
+  bool found_cfi = false;
+  auto load_cfi = [&](Module* cfi_module) {
+    if (dwarf_cfi_section) {
+      bool result =
+          LoadDwarfCFI<ElfClass>(obj_file, elf_header, ".debug_frame",
+                                 dwarf_cfi_section, false, 0, 0, big_endian,
+                                 cfi_module);
+      found_cfi = found_cfi || result;
+    }
+    if (eh_frame_section) {
+      bool result =
+          LoadDwarfCFI<ElfClass>(obj_file, elf_header, ".eh_frame",
+                                 eh_frame_section, true,
+                                 got_section, text_section, big_endian,
+                                 cfi_module);
+      found_cfi = found_cfi || result;
+    }
+  };
+
+  // The CFI sections are disjoint from those read below, and only ever
+  // produce stack frame entries, which nothing else adds. So when we may
+  // use several threads, give one of them to the CFI, reading it into a
+  // module of its own while the rest is loaded here.
+  unsigned int num_threads = options.num_threads;
+  scoped_ptr<Module> cfi_module;
+  std::thread cfi_thread;
+  if (num_threads > 1 && (dwarf_cfi_section || eh_frame_section)) {
+    cfi_module.reset(new Module(module->name(), module->os(),
+                                module->architecture(),
+                                module->identifier()));
+    cfi_thread = std::thread(load_cfi, cfi_module.get());
+    --num_threads;
+  }
+
   if (options.symbol_data != ONLY_CFI) {
 #ifndef NO_STABS_SUPPORT
     // Look for STABS debugging information, and load it if present.
@@ -669,7 +935,8 @@ bool LoadSymbols(const string& obj_file,
       found_usable_info = true;
       info->LoadedSection(".debug_info");
       if (!LoadDwarf<ElfClass>(obj_file, elf_header, big_endian,
-                               options.handle_inter_cu_refs, module)) {
+                               options.handle_inter_cu_refs,
+                               num_threads, module)) {
         fprintf(stderr, "%s: \".debug_info\" section found, but failed to load "
                 "DWARF debugging information\n", obj_file.c_str());
       }
@@ -734,61 +1001,23 @@ bool LoadSymbols(const string& obj_file,
     }
   }
 
-  if (options.symbol_data != NO_CFI) {
-    // Dwarf Call Frame Information (CFI) is actually independent from
-    // the other DWARF debugging information, and can be used alone.
-    const Shdr* dwarf_cfi_section =
-        FindElfSectionByName<ElfClass>(".debug_frame", SHT_PROGBITS,
-                                       sections, names, names_end,
-                                       elf_header->e_shnum);
-
-    // .debug_frame section type is SHT_PROGBITS for mips on pnacl toolchains,
-    // but MIPS_DWARF for regular gnu toolchains, so both need to be checked
-    if (elf_header->e_machine == EM_MIPS && !dwarf_cfi_section) {
-      dwarf_cfi_section =
-          FindElfSectionByName<ElfClass>(".debug_frame", SHT_MIPS_DWARF,
-                                        sections, names, names_end,
-                                        elf_header->e_shnum);
-    }
-
-    if (dwarf_cfi_section) {
-      // Ignore the return value of this function; even without call frame
-      // information, the other debugging information could be perfectly
-      // useful.
-      info->LoadedSection(".debug_frame");
-      bool result =
-          LoadDwarfCFI<ElfClass>(obj_file, elf_header, ".debug_frame",
-                                 dwarf_cfi_section, false, 0, 0, big_endian,
-                                 module);
-      found_usable_info = found_usable_info || result;
-    }
-
-    // Linux C++ exception handling information can also provide
-    // unwinding data.
-    const Shdr* eh_frame_section =
-        FindElfSectionByName<ElfClass>(".eh_frame", SHT_PROGBITS,
-                                       sections, names, names_end,
-                                       elf_header->e_shnum);
-    if (eh_frame_section) {
-      // Pointers in .eh_frame data may be relative to the base addresses of
-      // certain sections. Provide those sections if present.
-      const Shdr* got_section =
-          FindElfSectionByName<ElfClass>(".got", SHT_PROGBITS,
-                                         sections, names, names_end,
-                                         elf_header->e_shnum);
-      const Shdr* text_section =
-          FindElfSectionByName<ElfClass>(".text", SHT_PROGBITS,
-                                         sections, names, names_end,
-                                         elf_header->e_shnum);
-      info->LoadedSection(".eh_frame");
-      // As above, ignore the return value of this function.
-      bool result =
-          LoadDwarfCFI<ElfClass>(obj_file, elf_header, ".eh_frame",
-                                 eh_frame_section, true,
-                                 got_section, text_section, big_endian, module);
-      found_usable_info = found_usable_info || result;
-    }
+  // Note the CFI sections as loaded after the others, in the same order
+  // whether or not they're being read on a thread of their own.
+  if (dwarf_cfi_section)
+    info->LoadedSection(".debug_frame");
+  if (eh_frame_section)
+    info->LoadedSection(".eh_frame");
+
+  // Wait for the call frame information if it's being read on a thread
+  // of its own, and add it to MODULE after everything else; otherwise,
+  // read it now.
+  if (cfi_thread.joinable()) {
+    cfi_thread.join();
+    module->TakeStackFrameEntries(cfi_module.get());
+  } else {
+    load_cfi(module);
   }
+  found_usable_info = found_usable_info || found_cfi;
 
   if (!found_debug_info_section) {
     fprintf(stderr, "%s: file contains no debugging information"
@@ -934,6 +1163,10 @@ bool ReadSymbolDataElfClass(const typename ElfClass::Ehdr* elf_header,
   if (!InitModuleForElfClass<ElfClass>(elf_header, obj_filename, module)) {
     return false;
   }
+  if (!options.temp_directory.empty()) {
+    module->SetSpillDirectory(options.temp_directory,
+                              options.max_function_records);
+  }
 
   // Figure out what endianness this file is.
   bool big_endian;
@@ -49,11 +49,22 @@ class Module;
 struct DumpOptions {
   DumpOptions(SymbolData symbol_data, bool handle_inter_cu_refs)
       : symbol_data(symbol_data),
-        handle_inter_cu_refs(handle_inter_cu_refs) {
+        handle_inter_cu_refs(handle_inter_cu_refs),
+        num_threads(1),
+        max_function_records(1 << 20) {
   }
 
   SymbolData symbol_data;
   bool handle_inter_cu_refs;
+  // The number of threads to read debugging information on.  The symbol
+  // file written is the same however many are used.
+  unsigned int num_threads;
+  // If not empty, a directory in which to keep temporary files of the
+  // functions read so far, so that no more than about
+  // max_function_records function and line records are held in memory
+  // at once.  The symbol file written is the same either way.
+  string temp_directory;
+  size_t max_function_records;
 };
 
 // Find all the debugging information in OBJ_FILE, an ELF executable
@@ -40,6 +40,8 @@
 #include <vector>
 
 #include "breakpad_googletest_includes.h"
+#include "common/dwarf/cfi_assembler.h"
+#include "common/dwarf/dwarf2reader_test_common.h"
 #include "common/linux/elf_gnu_compat.h"
 #include "common/linux/elfutils.h"
 #include "common/linux/dump_symbols.h"
@@ -55,11 +57,13 @@ bool ReadSymbolDataInternal(const uint8_t* obj_file,
                             const DumpOptions& options,
                             Module** module);
 
+using google_breakpad::CFISection;
 using google_breakpad::synth_elf::ELF;
 using google_breakpad::synth_elf::Notes;
 using google_breakpad::synth_elf::StringTable;
 using google_breakpad::synth_elf::SymbolTable;
 using google_breakpad::test_assembler::kLittleEndian;
+using google_breakpad::test_assembler::Label;
 using google_breakpad::test_assembler::Section;
 using std::stringstream;
 using std::vector;
@@ -201,4 +205,185 @@ TYPED_TEST(DumpSymbols, SimpleBuildID) {
   delete module;
 }
 
+TYPED_TEST(DumpSymbols, CFIThread) {
+  ELF elf(TypeParam::kMachine, TypeParam::kClass, kLittleEndian);
+  // Zero out text section for simplicity.
+  Section text(kLittleEndian);
+  text.Append(4096, 0);
+  elf.AddSection(".text", text, SHT_PROGBITS);
+
+  // Add call frame information for one function, using the stack pointer
+  // and instruction pointer register numbers of the ELF class's machine.
+  const bool is_64 = TypeParam::kAddrSize == 8;
+  const int kStackPointer = is_64 ? 7 : 4;
+  const int kReturnAddress = is_64 ? 16 : 8;
+  CFISection cfi(kLittleEndian, TypeParam::kAddrSize);
+  Label cie;
+  cfi
+      .Mark(&cie)
+      .CIEHeader(1, -static_cast<int>(TypeParam::kAddrSize), kReturnAddress,
+                 1, "")
+      .D8(dwarf2reader::DW_CFA_def_cfa).ULEB128(kStackPointer)
+      .ULEB128(TypeParam::kAddrSize)
+      .D8(dwarf2reader::DW_CFA_offset | kReturnAddress).ULEB128(1)
+      .FinishEntry()
+      .FDEHeader(cie, 0x1000, 0x10)
+      .D8(dwarf2reader::DW_CFA_advance_loc | 1)
+      .D8(dwarf2reader::DW_CFA_def_cfa_offset).ULEB128(2 * TypeParam::kAddrSize)
+      .FinishEntry();
+  elf.AddSection(".debug_frame", cfi, SHT_PROGBITS);
+
+  // Add a public symbol.
+  StringTable table(kLittleEndian);
+  SymbolTable syms(kLittleEndian, TypeParam::kAddrSize, table);
+  syms.AddSymbol("superfunc",
+                   (typename TypeParam::Addr)0x1000,
+                   (typename TypeParam::Addr)0x10,
+                 // ELF32_ST_INFO works for 32-or 64-bit.
+                 ELF32_ST_INFO(STB_GLOBAL, STT_FUNC),
+                 SHN_UNDEF + 1);
+  int index = elf.AddSection(".dynstr", table, SHT_STRTAB);
+  elf.AddSection(".dynsym", syms,
+                 SHT_DYNSYM,          // type
+                 SHF_ALLOC,           // flags
+                 0,                   // addr
+                 index,               // link
+                 sizeof(typename TypeParam::Sym));  // entsize
+
+  elf.Finish();
+  this->GetElfContents(elf);
+
+  // Dump once reading everything on this thread, and once reading the
+  // call frame information on a thread of its own.
+  Module* serial_module;
+  DumpOptions options(ALL_SYMBOL_DATA, true);
+  EXPECT_TRUE(ReadSymbolDataInternal(this->elfdata,
+                                     "foo",
+                                     vector<string>(),
+                                     options,
+                                     &serial_module));
+  Module* threaded_module;
+  options.num_threads = 2;
+  EXPECT_TRUE(ReadSymbolDataInternal(this->elfdata,
+                                     "foo",
+                                     vector<string>(),
+                                     options,
+                                     &threaded_module));
+
+  stringstream serial;
+  serial_module->Write(serial, ALL_SYMBOL_DATA);
+  stringstream threaded;
+  threaded_module->Write(threaded, ALL_SYMBOL_DATA);
+  EXPECT_NE(string::npos, serial.str().find("PUBLIC 1000 0 superfunc\n"));
+  EXPECT_NE(string::npos, serial.str().find("STACK CFI INIT 1000 10 "));
+  EXPECT_EQ(serial.str(), threaded.str());
+  delete serial_module;
+  delete threaded_module;
+}
+
+
+TYPED_TEST(DumpSymbols, DwarfThreads) {
+  const size_t kAddrSize = TypeParam::kAddrSize;
+
+  // One abbreviation table for every compilation unit: a root DIE, and
+  // functions that are defined, declared, or defined by reference to a
+  // declaration.
+  TestAbbrevTable abbrevs;
+  abbrevs.set_endianness(kLittleEndian);
+  abbrevs
+      .Abbrev(1, dwarf2reader::DW_TAG_compile_unit,
+              dwarf2reader::DW_children_yes)
+      .Attribute(dwarf2reader::DW_AT_name, dwarf2reader::DW_FORM_string)
+      .EndAbbrev()
+      .Abbrev(2, dwarf2reader::DW_TAG_subprogram, dwarf2reader::DW_children_no)
+      .Attribute(dwarf2reader::DW_AT_name, dwarf2reader::DW_FORM_string)
+      .Attribute(dwarf2reader::DW_AT_low_pc, dwarf2reader::DW_FORM_addr)
+      .Attribute(dwarf2reader::DW_AT_high_pc, dwarf2reader::DW_FORM_addr)
+      .EndAbbrev()
+      .Abbrev(3, dwarf2reader::DW_TAG_subprogram, dwarf2reader::DW_children_no)
+      .Attribute(dwarf2reader::DW_AT_name, dwarf2reader::DW_FORM_string)
+      .Attribute(dwarf2reader::DW_AT_declaration, dwarf2reader::DW_FORM_flag)
+      .EndAbbrev()
+      .Abbrev(4, dwarf2reader::DW_TAG_subprogram, dwarf2reader::DW_children_no)
+      .Attribute(dwarf2reader::DW_AT_specification,
+                 dwarf2reader::DW_FORM_ref_addr)
+      .Attribute(dwarf2reader::DW_AT_low_pc, dwarf2reader::DW_FORM_addr)
+      .Attribute(dwarf2reader::DW_AT_high_pc, dwarf2reader::DW_FORM_addr)
+      .EndAbbrev()
+      .EndTable();
+
+  // Four compilation units, each defining one function. The third names
+  // its function only by a DW_AT_specification link to a declaration in
+  // the first, so reading it on its own can't find the name.
+  const char* kNames[] = { "alpha", "beta", NULL, "gamma" };
+  Label declaration;
+  Section info(kLittleEndian);
+  for (int i = 0; i < 4; i++) {
+    TestCompilationUnit unit;
+    unit.set_endianness(kLittleEndian);
+    unit.set_format_size(4);
+    if (i == 0)
+      unit.start() = 0;
+    unit.Header(3, Label(0), kAddrSize)
+        .ULEB128(1).AppendCString("unit.c");
+    if (i == 0) {
+      unit.Mark(&declaration)
+          .ULEB128(3).AppendCString("declared").D8(1);
+    }
+    if (kNames[i])
+      unit.ULEB128(2).AppendCString(kNames[i]);
+    else
+      unit.ULEB128(4).D32(declaration);
+    unit.Append(kLittleEndian, kAddrSize, 0x1000 + i * 0x10)
+        .Append(kLittleEndian, kAddrSize, 0x1010 + i * 0x10)
+        .D8(0);  // end of the root DIE's children
+    unit.Finish();
+    info.Append(unit);
+  }
+
+  // The same units, followed by the start of a unit whose length runs
+  // past the end of the section.
+  Section truncated_info(kLittleEndian);
+  truncated_info.Append(info).D32(0x100).D16(3);
+
+  Module* modules[3];
+  for (int i = 0; i < 3; i++) {
+    ELF elf(TypeParam::kMachine, TypeParam::kClass, kLittleEndian);
+    // Zero out text section for simplicity.
+    Section text(kLittleEndian);
+    text.Append(4096, 0);
+    elf.AddSection(".text", text, SHT_PROGBITS);
+    elf.AddSection(".debug_info", i == 2 ? truncated_info : info,
+                   SHT_PROGBITS);
+    elf.AddSection(".debug_abbrev", abbrevs, SHT_PROGBITS);
+    elf.Finish();
+    this->GetElfContents(elf);
+
+    // Dump once reading the units one after another, and then twice on
+    // several threads.
+    DumpOptions options(ALL_SYMBOL_DATA, true);
+    if (i > 0)
+      options.num_threads = 3;
+    ASSERT_TRUE(ReadSymbolDataInternal(this->elfdata,
+                                       "foo",
+                                       vector<string>(),
+                                       options,
+                                       &modules[i]));
+  }
+
+  stringstream serial;
+  modules[0]->Write(serial, ALL_SYMBOL_DATA);
+  stringstream threaded;
+  modules[1]->Write(threaded, ALL_SYMBOL_DATA);
+  stringstream truncated;
+  modules[2]->Write(truncated, ALL_SYMBOL_DATA);
+  EXPECT_NE(string::npos, serial.str().find("FUNC 1000 10 0 alpha\n"));
+  EXPECT_NE(string::npos, serial.str().find("FUNC 1020 10 0 declared\n"));
+  EXPECT_NE(string::npos, serial.str().find("FUNC 1030 10 0 gamma\n"));
+  EXPECT_EQ(serial.str(), threaded.str());
+  EXPECT_EQ(serial.str(), truncated.str());
+  for (int i = 0; i < 3; i++)
+    delete modules[i];
+}
+
 }  // namespace google_breakpad
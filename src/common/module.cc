@@ -36,17 +36,136 @@
 #include <assert.h>
 #include <errno.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
 #include <iostream>
+#include <queue>
 #include <utility>
 
 namespace google_breakpad {
 
-using std::dec;
-using std::endl;
-using std::hex;
 
+namespace {
+
+// Write VALUE's bytes to RUN, a temporary file of spilled functions.
+// Errors are left for the caller to find with ferror.
+template<typename T>
+void WriteSpillValue(FILE *run, const T &value) {
+  fwrite(&value, sizeof(value), 1, run);
+}
+
+// Read a value written by WriteSpillValue from RUN into VALUE. Return
+// false at the end of RUN, or if an error occurs.
+template<typename T>
+bool ReadSpillValue(FILE *run, T *value) {
+  return fread(value, sizeof(*value), 1, run) == 1;
+}
+
+// A function being merged by Module::WriteMergedFunctions, and the index
+// of the source it came from: the module's spill runs in order, and then
+// its functions held in memory.
+typedef std::pair<Module::Function *, size_t> MergeEntry;
+
+// Order MergeEntries so that a priority queue yields the least function
+// first, and among equal functions, the one from the earliest source.
+struct MergeEntryGreater {
+  bool operator()(const MergeEntry &x, const MergeEntry &y) const {
+    Module::FunctionCompare less;
+    if (less(x.first, y.first))
+      return false;
+    if (less(y.first, x.first))
+      return true;
+    return x.second > y.second;
+  }
+};
+
+}  // namespace
+
+// A RecordWriter formats symbol file records into a large buffer, and
+// writes the buffer to a stream each time it fills. This is much faster
+// than formatting each field with std::ostream's inserters and the hex
+// and dec manipulators, and flushing the stream after every line with
+// endl, and produces the same text.
+class Module::RecordWriter {
+ public:
+  explicit RecordWriter(std::ostream &stream)
+      : stream_(stream), buffer_(kBufferSize), used_(0) { }
+
+  void Append(const char *data, size_t size) {
+    if (size > buffer_.size() - used_) {
+      Flush();
+      if (size > buffer_.size()) {
+        stream_.write(data, size);
+        return;
+      }
+    }
+    memcpy(&buffer_[used_], data, size);
+    used_ += size;
+  }
+
+  void Append(const char *text) { Append(text, strlen(text)); }
+
+  void Append(const string &text) { Append(text.data(), text.size()); }
+
+  void Append(char c) {
+    if (used_ == buffer_.size())
+      Flush();
+    buffer_[used_++] = c;
+  }
+
+  // Append VALUE in lower-case hexadecimal without leading zeros, as
+  // 'stream << hex << VALUE' would.
+  void AppendHex(uint64_t value) {
+    char digits[16];
+    char *end = digits + sizeof(digits);
+    char *start = end;
+    do {
+      *--start = "0123456789abcdef"[value & 0xf];
+      value >>= 4;
+    } while (value);
+    Append(start, end - start);
+  }
+
+  // Append VALUE in decimal, as 'stream << dec << VALUE' would.
+  void AppendDecimal(int value) {
+    char digits[11];
+    char *end = digits + sizeof(digits);
+    char *start = end;
+    unsigned int magnitude = value < 0 ? 0U - static_cast<unsigned int>(value)
+                                       : static_cast<unsigned int>(value);
+    do {
+      *--start = static_cast<char>('0' + magnitude % 10);
+      magnitude /= 10;
+    } while (magnitude);
+    if (value < 0)
+      *--start = '-';
+    Append(start, end - start);
+  }
+
+  // Write the buffered text to the stream, and flush it. Return true if
+  // all output so far has been written without error.
+  bool Flush() {
+    if (used_ > 0) {
+      stream_.write(&buffer_[0], used_);
+      used_ = 0;
+    }
+    stream_.flush();
+    return stream_.good();
+  }
+
+  // Return true if no error has occurred writing to the stream so far.
+  // Errors in buffered text only show up once it's been written.
+  bool good() const { return stream_.good(); }
+
+ private:
+  static const size_t kBufferSize = 1 << 20;
+
+  std::ostream &stream_;
+  vector<char> buffer_;
+  size_t used_;
+};
 
 Module::Module(const string &name, const string &os,
                const string &architecture, const string &id,
@@ -56,21 +175,36 @@ Module::Module(const string &name, const string &os,
     architecture_(architecture),
     id_(id),
     code_id_(code_id),
-    load_address_(0) { }
+    load_address_(0),
+    function_nodes_(new Arena()),
+    functions_(FunctionCompare(),
+               ArenaAllocator<Function *>(function_nodes_.get())),
+    function_records_(0),
+    spill_limit_(0),
+    functions_on_heap_(false),
+    externs_(ExternCompare(), ArenaAllocator<Extern *>(&extern_arena_)) { }
 
 Module::~Module() {
   for (FileByNameMap::iterator it = files_.begin(); it != files_.end(); ++it)
     delete it->second;
   for (FunctionSet::iterator it = functions_.begin();
        it != functions_.end(); ++it) {
-    delete *it;
+    DeleteFunction(*it);
   }
   for (vector<StackFrameEntry *>::iterator it = stack_frame_entries_.begin();
        it != stack_frame_entries_.end(); ++it) {
+    DeleteStackFrameEntry(*it);
+  }
+  for (vector<Arena *>::iterator it = entry_arenas_.begin();
+       it != entry_arenas_.end(); ++it) {
     delete *it;
   }
   for (ExternSet::iterator it = externs_.begin(); it != externs_.end(); ++it)
-    delete *it;
+    DeleteExtern(*it);
+  for (vector<FILE *>::iterator it = spill_runs_.begin();
+       it != spill_runs_.end(); ++it) {
+    fclose(*it);
+  }
 }
 
 void Module::SetLoadAddress(Address address) {
@@ -94,7 +228,7 @@ void Module::AddFunction(Function *function) {
     it_ext = externs_.find(&arm_thumb_ext);
   }
   if (it_ext != externs_.end()) {
-    delete *it_ext;
+    DeleteExtern(*it_ext);
     externs_.erase(it_ext);
   }
 #if _DEBUG
@@ -108,34 +242,245 @@ void Module::AddFunction(Function *function) {
 #endif
 
   std::pair<FunctionSet::iterator,bool> ret = functions_.insert(function);
-  if (!ret.second && (*ret.first != function)) {
+  if (ret.second) {
+    function_records_ += 1 + function->lines.size();
+  } else if (*ret.first != function) {
     // Free the duplicate that was not inserted because this Module
     // now owns it.
-    delete function;
+    DeleteFunction(function);
   }
 }
 
+Module::Function *Module::NewFunction(const string &name, Address address) {
+  if (functions_on_heap_)
+    return new Function(name, address);
+  return new(function_arena_.Alloc(sizeof(Function))) Function(name, address);
+}
+
+void Module::DeleteFunction(Function *function) {
+  if (function_arena_.Contains(function))
+    function->~Function();
+  else
+    delete function;
+}
+
 void Module::AddFunctions(vector<Function *>::iterator begin,
                           vector<Function *>::iterator end) {
   for (vector<Function *>::iterator it = begin; it != end; ++it)
     AddFunction(*it);
+  SpillFunctionsIfNeeded();
+}
+
+void Module::TakeFunctions(Module *other) {
+  // Take OTHER's arena first, so that any of its functions that turn out
+  // to be duplicates are freed properly.
+  function_arena_.TakeBlocks(&other->function_arena_);
+
+  // Each of OTHER's files cited by its lines, and the file of the same
+  // name here.
+  map<File *, File *> files;
+  for (FunctionSet::iterator func_it = other->functions_.begin();
+       func_it != other->functions_.end(); ++func_it) {
+    Function *func = *func_it;
+    for (vector<Line>::iterator line_it = func->lines.begin();
+         line_it != func->lines.end(); ++line_it) {
+      map<File *, File *>::iterator file_it = files.find(line_it->file);
+      if (file_it == files.end()) {
+        file_it = files.insert(
+            std::make_pair(line_it->file, FindFile(line_it->file->name))).first;
+      }
+      line_it->file = file_it->second;
+    }
+    AddFunction(func);
+  }
+  other->functions_.clear();
+  other->function_records_ = 0;
+  SpillFunctionsIfNeeded();
+}
+
+void Module::SetSpillDirectory(const string &directory, size_t max_records) {
+  spill_directory_ = directory;
+  spill_limit_ = max_records;
+  if (max_records > 0)
+    functions_on_heap_ = true;
+}
+
+void Module::SpillFunctionsIfNeeded() {
+  if (spill_limit_ > 0 && function_records_ > spill_limit_)
+    SpillFunctions();
+}
+
+void Module::SpillFunctions() {
+  string path = spill_directory_ + "/breakpad_module_XXXXXX";
+  int fd = mkstemp(&path[0]);
+  if (fd < 0) {
+    fprintf(stderr, "error creating temporary file in '%s': %s\n",
+            spill_directory_.c_str(), strerror(errno));
+    spill_limit_ = 0;
+    return;
+  }
+  // Nothing else needs to find the file, so remove its name now; that
+  // way, it is deleted when closed, however this process exits.
+  unlink(path.c_str());
+  FILE *run = fdopen(fd, "w+b");
+  if (!run) {
+    fprintf(stderr, "error opening temporary file in '%s': %s\n",
+            spill_directory_.c_str(), strerror(errno));
+    close(fd);
+    spill_limit_ = 0;
+    return;
+  }
+
+  // Write each function as its address, size, parameter size, name
+  // length, name, and line count, followed by its lines. Files are
+  // written as indices into spilled_files_.
+  size_t spilled_file_count = spilled_files_.size();
+  for (FunctionSet::const_iterator func_it = functions_.begin();
+       func_it != functions_.end(); ++func_it) {
+    const Function *func = *func_it;
+    WriteSpillValue(run, func->address);
+    WriteSpillValue(run, func->size);
+    WriteSpillValue(run, func->parameter_size);
+    WriteSpillValue(run, static_cast<uint64_t>(func->name.size()));
+    fwrite(func->name.data(), 1, func->name.size(), run);
+    WriteSpillValue(run, static_cast<uint64_t>(func->lines.size()));
+    for (vector<Line>::const_iterator line_it = func->lines.begin();
+         line_it != func->lines.end(); ++line_it) {
+      map<const File *, uint32_t>::iterator file_it =
+          spilled_file_ids_.find(line_it->file);
+      if (file_it == spilled_file_ids_.end()) {
+        uint32_t file_id = static_cast<uint32_t>(spilled_files_.size());
+        file_it = spilled_file_ids_.insert(
+            std::make_pair(line_it->file, file_id)).first;
+        spilled_files_.push_back(line_it->file);
+      }
+      WriteSpillValue(run, line_it->address);
+      WriteSpillValue(run, line_it->size);
+      WriteSpillValue(run, file_it->second);
+      WriteSpillValue(run, line_it->number);
+    }
+  }
+  if (fflush(run) != 0 || ferror(run)) {
+    fprintf(stderr, "error writing temporary file in '%s': %s\n",
+            spill_directory_.c_str(), strerror(errno));
+    fclose(run);
+    // Forget the files cited only by this run, so they are not written
+    // out as used.
+    for (size_t i = spilled_file_count; i < spilled_files_.size(); i++)
+      spilled_file_ids_.erase(spilled_files_[i]);
+    spilled_files_.resize(spilled_file_count);
+    spill_limit_ = 0;
+    return;
+  }
+
+  for (FunctionSet::iterator func_it = functions_.begin();
+       func_it != functions_.end(); ++func_it) {
+    DeleteFunction(*func_it);
+  }
+  // Free the set's nodes as well, by starting a new set in a new arena.
+  Arena *function_nodes = new Arena();
+  functions_ = FunctionSet(FunctionCompare(),
+                           ArenaAllocator<Function *>(function_nodes));
+  function_nodes_.reset(function_nodes);
+  function_records_ = 0;
+  spill_runs_.push_back(run);
+}
+
+Module::Function *Module::ReadSpilledFunction(FILE *run) {
+  Address address, size, parameter_size;
+  uint64_t name_size;
+  if (!ReadSpillValue(run, &address) ||
+      !ReadSpillValue(run, &size) ||
+      !ReadSpillValue(run, &parameter_size) ||
+      !ReadSpillValue(run, &name_size))
+    return NULL;
+  string name(name_size, '\0');
+  uint64_t line_count;
+  if ((name_size > 0 && fread(&name[0], 1, name_size, run) != name_size) ||
+      !ReadSpillValue(run, &line_count))
+    return NULL;
+
+  Function *func = new Function(name, address);
+  func->size = size;
+  func->parameter_size = parameter_size;
+  func->lines.reserve(line_count);
+  for (uint64_t i = 0; i < line_count; i++) {
+    Line line;
+    uint32_t file_id;
+    if (!ReadSpillValue(run, &line.address) ||
+        !ReadSpillValue(run, &line.size) ||
+        !ReadSpillValue(run, &file_id) ||
+        !ReadSpillValue(run, &line.number) ||
+        file_id >= spilled_files_.size()) {
+      delete func;
+      return NULL;
+    }
+    line.file = spilled_files_[file_id];
+    func->lines.push_back(line);
+  }
+  return func;
 }
 
 void Module::AddStackFrameEntry(StackFrameEntry *stack_frame_entry) {
   stack_frame_entries_.push_back(stack_frame_entry);
 }
 
+void Module::TakeStackFrameEntries(Module *other) {
+  stack_frame_entries_.insert(stack_frame_entries_.end(),
+                              other->stack_frame_entries_.begin(),
+                              other->stack_frame_entries_.end());
+  other->stack_frame_entries_.clear();
+  entry_arenas_.insert(entry_arenas_.begin(), other->entry_arenas_.begin(),
+                       other->entry_arenas_.end());
+  other->entry_arenas_.clear();
+}
+
+Module::StackFrameEntry *Module::NewStackFrameEntry() {
+  if (entry_arenas_.empty())
+    entry_arenas_.push_back(new Arena());
+  Arena *arena = entry_arenas_.back();
+  return new(arena->Alloc(sizeof(StackFrameEntry))) StackFrameEntry(arena);
+}
+
+bool Module::InArenas(const vector<Arena *> &arenas, const void *p) {
+  for (vector<Arena *>::const_iterator it = arenas.begin();
+       it != arenas.end(); ++it) {
+    if ((*it)->Contains(p))
+      return true;
+  }
+  return false;
+}
+
+void Module::DeleteStackFrameEntry(StackFrameEntry *entry) {
+  if (InArenas(entry_arenas_, entry))
+    entry->~StackFrameEntry();
+  else
+    delete entry;
+}
+
 void Module::AddExtern(Extern *ext) {
   std::pair<ExternSet::iterator,bool> ret = externs_.insert(ext);
   if (!ret.second) {
     // Free the duplicate that was not inserted because this Module
     // now owns it.
-    delete ext;
+    DeleteExtern(ext);
   }
 }
 
+Module::Extern *Module::NewExtern(Address address) {
+  return new(extern_arena_.Alloc(sizeof(Extern))) Extern(address);
+}
+
+void Module::DeleteExtern(Extern *ext) {
+  if (extern_arena_.Contains(ext))
+    ext->~Extern();
+  else
+    delete ext;
+}
+
 void Module::GetFunctions(vector<Function *> *vec,
                           vector<Function *>::iterator i) {
+  assert(!has_spilled_functions());
   vec->insert(i, functions_.begin(), functions_.end());
 }
 
@@ -194,13 +539,16 @@ void Module::AssignSourceIds() {
   }
 
   // Next, mark all files actually cited by our functions' line number
-  // info, by setting each one's source id to zero.
-  for (FunctionSet::const_iterator func_it = functions_.begin();
-       func_it != functions_.end(); ++func_it) {
-    Function *func = *func_it;
-    for (vector<Line>::iterator line_it = func->lines.begin();
-         line_it != func->lines.end(); ++line_it)
-      line_it->file->source_id = 0;
+  // info, by setting each one's source id to zero. If functions have
+  // been written out to temporary files, merge them as Write will, so
+  // that files cited only by duplicates it drops stay unused. Any error
+  // reading the files is reported when they are merged again to write.
+  if (spill_runs_.empty()) {
+    for (FunctionSet::const_iterator func_it = functions_.begin();
+         func_it != functions_.end(); ++func_it)
+      MarkFunctionFiles(*func_it);
+  } else {
+    WriteMergedFunctions(NULL);
   }
 
   // Finally, assign source ids to those files that have been marked.
@@ -221,24 +569,129 @@ bool Module::ReportError() {
   return false;
 }
 
-bool Module::WriteRuleMap(const RuleMap &rule_map, std::ostream &stream) {
+void Module::WriteRuleMap(const RuleMap &rule_map, RecordWriter *writer) {
   for (RuleMap::const_iterator it = rule_map.begin();
        it != rule_map.end(); ++it) {
     if (it != rule_map.begin())
-      stream << ' ';
-    stream << it->first << ": " << it->second;
+      writer->Append(' ');
+    writer->Append(it->first);
+    writer->Append(": ");
+    writer->Append(it->second);
   }
-  return stream.good();
 }
 
-bool Module::Write(std::ostream &stream, SymbolData symbol_data) {
-  stream << "MODULE " << os_ << " " << architecture_ << " "
-         << id_ << " " << name_ << endl;
-  if (!stream.good())
+bool Module::WriteFunction(const Function *func, RecordWriter *writer) {
+  writer->Append("FUNC ");
+  writer->AppendHex(func->address - load_address_);
+  writer->Append(' ');
+  writer->AppendHex(func->size);
+  writer->Append(' ');
+  writer->AppendHex(func->parameter_size);
+  writer->Append(' ');
+  writer->Append(func->name);
+  writer->Append('\n');
+
+  for (vector<Line>::const_iterator line_it = func->lines.begin();
+       line_it != func->lines.end(); ++line_it) {
+    writer->AppendHex(line_it->address - load_address_);
+    writer->Append(' ');
+    writer->AppendHex(line_it->size);
+    writer->Append(' ');
+    writer->AppendDecimal(line_it->number);
+    writer->Append(' ');
+    writer->AppendDecimal(line_it->file->source_id);
+    writer->Append('\n');
+  }
+  return writer->good();
+}
+
+void Module::MarkFunctionFiles(const Function *func) {
+  for (vector<Line>::const_iterator line_it = func->lines.begin();
+       line_it != func->lines.end(); ++line_it)
+    line_it->file->source_id = 0;
+}
+
+bool Module::WriteMergedFunctions(RecordWriter *writer) {
+  std::priority_queue<MergeEntry, vector<MergeEntry>, MergeEntryGreater>
+      queue;
+  const size_t held = spill_runs_.size();
+  for (size_t i = 0; i < spill_runs_.size(); i++) {
+    rewind(spill_runs_[i]);
+    Function *func = ReadSpilledFunction(spill_runs_[i]);
+    if (func)
+      queue.push(MergeEntry(func, i));
+  }
+  FunctionSet::const_iterator held_it = functions_.begin();
+  if (held_it != functions_.end())
+    queue.push(MergeEntry(*held_it++, held));
+
+  // The last function written. Functions read from spill runs are ours
+  // to delete once we're done with them.
+  FunctionCompare less;
+  MergeEntry previous(NULL, held);
+  bool written = true;
+  while (written && !queue.empty()) {
+    MergeEntry entry = queue.top();
+    queue.pop();
+
+    // Replace ENTRY in the queue with the next function from its source.
+    if (entry.second != held) {
+      Function *func = ReadSpilledFunction(spill_runs_[entry.second]);
+      if (func)
+        queue.push(MergeEntry(func, entry.second));
+    } else if (held_it != functions_.end()) {
+      queue.push(MergeEntry(*held_it++, held));
+    }
+
+    if (previous.first && !less(previous.first, entry.first)) {
+      // A function equal to one already written, but added later.
+      if (entry.second != held)
+        delete entry.first;
+      continue;
+    }
+    if (writer)
+      written = WriteFunction(entry.first, writer);
+    else
+      MarkFunctionFiles(entry.first);
+    if (previous.second != held)
+      delete previous.first;
+    previous = entry;
+  }
+
+  if (previous.second != held)
+    delete previous.first;
+  for (; !queue.empty(); queue.pop()) {
+    if (queue.top().second != held)
+      delete queue.top().first;
+  }
+  if (!written)
     return ReportError();
 
+  for (size_t i = 0; i < spill_runs_.size(); i++) {
+    if (ferror(spill_runs_[i])) {
+      fprintf(stderr, "error reading temporary file of functions\n");
+      return false;
+    }
+  }
+  return true;
+}
+
+bool Module::Write(std::ostream &stream, SymbolData symbol_data) {
+  RecordWriter writer(stream);
+  writer.Append("MODULE ");
+  writer.Append(os_);
+  writer.Append(' ');
+  writer.Append(architecture_);
+  writer.Append(' ');
+  writer.Append(id_);
+  writer.Append(' ');
+  writer.Append(name_);
+  writer.Append('\n');
+
   if (!code_id_.empty()) {
-    stream << "INFO CODE_ID " << code_id_ << endl;
+    writer.Append("INFO CODE_ID ");
+    writer.Append(code_id_);
+    writer.Append('\n');
   }
 
   if (symbol_data != ONLY_CFI) {
@@ -249,44 +702,36 @@ bool Module::Write(std::ostream &stream, SymbolData symbol_data) {
          file_it != files_.end(); ++file_it) {
       File *file = file_it->second;
       if (file->source_id >= 0) {
-        stream << "FILE " << file->source_id << " " <<  file->name << endl;
-        if (!stream.good())
+        writer.Append("FILE ");
+        writer.AppendDecimal(file->source_id);
+        writer.Append(' ');
+        writer.Append(file->name);
+        writer.Append('\n');
+        if (!writer.good())
           return ReportError();
       }
     }
 
     // Write out functions and their lines.
-    for (FunctionSet::const_iterator func_it = functions_.begin();
-         func_it != functions_.end(); ++func_it) {
-      Function *func = *func_it;
-      stream << "FUNC " << hex
-             << (func->address - load_address_) << " "
-             << func->size << " "
-             << func->parameter_size << " "
-             << func->name << dec << endl;
-      if (!stream.good())
-        return ReportError();
-
-      for (vector<Line>::iterator line_it = func->lines.begin();
-           line_it != func->lines.end(); ++line_it) {
-        stream << hex
-               << (line_it->address - load_address_) << " "
-               << line_it->size << " "
-               << dec
-               << line_it->number << " "
-               << line_it->file->source_id << endl;
-        if (!stream.good())
+    if (spill_runs_.empty()) {
+      for (FunctionSet::const_iterator func_it = functions_.begin();
+           func_it != functions_.end(); ++func_it) {
+        if (!WriteFunction(*func_it, &writer))
           return ReportError();
       }
+    } else if (!WriteMergedFunctions(&writer)) {
+      return false;
     }
 
     // Write out 'PUBLIC' records.
     for (ExternSet::const_iterator extern_it = externs_.begin();
          extern_it != externs_.end(); ++extern_it) {
       Extern *ext = *extern_it;
-      stream << "PUBLIC " << hex
-             << (ext->address - load_address_) << " 0 "
-             << ext->name << dec << endl;
+      writer.Append("PUBLIC ");
+      writer.AppendHex(ext->address - load_address_);
+      writer.Append(" 0 ");
+      writer.Append(ext->name);
+      writer.Append('\n');
     }
   }
 
@@ -296,29 +741,30 @@ bool Module::Write(std::ostream &stream, SymbolData symbol_data) {
     for (frame_it = stack_frame_entries_.begin();
          frame_it != stack_frame_entries_.end(); ++frame_it) {
       StackFrameEntry *entry = *frame_it;
-      stream << "STACK CFI INIT " << hex
-             << (entry->address - load_address_) << " "
-             << entry->size << " " << dec;
-      if (!stream.good()
-          || !WriteRuleMap(entry->initial_rules, stream))
-        return ReportError();
-
-      stream << endl;
+      writer.Append("STACK CFI INIT ");
+      writer.AppendHex(entry->address - load_address_);
+      writer.Append(' ');
+      writer.AppendHex(entry->size);
+      writer.Append(' ');
+      WriteRuleMap(entry->initial_rules, &writer);
+      writer.Append('\n');
 
       // Write out this entry's delta rules as 'STACK CFI' records.
       for (RuleChangeMap::const_iterator delta_it = entry->rule_changes.begin();
            delta_it != entry->rule_changes.end(); ++delta_it) {
-        stream << "STACK CFI " << hex
-               << (delta_it->first - load_address_) << " " << dec;
-        if (!stream.good()
-            || !WriteRuleMap(delta_it->second, stream))
-          return ReportError();
-
-        stream << endl;
+        writer.Append("STACK CFI ");
+        writer.AppendHex(delta_it->first - load_address_);
+        writer.Append(' ');
+        WriteRuleMap(delta_it->second, &writer);
+        writer.Append('\n');
       }
+      if (!writer.good())
+        return ReportError();
     }
   }
 
+  if (!writer.Flush())
+    return ReportError();
   return true;
 }
 
@@ -38,12 +38,17 @@
 #ifndef COMMON_LINUX_MODULE_H__
 #define COMMON_LINUX_MODULE_H__
 
+#include <stdio.h>
+
 #include <iostream>
 #include <map>
+#include <scoped_allocator>
 #include <set>
 #include <string>
 #include <vector>
 
+#include "common/arena.h"
+#include "common/scoped_ptr.h"
 #include "common/symbol_data.h"
 #include "common/using_std_string.h"
 #include "google_breakpad/common/breakpad_types.h"
@@ -135,16 +140,30 @@ class Module {
   // their their values. This can represent a complete set of rules to
   // follow at some address, or a set of changes to be applied to an
   // extant set of rules.
-  typedef map<string, string> RuleMap;
+  typedef map<string, string, std::less<string>,
+              ArenaAllocator<std::pair<const string, string> > > RuleMap;
 
   // A map from addresses to RuleMaps, representing changes that take
-  // effect at given addresses.
-  typedef map<Address, RuleMap> RuleChangeMap;
+  // effect at given addresses. The RuleMaps use the same allocator as
+  // the map holding them.
+  typedef map<Address, RuleMap, std::less<Address>,
+              std::scoped_allocator_adaptor<
+                  ArenaAllocator<std::pair<const Address, RuleMap> > > >
+      RuleChangeMap;
 
   // A range of 'STACK CFI' stack walking information. An instance of
   // this structure corresponds to a 'STACK CFI INIT' record and the
   // subsequent 'STACK CFI' records that fall within its range.
   struct StackFrameEntry {
+    StackFrameEntry() : address(0), size(0) { }
+
+    // Create an entry whose rules are stored in ARENA.
+    explicit StackFrameEntry(Arena *arena)
+        : address(0), size(0),
+          initial_rules(RuleMap::allocator_type(arena)),
+          rule_changes(RuleChangeMap::allocator_type(
+              RuleMap::allocator_type(arena))) { }
+
     // The starting address and number of bytes of machine code this
     // entry covers.
     Address address, size;
@@ -201,22 +220,93 @@ class Module {
   // destroying the module destroys them as well.
   void AddFunction(Function *function);
 
+  // Return a new Function named NAME at ADDRESS, allocated in an arena
+  // belonging to this module, so that it is made cheaply and its memory
+  // is freed all at once when the module is destroyed. If
+  // functions_on_heap() is true, it is allocated on the heap instead. The
+  // caller owns the Function until it passes it to AddFunction or
+  // AddFunctions, but must not let it outlive this module.
+  Function *NewFunction(const string &name, Address address);
+
+  // Destroy FUNCTION, which was made by this module's NewFunction or
+  // with new, and has not been added to this module.
+  void DeleteFunction(Function *function);
+
   // Add all the functions in [BEGIN,END) to the module.
   // This module owns all Function objects added with this function:
   // destroying the module destroys them as well.
   void AddFunctions(vector<Function *>::iterator begin,
                     vector<Function *>::iterator end);
 
+  // Move the functions added to OTHER into this module, as if they had
+  // been passed to AddFunctions in address order, leaving OTHER with none.
+  // Lines citing OTHER's files are pointed at this module's files of the
+  // same names, which are created as needed. This lets separate parts of
+  // a file be read into modules of their own, and then combined.
+  // This module takes over the arena of OTHER's functions along with
+  // them, so OTHER must not hold any it made with NewFunction and has
+  // not added.
+  void TakeFunctions(Module *other);
+
+  // Bound the memory used to hold this module's functions. Whenever a
+  // call to AddFunctions or TakeFunctions leaves more than MAX_RECORDS
+  // function and line records held in memory, write the functions held
+  // so far, sorted, to a temporary file in DIRECTORY, and free them.
+  // Write merges those files with the functions still in memory, and
+  // produces the same output as if every function had been kept. Once
+  // functions have been written out, GetFunctions can no longer be used.
+  // If a temporary file can't be created or written, report the problem
+  // and keep all further functions in memory.
+  void SetSpillDirectory(const string &directory, size_t max_records);
+
+  // True if some of this module's functions have been written out to
+  // temporary files, and are held only there (see SetSpillDirectory).
+  bool has_spilled_functions() const { return !spill_runs_.empty(); }
+
+  // Whether NewFunction allocates Functions on the heap, so that they can
+  // be freed one at a time, rather than in an arena. SetSpillDirectory
+  // turns this on, so that functions written to temporary files are
+  // freed. A module whose functions will be taken by such a module
+  // should turn it on too.
+  void set_functions_on_heap(bool on_heap) { functions_on_heap_ = on_heap; }
+  bool functions_on_heap() const { return functions_on_heap_; }
+
   // Add STACK_FRAME_ENTRY to the module.
   // This module owns all StackFrameEntry objects added with this
   // function: destroying the module destroys them as well.
   void AddStackFrameEntry(StackFrameEntry *stack_frame_entry);
 
+  // Return a new StackFrameEntry which, along with its rules, is stored
+  // in an arena belonging to this module, so that it is allocated
+  // cheaply and freed all at once when the module is destroyed. The
+  // caller owns the entry until it passes it to AddStackFrameEntry, but
+  // must not let it outlive this module.
+  StackFrameEntry *NewStackFrameEntry();
+
+  // Destroy ENTRY, which was made by this module's NewStackFrameEntry or
+  // with new, and has not been added to this module.
+  void DeleteStackFrameEntry(StackFrameEntry *entry);
+
+  // Move the StackFrameEntry objects added to OTHER onto the end of this
+  // module's, in the order they were added there, leaving OTHER with none.
+  // This module takes over OTHER's arenas along with them.
+  void TakeStackFrameEntries(Module *other);
+
   // Add PUBLIC to the module.
   // This module owns all Extern objects added with this function:
   // destroying the module destroys them as well.
   void AddExtern(Extern *ext);
 
+  // Return a new Extern at ADDRESS, allocated in an arena belonging to
+  // this module, like the Functions NewFunction returns. The caller owns
+  // the Extern until it passes it to AddExtern, but must not let it
+  // outlive this module.
+  Extern *NewExtern(Address address);
+
+  // Destroy EXT, which was made by this module's NewExtern or with new,
+  // and has not been added to this module.
+  void DeleteExtern(Extern *ext);
+
   // If this module has a file named NAME, return a pointer to it. If
   // it has none, then create one and return a pointer to the new
   // file. This module owns all File objects created using these
@@ -229,7 +319,10 @@ class Module {
   File *FindExistingFile(const string &name);
 
   // Insert pointers to the functions added to this module at I in
-  // VEC. The pointed-to Functions are still owned by this module.
+  // VEC. The pointed-to Functions are still owned by this module. This
+  // must not be called once functions have been written out to temporary
+  // files (see has_spilled_functions), as only those in memory could be
+  // returned.
   // (Since this is effectively a copy of the function list, this is
   // mostly useful for testing; other uses should probably get a more
   // appropriate interface.)
@@ -288,10 +381,45 @@ class Module {
   // errno to find the appropriate cause.  Return false.
   static bool ReportError();
 
-  // Write RULE_MAP to STREAM, in the form appropriate for 'STACK CFI'
-  // records, without a final newline. Return true if all goes well;
-  // if an error occurs, return false, and leave errno set.
-  static bool WriteRuleMap(const RuleMap &rule_map, std::ostream &stream);
+  // Formats symbol file records into a buffer, and writes them to a
+  // stream in large pieces. See module.cc.
+  class RecordWriter;
+
+  // Write RULE_MAP to WRITER, in the form appropriate for 'STACK CFI'
+  // records, without a final newline.
+  static void WriteRuleMap(const RuleMap &rule_map, RecordWriter *writer);
+
+  // Write FUNC and its lines to WRITER as 'FUNC' and line records.
+  // Return true if all goes well; if an error occurs, return false, and
+  // leave errno set.
+  bool WriteFunction(const Function *func, RecordWriter *writer);
+
+  // Write the functions in spill_runs_ and functions_ to WRITER, in
+  // FunctionCompare order, as WriteFunction would. Where equal functions
+  // appear in more than one place, write only the one added first, as
+  // AddFunction would have kept. If WRITER is NULL, only mark the files
+  // cited by the functions that would be written, as MarkFunctionFiles
+  // does. Return true if all goes well; report an error and return false
+  // otherwise.
+  bool WriteMergedFunctions(RecordWriter *writer);
+
+  // Mark the files cited by FUNC's lines as used, by setting their
+  // source ids to zero; see AssignSourceIds.
+  static void MarkFunctionFiles(const Function *func);
+
+  // If more than spill_limit_ function and line records are held in
+  // functions_, call SpillFunctions.
+  void SpillFunctionsIfNeeded();
+
+  // Write the functions held in functions_ to a new temporary file in
+  // spill_directory_, add it to spill_runs_, and free them. On failure,
+  // report the error, keep the functions, and stop spilling.
+  void SpillFunctions();
+
+  // Read the next function written to RUN by SpillFunctions, and return
+  // it; the caller takes ownership. Return NULL at the end of RUN, or if
+  // an error occurs.
+  Function *ReadSpilledFunction(FILE *run);
 
   // Module header entries.
   string name_, os_, architecture_, id_, code_id_;
@@ -312,10 +440,25 @@ class Module {
   typedef map<const string *, File *, CompareStringPtrs> FileByNameMap;
 
   // A set containing Function structures, sorted by address.
-  typedef set<Function *, FunctionCompare> FunctionSet;
+  typedef set<Function *, FunctionCompare, ArenaAllocator<Function *> >
+      FunctionSet;
 
   // A set containing Extern structures, sorted by address.
-  typedef set<Extern *, ExternCompare> ExternSet;
+  typedef set<Extern *, ExternCompare, ArenaAllocator<Extern *> > ExternSet;
+
+  // Return true if P points into one of ARENAS.
+  static bool InArenas(const vector<Arena *> &arenas, const void *p);
+
+  // The arenas holding the nodes of functions_ and externs_, which are
+  // freed all at once with the module. SpillFunctions replaces
+  // function_nodes_ whenever it empties functions_. extern_arena_ also
+  // holds the Externs made by NewExtern.
+  scoped_ptr<Arena> function_nodes_;
+  Arena extern_arena_;
+
+  // The arena holding the Functions made by NewFunction, here and in
+  // modules whose functions this one has taken.
+  Arena function_arena_;
 
   // The module owns all the files and functions that have been added
   // to it; destroying the module frees the Files and Functions these
@@ -323,10 +466,38 @@ class Module {
   FileByNameMap files_;    // This module's source files.
   FunctionSet functions_;  // This module's functions.
 
+  // The number of function and line records held in functions_.
+  size_t function_records_;
+
+  // Where to write functions held in memory, and how many function and
+  // line records to allow before doing so; see SetSpillDirectory. If
+  // spill_limit_ is zero, functions are all kept in memory.
+  string spill_directory_;
+  size_t spill_limit_;
+
+  // Whether NewFunction uses the heap; see set_functions_on_heap.
+  bool functions_on_heap_;
+
+  // Temporary files of functions written out of functions_, each sorted
+  // by FunctionCompare, in the order they were written. The module
+  // closes these when it is destroyed, which deletes them.
+  vector<FILE *> spill_runs_;
+
+  // The files cited by the lines in spill_runs_. Spilled lines refer to
+  // files by their index in spilled_files_.
+  vector<File *> spilled_files_;
+  map<const File *, uint32_t> spilled_file_ids_;
+
   // The module owns all the call frame info entries that have been
   // added to it.
   vector<StackFrameEntry *> stack_frame_entries_;
 
+  // The arenas holding the entries made by NewStackFrameEntry and their
+  // rules, here and in modules whose entries this one has taken. The
+  // module frees these after its entries. NewStackFrameEntry uses the
+  // last.
+  vector<Arena *> entry_arenas_;
+
   // The module owns all the externs that have been added to it;
   // destroying the module frees the Externs these point to.
   ExternSet externs_;
@@ -0,0 +1,270 @@
+// Copyright (c) 2026 Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// module_benchmark.cc: Measures how long it takes to build a large Module,
+// write it out as a symbol file, and destroy it.
+//
+// A synthetic module with many functions, each with a few lines and a
+// STACK CFI entry like a compiler would emit, is built twice: once with
+// its functions and entries made with new, so that they and the entries'
+// rules are allocated on the heap, and once with functions and entries
+// from Module::NewFunction and Module::NewStackFrameEntry, which are in
+// the module's arenas.  Both modules' symbol files are hashed, and the
+// hashes must agree.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <ostream>
+#include <streambuf>
+#include <string>
+
+#include "common/module.h"
+#include "common/path_helper.h"
+#include "common/using_std_string.h"
+
+namespace {
+
+using google_breakpad::Module;
+
+struct Options {
+  int functions;
+  int lines;
+  int iterations;
+};
+
+typedef std::chrono::steady_clock Clock;
+
+double MillisecondsSince(Clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(Clock::now() - start)
+      .count();
+}
+
+// A streambuf that keeps an FNV-1a hash of what is written to it, so
+// that symbol files can be compared without holding them in memory.
+class HashingStreamBuf : public std::streambuf {
+ public:
+  HashingStreamBuf() : hash_(0xcbf29ce484222325ULL) {}
+
+  uint64_t hash() const { return hash_; }
+
+ protected:
+  virtual int_type overflow(int_type c) {
+    if (c != traits_type::eof())
+      Add(static_cast<char>(c));
+    return traits_type::not_eof(c);
+  }
+
+  virtual std::streamsize xsputn(const char *s, std::streamsize n) {
+    for (std::streamsize i = 0; i < n; ++i)
+      Add(s[i]);
+    return n;
+  }
+
+ private:
+  void Add(char c) {
+    hash_ = (hash_ ^ static_cast<unsigned char>(c)) * 0x100000001b3ULL;
+  }
+
+  uint64_t hash_;
+};
+
+// Fills |module| with |options.functions| functions, laid out one after
+// another, each with |options.lines| lines and a STACK CFI entry.  Functions
+// and entries come from NewFunction and NewStackFrameEntry if |use_arena| is
+// true.
+void AddRecords(const Options &options, bool use_arena, Module *module) {
+  Module::File *files[64];
+  for (int i = 0; i < 64; ++i) {
+    char name[64];
+    snprintf(name, sizeof(name), "/src/project/module%d/file%d.cc", i % 8, i);
+    files[i] = module->FindFile(name);
+  }
+
+  const Module::Address kFunctionSize = 0x40;
+  Module::Address address = 0x10000;
+  for (int i = 0; i < options.functions; ++i) {
+    char name[128];
+    snprintf(name, sizeof(name),
+             "project::Class%d::Method%d(int, std::string const&)",
+             i % 977, i);
+    Module::Function *function = use_arena ?
+        module->NewFunction(name, address) :
+        new Module::Function(name, address);
+    function->size = kFunctionSize;
+    function->parameter_size = 0;
+    Module::Address line_size = kFunctionSize / options.lines;
+    for (int j = 0; j < options.lines; ++j) {
+      Module::Line line = { address + j * line_size, line_size,
+                            files[(i + j) % 64], 10 + (i + j) % 5000 };
+      function->lines.push_back(line);
+    }
+    module->AddFunction(function);
+
+    Module::StackFrameEntry *entry = use_arena ?
+        module->NewStackFrameEntry() : new Module::StackFrameEntry();
+    entry->address = address;
+    entry->size = kFunctionSize;
+    entry->initial_rules[".cfa"] = "$rsp 8 +";
+    entry->initial_rules[".ra"] = ".cfa -8 + ^";
+    entry->rule_changes[address + 1][".cfa"] = "$rsp 16 +";
+    entry->rule_changes[address + 4][".cfa"] = "$rbp 16 +";
+    entry->rule_changes[address + 4]["$rbp"] = ".cfa -16 + ^";
+    module->AddStackFrameEntry(entry);
+
+    address += kFunctionSize;
+  }
+}
+
+// Builds, writes and destroys a module |options.iterations| times,
+// printing the best time of each phase.  Returns the symbol file's hash.
+uint64_t RunBenchmark(const Options &options, const string &description,
+                      bool use_arena) {
+  double best_build_ms = 0, best_write_ms = 0, best_destroy_ms = 0;
+  uint64_t hash = 0;
+  for (int i = 0; i < options.iterations; ++i) {
+    Clock::time_point start = Clock::now();
+    Module *module = new Module("synthetic", "Linux", "x86_64",
+                                "000102030405060708090A0B0C0D0E0F0");
+    AddRecords(options, use_arena, module);
+    double build_ms = MillisecondsSince(start);
+
+    start = Clock::now();
+    HashingStreamBuf hashing_buf;
+    std::ostream stream(&hashing_buf);
+    module->Write(stream, ALL_SYMBOL_DATA);
+    double write_ms = MillisecondsSince(start);
+    hash = hashing_buf.hash();
+
+    start = Clock::now();
+    delete module;
+    double destroy_ms = MillisecondsSince(start);
+
+    if (i == 0 || build_ms < best_build_ms)
+      best_build_ms = build_ms;
+    if (i == 0 || write_ms < best_write_ms)
+      best_write_ms = write_ms;
+    if (i == 0 || destroy_ms < best_destroy_ms)
+      best_destroy_ms = destroy_ms;
+  }
+
+  printf("%s: best of %d runs\n", description.c_str(), options.iterations);
+  printf("  build:   %10.2f ms\n", best_build_ms);
+  printf("  write:   %10.2f ms\n", best_write_ms);
+  printf("  destroy: %10.2f ms\n", best_destroy_ms);
+  return hash;
+}
+
+//=============================================================================
+static void Usage(int argc, const char *argv[], bool error) {
+  fprintf(error ? stderr : stdout,
+          "Usage: %s [options]\n"
+          "\n"
+          "Time building, writing and destroying a synthetic Module.\n"
+          "\n"
+          "Options:\n"
+          "\n"
+          "  -f <count>  Functions, each with a STACK CFI entry "
+          "(default %d)\n"
+          "  -l <count>  Lines per function (default %d)\n"
+          "  -n <count>  Runs; the fastest of each phase is reported "
+          "(default %d)\n",
+          google_breakpad::BaseName(argv[0]).c_str(),
+          1000000, 4, 3);
+}
+
+static int ParseCount(int argc, const char *argv[], const char *value) {
+  char *end;
+  long count = strtol(value, &end, 10);
+  if (*value == '\0' || *end != '\0' || count <= 0 || count > 100000000) {
+    fprintf(stderr, "%s: Invalid count %s\n", argv[0], value);
+    Usage(argc, argv, true);
+    exit(1);
+  }
+  return static_cast<int>(count);
+}
+
+static void SetupOptions(int argc, const char *argv[], Options *options) {
+  int ch;
+
+  options->functions = 1000000;
+  options->lines = 4;
+  options->iterations = 3;
+
+  while ((ch = getopt(argc, (char * const *)argv, "f:hl:n:")) != -1) {
+    switch (ch) {
+      case 'h':
+        Usage(argc, argv, false);
+        exit(0);
+        break;
+
+      case 'f':
+        options->functions = ParseCount(argc, argv, optarg);
+        break;
+      case 'l':
+        options->lines = ParseCount(argc, argv, optarg);
+        if (options->lines > 64) {
+          fprintf(stderr, "%s: At most 64 lines per function\n", argv[0]);
+          exit(1);
+        }
+        break;
+      case 'n':
+        options->iterations = ParseCount(argc, argv, optarg);
+        break;
+
+      case '?':
+        Usage(argc, argv, true);
+        exit(1);
+        break;
+    }
+  }
+
+  if (optind != argc) {
+    Usage(argc, argv, true);
+    exit(1);
+  }
+}
+
+}  // namespace
+
+int main(int argc, const char *argv[]) {
+  Options options;
+  SetupOptions(argc, argv, &options);
+  printf("%d functions, %d lines each\n", options.functions, options.lines);
+
+  uint64_t heap_hash = RunBenchmark(options, "records on the heap", false);
+  uint64_t arena_hash = RunBenchmark(options, "records in arenas", true);
+  if (heap_hash != arena_hash) {
+    fprintf(stderr, "symbol files differ\n");
+    return 1;
+  }
+  return 0;
+}
@@ -42,6 +42,7 @@
 
 #include "breakpad_googletest_includes.h"
 #include "common/module.h"
+#include "common/tests/auto_tempdir.h"
 #include "common/using_std_string.h"
 
 using google_breakpad::Module;
@@ -386,6 +387,112 @@ TEST(Construct, AddFrames) {
   EXPECT_THAT(entries[2]->rule_changes, ContainerEq(entry3_changes));
 }
 
+// Entries from NewStackFrameEntry keep their rules in the module's arena,
+// which a module taking the entries must take along with them.
+TEST(Construct, TakeArenaFrames) {
+  stringstream s;
+  Module m(MODULE_NAME, MODULE_OS, MODULE_ARCH, MODULE_ID);
+
+  Module::StackFrameEntry *entry1 = new Module::StackFrameEntry();
+  entry1->address = 0x1000;
+  entry1->size = 0x100;
+  entry1->initial_rules[".cfa"] = "$rsp 8 +";
+  m.AddStackFrameEntry(entry1);
+
+  {
+    Module other(MODULE_NAME, MODULE_OS, MODULE_ARCH, MODULE_ID);
+    Module::StackFrameEntry *entry2 = other.NewStackFrameEntry();
+    entry2->address = 0x2000;
+    entry2->size = 0x200;
+    entry2->initial_rules[".cfa"] = "$rsp 8 +";
+    entry2->initial_rules[".ra"] = ".cfa -8 + ^";
+    entry2->rule_changes[0x2001][".cfa"] = "$rsp 16 +";
+    entry2->rule_changes[0x2004][".cfa"] = "$rbp 16 +";
+    entry2->rule_changes[0x2004]["$rbp"] = ".cfa -16 + ^";
+    other.AddStackFrameEntry(entry2);
+
+    // A copy of an arena entry has its own rules.
+    Module::StackFrameEntry *entry3 = new Module::StackFrameEntry(*entry2);
+    entry3->address = 0x3000;
+    m.AddStackFrameEntry(entry3);
+
+    m.TakeStackFrameEntries(&other);
+    vector<Module::StackFrameEntry *> entries;
+    other.GetStackFrameEntries(&entries);
+    EXPECT_TRUE(entries.empty());
+  }
+
+  m.Write(s, ALL_SYMBOL_DATA);
+  string contents = s.str();
+  EXPECT_STREQ("MODULE os-name architecture id-string name with spaces\n"
+               "STACK CFI INIT 1000 100 .cfa: $rsp 8 +\n"
+               "STACK CFI INIT 3000 200 .cfa: $rsp 8 + .ra: .cfa -8 + ^\n"
+               "STACK CFI 2001 .cfa: $rsp 16 +\n"
+               "STACK CFI 2004 $rbp: .cfa -16 + ^ .cfa: $rbp 16 +\n"
+               "STACK CFI INIT 2000 200 .cfa: $rsp 8 + .ra: .cfa -8 + ^\n"
+               "STACK CFI 2001 .cfa: $rsp 16 +\n"
+               "STACK CFI 2004 $rbp: .cfa -16 + ^ .cfa: $rbp 16 +\n",
+               contents.c_str());
+}
+
+TEST(Construct, TakeArenaFunctions) {
+  stringstream s;
+  Module m(MODULE_NAME, MODULE_OS, MODULE_ARCH, MODULE_ID);
+
+  Module::Function *function1 = m.NewFunction("_one", 0x1000);
+  function1->size = 0x100;
+  function1->parameter_size = 0;
+  m.AddFunction(function1);
+
+  // A heap extern that duplicates an arena extern is freed on the heap.
+  Module::Extern *extern1 = m.NewExtern(0x5000);
+  extern1->name = "_ext";
+  m.AddExtern(extern1);
+  Module::Extern *extern2 = new Module::Extern(0x5000);
+  extern2->name = "_dup";
+  m.AddExtern(extern2);
+
+  // Records that are never added can be discarded.
+  m.DeleteFunction(m.NewFunction("_unused", 0x6000));
+  m.DeleteExtern(m.NewExtern(0x6000));
+  m.DeleteStackFrameEntry(m.NewStackFrameEntry());
+
+  {
+    Module other(MODULE_NAME, MODULE_OS, MODULE_ARCH, MODULE_ID);
+    Module::File *file = other.FindFile("filename");
+    Module::Function *function2 = other.NewFunction("_two", 0x2000);
+    function2->size = 0x100;
+    function2->parameter_size = 0;
+    Module::Line line = { 0x2000, 0x100, file, 12 };
+    function2->lines.push_back(line);
+    other.AddFunction(function2);
+
+    // A duplicate of a function M already has, which M frees.
+    Module::Function *function3 = other.NewFunction("_one", 0x1000);
+    function3->size = 0x100;
+    function3->parameter_size = 0;
+    other.AddFunction(function3);
+
+    m.TakeFunctions(&other);
+  }
+
+  m.Write(s, ALL_SYMBOL_DATA);
+  string contents = s.str();
+  EXPECT_STREQ("MODULE os-name architecture id-string name with spaces\n"
+               "FILE 0 filename\n"
+               "FUNC 1000 100 0 _one\n"
+               "FUNC 2000 100 0 _two\n"
+               "2000 100 12 0\n"
+               "PUBLIC 5000 0 _ext\n",
+               contents.c_str());
+
+  // Once functions may be written to temporary files, NewFunction uses
+  // the heap.
+  EXPECT_FALSE(m.functions_on_heap());
+  m.SetSpillDirectory(".", 1000);
+  EXPECT_TRUE(m.functions_on_heap());
+}
+
 TEST(Construct, UniqueFiles) {
   Module m(MODULE_NAME, MODULE_OS, MODULE_ARCH, MODULE_ID);
   Module::File *file1 = m.FindFile("foo");
@@ -439,6 +546,118 @@ TEST(Construct, FunctionsWithSameAddress) {
                contents.c_str());
 }
 
+// Functions taken from another module should cite this module's files,
+// and be written out just as if they had been added here directly.
+TEST(Construct, TakeFunctions) {
+  stringstream s;
+  Module m(MODULE_NAME, MODULE_OS, MODULE_ARCH, MODULE_ID);
+  Module other(MODULE_NAME, MODULE_OS, MODULE_ARCH, MODULE_ID);
+
+  Module::File *file1 = m.FindFile("filename1");
+  Module::Function *function1 = new Module::Function("_one", 0x2000);
+  function1->size = 0x100;
+  function1->parameter_size = 0;
+  Module::Line line1 = { 0x2000, 0x100, file1, 10 };
+  function1->lines.push_back(line1);
+  m.AddFunction(function1);
+
+  Module::File *other_file1 = other.FindFile("filename1");
+  Module::File *other_file2 = other.FindFile("filename2");
+  Module::Function *function2 = new Module::Function("_two", 0x1000);
+  function2->size = 0x80;
+  function2->parameter_size = 0;
+  Module::Line line2 = { 0x1000, 0x40, other_file2, 20 };
+  Module::Line line3 = { 0x1040, 0x40, other_file1, 30 };
+  function2->lines.push_back(line2);
+  function2->lines.push_back(line3);
+  other.AddFunction(function2);
+
+  m.TakeFunctions(&other);
+
+  vector<Module::Function *> other_functions;
+  other.GetFunctions(&other_functions, other_functions.end());
+  EXPECT_TRUE(other_functions.empty());
+  EXPECT_EQ(file1, function2->lines[1].file);
+  EXPECT_EQ(m.FindExistingFile("filename2"), function2->lines[0].file);
+
+  m.Write(s, ALL_SYMBOL_DATA);
+  string contents = s.str();
+  EXPECT_STREQ("MODULE os-name architecture id-string name with spaces\n"
+               "FILE 0 filename1\n"
+               "FILE 1 filename2\n"
+               "FUNC 1000 80 0 _two\n"
+               "1000 40 20 1\n"
+               "1040 40 30 0\n"
+               "FUNC 2000 100 0 _one\n"
+               "2000 100 10 0\n",
+               contents.c_str());
+}
+
+// Functions written out to temporary files should be merged back with
+// those held in memory, producing the same output as if none had been,
+// and keeping the first of any duplicates added.
+TEST(Construct, SpillFunctions) {
+  google_breakpad::AutoTempDir temp_dir;
+  stringstream s;
+  Module m(MODULE_NAME, MODULE_OS, MODULE_ARCH, MODULE_ID);
+  m.SetSpillDirectory(temp_dir.path(), 2);
+
+  Module::File *file0 = m.FindFile("filename0");  // cited only by a dup
+  Module::File *file1 = m.FindFile("filename1");
+  Module::File *file2 = m.FindFile("filename2");
+  m.FindFile("filename3");  // not used by any line
+
+  // A function with two lines: more than two records, so it is spilled.
+  vector<Module::Function *> vec;
+  Module::Function *function1 = new Module::Function("_one", 0x3000);
+  function1->size = 0x100;
+  function1->parameter_size = 0;
+  Module::Line line1 = { 0x3000, 0x80, file2, 10 };
+  Module::Line line2 = { 0x3080, 0x80, file1, 11 };
+  function1->lines.push_back(line1);
+  function1->lines.push_back(line2);
+  vec.push_back(function1);
+  EXPECT_FALSE(m.has_spilled_functions());
+  m.AddFunctions(vec.begin(), vec.end());
+  EXPECT_TRUE(m.has_spilled_functions());
+
+  // A duplicate of the spilled function, which should be dropped along
+  // with the only line citing file0, and another function; these are
+  // spilled to a second file.
+  vec.clear();
+  Module::Function *function2 = new Module::Function("_one", 0x3000);
+  function2->size = 0x200;
+  function2->parameter_size = 0;
+  Module::Line line3 = { 0x3000, 0x200, file0, 20 };
+  function2->lines.push_back(line3);
+  vec.push_back(function2);
+  Module::Function *function3 = new Module::Function("_two", 0x1000);
+  function3->size = 0x10;
+  function3->parameter_size = 0x8;
+  vec.push_back(function3);
+  m.AddFunctions(vec.begin(), vec.end());
+
+  // A function that stays in memory.
+  vec.clear();
+  Module::Function *function4 = new Module::Function("_three", 0x2000);
+  function4->size = 0x20;
+  function4->parameter_size = 0;
+  vec.push_back(function4);
+  m.AddFunctions(vec.begin(), vec.end());
+
+  m.Write(s, ALL_SYMBOL_DATA);
+  string contents = s.str();
+  EXPECT_STREQ("MODULE os-name architecture id-string name with spaces\n"
+               "FILE 0 filename1\n"
+               "FILE 1 filename2\n"
+               "FUNC 1000 10 8 _two\n"
+               "FUNC 2000 20 0 _three\n"
+               "FUNC 3000 100 0 _one\n"
+               "3000 80 10 1\n"
+               "3080 80 11 0\n",
+               contents.c_str());
+}
+
 // Externs should be written out as PUBLIC records, sorted by
 // address.
 TEST(Construct, Externs) {
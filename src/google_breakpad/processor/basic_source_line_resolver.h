@@ -56,14 +56,46 @@ class BasicSourceLineResolver : public SourceLineResolverBase {
   using SourceLineResolverBase::LoadModule;
   using SourceLineResolverBase::LoadModuleUsingMapBuffer;
   using SourceLineResolverBase::LoadModuleUsingMemoryBuffer;
-  using SourceLineResolverBase::ShouldDeleteMemoryBufferAfterLoadModule;
   using SourceLineResolverBase::UnloadModule;
+  using SourceLineResolverBase::TakeUnloadedModules;
   using SourceLineResolverBase::HasModule;
   using SourceLineResolverBase::IsModuleCorrupt;
   using SourceLineResolverBase::FillSourceLineInfo;
+  using SourceLineResolverBase::FillSourceLineInfoSharingNames;
   using SourceLineResolverBase::FindWindowsFrameInfo;
   using SourceLineResolverBase::FindCFIFrameInfo;
 
+  // Sets the number of threads used to parse a symbol file when a module
+  // is loaded.  Large files are split into chunks of whole lines that are
+  // parsed concurrently; the loaded module is the same as with a single
+  // thread.  A value of 0 or 1, the default, parses on the calling thread.
+  void set_max_parse_threads(unsigned int max_threads);
+  unsigned int max_parse_threads() const;
+
+  // Enables lazy loading of symbol files, which must be chosen before any
+  // modules are loaded.  A lazy load only indexes the FUNC, PUBLIC and
+  // STACK CFI records, pointing into the symbol data, which is then kept
+  // until the module is unloaded; a function's LINE records are parsed the
+  // first time it is looked up.  This makes loading much cheaper when only
+  // a few addresses in a large module are ever looked up.  Malformed LINE
+  // records are not detected, so they don't make the module corrupt, and
+  // lookups on lazily loaded modules must not run concurrently.
+  void set_lazy_loading(bool lazy);
+  bool lazy_loading() const;
+
+  // Stores each module's functions, and each function's lines, in sorted
+  // arrays rather than trees, which must be chosen before any modules are
+  // loaded.  This takes much less memory, and lookups are as fast or
+  // faster, but symbol files whose records aren't in address order load
+  // slowly.  Lookups give the same results either way.
+  void set_compact_range_maps(bool compact);
+  bool compact_range_maps() const;
+
+  // Lazily loaded modules point into the symbol data they were loaded from.
+  // This changes with set_lazy_loading, so callers must ask after each
+  // load; modules already loaded keep the buffers they kept.
+  virtual bool ShouldDeleteMemoryBufferAfterLoadModule();
+
  private:
   // friend declarations:
   friend class BasicModuleFactory;
@@ -130,7 +162,8 @@ class SymbolParseHelper {
                                 char **name);            // out
 
  private:
-  // Used for success checks after strtoull and strtol.
+  // Used for success checks after parsing a number: the number must be
+  // followed by whitespace or the end of the string.
   static bool IsValidAfterNumber(char *after_number);
 
   // Only allow static methods.
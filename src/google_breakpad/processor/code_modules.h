@@ -46,6 +46,12 @@ namespace google_breakpad {
 
 class CodeModule;
 
+// The Get methods and module_count are const lookups, which callers may
+// make on one CodeModules object from several threads at once, such as
+// when MinidumpProcessor walks stacks concurrently.  Implementations that
+// remember anything in them, such as a hint for the next lookup, must do so
+// safely.  Copy and GetShrunkRangeModules copy linked_ptrs, which isn't
+// safe to do from several threads at once.
 class CodeModules {
  public:
   virtual ~CodeModules() {}
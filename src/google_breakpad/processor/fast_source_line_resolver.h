@@ -35,7 +35,9 @@
 // difference is FastSourceLineResolver loads a serialized memory chunk of data
 // which can be used directly a Module without parsing or copying of underlying
 // data.  Therefore loading a symbol in FastSourceLineResolver is much faster
-// and more memory-efficient than BasicSourceLineResolver.
+// and more memory-efficient than BasicSourceLineResolver.  Serialized symbol
+// files can also be mapped in place with LoadModuleUsingMappedFile, which
+// avoids reading them into the heap at all.
 //
 // See "source_line_resolver_base.h" and
 // "google_breakpad/source_line_resolver_interface.h" for more reference.
@@ -60,13 +62,16 @@ class FastSourceLineResolver : public SourceLineResolverBase {
   virtual ~FastSourceLineResolver() { }
 
   using SourceLineResolverBase::FillSourceLineInfo;
+  using SourceLineResolverBase::FillSourceLineInfoSharingNames;
   using SourceLineResolverBase::FindCFIFrameInfo;
   using SourceLineResolverBase::FindWindowsFrameInfo;
   using SourceLineResolverBase::HasModule;
   using SourceLineResolverBase::IsModuleCorrupt;
   using SourceLineResolverBase::LoadModule;
   using SourceLineResolverBase::LoadModuleUsingMapBuffer;
+  using SourceLineResolverBase::LoadModuleUsingMappedFile;
   using SourceLineResolverBase::LoadModuleUsingMemoryBuffer;
+  using SourceLineResolverBase::TakeUnloadedModules;
   using SourceLineResolverBase::UnloadModule;
 
  private:
@@ -85,6 +85,7 @@
 #include <unistd.h>
 #endif
 
+#include <atomic>
 #include <iostream>
 #include <map>
 #include <string>
@@ -108,6 +109,8 @@ using std::vector;
 
 
 class Minidump;
+class MinidumpPageCache;
+template<typename AddressType, typename EntryType> class CompactRangeMap;
 template<typename AddressType, typename EntryType> class RangeMap;
 
 
@@ -225,7 +228,8 @@ class MinidumpMemoryRegion : public MinidumpObject,
   // The size, in bytes, of the memory region.
   uint32_t GetSize() const;
 
-  // Frees the cached memory region, if cached.
+  // Frees the cached memory region, if cached.  When the minidump is
+  // memory mapped, this only forgets the pointer into the mapping.
   void FreeMemory();
 
   // Obtains the value of memory at the pointer specified by address.
@@ -266,6 +270,10 @@ class MinidumpMemoryRegion : public MinidumpObject,
 
   // Cached memory.
   mutable vector<uint8_t>* memory_;
+
+  // Memory served directly out of the minidump's file mapping, set instead
+  // of memory_ when the minidump is memory mapped.  Not owned.
+  mutable const uint8_t* mapped_memory_;
 };
 
 
@@ -479,9 +487,15 @@ class MinidumpModule : public MinidumpObject,
   // Cached CodeView record - this is MDCVInfoPDB20 or (likely)
   // MDCVInfoPDB70, or possibly something else entirely.  Stored as a uint8_t
   // because the structure contains a variable-sized string and its exact
-  // size cannot be known until it is processed.
+  // size cannot be known until it is processed.  Only allocated when the
+  // record had to be copied out of the minidump.
   vector<uint8_t>* cv_record_;
 
+  // The cached CodeView record's bytes: either cv_record_'s storage or,
+  // for a memory-mapped minidump that needs no byte-swapping, the record
+  // in place in the mapping.  NULL if the record has not been cached.
+  const uint8_t* cv_record_data_;
+
   // If cv_record_ is present, cv_record_signature_ contains a copy of the
   // CodeView record's first four bytes, for ease of determinining the
   // type of structure that cv_record_ contains.
@@ -489,8 +503,12 @@ class MinidumpModule : public MinidumpObject,
 
   // Cached MDImageDebugMisc (usually not present), stored as uint8_t
   // because the structure contains a variable-sized string and its exact
-  // size cannot be known until it is processed.
+  // size cannot be known until it is processed.  Like cv_record_, only
+  // allocated when the record had to be copied.
   vector<uint8_t>* misc_record_;
+
+  // The cached MDImageDebugMisc, in misc_record_ or in the mapping.
+  const MDImageDebugMisc* misc_record_data_;
 };
 
 
@@ -545,8 +563,13 @@ class MinidumpModuleList : public MinidumpStream,
   // default is 1024.
   static uint32_t max_modules_;
 
-  // Access to modules using addresses as the key.
-  RangeMap<uint64_t, unsigned int> *range_map_;
+  // Access to modules using addresses as the key.  Built once by Read.
+  CompactRangeMap<uint64_t, unsigned int> *range_map_;
+
+  // The index in range_map_ of the module GetModuleForAddress last found,
+  // checked before searching again.  Threads looking up modules at once
+  // may overwrite each other's hint, so it's loaded and stored relaxed.
+  mutable std::atomic<int> last_hit_index_;
 
   MinidumpModules *modules_;
   uint32_t module_count_;
@@ -1149,6 +1172,39 @@ class Minidump {
 
   virtual ~Minidump();
 
+  // When set, a minidump opened from a path is read through a read-only
+  // memory mapping of the whole file instead of an istream.  Stream reads
+  // become plain copies out of the mapping.  MinidumpMemoryRegion, and
+  // MinidumpModule's CodeView and miscellaneous debugging records when
+  // they need no byte-swapping, return pointers into the mapping rather
+  // than copying the data into the heap.  Contexts and other fixed-size
+  // structures are still copied.  Must be set before Read().  Has no
+  // effect on a Minidump
+  // constructed from an istream, or on platforms without mmap.
+  void set_use_memory_mapping(bool use_memory_mapping) {
+    use_memory_mapping_ = use_memory_mapping;
+  }
+  bool use_memory_mapping() const { return use_memory_mapping_; }
+
+  // True if the minidump file is currently accessed through a mapping.
+  bool IsMemoryMapped() const { return mapped_data_ != NULL; }
+
+  // When set with a nonzero max_pages, MinidumpMemoryRegion reads memory
+  // through a cache of at most max_pages pages of page_size bytes, shared
+  // by all of the minidump's regions, instead of reading each region into
+  // the heap whole on first access.  This bounds the memory held for
+  // region data regardless of the size of the minidump or its regions,
+  // which may then exceed MinidumpMemoryRegion::max_bytes().  Only
+  // MinidumpMemoryRegion::GetMemory, which must return the whole region,
+  // still reads it whole.  Setting max_pages to 0 turns paging off.  Must
+  // be set before any memory is read.  A minidump that is memory mapped,
+  // either already or when it is read, doesn't use the cache, as the
+  // mapping is already paged in on demand; the cache is then freed.
+  void set_memory_page_cache(uint32_t page_size, size_t max_pages);
+
+  // True if memory regions are read through the page cache.
+  bool IsMemoryPaged() const { return page_cache_ != NULL; }
+
   // path may be empty if the minidump was not opened from a file
   virtual string path() const {
     return path_;
@@ -1223,6 +1279,20 @@ class Minidump {
   // Returns the current position of the minidump file.
   off_t Tell();
 
+  // Returns a pointer to count bytes at offset in the memory-mapped
+  // minidump file, without copying and without moving the file position.
+  // Returns NULL if the minidump is not memory mapped or if the range does
+  // not lie entirely within the file.  The returned data is in the
+  // minidump's byte order and remains valid as long as the Minidump object.
+  const uint8_t* GetMappedBytes(off_t offset, size_t count) const;
+
+  // Copies count bytes at offset in the minidump file into bytes through
+  // the page cache, reading pages no further than limit.  Unlike ReadBytes,
+  // this may be called from several threads at once, as long as nothing
+  // else reads the minidump meanwhile.  Returns false if the minidump
+  // isn't paged or the bytes couldn't be read.
+  bool ReadPagedBytes(off_t offset, off_t limit, void* bytes, size_t count);
+
   // Medium-level I/O routines.
 
   // ReadString returns a string which is owned by the caller!  offset
@@ -1286,6 +1356,13 @@ class Minidump {
   // Opens the minidump file, or if already open, seeks to the beginning.
   bool Open();
 
+  // Maps the file at path_ into mapped_data_.  Returns false if the file
+  // could not be mapped, in which case Open falls back to an istream.
+  bool MapFile();
+
+  // Releases the mapping established by MapFile, if any.
+  void UnmapFile();
+
   // The largest number of top-level streams that will be read from a minidump.
   // Note that streams are only read (and only consume memory) as needed,
   // when directed by the caller.  The default is 128.
@@ -1313,6 +1390,21 @@ class Minidump {
   // Set based on the path in Open, or directly in the constructor.
   std::istream*             stream_;
 
+  // Whether Open should try to memory map path_, set by
+  // set_use_memory_mapping.
+  bool                      use_memory_mapping_;
+
+  // The read-only mapping of the minidump file when memory mapped, its
+  // size, and the file position used by ReadBytes and SeekSet in place of
+  // stream_'s.  mapped_data_ is NULL when the minidump is not mapped.
+  const uint8_t*            mapped_data_;
+  size_t                    mapped_size_;
+  size_t                    mapped_position_;
+
+  // The pages read by ReadPagedBytes, set by set_memory_page_cache.  NULL
+  // when memory isn't paged.
+  MinidumpPageCache*        page_cache_;
+
   // swap_ is true if the minidump file should be byte-swapped.  If the
   // minidump was produced by a CPU that is other-endian than the CPU
   // processing the minidump, this will be true.  If the two CPUs are
@@ -127,6 +127,34 @@ class MinidumpProcessor {
 
   void set_enable_objdump(bool enabled) { enable_objdump_ = enabled; }
 
+  // Sets the number of threads used to walk the stacks of the threads in a
+  // minidump.  With the default of 1, stacks are walked one after another on
+  // the calling thread.  With more, the minidump is read up front and the
+  // stack walks run on a pool of at most max_threads threads, producing the
+  // same ProcessState as a sequential walk.  Loading symbols, and so every
+  // call into the symbol supplier, is done by one walk at a time, with the
+  // others waiting.  Lookups in loaded modules run side by side if the
+  // StackFrameSymbolizer and its resolver support concurrent lookups, as
+  // the resolvers here do (see
+  // StackFrameSymbolizer::FillSourceLineInfoFromLoadedModule); otherwise
+  // they too are made one at a time.
+  void set_max_stackwalk_threads(unsigned int max_threads) {
+    max_stackwalk_threads_ = max_threads ? max_threads : 1;
+  }
+  unsigned int max_stackwalk_threads() const { return max_stackwalk_threads_; }
+
+  // When set, only the requesting thread, which is the crashed thread in a
+  // dump written for a crash, is walked and placed in the ProcessState.  The
+  // other threads' contexts and stacks aren't read, and the memory list is
+  // only read if the requesting thread's stack must be found in it.  This
+  // suits triage, which only needs the crash and the modules.  A dump that
+  // doesn't identify a requesting thread, or whose requesting thread isn't
+  // in its thread list, still has all of its threads walked.
+  void set_crashing_thread_only(bool crashing_thread_only) {
+    crashing_thread_only_ = crashing_thread_only;
+  }
+  bool crashing_thread_only() const { return crashing_thread_only_; }
+
  private:
   StackFrameSymbolizer* frame_symbolizer_;
   // Indicate whether resolver_helper_ is owned by this instance.
@@ -140,6 +168,12 @@ class MinidumpProcessor {
   // This flag permits the exploitability scanner to shell out to objdump
   // for purposes of disassembly.
   bool enable_objdump_;
+
+  // The largest number of threads used to walk stacks concurrently.
+  unsigned int max_stackwalk_threads_;
+
+  // Whether to walk only the requesting thread.
+  bool crashing_thread_only_;
 };
 
 }  // namespace google_breakpad
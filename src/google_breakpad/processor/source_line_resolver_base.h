@@ -41,9 +41,12 @@
 #ifndef GOOGLE_BREAKPAD_PROCESSOR_SOURCE_LINE_RESOLVER_BASE_H__
 #define GOOGLE_BREAKPAD_PROCESSOR_SOURCE_LINE_RESOLVER_BASE_H__
 
+#include <list>
 #include <map>
+#include <mutex>
 #include <set>
 #include <string>
+#include <vector>
 
 #include "google_breakpad/processor/source_line_resolver_interface.h"
 
@@ -68,6 +71,43 @@ class SourceLineResolverBase : public SourceLineResolverInterface {
                              char **symbol_data,
                              size_t *symbol_data_size);
 
+  // Bounds the memory that loaded modules take to about |max_bytes|.  Each
+  // module counts as its own estimate of the memory its parsed records
+  // take, plus the buffer or file it was loaded from if it keeps that.
+  // The estimate is rough: it assumes typical heap and std::map overheads,
+  // counts a mapped file in full though only the pages used are read in,
+  // and leaves out the bounded per-module CFI rule cache.  Lookups can add
+  // to a module's memory, by parsing a lazily loaded function or sharing a
+  // name with a frame; that growth is counted at the next load or
+  // set_symbol_data_budget call.
+  // Whenever a load takes the total over the budget, the least recently
+  // used modules are unloaded until it fits again; the module just loaded
+  // is always kept.  Modules unloaded whose memory buffers the resolver did
+  // not own are reported by TakeUnloadedModules, so that whoever supplied
+  // them can free them.  Zero, the default, means no budget.
+  void set_symbol_data_budget(size_t max_bytes);
+  size_t symbol_data_budget() const { return symbol_data_budget_; }
+
+  // The estimated memory taken by all loaded modules, as counted against
+  // symbol_data_budget().
+  size_t loaded_symbol_data() const;
+
+  // Module cache statistics.  HasModule counts a hit when the module is
+  // loaded and a miss when it is not; an eviction is counted each time a
+  // module is unloaded to stay within symbol_data_budget().
+  uint64_t module_cache_hits() const { return module_cache_hits_; }
+  uint64_t module_cache_misses() const { return module_cache_misses_; }
+  uint64_t module_cache_evictions() const { return module_cache_evictions_; }
+
+  // CFI rule cache statistics, summed over every module loaded so far,
+  // including unloaded ones.  Each module caches the CFI rule sets it
+  // builds, and remembers which rule set each instruction address looked
+  // up used.  FindCFIFrameInfo counts a hit when it answers from that
+  // cache, and a miss when it must build the rule set from the module's
+  // STACK CFI records.  Lookups outside any CFI are counted as neither.
+  uint64_t cfi_cache_hits() const;
+  uint64_t cfi_cache_misses() const;
+
  protected:
   // Users are not allowed create SourceLineResolverBase instance directly.
   SourceLineResolverBase(ModuleFactory *module_factory);
@@ -82,11 +122,24 @@ class SourceLineResolverBase : public SourceLineResolverInterface {
                                            size_t memory_buffer_size);
   virtual bool ShouldDeleteMemoryBufferAfterLoadModule();
   virtual void UnloadModule(const CodeModule *module);
+  virtual void TakeUnloadedModules(std::vector<string> *code_files);
+
+  // Maps |map_file| read-only and loads the module straight from the mapping,
+  // which is kept until the module is unloaded.  Nothing is copied, and the
+  // pages are shared with every other process mapping the same file.  Only
+  // for resolvers whose modules keep, and never write to, the memory buffer
+  // they were loaded from; see ShouldDeleteMemoryBufferAfterLoadModule.
+  virtual bool LoadModuleUsingMappedFile(const CodeModule *module,
+                                         const string &map_file);
+
   virtual bool HasModule(const CodeModule *module);
+  virtual bool IsModuleLoaded(const CodeModule *module);
   virtual bool IsModuleCorrupt(const CodeModule *module);
   virtual void FillSourceLineInfo(StackFrame *frame);
+  virtual bool FillSourceLineInfoSharingNames(StackFrame *frame);
   virtual WindowsFrameInfo *FindWindowsFrameInfo(const StackFrame *frame);
   virtual CFIFrameInfo *FindCFIFrameInfo(const StackFrame *frame);
+  virtual bool SupportsConcurrentLookups() { return true; }
 
   // Nested structs and classes.
   struct Line;
@@ -118,6 +171,58 @@ class SourceLineResolverBase : public SourceLineResolverInterface {
   // ModuleFactory needs to have access to protected type Module.
   friend class ModuleFactory;
 
+  // Loaded modules by code file, most recently used first.
+  typedef std::list<string> ModuleUseList;
+  struct ModuleUsage {
+    ModuleUseList::iterator position;
+    Module *module;
+    size_t buffer_size;
+    // Whether the module keeps the memory buffer it was loaded from, as
+    // ShouldDeleteMemoryBufferAfterLoadModule said when it was loaded.
+    bool keeps_buffer;
+  };
+  typedef map<string, ModuleUsage, CompareString> ModuleUsageMap;
+
+  // Files mapped by LoadModuleUsingMappedFile, by code file.
+  struct MappedFile {
+    void *data;
+    size_t size;
+  };
+  typedef map<string, MappedFile, CompareString> MappedFileMap;
+
+  // Unloads the module for |code_file| and releases everything held for it.
+  void UnloadModuleByCodeFile(const string &code_file);
+
+  // Marks the module for |code_file| as the most recently used one.  Only
+  // done while a budget is set, since nothing else reads the order.
+  // Lookups call it, so it takes module_use_mutex_.
+  void TouchModule(const string &code_file);
+
+  // Returns the memory counted against the budget for a loaded module.
+  static size_t ModuleMemoryUsage(const ModuleUsage &usage);
+
+  // Unloads least recently used modules, other than the one for |keep|,
+  // until loaded_symbol_data() is within symbol_data_budget_.
+  void EnforceSymbolDataBudget(const string &keep);
+
+  // Guards module_use_list_ and the module cache hit and miss counts
+  // against concurrent lookups; loads and unloads don't run alongside them.
+  std::mutex module_use_mutex_;
+  ModuleUseList module_use_list_;
+  ModuleUsageMap module_usage_;
+
+  // Code files for TakeUnloadedModules to report.
+  std::vector<string> unloaded_modules_;
+  MappedFileMap mapped_files_;
+  size_t symbol_data_budget_;
+  uint64_t module_cache_hits_;
+  uint64_t module_cache_misses_;
+  uint64_t module_cache_evictions_;
+
+  // CFI rule cache statistics of modules that have been unloaded.
+  uint64_t unloaded_cfi_cache_hits_;
+  uint64_t unloaded_cfi_cache_misses_;
+
   // Disallow unwanted copy ctor and assignment operator
   SourceLineResolverBase(const SourceLineResolverBase&);
   void operator=(const SourceLineResolverBase&);
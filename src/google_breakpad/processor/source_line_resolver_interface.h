@@ -35,6 +35,7 @@
 #define GOOGLE_BREAKPAD_PROCESSOR_SOURCE_LINE_RESOLVER_INTERFACE_H__
 
 #include <string>
+#include <vector>
 
 #include "common/using_std_string.h"
 #include "google_breakpad/common/breakpad_types.h"
@@ -79,13 +80,37 @@ class SourceLineResolverInterface {
   // alive during the lifetime of the corresponding Module.
   virtual bool ShouldDeleteMemoryBufferAfterLoadModule() = 0;
 
+  // Adds a module loaded in place from map_file, which is mapped read-only
+  // and kept mapped until the module is unloaded, instead of being read
+  // into a buffer.  Returns false if the module could not be loaded that
+  // way, including when this resolver cannot load modules from a mapping at
+  // all, which is the default; the caller may still load it another way.
+  virtual bool LoadModuleUsingMappedFile(const CodeModule * /* module */,
+                                         const string & /* map_file */) {
+    return false;
+  }
+
   // Request that the specified module be unloaded from this resolver.
   // A resolver may choose to ignore such a request.
   virtual void UnloadModule(const CodeModule *module) = 0;
 
+  // Appends to code_files the code files of the modules this resolver has
+  // unloaded on its own since the last call, such as to stay within a
+  // symbol data budget, and that were loaded from memory buffers it was
+  // passed but did not own (see ShouldDeleteMemoryBufferAfterLoadModule).
+  // Those buffers may now be freed.
+  virtual void TakeUnloadedModules(std::vector<string> * /* code_files */) {}
+
   // Returns true if the module has been loaded.
   virtual bool HasModule(const CodeModule *module) = 0;
 
+  // Returns true if the module has been loaded, as HasModule does, but
+  // without counting as a use of the module, in cache statistics or in
+  // choosing which modules to unload.  By default, just calls HasModule.
+  virtual bool IsModuleLoaded(const CodeModule *module) {
+    return HasModule(module);
+  }
+
   // Returns true if the module has been loaded and it is corrupt.
   virtual bool IsModuleCorrupt(const CodeModule *module) = 0;
 
@@ -94,6 +119,17 @@ class SourceLineResolverInterface {
   // module_name fields must already be filled in.
   virtual void FillSourceLineInfo(StackFrame *frame) = 0;
 
+  // As FillSourceLineInfo, except that the function and source file names
+  // go in the StackFrame's interned_function_name and
+  // interned_source_file_name, which then share the resolver's own copy
+  // of each name, rather than being copied into function_name and
+  // source_file_name.  Returns false, filling in nothing, if this resolver
+  // cannot share its names, which is the default; the caller may then
+  // call FillSourceLineInfo instead.
+  virtual bool FillSourceLineInfoSharingNames(StackFrame * /* frame */) {
+    return false;
+  }
+
   // If Windows stack walking information is available covering
   // FRAME's instruction address, return a WindowsFrameInfo structure
   // describing it. If the information is not available, returns NULL.
@@ -107,6 +143,13 @@ class SourceLineResolverInterface {
   // returned CFIFrameInfo object.
   virtual CFIFrameInfo *FindCFIFrameInfo(const StackFrame *frame) = 0;
 
+  // Returns true if lookups, that is HasModule, IsModuleLoaded,
+  // IsModuleCorrupt, FillSourceLineInfo, FillSourceLineInfoSharingNames,
+  // FindWindowsFrameInfo and FindCFIFrameInfo, may be made from several
+  // threads at once, provided nothing else is called meanwhile, such as to
+  // load or unload a module.  False by default.
+  virtual bool SupportsConcurrentLookups() { return false; }
+
  protected:
   // SourceLineResolverInterface cannot be instantiated except by subclasses
   SourceLineResolverInterface() {}
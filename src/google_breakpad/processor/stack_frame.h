@@ -30,6 +30,7 @@
 #ifndef GOOGLE_BREAKPAD_PROCESSOR_STACK_FRAME_H__
 #define GOOGLE_BREAKPAD_PROCESSOR_STACK_FRAME_H__
 
+#include <memory>
 #include <string>
 
 #include "common/using_std_string.h"
@@ -62,6 +63,8 @@ struct StackFrame {
         source_file_name(),
         source_line(),
         source_line_base(),
+        interned_function_name(),
+        interned_source_file_name(),
         trust(FRAME_TRUST_NONE) {}
   virtual ~StackFrame() {}
 
@@ -90,6 +93,16 @@ struct StackFrame {
   // register. See the comments for 'instruction', below, for details.
   virtual uint64_t ReturnAddress() const { return instruction; }
 
+  // Return the function and source file names, whether they were stored in
+  // function_name and source_file_name or interned.
+  const string &FunctionName() const {
+    return interned_function_name ? *interned_function_name : function_name;
+  }
+  const string &SourceFileName() const {
+    return interned_source_file_name ? *interned_source_file_name
+                                     : source_file_name;
+  }
+
   // The program counter location as an absolute virtual address.
   //
   // - For the innermost called frame in a stack, this will be an exact
@@ -134,6 +147,16 @@ struct StackFrame {
   // are not available.
   uint64_t source_line_base;
 
+  // When the symbolizer interns names (see
+  // StackFrameSymbolizer::set_intern_names), it leaves function_name and
+  // source_file_name empty and sets these instead, to a copy of the name
+  // shared with the resolver and with the other frames that use it.  The
+  // frame keeps its copy alive for as long as the frame lives, whatever
+  // becomes of the symbols it came from.  Read either form through
+  // FunctionName() and SourceFileName().
+  std::shared_ptr<const string> interned_function_name;
+  std::shared_ptr<const string> interned_source_file_name;
+
   // Amount of trust the stack walker has in the instruction pointer
   // of this frame.
   FrameTrust trust;
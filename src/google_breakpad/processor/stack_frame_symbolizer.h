@@ -35,6 +35,9 @@
 #ifndef GOOGLE_BREAKPAD_PROCESSOR_STACK_FRAME_SYMBOLIZER_H__
 #define GOOGLE_BREAKPAD_PROCESSOR_STACK_FRAME_SYMBOLIZER_H__
 
+#include <map>
+#include <memory>
+#include <mutex>
 #include <set>
 #include <string>
 
@@ -81,6 +84,25 @@ class StackFrameSymbolizer {
       const SystemInfo* system_info,
       StackFrame* stack_frame);
 
+  // Fills in |stack_frame| as FillSourceLineInfo would, setting |result| to
+  // what it would return, and returns true, if that needs no more than
+  // lookups in the resolver: the frame's module must be loaded already, or
+  // known to have no symbols.  Otherwise returns false, leaving the frame
+  // for FillSourceLineInfo.  When SupportsConcurrentLookups() is true,
+  // several threads may call this, FindWindowsFrameInfo and
+  // FindCFIFrameInfo at once, provided nothing else is called meanwhile.
+  // Subclasses that override FillSourceLineInfo should override this to
+  // match, or to return false.
+  virtual bool FillSourceLineInfoFromLoadedModule(
+      const CodeModules* modules,
+      const CodeModules* unloaded_modules,
+      StackFrame* stack_frame,
+      SymbolizerResult* result);
+
+  // Returns true if the resolver supports concurrent lookups; see
+  // FillSourceLineInfoFromLoadedModule.
+  virtual bool SupportsConcurrentLookups();
+
   virtual WindowsFrameInfo* FindWindowsFrameInfo(const StackFrame* frame);
 
   virtual CFIFrameInfo* FindCFIFrameInfo(const StackFrame* frame);
@@ -89,20 +111,165 @@ class StackFrameSymbolizer {
   // A typical case is to call Reset() after processing an individual report
   // before start to process next one, in order to reset internal information
   // about missing symbols found so far.
-  virtual void Reset() { no_symbol_modules_.clear(); }
+  virtual void Reset();
 
   // Returns true if there is valid implementation for stack symbolization.
   virtual bool HasImplementation() { return resolver_ && supplier_; }
 
+  // Unloads |module| from the resolver, and frees any symbol data the
+  // supplier still holds for the resolver's copy of it.
+  void UnloadModule(const CodeModule* module);
+
   SourceLineResolverInterface* resolver() { return resolver_; }
   SymbolSupplier* supplier() { return supplier_; }
 
+  // When frames are memoized (see set_memoize_frames), FillSourceLineInfo
+  // remembers what the resolver found at each module-relative address, and
+  // fills in later frames at the same address from that memo.  Reset()
+  // empties the memo, unless it is to be kept across dumps; then each
+  // module's entries are kept for as long as its code file keeps the same
+  // debug identifier.
+  void set_keep_memo_across_dumps(bool keep) {
+    keep_memo_across_dumps_ = keep;
+  }
+  bool keep_memo_across_dumps() const { return keep_memo_across_dumps_; }
+
+  // When names are interned, frames share one copy of each function and
+  // source file name instead of each holding their own: see
+  // StackFrame::interned_function_name.  The copies are the resolver's
+  // own, when it can share them (see
+  // SourceLineResolverInterface::FillSourceLineInfoSharingNames), so the
+  // names are never copied into frames.  Off by default, since it leaves
+  // StackFrame::function_name and source_file_name empty.  Changing it
+  // empties the memo.
+  void set_intern_names(bool intern) {
+    if (intern != intern_names_)
+      ClearMemo();
+    intern_names_ = intern;
+  }
+  bool intern_names() const { return intern_names_; }
+
+  // Memo statistics.  A hit is a frame filled in from the memo; a miss is a
+  // frame the resolver filled in, and whose result was remembered.
+  uint64_t memo_hits() const { return memo_hits_; }
+  uint64_t memo_misses() const { return memo_misses_; }
+
+  // The most frames the memo holds.  When it is full, it is emptied.
+  static const size_t kMaxMemoizedFrames = 65536;
+
+  // Whether FillSourceLineInfo uses the memo at all.  Off by default, since
+  // the memo holds up to kMaxMemoizedFrames frames with their names for as
+  // long as the symbolizer lives; turning it off empties it.
+  void set_memoize_frames(bool memoize) {
+    if (!memoize)
+      ClearMemo();
+    memoize_frames_ = memoize;
+  }
+  bool memoize_frames() const { return memoize_frames_; }
+
  protected:
   SymbolSupplier* supplier_;
   SourceLineResolverInterface* resolver_;
   // A list of modules known to have symbols missing. This helps avoid
   // repeated lookups for the missing symbols within one minidump.
   std::set<string> no_symbol_modules_;
+
+ private:
+  // Returns the module containing |frame|'s instruction, or NULL.
+  static const CodeModule* FindModule(const CodeModules* modules,
+                                      const CodeModules* unloaded_modules,
+                                      const StackFrame* frame);
+
+  // Fills in |frame|, whose module is loaded, from the memo or else the
+  // resolver, and returns the result.
+  SymbolizerResult FillFromLoadedModule(const CodeModule* module,
+                                        StackFrame* frame);
+
+  // Fetches |module|'s symbols from the supplier and loads them into the
+  // resolver.  Returns kNoError once the module is loaded.
+  SymbolizerResult LoadModule(const CodeModule* module,
+                              const SystemInfo* system_info);
+
+  // Frees the symbol data the supplier holds for modules the resolver has
+  // unloaded on its own.
+  void FreeUnloadedSymbolData();
+
+  // Copies of the modules whose symbol data the supplier holds for the
+  // resolver, by code file, to pass to SymbolSupplier::FreeSymbolData once
+  // the resolver unloads them.
+  std::map<string, std::shared_ptr<const CodeModule> > supplied_modules_;
+
+  // What the resolver filled in for one address.  The addresses are
+  // absolute, for a module loaded at module_base.
+  // When names are interned, they are held in interned_function_name and
+  // interned_source_file_name, which are NULL when empty; otherwise they
+  // are held in function_name and source_file_name.
+  struct MemoizedFrame {
+    SymbolizerResult result;
+    uint64_t module_base;
+    string function_name;
+    std::shared_ptr<const string> interned_function_name;
+    uint64_t function_base;
+    string source_file_name;
+    std::shared_ptr<const string> interned_source_file_name;
+    int source_line;
+    uint64_t source_line_base;
+  };
+
+  // Orders interned strings by their contents.
+  struct CompareInterned {
+    bool operator()(const std::shared_ptr<const string>& a,
+                    const std::shared_ptr<const string>& b) const {
+      return *a < *b;
+    }
+  };
+  typedef std::set<std::shared_ptr<const string>, CompareInterned> NamePool;
+
+  // The memoized frames of one module, by module-relative address.
+  struct ModuleMemo {
+    string debug_identifier;
+    std::map<uint64_t, MemoizedFrame> frames;
+  };
+
+  // Returns the memo for |module|, first emptying it if it was filled for
+  // a different build of the module.  The caller must hold memo_mutex_.
+  ModuleMemo* GetModuleMemo(const CodeModule* module);
+
+  // Remembers |result| and what the resolver filled in to |frame|, if
+  // frames are memoized, and returns |result|.
+  SymbolizerResult Memoize(ModuleMemo* memo, StackFrame* frame,
+                           SymbolizerResult result);
+
+  // Switches |frame| over to interned copies of its names, for resolvers
+  // that can't share their own.
+  void InternNames(StackFrame* frame);
+
+  // Fills in |frame| from |memoized|.
+  void FillFromMemo(const MemoizedFrame& memoized, StackFrame* frame) const;
+
+  // Returns the interned copy of |name|, or NULL if |name| is empty.  The
+  // caller must hold memo_mutex_.
+  std::shared_ptr<const string> Intern(const string& name);
+
+  // Empties the memo and the name pool.
+  void ClearMemo();
+
+  // Guards the memo, the name pool and their statistics against
+  // concurrent calls to FillSourceLineInfoFromLoadedModule.
+  std::mutex memo_mutex_;
+
+  // Module memos, by code file.
+  std::map<string, ModuleMemo> memo_;
+  size_t memoized_frames_;
+  bool memoize_frames_;
+  bool keep_memo_across_dumps_;
+
+  // The names interned for resolvers that can't share their own, each
+  // held once.
+  NamePool names_;
+  bool intern_names_;
+  uint64_t memo_hits_;
+  uint64_t memo_misses_;
 };
 
 }  // namespace google_breakpad
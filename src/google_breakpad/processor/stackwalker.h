@@ -43,6 +43,7 @@
 
 #include <set>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "common/using_std_string.h"
@@ -169,17 +170,28 @@ class Stackwalker {
                             InstructionType* location_found,
                             InstructionType* ip_found,
                             int searchwords) {
+    // Read the whole window up front, up to the first word that can't be
+    // read, so that it can be screened against the module ranges in bulk.
+    scan_words_.clear();
     for (InstructionType location = location_start;
          location <= location_start + searchwords * sizeof(InstructionType);
          location += sizeof(InstructionType)) {
       InstructionType ip;
       if (!memory_->GetMemoryAtAddress(location, &ip))
         break;
+      scan_words_.push_back(ip);
+    }
 
-      if (modules_ && modules_->GetModuleForAddress(ip) &&
+    // Only words that fall within some module are worth looking up.
+    FindScanCandidates();
+    for (size_t i = 0; i < scan_words_.size(); ++i) {
+      if (!scan_candidates_[i])
+        continue;
+      InstructionType ip = static_cast<InstructionType>(scan_words_[i]);
+      if (modules_->GetModuleForAddress(ip) &&
           InstructionAddressSeemsValid(ip)) {
         *ip_found = ip;
-        *location_found = location;
+        *location_found = location_start + i * sizeof(InstructionType);
         return true;
       }
     }
@@ -235,6 +247,22 @@ class Stackwalker {
   virtual StackFrame* GetCallerFrame(const CallStack* stack,
                                      bool stack_scan_allowed) = 0;
 
+  // Sets scan_candidates_[i] to whether scan_words_[i] falls within the
+  // address range of any module in modules_.  Every word that
+  // modules_->GetModuleForAddress could place in a module is a candidate.
+  void FindScanCandidates();
+
+  // The words ScanForReturnAddress read from the stack, and which of them
+  // FindScanCandidates found within a module.
+  vector<uint64_t> scan_words_;
+  vector<uint8_t> scan_candidates_;
+
+  // The address ranges of modules_, sorted and with overlapping or
+  // adjacent ranges merged.  Each range is given by its first and last
+  // address.  Built by the first FindScanCandidates call.
+  vector<std::pair<uint64_t, uint64_t> > module_ranges_;
+  bool module_ranges_built_;
+
   // The maximum number of frames Stackwalker will walk through.
   // This defaults to 1024 to prevent infinite loops.
   static uint32_t max_frames_;
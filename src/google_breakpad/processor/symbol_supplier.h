@@ -92,6 +92,18 @@ class SymbolSupplier {
 
   // Frees the data buffer allocated for the module in GetCStringSymbolData.
   virtual void FreeSymbolData(const CodeModule *module) = 0;
+
+  // Places in symbol_file the path of a symbol file for the given module
+  // that a resolver can map and load in place (see
+  // SourceLineResolverInterface::LoadModuleUsingMappedFile), and returns
+  // true, if the supplier has one.  Otherwise returns false, and the symbol
+  // data should be fetched with GetCStringSymbolData.  Suppliers that only
+  // hand out symbol data in buffers need not override this.
+  virtual bool GetMappableSymbolFile(const CodeModule * /* module */,
+                                     const SystemInfo * /* system_info */,
+                                     string * /* symbol_file */) {
+    return false;
+  }
 };
 
 }  // namespace google_breakpad
@@ -41,16 +41,16 @@
 #include <vector>
 
 #include "google_breakpad/processor/code_module.h"
+#include "processor/compact_range_map-inl.h"
 #include "processor/linked_ptr.h"
 #include "processor/logging.h"
-#include "processor/range_map-inl.h"
 
 namespace google_breakpad {
 
 using std::vector;
 
 BasicCodeModules::BasicCodeModules(const CodeModules *that)
-    : main_address_(0), map_() {
+    : main_address_(0), map_(), last_hit_index_(-1) {
   BPLOG_IF(ERROR, !that) << "BasicCodeModules::BasicCodeModules requires "
                             "|that|";
   assert(that);
@@ -91,9 +91,12 @@ BasicCodeModules::BasicCodeModules(const CodeModules *that)
 
   // TODO(ivanpe): Report modules with conflicting ranges.  The list of such
   // modules should be copied from |that|.
+
+  map_.ShrinkToFit();
 }
 
-BasicCodeModules::BasicCodeModules() : main_address_(0), map_() { }
+BasicCodeModules::BasicCodeModules()
+    : main_address_(0), map_(), last_hit_index_(-1) { }
 
 BasicCodeModules::~BasicCodeModules() {
 }
@@ -104,14 +107,17 @@ unsigned int BasicCodeModules::module_count() const {
 
 const CodeModule* BasicCodeModules::GetModuleForAddress(
     uint64_t address) const {
-  linked_ptr<const CodeModule> module;
-  if (!map_.RetrieveRange(address, &module, NULL /* base */, NULL /* delta */,
-                          NULL /* size */)) {
-    BPLOG(INFO) << "No module at " << HexString(address);
-    return NULL;
+  int index = last_hit_index_.load(std::memory_order_relaxed);
+  if (!map_.RangeAtIndexContains(index, address)) {
+    index = map_.FindRangeIndex(address);
+    if (index < 0) {
+      BPLOG(INFO) << "No module at " << HexString(address);
+      return NULL;
+    }
+    last_hit_index_.store(index, std::memory_order_relaxed);
   }
 
-  return module.get();
+  return map_.EntryAtIndex(index).get();
 }
 
 const CodeModule* BasicCodeModules::GetMainModule() const {
@@ -120,22 +126,23 @@ const CodeModule* BasicCodeModules::GetMainModule() const {
 
 const CodeModule* BasicCodeModules::GetModuleAtSequence(
     unsigned int sequence) const {
-  linked_ptr<const CodeModule> module;
-  if (!map_.RetrieveRangeAtIndex(sequence, &module, NULL /* base */,
-                                 NULL /* delta */, NULL /* size */)) {
-    BPLOG(ERROR) << "RetrieveRangeAtIndex failed for sequence " << sequence;
+  // EntryAtIndex doesn't copy the linked_ptr, which would update the
+  // reference ring it shares with the map, so this is safe to call from
+  // several threads at once.
+  if (sequence >= static_cast<unsigned int>(map_.GetCount())) {
+    BPLOG(ERROR) << "No module at sequence " << sequence;
     return NULL;
   }
 
-  return module.get();
+  return map_.EntryAtIndex(sequence).get();
 }
 
 const CodeModule* BasicCodeModules::GetModuleAtIndex(
     unsigned int index) const {
-  // This class stores everything in a RangeMap, without any more-efficient
-  // way to walk the list of CodeModule objects.  Implement GetModuleAtIndex
-  // using GetModuleAtSequence, which meets all of the requirements, and
-  // in addition, guarantees ordering.
+  // This class stores everything in a CompactRangeMap, without any
+  // more-efficient way to walk the list of CodeModule objects.  Implement
+  // GetModuleAtIndex using GetModuleAtSequence, which meets all of the
+  // requirements, and in addition, guarantees ordering.
   return GetModuleAtSequence(index);
 }
 
@@ -43,11 +43,12 @@
 
 #include <stddef.h>
 
+#include <atomic>
 #include <vector>
 
 #include "google_breakpad/processor/code_modules.h"
+#include "processor/compact_range_map.h"
 #include "processor/linked_ptr.h"
-#include "processor/range_map.h"
 
 namespace google_breakpad {
 
@@ -81,7 +82,15 @@ class BasicCodeModules : public CodeModules {
 
   // The map used to contain each CodeModule, keyed by each CodeModule's
   // address range.
-  RangeMap<uint64_t, linked_ptr<const CodeModule> > map_;
+  CompactRangeMap<uint64_t, linked_ptr<const CodeModule> > map_;
+
+  // The index in map_ of the module GetModuleForAddress last found.
+  // Consecutive lookups, such as those made while walking and symbolizing
+  // a stack, tend to land in the same module, so this is checked before
+  // searching.  It's only a hint, and is checked against map_ before use,
+  // so threads looking up modules at once may overwrite each other's with
+  // relaxed stores.
+  mutable std::atomic<int> last_hit_index_;
 
   // A vector of all CodeModules that were shrunk downs due to
   // address range conflicts.
@@ -38,8 +38,11 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 
+#include <algorithm>
+#include <atomic>
 #include <limits>
 #include <map>
+#include <thread>
 #include <utility>
 #include <vector>
 
@@ -47,32 +50,308 @@
 #include "processor/basic_source_line_resolver_types.h"
 #include "processor/module_factory.h"
 
-#include "processor/tokenize.h"
-
-#ifndef HAVE_STRTOK_R
-extern "C" char *strtok_r(char *, const char *, char **);
-#endif
-
 using std::map;
-using std::vector;
 using std::make_pair;
+using std::vector;
 
 namespace google_breakpad {
 
-#ifdef _WIN32
-#ifdef _MSC_VER
-#define strtok_r strtok_s
-#endif
-#define strtoull _strtoui64
-#endif
-
 static const char *kWhitespace = " \r\n";
 static const int kMaxErrorsPrinted = 5;
 static const int kMaxErrorsBeforeBailing = 100;
 
+// The routines below split records and parse numbers in place, without
+// calling into libc for every field.  Symbol files routinely contain
+// millions of records, most of them LINE and STACK CFI records, so this
+// is the bulk of the time spent loading a module.
+
+// Returns true if |c| separates the fields of a record (see kWhitespace).
+static inline bool IsSeparator(char c) {
+  return c == ' ' || c == '\r' || c == '\n';
+}
+
+// Returns the next field of the record at |*cursor| and advances |*cursor|
+// past it.  Like strtok_r(..., kWhitespace, ...), leading separators are
+// skipped and the field is null-terminated in place.  Returns NULL if there
+// are no fields left.
+static inline char *NextField(char **cursor) {
+  char *field = *cursor;
+  while (IsSeparator(*field))
+    ++field;
+  if (*field == '\0') {
+    *cursor = field;
+    return NULL;
+  }
+  char *end = field;
+  while (*end != '\0' && !IsSeparator(*end))
+    ++end;
+  if (*end != '\0')
+    *end++ = '\0';
+  *cursor = end;
+  return field;
+}
+
+// Returns the remainder of the record at |*cursor|, up to the end of the
+// line, as strtok_r(NULL, "\r\n", ...) would.  This is used for the last
+// field of a record, which may itself contain spaces.  Returns NULL if
+// nothing is left.
+static inline char *RemainingField(char **cursor) {
+  char *field = *cursor;
+  while (*field == '\r' || *field == '\n')
+    ++field;
+  if (*field == '\0') {
+    *cursor = field;
+    return NULL;
+  }
+  char *end = field;
+  while (*end != '\0' && *end != '\r' && *end != '\n')
+    ++end;
+  if (*end != '\0')
+    *end++ = '\0';
+  *cursor = end;
+  return field;
+}
+
+// Splits |line| into exactly |count| fields, the last of which extends to
+// the end of the line.  This matches Tokenize(line, kWhitespace, count, ...)
+// but stores the fields in the caller's |fields| array rather than a vector.
+static bool SplitFields(char *line, int count, char **fields) {
+  char *cursor = line;
+  for (int i = 0; i < count - 1; ++i) {
+    if (!(fields[i] = NextField(&cursor)))
+      return false;
+  }
+  return (fields[count - 1] = RemainingField(&cursor)) != NULL;
+}
+
+// Returns the value of the digit |c| in |kBase|, or -1 if |c| isn't one.
+template<int kBase>
+static inline int DigitValue(char c) {
+  if (c >= '0' && c <= '9')
+    return c - '0';
+  if (kBase == 16) {
+    if (c >= 'a' && c <= 'f')
+      return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+      return c - 'A' + 10;
+  }
+  return -1;
+}
+
+// Parses the number at |field| in |kBase|, accepting what strtoull and
+// strtol accept: leading white space, an optional sign, and for base 16 an
+// optional "0x" prefix.  On success, stores the magnitude in |*magnitude|,
+// whether it was negated in |*negative|, and the first character after the
+// digits in |*after_number|.  Returns false if there are no digits or the
+// magnitude doesn't fit in 64 bits.
+template<int kBase>
+static inline bool ParseMagnitude(const char *field, uint64_t *magnitude,
+                                  bool *negative, char **after_number) {
+  static const uint64_t kMaxMagnitude = std::numeric_limits<uint64_t>::max();
+  const char *cursor = field;
+  while (*cursor == ' ' || (*cursor >= '\t' && *cursor <= '\r'))
+    ++cursor;
+  *negative = false;
+  if (*cursor == '+' || *cursor == '-') {
+    *negative = *cursor == '-';
+    ++cursor;
+  }
+  if (kBase == 16 && cursor[0] == '0' &&
+      (cursor[1] == 'x' || cursor[1] == 'X') && DigitValue<16>(cursor[2]) >= 0)
+    cursor += 2;
+
+  const char *digits = cursor;
+  uint64_t value = 0;
+  int digit;
+  while ((digit = DigitValue<kBase>(*cursor)) >= 0) {
+    if (value > kMaxMagnitude / kBase ||
+        (value == kMaxMagnitude / kBase &&
+         static_cast<uint64_t>(digit) > kMaxMagnitude % kBase))
+      return false;
+    value = value * kBase + digit;
+    ++cursor;
+  }
+  if (cursor == digits)
+    return false;
+
+  *magnitude = value;
+  *after_number = const_cast<char*>(cursor);
+  return true;
+}
+
+// Parses an unsigned number the way strtoull does, including wrapping
+// negative values.  Returns false on a missing number or overflow.
+template<int kBase>
+static inline bool ParseUnsignedNumber(const char *field, uint64_t *value,
+                                       char **after_number) {
+  uint64_t magnitude;
+  bool negative;
+  if (!ParseMagnitude<kBase>(field, &magnitude, &negative, after_number))
+    return false;
+  *value = negative ? 0 - magnitude : magnitude;
+  return true;
+}
+
+// Parses a signed number the way strtol does.  Returns false on a missing
+// number or if the value doesn't fit in a long.
+template<int kBase>
+static inline bool ParseSignedNumber(const char *field, long *value,
+                                     char **after_number) {
+  static const uint64_t kMaxLong = std::numeric_limits<long>::max();
+  uint64_t magnitude;
+  bool negative;
+  if (!ParseMagnitude<kBase>(field, &magnitude, &negative, after_number))
+    return false;
+  if (negative) {
+    if (magnitude > kMaxLong + 1)
+      return false;
+    *value = magnitude == 0 ? 0 : -static_cast<long>(magnitude - 1) - 1;
+  } else {
+    if (magnitude > kMaxLong)
+      return false;
+    *value = static_cast<long>(magnitude);
+  }
+  return true;
+}
+
 BasicSourceLineResolver::BasicSourceLineResolver() :
     SourceLineResolverBase(new BasicModuleFactory) { }
 
+void BasicSourceLineResolver::set_max_parse_threads(unsigned int max_threads) {
+  static_cast<BasicModuleFactory*>(module_factory_)->set_max_parse_threads(
+      max_threads);
+}
+
+unsigned int BasicSourceLineResolver::max_parse_threads() const {
+  return static_cast<BasicModuleFactory*>(module_factory_)->max_parse_threads();
+}
+
+void BasicSourceLineResolver::set_lazy_loading(bool lazy) {
+  static_cast<BasicModuleFactory*>(module_factory_)->set_lazy_loading(lazy);
+}
+
+bool BasicSourceLineResolver::lazy_loading() const {
+  return static_cast<BasicModuleFactory*>(module_factory_)->lazy_loading();
+}
+
+void BasicSourceLineResolver::set_compact_range_maps(bool compact) {
+  static_cast<BasicModuleFactory*>(module_factory_)->set_compact_range_maps(
+      compact);
+}
+
+bool BasicSourceLineResolver::compact_range_maps() const {
+  return static_cast<BasicModuleFactory*>(module_factory_)->
+      compact_range_maps();
+}
+
+bool BasicSourceLineResolver::ShouldDeleteMemoryBufferAfterLoadModule() {
+  // Lazily loaded modules parse the symbol data as it is looked up.
+  return !lazy_loading();
+}
+
+// A run of whole lines of the symbol file.  When the file is parsed as a
+// single chunk, records are stored in the module as they are parsed, exactly
+// as they always were.  Otherwise each chunk is parsed on its own thread and
+// queues its records, and MergeChunk stores them in file order afterwards,
+// so every map sees the same sequence of insertions as a serial load.
+struct BasicSourceLineResolver::Module::ParseChunk {
+  // A line record that appears before the chunk's first FUNC or PUBLIC
+  // record, and so belongs to whatever function an earlier chunk ended in.
+  struct LeadingLine {
+    int line_number;
+    bool valid;
+    Line line;
+  };
+
+  struct PublicSymbolRecord {
+    int line_number;
+    linked_ptr<PublicSymbol> symbol;
+  };
+
+  struct WindowsFrameInfoRecord {
+    int type;
+    MemAddr rva;
+    MemAddr code_size;
+    linked_ptr<WindowsFrameInfo> frame_info;
+  };
+
+  struct CFIInitialRule {
+    MemAddr address;
+    MemAddr size;
+    const char *rules;
+  };
+
+  struct ParseError {
+    int line_number;
+    const char *message;
+
+    bool operator<(const ParseError &other) const {
+      return line_number < other.line_number;
+    }
+  };
+
+  ParseChunk(char *chunk_begin, char *chunk_end, bool is_direct)
+      : begin(chunk_begin), end(chunk_end), direct(is_direct),
+        line_count(0), num_errors(0), memory_usage(0), sets_function(false),
+        line(NULL) { }
+
+  // Returns a copy of |length| bytes at |original| that may be parsed in
+  // place, leaving the symbol data intact for a lazy load to parse again.
+  char *Scratch(const char *original, size_t length) {
+    scratch.assign(original, original + length);
+    scratch.push_back('\0');
+    line = original;
+    return &scratch[0];
+  }
+
+  // Maps |field|, within the copy returned by Scratch, back to the
+  // symbol data.
+  const char *Original(const char *field) const {
+    return line + (field - &scratch[0]);
+  }
+
+  char *begin;
+  char *end;
+
+  // True if records are stored in the module directly.
+  bool direct;
+
+  // The number of lines parsed so far; the chunk-relative line number.
+  int line_count;
+  int num_errors;
+
+  // The estimated memory taken by the chunk's records once stored.
+  size_t memory_usage;
+
+  // True if the chunk contains a FUNC or PUBLIC record, in which case
+  // |last_function| is the function its last lines belong to, if any.
+  bool sets_function;
+  linked_ptr<Function> last_function;
+
+  // Records queued for MergeChunk.
+  vector<LeadingLine> leading_lines;
+  vector<std::pair<long, string> > files;
+  vector<linked_ptr<Function> > functions;
+  vector<PublicSymbolRecord> public_symbols;
+  vector<WindowsFrameInfoRecord> windows_frame_info;
+  vector<CFIInitialRule> cfi_initial_rules;
+  vector<std::pair<MemAddr, const char*> > cfi_delta_rules;
+  vector<ParseError> errors;
+
+  // The line most recently copied by Scratch, and its copy.
+  const char *line;
+  vector<char> scratch;
+};
+
+// Chunks are only worth a thread if they are at least this large.
+static const size_t kMinParseChunkSize = 256 * 1024;
+
+// Orders lazily loaded STACK CFI delta records by address.
+static bool CompareDeltaRules(const std::pair<uint64_t, const char*> &a,
+                              const std::pair<uint64_t, const char*> &b) {
+  return a.first < b.first;
+}
+
 // static
 void BasicSourceLineResolver::Module::LogParseError(
    const string &message,
@@ -87,13 +366,23 @@ void BasicSourceLineResolver::Module::LogParseError(
   }
 }
 
+// static
+void BasicSourceLineResolver::Module::RecordParseError(ParseChunk *chunk,
+                                                       const char *message) {
+  if (chunk->direct) {
+    LogParseError(message, chunk->line_count, &chunk->num_errors);
+  } else {
+    ParseChunk::ParseError error = { chunk->line_count, message };
+    chunk->errors.push_back(error);
+    ++chunk->num_errors;
+  }
+}
+
 bool BasicSourceLineResolver::Module::LoadMapFromMemory(
     char *memory_buffer,
     size_t memory_buffer_size) {
-  linked_ptr<Function> cur_func;
   int line_number = 0;
   int num_errors = 0;
-  char *save_ptr;
 
   // If the length is 0, we can still pretend we have a symbol file. This is
   // for scenarios that want to test symbol lookup, but don't necessarily care
@@ -115,11 +404,13 @@ bool BasicSourceLineResolver::Module::LoadMapFromMemory(
          memory_buffer[last_null_terminator - 1] == '\0') {
     last_null_terminator--;
   }
-  for (size_t i = 0; i < last_null_terminator; i++) {
-    if (memory_buffer[i] == '\0') {
-      memory_buffer[i] = '_';
-      has_null_terminator_in_the_middle = true;
-    }
+  char *buffer_end = memory_buffer + last_null_terminator;
+  for (char *null_terminator = memory_buffer;
+       (null_terminator = static_cast<char*>(
+            memchr(null_terminator, '\0', buffer_end - null_terminator)));
+       ++null_terminator) {
+    *null_terminator = '_';
+    has_null_terminator_in_the_middle = true;
   }
   if (has_null_terminator_in_the_middle) {
     LogParseError(
@@ -128,72 +419,452 @@ bool BasicSourceLineResolver::Module::LoadMapFromMemory(
        &num_errors);
   }
 
-  char *buffer;
-  buffer = strtok_r(memory_buffer, "\r\n", &save_ptr);
-
-  while (buffer != NULL) {
-    ++line_number;
-
-    if (strncmp(buffer, "FILE ", 5) == 0) {
-      if (!ParseFile(buffer)) {
-        LogParseError("ParseFile on buffer failed", line_number, &num_errors);
-      }
-    } else if (strncmp(buffer, "STACK ", 6) == 0) {
-      if (!ParseStackInfo(buffer)) {
-        LogParseError("ParseStackInfo failed", line_number, &num_errors);
-      }
-    } else if (strncmp(buffer, "FUNC ", 5) == 0) {
-      cur_func.reset(ParseFunction(buffer));
-      if (!cur_func.get()) {
-        LogParseError("ParseFunction failed", line_number, &num_errors);
-      } else {
-        // StoreRange will fail if the function has an invalid address or size.
-        // We'll silently ignore this, the function and any corresponding lines
-        // will be destroyed when cur_func is released.
-        functions_.StoreRange(cur_func->address, cur_func->size, cur_func);
-      }
-    } else if (strncmp(buffer, "PUBLIC ", 7) == 0) {
-      // Clear cur_func: public symbols don't contain line number information.
-      cur_func.reset();
-
-      if (!ParsePublicSymbol(buffer)) {
-        LogParseError("ParsePublicSymbol failed", line_number, &num_errors);
-      }
-    } else if (strncmp(buffer, "MODULE ", 7) == 0) {
-      // Ignore these.  They're not of any use to BasicSourceLineResolver,
-      // which is fed modules by a SymbolSupplier.  These lines are present to
-      // aid other tools in properly placing symbol files so that they can
-      // be accessed by a SymbolSupplier.
-      //
-      // MODULE <guid> <age> <filename>
-    } else if (strncmp(buffer, "INFO ", 5) == 0) {
-      // Ignore these as well, they're similarly just for housekeeping.
-      //
-      // INFO CODE_ID <code id> <filename>
-    } else {
-      if (!cur_func.get()) {
-        LogParseError("Found source line data without a function",
-                       line_number, &num_errors);
-      } else {
-        Line *line = ParseLine(buffer);
-        if (!line) {
-          LogParseError("ParseLine failed", line_number, &num_errors);
-        } else {
-          cur_func->lines.StoreRange(line->address, line->size,
-                                     linked_ptr<Line>(line));
+  // A lazy load only indexes most records, which is cheap enough to do on
+  // one thread.
+  size_t chunk_count = 1;
+  if (max_parse_threads_ > 1 && !lazy_) {
+    chunk_count = std::min<size_t>(max_parse_threads_,
+                                   last_null_terminator / kMinParseChunkSize);
+  }
+  if (chunk_count <= 1) {
+    ParseChunk chunk(memory_buffer, buffer_end, true);
+    chunk.num_errors = num_errors;
+    lazy_buffer_end_ = buffer_end;
+    ParseChunkRecords(&chunk);
+    if (lazy_) {
+      // Sort the delta rules for FindCFIFrameInfo, keeping only the last
+      // rule at each address, as cfi_delta_rules_ would.
+      std::stable_sort(lazy_cfi_delta_rules_.begin(),
+                       lazy_cfi_delta_rules_.end(), CompareDeltaRules);
+      size_t kept = 0;
+      for (size_t i = 0; i < lazy_cfi_delta_rules_.size(); ++i) {
+        if (kept > 0 &&
+            lazy_cfi_delta_rules_[kept - 1].first ==
+            lazy_cfi_delta_rules_[i].first) {
+          --kept;
         }
+        lazy_cfi_delta_rules_[kept++] = lazy_cfi_delta_rules_[i];
       }
+      lazy_cfi_delta_rules_.resize(kept);
     }
+    ShrinkRangeMaps();
+    memory_usage_ = chunk.memory_usage;
+    is_corrupt_ = chunk.num_errors > 0;
+    return true;
+  }
+
+  // Split the buffer after the newline nearest each even division, so that
+  // every chunk holds whole lines.
+  vector<ParseChunk> chunks;
+  char *chunk_begin = memory_buffer;
+  for (size_t i = 1; i < chunk_count; ++i) {
+    char *division = memory_buffer + last_null_terminator * i / chunk_count;
+    if (division < chunk_begin)
+      continue;
+    char *newline = static_cast<char*>(
+        memchr(division, '\n', buffer_end - division));
+    if (!newline)
+      break;
+    chunks.push_back(ParseChunk(chunk_begin, newline + 1, false));
+    chunk_begin = newline + 1;
+  }
+  chunks.push_back(ParseChunk(chunk_begin, buffer_end, false));
+
+  // Each pool thread, and the calling thread, claims the next chunk until
+  // none are left.
+  std::atomic<size_t> next_chunk(0);
+  auto parse_chunks = [this, &chunks, &next_chunk]() {
+    size_t index;
+    while ((index = next_chunk++) < chunks.size())
+      ParseChunkRecords(&chunks[index]);
+  };
+  vector<std::thread> pool;
+  for (size_t i = 1; i < chunks.size(); ++i)
+    pool.push_back(std::thread(parse_chunks));
+  parse_chunks();
+  for (size_t i = 0; i < pool.size(); ++i)
+    pool[i].join();
+
+  // Each chunk gives up after kMaxErrorsBeforeBailing errors of its own, so
+  // a badly corrupt file may be parsed further than a serial load would
+  // before the merge gives up too.
+  linked_ptr<Function> cur_func;
+  for (size_t i = 0; i < chunks.size(); ++i) {
+    MergeChunk(&chunks[i], line_number, &cur_func, &num_errors);
+    memory_usage_ += chunks[i].memory_usage;
+    line_number += chunks[i].line_count;
     if (num_errors > kMaxErrorsBeforeBailing) {
       break;
     }
-    buffer = strtok_r(NULL, "\r\n", &save_ptr);
   }
+  ShrinkRangeMaps();
   is_corrupt_ = num_errors > 0;
   return true;
 }
 
-void BasicSourceLineResolver::Module::LookupAddress(StackFrame *frame) const {
+void BasicSourceLineResolver::Module::ShrinkRangeMaps() {
+  if (!compact_range_maps_)
+    return;
+  functions_.ShrinkToFit();
+  const CompactRangeMap<MemAddr, linked_ptr<Function> > &functions =
+      functions_.compact_range_map();
+  for (int i = 0; i < functions.GetCount(); ++i) {
+    linked_ptr<Function> function;
+    functions.RetrieveRangeAtIndex(i, &function, NULL, NULL, NULL);
+    function->lines.ShrinkToFit();
+  }
+}
+
+void BasicSourceLineResolver::Module::ParseChunkRecords(ParseChunk *chunk) {
+  linked_ptr<Function> cur_func;
+
+  // In a lazy load, records other than LINE records are parsed from a copy
+  // of the line, and LINE records aren't parsed until their function is
+  // looked up.  All that is checked now is that they follow a function.
+  bool in_lazy_function = false;
+  auto parse_line_record = [this, &cur_func, &in_lazy_function,
+                            chunk](char *line_line) {
+    if (!lazy_)
+      ParseLineRecord(line_line, cur_func.get(), chunk);
+    else if (!in_lazy_function)
+      RecordParseError(chunk, "Found source line data without a function");
+  };
+
+  // Walk the chunk one line at a time, terminating each line in place.
+  // As with strtok_r, runs of line separators are collapsed, so blank lines
+  // are skipped and don't count towards the line number.
+  char *cursor = chunk->begin;
+  while (cursor < chunk->end) {
+    if (*cursor == '\r' || *cursor == '\n') {
+      ++cursor;
+      continue;
+    }
+
+    char *buffer = cursor;
+    char *end_of_line = static_cast<char*>(
+        memchr(buffer, '\n', chunk->end - buffer));
+    if (!end_of_line)
+      end_of_line = chunk->end;
+    char *carriage_return = static_cast<char*>(
+        memchr(buffer, '\r', end_of_line - buffer));
+    if (carriage_return)
+      end_of_line = carriage_return;
+    *end_of_line = '\0';
+    cursor = end_of_line + 1;
+
+    ++chunk->line_count;
+
+    // The line to parse records other than LINE records from.
+    char *record = buffer;
+    if (lazy_ && (buffer[0] == 'F' || buffer[0] == 'S' || buffer[0] == 'P'))
+      record = chunk->Scratch(buffer, end_of_line - buffer);
+
+    switch (buffer[0]) {
+      case 'F':
+        if (strncmp(buffer, "FILE ", 5) == 0) {
+          if (!ParseFile(record, chunk)) {
+            RecordParseError(chunk, "ParseFile on buffer failed");
+          }
+          break;
+        }
+        if (strncmp(buffer, "FUNC ", 5) == 0 && lazy_) {
+          in_lazy_function = IndexFunction(record, cursor, chunk);
+          if (!in_lazy_function) {
+            RecordParseError(chunk, "ParseFunction failed");
+          }
+          break;
+        }
+        if (strncmp(buffer, "FUNC ", 5) == 0) {
+          cur_func.reset(ParseFunction(buffer));
+          chunk->sets_function = true;
+          if (!cur_func.get()) {
+            RecordParseError(chunk, "ParseFunction failed");
+            break;
+          }
+          chunk->memory_usage +=
+              RangeEntryMemoryUsage(sizeof(cur_func), compact_range_maps_) +
+              FunctionMemoryUsage(*cur_func);
+          if (chunk->direct) {
+            // StoreRange will fail if the function has an invalid address or
+            // size.  We'll silently ignore this, the function and any
+            // corresponding lines will be destroyed when cur_func is
+            // released.
+            functions_.StoreRange(cur_func->address, cur_func->size,
+                                  cur_func);
+          } else {
+            chunk->functions.push_back(cur_func);
+          }
+          break;
+        }
+        parse_line_record(buffer);
+        break;
+      case 'S':
+        if (strncmp(buffer, "STACK ", 6) == 0) {
+          if (!ParseStackInfo(record, chunk)) {
+            RecordParseError(chunk, "ParseStackInfo failed");
+          }
+          break;
+        }
+        parse_line_record(buffer);
+        break;
+      case 'P':
+        if (strncmp(buffer, "PUBLIC ", 7) == 0) {
+          // Clear cur_func: public symbols don't contain line number
+          // information.
+          cur_func.reset();
+          in_lazy_function = false;
+          chunk->sets_function = true;
+
+          if (!ParsePublicSymbol(record, chunk)) {
+            RecordParseError(chunk, "ParsePublicSymbol failed");
+          }
+          break;
+        }
+        parse_line_record(buffer);
+        break;
+      case 'M':
+        // Ignore these.  They're not of any use to BasicSourceLineResolver,
+        // which is fed modules by a SymbolSupplier.  These lines are present
+        // to aid other tools in properly placing symbol files so that they
+        // can be accessed by a SymbolSupplier.
+        //
+        // MODULE <guid> <age> <filename>
+        if (strncmp(buffer, "MODULE ", 7) == 0)
+          break;
+        parse_line_record(buffer);
+        break;
+      case 'I':
+        // Ignore these as well, they're similarly just for housekeeping.
+        //
+        // INFO CODE_ID <code id> <filename>
+        if (strncmp(buffer, "INFO ", 5) == 0)
+          break;
+        parse_line_record(buffer);
+        break;
+      default:
+        parse_line_record(buffer);
+        break;
+    }
+    if (chunk->num_errors > kMaxErrorsBeforeBailing) {
+      break;
+    }
+  }
+  chunk->last_function = cur_func;
+}
+
+void BasicSourceLineResolver::Module::MergeChunk(
+    ParseChunk *chunk,
+    int first_line,
+    linked_ptr<Function> *cur_func,
+    int *num_errors) {
+  for (size_t i = 0; i < chunk->leading_lines.size(); ++i) {
+    const ParseChunk::LeadingLine &leading_line = chunk->leading_lines[i];
+    const char *message = NULL;
+    if (!cur_func->get()) {
+      message = "Found source line data without a function";
+    } else if (!leading_line.valid) {
+      message = "ParseLine failed";
+    } else {
+      (*cur_func)->lines.StoreRange(leading_line.line.address,
+                                    leading_line.line.size,
+                                    leading_line.line);
+      chunk->memory_usage +=
+          RangeEntryMemoryUsage(sizeof(Line), compact_range_maps_);
+    }
+    if (message) {
+      ParseChunk::ParseError error = { leading_line.line_number, message };
+      chunk->errors.push_back(error);
+    }
+  }
+  if (chunk->sets_function) {
+    *cur_func = chunk->last_function;
+  }
+
+  for (size_t i = 0; i < chunk->files.size(); ++i) {
+    files_.insert(chunk->files[i]);
+  }
+  for (size_t i = 0; i < chunk->functions.size(); ++i) {
+    const linked_ptr<Function> &function = chunk->functions[i];
+    functions_.StoreRange(function->address, function->size, function);
+  }
+  for (size_t i = 0; i < chunk->public_symbols.size(); ++i) {
+    const ParseChunk::PublicSymbolRecord &record = chunk->public_symbols[i];
+    if (!public_symbols_.Store(record.symbol->address, record.symbol)) {
+      ParseChunk::ParseError error = { record.line_number,
+                                       "ParsePublicSymbol failed" };
+      chunk->errors.push_back(error);
+    }
+  }
+  for (size_t i = 0; i < chunk->windows_frame_info.size(); ++i) {
+    const ParseChunk::WindowsFrameInfoRecord &record =
+        chunk->windows_frame_info[i];
+    windows_frame_info_[record.type].StoreRange(record.rva, record.code_size,
+                                                record.frame_info);
+  }
+  for (size_t i = 0; i < chunk->cfi_initial_rules.size(); ++i) {
+    const ParseChunk::CFIInitialRule &rule = chunk->cfi_initial_rules[i];
+    cfi_initial_rules_.StoreRange(rule.address, rule.size, rule.rules);
+  }
+  for (size_t i = 0; i < chunk->cfi_delta_rules.size(); ++i) {
+    cfi_delta_rules_[chunk->cfi_delta_rules[i].first] =
+        chunk->cfi_delta_rules[i].second;
+  }
+
+  std::stable_sort(chunk->errors.begin(), chunk->errors.end());
+  for (size_t i = 0; i < chunk->errors.size(); ++i) {
+    LogParseError(chunk->errors[i].message,
+                  first_line + chunk->errors[i].line_number, num_errors);
+  }
+}
+
+void BasicSourceLineResolver::Module::ParseLineRecord(char *line_line,
+                                                      Function *function,
+                                                      ParseChunk *chunk) {
+  if (!function) {
+    if (!chunk->direct && !chunk->sets_function) {
+      // The function these lines belong to, if any, is in an earlier chunk.
+      ParseChunk::LeadingLine leading_line;
+      leading_line.line_number = chunk->line_count;
+      leading_line.valid = ParseLine(line_line, &leading_line.line);
+      chunk->leading_lines.push_back(leading_line);
+      return;
+    }
+    RecordParseError(chunk, "Found source line data without a function");
+    return;
+  }
+  Line line;
+  if (!ParseLine(line_line, &line)) {
+    RecordParseError(chunk, "ParseLine failed");
+    return;
+  }
+  function->lines.StoreRange(line.address, line.size, line);
+  chunk->memory_usage +=
+      RangeEntryMemoryUsage(sizeof(Line), compact_range_maps_);
+}
+
+bool BasicSourceLineResolver::Module::IndexFunction(char *function_line,
+                                                    const char *lines,
+                                                    ParseChunk *chunk) {
+  uint64_t address;
+  uint64_t size;
+  long stack_param_size;
+  char *name;
+  if (!SymbolParseHelper::ParseFunction(function_line, &address, &size,
+                                        &stack_param_size, &name)) {
+    return false;
+  }
+  LazyFunction function = { chunk->Original(name), address, size,
+                            static_cast<int>(stack_param_size), lines };
+  // As in a full load, a function whose range can't be stored is ignored
+  // along with its lines.
+  lazy_functions_.StoreRange(address, size, function);
+  chunk->memory_usage += RangeEntryMemoryUsage(sizeof(function), false);
+  return true;
+}
+
+BasicSourceLineResolver::Function*
+BasicSourceLineResolver::Module::MaterializeFunction(
+    const LazyFunction &lazy_function) const {
+  Function *function = NewFunction(lazy_function.name, lazy_function.address,
+                                   lazy_function.size,
+                                   lazy_function.parameter_size);
+
+  // The function's LINE records run until the next FUNC or PUBLIC record,
+  // possibly interleaved with records of other types.  Loading terminated
+  // each line it walked with a NUL, in place of its '\r' or '\n'.
+  const char *cursor = lazy_function.lines;
+  vector<char> line_line;
+  while (cursor < lazy_buffer_end_) {
+    if (*cursor == '\0' || *cursor == '\r' || *cursor == '\n') {
+      ++cursor;
+      continue;
+    }
+    size_t length = strcspn(cursor, "\r\n");
+    const char *line_start = cursor;
+    cursor += length;
+
+    if (strncmp(line_start, "FUNC ", 5) == 0 ||
+        strncmp(line_start, "PUBLIC ", 7) == 0) {
+      break;
+    }
+    if (strncmp(line_start, "FILE ", 5) == 0 ||
+        strncmp(line_start, "STACK ", 6) == 0 ||
+        strncmp(line_start, "MODULE ", 7) == 0 ||
+        strncmp(line_start, "INFO ", 5) == 0) {
+      continue;
+    }
+
+    // Malformed records were counted as errors by a full load; here they
+    // are just skipped.
+    line_line.assign(line_start, line_start + length);
+    line_line.push_back('\0');
+    Line line;
+    if (ParseLine(&line_line[0], &line))
+      function->lines.StoreRange(line.address, line.size, line);
+  }
+  function->lines.ShrinkToFit();
+  return function;
+}
+
+bool BasicSourceLineResolver::Module::FindFunction(
+    MemAddr address,
+    linked_ptr<Function> *function,
+    MemAddr *function_base,
+    MemAddr *function_size) const {
+  if (!lazy_) {
+    return functions_.RetrieveNearestRange(address, function, function_base,
+                                           NULL /* delta */, function_size);
+  }
+
+  LazyFunction lazy_function;
+  if (!lazy_functions_.RetrieveNearestRange(address, &lazy_function,
+                                            function_base, NULL /* delta */,
+                                            function_size)) {
+    return false;
+  }
+
+  // Only parse the lines of a function that covers |address|; callers
+  // just use the range of any other.
+  if (address < *function_base ||
+      address - *function_base >= *function_size) {
+    function->reset(new Function(lazy_function.name, lazy_function.address,
+                                 lazy_function.size,
+                                 lazy_function.parameter_size));
+    return true;
+  }
+
+  linked_ptr<Function> &materialized =
+      materialized_functions_[lazy_function.address];
+  if (!materialized.get()) {
+    materialized.reset(MaterializeFunction(lazy_function));
+    materialized_memory_usage_ +=
+        kMapNodeOverhead + sizeof(MemAddr) + sizeof(materialized) +
+        FunctionMemoryUsage(*materialized) +
+        materialized->lines.GetCount() *
+            RangeEntryMemoryUsage(sizeof(Line), compact_range_maps_);
+  }
+  *function = materialized;
+  return true;
+}
+
+bool BasicSourceLineResolver::Module::FindPublicSymbol(
+    MemAddr address,
+    linked_ptr<PublicSymbol> *public_symbol,
+    MemAddr *public_address) const {
+  if (!lazy_)
+    return public_symbols_.Retrieve(address, public_symbol, public_address);
+
+  LazyPublicSymbol lazy_symbol;
+  if (!lazy_public_symbols_.Retrieve(address, &lazy_symbol, public_address))
+    return false;
+  public_symbol->reset(new PublicSymbol(lazy_symbol.name, *public_address,
+                                        lazy_symbol.parameter_size));
+  return true;
+}
+
+void BasicSourceLineResolver::Module::LookupAddress(StackFrame *frame,
+                                                    bool share_names) const {
+  std::lock_guard<std::mutex> lock(lookup_mutex_);
   MemAddr address = frame->instruction - frame->module->base_address();
 
   // First, look for a FUNC record that covers address. Use
@@ -207,33 +878,41 @@ void BasicSourceLineResolver::Module::LookupAddress(StackFrame *frame) const {
   MemAddr function_base;
   MemAddr function_size;
   MemAddr public_address;
-  if (functions_.RetrieveNearestRange(address, &func, &function_base,
-                                      NULL /* delta */, &function_size) &&
+  if (FindFunction(address, &func, &function_base, &function_size) &&
       address >= function_base && address - function_base < function_size) {
-    frame->function_name = func->name;
+    if (share_names)
+      frame->interned_function_name = SharedName(func->name.c_str());
+    else
+      frame->function_name = func->name;
     frame->function_base = frame->module->base_address() + function_base;
 
-    linked_ptr<Line> line;
+    Line line;
     MemAddr line_base;
     if (func->lines.RetrieveRange(address, &line, &line_base, NULL /* delta */,
                                   NULL /* size */)) {
-      FileMap::const_iterator it = files_.find(line->source_file_id);
+      FileMap::const_iterator it = files_.find(line.source_file_id);
       if (it != files_.end()) {
-        frame->source_file_name = files_.find(line->source_file_id)->second;
+        if (share_names)
+          frame->interned_source_file_name = SharedName(it->second.c_str());
+        else
+          frame->source_file_name = it->second;
       }
-      frame->source_line = line->line;
+      frame->source_line = line.line;
       frame->source_line_base = frame->module->base_address() + line_base;
     }
-  } else if (public_symbols_.Retrieve(address,
-                                      &public_symbol, &public_address) &&
+  } else if (FindPublicSymbol(address, &public_symbol, &public_address) &&
              (!func.get() || public_address > function_base)) {
-    frame->function_name = public_symbol->name;
+    if (share_names)
+      frame->interned_function_name = SharedName(public_symbol->name.c_str());
+    else
+      frame->function_name = public_symbol->name;
     frame->function_base = frame->module->base_address() + public_address;
   }
 }
 
 WindowsFrameInfo *BasicSourceLineResolver::Module::FindWindowsFrameInfo(
     const StackFrame *frame) const {
+  std::lock_guard<std::mutex> lock(lookup_mutex_);
   MemAddr address = frame->instruction - frame->module->base_address();
   scoped_ptr<WindowsFrameInfo> result(new WindowsFrameInfo());
 
@@ -261,8 +940,7 @@ WindowsFrameInfo *BasicSourceLineResolver::Module::FindWindowsFrameInfo(
   // comparison in an overflow-friendly way.
   linked_ptr<Function> function;
   MemAddr function_base, function_size;
-  if (functions_.RetrieveNearestRange(address, &function, &function_base,
-                                      NULL /* delta */, &function_size) &&
+  if (FindFunction(address, &function, &function_base, &function_size) &&
       address >= function_base && address - function_base < function_size) {
     result->parameter_size = function->parameter_size;
     result->valid |= WindowsFrameInfo::VALID_PARAMETER_SIZE;
@@ -273,7 +951,7 @@ WindowsFrameInfo *BasicSourceLineResolver::Module::FindWindowsFrameInfo(
   // found above to limit the range the public symbol covers.
   linked_ptr<PublicSymbol> public_symbol;
   MemAddr public_address;
-  if (public_symbols_.Retrieve(address, &public_symbol, &public_address) &&
+  if (FindPublicSymbol(address, &public_symbol, &public_address) &&
       (!function.get() || public_address > function_base)) {
     result->parameter_size = public_symbol->parameter_size;
   }
@@ -287,6 +965,47 @@ CFIFrameInfo *BasicSourceLineResolver::Module::FindCFIFrameInfo(
   MemAddr initial_base, initial_size;
   string initial_rules;
 
+  // A frame at an address looked up before uses the rule set found then.
+  CFIFrameInfo *cached = cfi_frame_info_cache_.FindByAddress(address);
+  if (cached)
+    return cached;
+
+  if (lazy_) {
+    const char *lazy_initial_rules;
+    if (!lazy_cfi_initial_rules_.RetrieveRange(address, &lazy_initial_rules,
+                                               &initial_base, NULL /* delta */,
+                                               &initial_size)) {
+      return NULL;
+    }
+    vector<std::pair<MemAddr, const char*> >::const_iterator delta_begin =
+        std::lower_bound(lazy_cfi_delta_rules_.begin(),
+                         lazy_cfi_delta_rules_.end(),
+                         std::make_pair(initial_base,
+                                        static_cast<const char*>(NULL)),
+                         CompareDeltaRules);
+    vector<std::pair<MemAddr, const char*> >::const_iterator delta_end =
+        std::upper_bound(delta_begin, lazy_cfi_delta_rules_.end(),
+                         std::make_pair(address,
+                                        static_cast<const char*>(NULL)),
+                         CompareDeltaRules);
+    MemAddr key = delta_begin == delta_end ? initial_base
+                                           : (delta_end - 1)->first;
+    cached = cfi_frame_info_cache_.Find(key, address);
+    if (cached)
+      return cached;
+
+    scoped_ptr<CFIFrameInfo> rules(new CFIFrameInfo());
+    if (!ParseCFIRuleSet(lazy_initial_rules, rules.get()))
+      return NULL;
+    for (vector<std::pair<MemAddr, const char*> >::const_iterator delta =
+             delta_begin; delta != delta_end; ++delta) {
+      ParseCFIRuleSet(delta->second, rules.get());
+    }
+    rules->Compile();
+    cfi_frame_info_cache_.Insert(key, address, *rules);
+    return rules.release();
+  }
+
   // Find the initial rule whose range covers this address. That
   // provides an initial set of register recovery rules. Then, walk
   // forward from the initial rule's starting address to frame's
@@ -296,30 +1015,51 @@ CFIFrameInfo *BasicSourceLineResolver::Module::FindCFIFrameInfo(
     return NULL;
   }
 
+  // Find the delta rules that fall within the initial rule's range, up to
+  // and including the frame's address. The last of them, or the initial
+  // rule if there are none, keys the rule set in the cache.
+  map<MemAddr, string>::const_iterator delta_begin =
+    cfi_delta_rules_.lower_bound(initial_base);
+  map<MemAddr, string>::const_iterator delta_end =
+    cfi_delta_rules_.upper_bound(address);
+  MemAddr key = initial_base;
+  if (delta_begin != delta_end) {
+    map<MemAddr, string>::const_iterator last_delta = delta_end;
+    key = (--last_delta)->first;
+  }
+  cached = cfi_frame_info_cache_.Find(key, address);
+  if (cached)
+    return cached;
+
   // Create a frame info structure, and populate it with the rules from
   // the STACK CFI INIT record.
   scoped_ptr<CFIFrameInfo> rules(new CFIFrameInfo());
   if (!ParseCFIRuleSet(initial_rules, rules.get()))
     return NULL;
 
-  // Find the first delta rule that falls within the initial rule's range.
-  map<MemAddr, string>::const_iterator delta =
-    cfi_delta_rules_.lower_bound(initial_base);
-
-  // Apply delta rules up to and including the frame's address.
-  while (delta != cfi_delta_rules_.end() && delta->first <= address) {
+  // Apply the delta rules.
+  for (map<MemAddr, string>::const_iterator delta = delta_begin;
+       delta != delta_end; ++delta) {
     ParseCFIRuleSet(delta->second, rules.get());
-    delta++;
   }
 
+  // Compile the rules once for every frame that uses them.
+  rules->Compile();
+  cfi_frame_info_cache_.Insert(key, address, *rules);
   return rules.release();
 }
 
-bool BasicSourceLineResolver::Module::ParseFile(char *file_line) {
+bool BasicSourceLineResolver::Module::ParseFile(char *file_line,
+                                                ParseChunk *chunk) {
   long index;
   char *filename;
   if (SymbolParseHelper::ParseFile(file_line, &index, &filename)) {
-    files_.insert(make_pair(index, string(filename)));
+    if (chunk->direct)
+      files_.insert(make_pair(index, string(filename)));
+    else
+      chunk->files.push_back(make_pair(index, string(filename)));
+    chunk->memory_usage += kMapNodeOverhead + sizeof(FileMap::value_type) +
+                           StringMemoryUsage(strlen(filename));
     return true;
   }
   return false;
@@ -333,13 +1073,40 @@ BasicSourceLineResolver::Module::ParseFunction(char *function_line) {
   char *name;
   if (SymbolParseHelper::ParseFunction(function_line, &address, &size,
                                        &stack_param_size, &name)) {
-    return new Function(name, address, size, stack_param_size);
+    return NewFunction(name, address, size, stack_param_size);
   }
   return NULL;
 }
 
-BasicSourceLineResolver::Line* BasicSourceLineResolver::Module::ParseLine(
-    char *line_line) {
+// static
+size_t BasicSourceLineResolver::Module::RangeEntryMemoryUsage(
+    size_t entry_size, bool compact) {
+  // A compact map keeps a base and a high address and the entry in arrays;
+  // a RangeMap node adds a delta to those.
+  if (compact)
+    return 2 * sizeof(MemAddr) + entry_size;
+  return kMapNodeOverhead + 3 * sizeof(MemAddr) + entry_size;
+}
+
+// static
+size_t BasicSourceLineResolver::Module::FunctionMemoryUsage(
+    const Function &function) {
+  return kHeapBlockOverhead + sizeof(Function) +
+         StringMemoryUsage(function.name.size());
+}
+
+BasicSourceLineResolver::Function*
+BasicSourceLineResolver::Module::NewFunction(const string &name,
+                                             MemAddr address,
+                                             MemAddr size,
+                                             int parameter_size) const {
+  Function *function = new Function(name, address, size, parameter_size);
+  function->lines.SetCompact(compact_range_maps_);
+  return function;
+}
+
+bool BasicSourceLineResolver::Module::ParseLine(char *line_line,
+                                                Line *line) const {
   uint64_t address;
   uint64_t size;
   long line_number;
@@ -347,12 +1114,14 @@ BasicSourceLineResolver::Line* BasicSourceLineResolver::Module::ParseLine(
 
   if (SymbolParseHelper::ParseLine(line_line, &address, &size, &line_number,
                                    &source_file)) {
-    return new Line(address, size, source_file, line_number);
+    *line = Line(address, size, source_file, line_number);
+    return true;
   }
-  return NULL;
+  return false;
 }
 
-bool BasicSourceLineResolver::Module::ParsePublicSymbol(char *public_line) {
+bool BasicSourceLineResolver::Module::ParsePublicSymbol(char *public_line,
+                                                        ParseChunk *chunk) {
   uint64_t address;
   long stack_param_size;
   char *name;
@@ -369,14 +1138,34 @@ bool BasicSourceLineResolver::Module::ParsePublicSymbol(char *public_line) {
       return true;
     }
 
+    if (lazy_) {
+      LazyPublicSymbol symbol = { chunk->Original(name),
+                                  static_cast<int>(stack_param_size) };
+      chunk->memory_usage += kMapNodeOverhead + sizeof(MemAddr) +
+                             sizeof(symbol);
+      return lazy_public_symbols_.Store(address, symbol);
+    }
+
     linked_ptr<PublicSymbol> symbol(new PublicSymbol(name, address,
                                                      stack_param_size));
-    return public_symbols_.Store(address, symbol);
+    chunk->memory_usage += kMapNodeOverhead + sizeof(MemAddr) +
+                           sizeof(symbol) + kHeapBlockOverhead +
+                           sizeof(PublicSymbol) +
+                           StringMemoryUsage(symbol->name.size());
+    if (chunk->direct)
+      return public_symbols_.Store(address, symbol);
+
+    // Whether this address is already taken is only known once the
+    // preceding chunks are merged.
+    ParseChunk::PublicSymbolRecord record = { chunk->line_count, symbol };
+    chunk->public_symbols.push_back(record);
+    return true;
   }
   return false;
 }
 
-bool BasicSourceLineResolver::Module::ParseStackInfo(char *stack_info_line) {
+bool BasicSourceLineResolver::Module::ParseStackInfo(char *stack_info_line,
+                                                     ParseChunk *chunk) {
   // Skip "STACK " prefix.
   stack_info_line += 6;
 
@@ -387,7 +1176,8 @@ bool BasicSourceLineResolver::Module::ParseStackInfo(char *stack_info_line) {
   const char *platform = stack_info_line;
   while (!strchr(kWhitespace, *stack_info_line))
     stack_info_line++;
-  *stack_info_line++ = '\0';
+  if (*stack_info_line != '\0')
+    *stack_info_line++ = '\0';
 
   // MSVC stack frame info.
   if (strcmp(platform, "WIN") == 0) {
@@ -400,6 +1190,12 @@ bool BasicSourceLineResolver::Module::ParseStackInfo(char *stack_info_line) {
                                                          code_size));
     if (stack_frame_info == NULL)
       return false;
+    chunk->memory_usage +=
+        kMapNodeOverhead + sizeof(MemAddr) + sizeof(void*) +
+        kHeapBlockOverhead +
+        sizeof(ContainedRangeMap<MemAddr, linked_ptr<WindowsFrameInfo> >) +
+        kHeapBlockOverhead + sizeof(WindowsFrameInfo) +
+        StringMemoryUsage(stack_frame_info->program_string.size());
 
     // TODO(mmentovai): I wanted to use StoreRange's return value as this
     // method's return value, but MSVC infrequently outputs stack info that
@@ -421,11 +1217,17 @@ bool BasicSourceLineResolver::Module::ParseStackInfo(char *stack_info_line) {
     // if ContainedRangeMap were modified to allow replacement of
     // already-stored values.
 
-    windows_frame_info_[type].StoreRange(rva, code_size, stack_frame_info);
+    if (chunk->direct) {
+      windows_frame_info_[type].StoreRange(rva, code_size, stack_frame_info);
+    } else {
+      ParseChunk::WindowsFrameInfoRecord record =
+          { type, rva, code_size, stack_frame_info };
+      chunk->windows_frame_info.push_back(record);
+    }
     return true;
   } else if (strcmp(platform, "CFI") == 0) {
     // DWARF CFI stack frame info
-    return ParseCFIFrameInfo(stack_info_line);
+    return ParseCFIFrameInfo(stack_info_line, chunk);
   } else {
     // Something unrecognized.
     return false;
@@ -433,37 +1235,67 @@ bool BasicSourceLineResolver::Module::ParseStackInfo(char *stack_info_line) {
 }
 
 bool BasicSourceLineResolver::Module::ParseCFIFrameInfo(
-    char *stack_info_line) {
-  char *cursor;
+    char *stack_info_line,
+    ParseChunk *chunk) {
+  char *cursor = stack_info_line;
+  char *after_number;
 
   // Is this an INIT record or a delta record?
-  char *init_or_address = strtok_r(stack_info_line, " \r\n", &cursor);
+  char *init_or_address = NextField(&cursor);
   if (!init_or_address)
     return false;
 
   if (strcmp(init_or_address, "INIT") == 0) {
     // This record has the form "STACK INIT <address> <size> <rules...>".
-    char *address_field = strtok_r(NULL, " \r\n", &cursor);
+    char *address_field = NextField(&cursor);
     if (!address_field) return false;
 
-    char *size_field = strtok_r(NULL, " \r\n", &cursor);
+    char *size_field = NextField(&cursor);
     if (!size_field) return false;
 
-    char *initial_rules = strtok_r(NULL, "\r\n", &cursor);
+    char *initial_rules = RemainingField(&cursor);
     if (!initial_rules) return false;
 
-    MemAddr address = strtoul(address_field, NULL, 16);
-    MemAddr size    = strtoul(size_field,    NULL, 16);
-    cfi_initial_rules_.StoreRange(address, size, initial_rules);
+    uint64_t address, size;
+    if (!ParseUnsignedNumber<16>(address_field, &address, &after_number) ||
+        !ParseUnsignedNumber<16>(size_field, &size, &after_number))
+      return false;
+    if (lazy_) {
+      lazy_cfi_initial_rules_.StoreRange(address, size,
+                                         chunk->Original(initial_rules));
+      chunk->memory_usage += RangeEntryMemoryUsage(sizeof(const char*), false);
+      return true;
+    }
+    if (chunk->direct) {
+      cfi_initial_rules_.StoreRange(address, size, initial_rules);
+    } else {
+      ParseChunk::CFIInitialRule rule = { address, size, initial_rules };
+      chunk->cfi_initial_rules.push_back(rule);
+    }
+    chunk->memory_usage += RangeEntryMemoryUsage(sizeof(string), false) +
+                           StringMemoryUsage(strlen(initial_rules));
     return true;
   }
 
   // This record has the form "STACK <address> <rules...>".
   char *address_field = init_or_address;
-  char *delta_rules = strtok_r(NULL, "\r\n", &cursor);
+  char *delta_rules = RemainingField(&cursor);
   if (!delta_rules) return false;
-  MemAddr address = strtoul(address_field, NULL, 16);
-  cfi_delta_rules_[address] = delta_rules;
+  uint64_t address;
+  if (!ParseUnsignedNumber<16>(address_field, &address, &after_number))
+    return false;
+  if (lazy_) {
+    lazy_cfi_delta_rules_.push_back(
+        make_pair(address, chunk->Original(delta_rules)));
+    chunk->memory_usage += sizeof(std::pair<MemAddr, const char*>);
+    return true;
+  }
+  if (chunk->direct)
+    cfi_delta_rules_[address] = delta_rules;
+  else
+    chunk->cfi_delta_rules.push_back(make_pair(address, delta_rules));
+  chunk->memory_usage += kMapNodeOverhead + sizeof(MemAddr) + sizeof(string) +
+                         StringMemoryUsage(strlen(delta_rules));
   return true;
 }
 
@@ -474,19 +1306,19 @@ bool SymbolParseHelper::ParseFile(char *file_line, long *index,
   assert(strncmp(file_line, "FILE ", 5) == 0);
   file_line += 5;  // skip prefix
 
-  vector<char*> tokens;
-  if (!Tokenize(file_line, kWhitespace, 2, &tokens)) {
+  char *fields[2];
+  if (!SplitFields(file_line, 2, fields)) {
     return false;
   }
 
   char *after_number;
-  *index = strtol(tokens[0], &after_number, 10);
-  if (!IsValidAfterNumber(after_number) || *index < 0 ||
+  if (!ParseSignedNumber<10>(fields[0], index, &after_number) ||
+      !IsValidAfterNumber(after_number) || *index < 0 ||
       *index == std::numeric_limits<long>::max()) {
     return false;
   }
 
-  *filename = tokens[1];
+  *filename = fields[1];
   if (!*filename) {
     return false;
   }
@@ -502,29 +1334,29 @@ bool SymbolParseHelper::ParseFunction(char *function_line, uint64_t *address,
   assert(strncmp(function_line, "FUNC ", 5) == 0);
   function_line += 5;  // skip prefix
 
-  vector<char*> tokens;
-  if (!Tokenize(function_line, kWhitespace, 4, &tokens)) {
+  char *fields[4];
+  if (!SplitFields(function_line, 4, fields)) {
     return false;
   }
 
   char *after_number;
-  *address = strtoull(tokens[0], &after_number, 16);
-  if (!IsValidAfterNumber(after_number) ||
+  if (!ParseUnsignedNumber<16>(fields[0], address, &after_number) ||
+      !IsValidAfterNumber(after_number) ||
       *address == std::numeric_limits<unsigned long long>::max()) {
     return false;
   }
-  *size = strtoull(tokens[1], &after_number, 16);
-  if (!IsValidAfterNumber(after_number) ||
+  if (!ParseUnsignedNumber<16>(fields[1], size, &after_number) ||
+      !IsValidAfterNumber(after_number) ||
       *size == std::numeric_limits<unsigned long long>::max()) {
     return false;
   }
-  *stack_param_size = strtol(tokens[2], &after_number, 16);
-  if (!IsValidAfterNumber(after_number) ||
+  if (!ParseSignedNumber<16>(fields[2], stack_param_size, &after_number) ||
+      !IsValidAfterNumber(after_number) ||
       *stack_param_size == std::numeric_limits<long>::max() ||
       *stack_param_size < 0) {
     return false;
   }
-  *name = tokens[3];
+  *name = fields[3];
 
   return true;
 }
@@ -534,29 +1366,29 @@ bool SymbolParseHelper::ParseLine(char *line_line, uint64_t *address,
                                   uint64_t *size, long *line_number,
                                   long *source_file) {
   // <address> <size> <line number> <source file id>
-  vector<char*> tokens;
-  if (!Tokenize(line_line, kWhitespace, 4, &tokens)) {
+  char *fields[4];
+  if (!SplitFields(line_line, 4, fields)) {
     return false;
   }
 
   char *after_number;
-  *address  = strtoull(tokens[0], &after_number, 16);
-  if (!IsValidAfterNumber(after_number) ||
+  if (!ParseUnsignedNumber<16>(fields[0], address, &after_number) ||
+      !IsValidAfterNumber(after_number) ||
       *address == std::numeric_limits<unsigned long long>::max()) {
     return false;
   }
-  *size = strtoull(tokens[1], &after_number, 16);
-  if (!IsValidAfterNumber(after_number) ||
+  if (!ParseUnsignedNumber<16>(fields[1], size, &after_number) ||
+      !IsValidAfterNumber(after_number) ||
       *size == std::numeric_limits<unsigned long long>::max()) {
     return false;
   }
-  *line_number = strtol(tokens[2], &after_number, 10);
-  if (!IsValidAfterNumber(after_number) ||
+  if (!ParseSignedNumber<10>(fields[2], line_number, &after_number) ||
+      !IsValidAfterNumber(after_number) ||
       *line_number == std::numeric_limits<long>::max()) {
     return false;
   }
-  *source_file = strtol(tokens[3], &after_number, 10);
-  if (!IsValidAfterNumber(after_number) || *source_file < 0 ||
+  if (!ParseSignedNumber<10>(fields[3], source_file, &after_number) ||
+      !IsValidAfterNumber(after_number) || *source_file < 0 ||
       *source_file == std::numeric_limits<long>::max()) {
     return false;
   }
@@ -583,34 +1415,32 @@ bool SymbolParseHelper::ParsePublicSymbol(char *public_line,
   assert(strncmp(public_line, "PUBLIC ", 7) == 0);
   public_line += 7;  // skip prefix
 
-  vector<char*> tokens;
-  if (!Tokenize(public_line, kWhitespace, 3, &tokens)) {
+  char *fields[3];
+  if (!SplitFields(public_line, 3, fields)) {
     return false;
   }
 
   char *after_number;
-  *address = strtoull(tokens[0], &after_number, 16);
-  if (!IsValidAfterNumber(after_number) ||
+  if (!ParseUnsignedNumber<16>(fields[0], address, &after_number) ||
+      !IsValidAfterNumber(after_number) ||
       *address == std::numeric_limits<unsigned long long>::max()) {
     return false;
   }
-  *stack_param_size = strtol(tokens[1], &after_number, 16);
-  if (!IsValidAfterNumber(after_number) ||
+  if (!ParseSignedNumber<16>(fields[1], stack_param_size, &after_number) ||
+      !IsValidAfterNumber(after_number) ||
       *stack_param_size == std::numeric_limits<long>::max() ||
       *stack_param_size < 0) {
     return false;
   }
-  *name = tokens[2];
+  *name = fields[2];
 
   return true;
 }
 
 // static
 bool SymbolParseHelper::IsValidAfterNumber(char *after_number) {
-  if (after_number != NULL && strchr(kWhitespace, *after_number) != NULL) {
-    return true;
-  }
-  return false;
+  return after_number != NULL && (IsSeparator(*after_number) ||
+                                  *after_number == '\0');
 }
 
 }  // namespace google_breakpad
@@ -0,0 +1,504 @@
+// Copyright (c) 2026 Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// basic_source_line_resolver_benchmark.cc: Measures how long it takes to
+// parse and load text symbol files.
+//
+// The symbol data is either read from the files named on the command line
+// or generated to resemble the output of dump_syms.  For each input, the
+// record parser that BasicSourceLineResolver used to have (strtok_r,
+// Tokenize and strtoull) is timed against SymbolParseHelper on identical
+// copies of the data, and then a full BasicSourceLineResolver load is
+// timed, on one thread and optionally on several.  Both parsers fold
+// every field they produce into a checksum, and the checksums must agree.
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "common/path_helper.h"
+#include "common/using_std_string.h"
+#include "google_breakpad/processor/basic_source_line_resolver.h"
+#include "google_breakpad/processor/stack_frame.h"
+#include "processor/basic_code_module.h"
+#include "processor/tokenize.h"
+
+namespace {
+
+using google_breakpad::BasicCodeModule;
+using google_breakpad::BasicSourceLineResolver;
+using google_breakpad::StackFrame;
+using google_breakpad::SymbolParseHelper;
+using google_breakpad::Tokenize;
+using std::vector;
+
+struct Options {
+  int functions;
+  int lines_per_function;
+  int cfi_per_function;
+  int iterations;
+  int parse_threads;
+  vector<string> symbol_files;
+};
+
+struct ParseResult {
+  uint64_t records;
+  uint64_t checksum;
+};
+
+typedef std::chrono::steady_clock Clock;
+
+// The number of addresses looked up after a lazy load.
+const int kLazyLookups = 64;
+
+// The number of addresses looked up to time lookups in a loaded module.
+const int kLookups = 1000000;
+
+// Looks up kLookups addresses spread over an address range as large as the
+// symbol data, which is about the size of the code that dump_syms output
+// describes.  Returns a checksum of the source lines found.
+uint64_t LookUpAddresses(BasicSourceLineResolver *resolver,
+                         const BasicCodeModule *module,
+                         size_t data_size) {
+  uint64_t checksum = 0;
+  for (int lookup = 0; lookup < kLookups; ++lookup) {
+    StackFrame frame;
+    frame.instruction = (lookup * 0x9e3779b1ULL) % data_size;
+    frame.module = module;
+    resolver->FillSourceLineInfo(&frame);
+    checksum += frame.source_line;
+  }
+  return checksum;
+}
+
+double MillisecondsSince(Clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(Clock::now() - start)
+      .count();
+}
+
+void AppendRecord(string *data, const char *format, ...) {
+  char record[256];
+  va_list args;
+  va_start(args, format);
+  vsnprintf(record, sizeof(record), format, args);
+  va_end(args);
+  data->append(record);
+}
+
+// Generates symbol data shaped like dump_syms output for a large module.
+string GenerateSymbolData(const Options &options) {
+  string data;
+  AppendRecord(&data,
+               "MODULE Linux x86_64 000102030405060708090A0B0C0D0E0F0 "
+               "benchmark\n");
+  AppendRecord(&data, "INFO CODE_ID 0001020304050607\n");
+  const int kFiles = 1000;
+  for (int i = 0; i < kFiles; ++i)
+    AppendRecord(&data, "FILE %d /src/benchmark/dir%d/file%d.cc\n",
+                 i, i % 37, i);
+
+  uint64_t address = 0x1000;
+  for (int i = 0; i < options.functions; ++i) {
+    const uint64_t line_size = 0x10;
+    const uint64_t size = line_size * options.lines_per_function;
+    AppendRecord(&data,
+                 "FUNC %llx %llx 0 benchmark::Namespace%d::Function%d(int)\n",
+                 static_cast<unsigned long long>(address),
+                 static_cast<unsigned long long>(size), i % 101, i);
+    for (int j = 0; j < options.lines_per_function; ++j)
+      AppendRecord(&data, "%llx %llx %d %d\n",
+                   static_cast<unsigned long long>(address + j * line_size),
+                   static_cast<unsigned long long>(line_size),
+                   10 + j * 3, i % kFiles);
+    address += size;
+  }
+
+  address = 0x1000;
+  for (int i = 0; i < options.functions; ++i) {
+    const uint64_t size = 0x10 * options.lines_per_function;
+    AppendRecord(&data, "STACK CFI INIT %llx %llx .cfa: $rsp 8 + .ra: .cfa -8 "
+                 "+ ^\n", static_cast<unsigned long long>(address),
+                 static_cast<unsigned long long>(size));
+    for (int j = 1; j <= options.cfi_per_function; ++j)
+      AppendRecord(&data, "STACK CFI %llx .cfa: $rsp %d +\n",
+                   static_cast<unsigned long long>(address + j),
+                   8 + j * 8);
+    address += size;
+  }
+
+  for (int i = 0; i < options.functions / 10; ++i)
+    AppendRecord(&data, "PUBLIC %llx 0 benchmark_public_%d\n",
+                 static_cast<unsigned long long>(address + i * 0x20), i);
+  return data;
+}
+
+// The record parsing that BasicSourceLineResolver::Module::LoadMapFromMemory
+// and SymbolParseHelper used before they were rewritten, minus building the
+// maps.
+ParseResult ParseWithLibc(char *buffer) {
+  ParseResult result = { 0, 0 };
+  char *save_ptr;
+  vector<char*> tokens;
+  for (char *line = strtok_r(buffer, "\r\n", &save_ptr); line;
+       line = strtok_r(NULL, "\r\n", &save_ptr)) {
+    ++result.records;
+    char *after_number;
+    if (strncmp(line, "FILE ", 5) == 0) {
+      if (Tokenize(line + 5, " \r\n", 2, &tokens)) {
+        result.checksum += strtol(tokens[0], &after_number, 10);
+        result.checksum += strlen(tokens[1]);
+      }
+    } else if (strncmp(line, "FUNC ", 5) == 0) {
+      if (Tokenize(line + 5, " \r\n", 4, &tokens)) {
+        result.checksum += strtoull(tokens[0], &after_number, 16);
+        result.checksum += strtoull(tokens[1], &after_number, 16);
+        result.checksum += strtol(tokens[2], &after_number, 16);
+        result.checksum += strlen(tokens[3]);
+      }
+    } else if (strncmp(line, "PUBLIC ", 7) == 0) {
+      if (Tokenize(line + 7, " \r\n", 3, &tokens)) {
+        result.checksum += strtoull(tokens[0], &after_number, 16);
+        result.checksum += strtol(tokens[1], &after_number, 16);
+        result.checksum += strlen(tokens[2]);
+      }
+    } else if (strncmp(line, "STACK ", 6) == 0 ||
+               strncmp(line, "MODULE ", 7) == 0 ||
+               strncmp(line, "INFO ", 5) == 0) {
+      // Not handled by SymbolParseHelper.
+    } else {
+      if (Tokenize(line, " \r\n", 4, &tokens)) {
+        result.checksum += strtoull(tokens[0], &after_number, 16);
+        result.checksum += strtoull(tokens[1], &after_number, 16);
+        result.checksum += strtol(tokens[2], &after_number, 10);
+        result.checksum += strtol(tokens[3], &after_number, 10);
+      }
+    }
+  }
+  return result;
+}
+
+// The same work as ParseWithLibc, using SymbolParseHelper and splitting
+// lines the way LoadMapFromMemory now does.
+ParseResult ParseWithHelper(char *buffer, size_t size) {
+  ParseResult result = { 0, 0 };
+  char *buffer_end = buffer + size;
+  char *cursor = buffer;
+  while (cursor < buffer_end) {
+    if (*cursor == '\r' || *cursor == '\n') {
+      ++cursor;
+      continue;
+    }
+    char *line = cursor;
+    char *end_of_line =
+        static_cast<char*>(memchr(line, '\n', buffer_end - line));
+    if (!end_of_line)
+      end_of_line = buffer_end;
+    char *carriage_return =
+        static_cast<char*>(memchr(line, '\r', end_of_line - line));
+    if (carriage_return)
+      end_of_line = carriage_return;
+    *end_of_line = '\0';
+    cursor = end_of_line + 1;
+
+    ++result.records;
+    uint64_t address, size;
+    long number, other_number;
+    char *name;
+    if (strncmp(line, "FILE ", 5) == 0) {
+      if (SymbolParseHelper::ParseFile(line, &number, &name))
+        result.checksum += number + strlen(name);
+    } else if (strncmp(line, "FUNC ", 5) == 0) {
+      if (SymbolParseHelper::ParseFunction(line, &address, &size, &number,
+                                           &name))
+        result.checksum += address + size + number + strlen(name);
+    } else if (strncmp(line, "PUBLIC ", 7) == 0) {
+      if (SymbolParseHelper::ParsePublicSymbol(line, &address, &number,
+                                               &name))
+        result.checksum += address + number + strlen(name);
+    } else if (strncmp(line, "STACK ", 6) == 0 ||
+               strncmp(line, "MODULE ", 7) == 0 ||
+               strncmp(line, "INFO ", 5) == 0) {
+      // Not handled by SymbolParseHelper.
+    } else {
+      if (SymbolParseHelper::ParseLine(line, &address, &size, &number,
+                                       &other_number))
+        result.checksum += address + size + number + other_number;
+    }
+  }
+  return result;
+}
+
+// Runs the benchmarks on |data|, returning false if the parsers disagree.
+bool RunBenchmark(const Options &options, const string &description,
+                  const string &data) {
+  printf("%s: %zu bytes, best of %d runs\n", description.c_str(),
+         data.size(), options.iterations);
+
+  double libc_ms = 0, helper_ms = 0, load_ms = 0, parallel_load_ms = 0;
+  double lazy_load_ms = 0, lazy_lookup_ms = 0;
+  double compact_load_ms = 0, lookup_ms = 0, compact_lookup_ms = 0;
+  ParseResult libc_result = { 0, 0 }, helper_result = { 0, 0 };
+  vector<char> buffer(data.size() + 1);
+  for (int i = 0; i < options.iterations; ++i) {
+    memcpy(&buffer[0], data.c_str(), buffer.size());
+    Clock::time_point start = Clock::now();
+    libc_result = ParseWithLibc(&buffer[0]);
+    double elapsed = MillisecondsSince(start);
+    if (i == 0 || elapsed < libc_ms)
+      libc_ms = elapsed;
+
+    memcpy(&buffer[0], data.c_str(), buffer.size());
+    start = Clock::now();
+    helper_result = ParseWithHelper(&buffer[0], data.size());
+    elapsed = MillisecondsSince(start);
+    if (i == 0 || elapsed < helper_ms)
+      helper_ms = elapsed;
+
+    BasicSourceLineResolver resolver;
+    BasicCodeModule module(0, 0, "benchmark", "", "benchmark.pdb", "", "");
+    start = Clock::now();
+    if (!resolver.LoadModuleUsingMapBuffer(&module, data)) {
+      fprintf(stderr, "%s: failed to load symbols\n", description.c_str());
+      return false;
+    }
+    elapsed = MillisecondsSince(start);
+    if (i == 0 || elapsed < load_ms)
+      load_ms = elapsed;
+
+    BasicSourceLineResolver compact_resolver;
+    compact_resolver.set_compact_range_maps(true);
+    start = Clock::now();
+    if (!compact_resolver.LoadModuleUsingMapBuffer(&module, data)) {
+      fprintf(stderr, "%s: failed to load symbols\n", description.c_str());
+      return false;
+    }
+    elapsed = MillisecondsSince(start);
+    if (i == 0 || elapsed < compact_load_ms)
+      compact_load_ms = elapsed;
+
+    start = Clock::now();
+    uint64_t lookup_checksum = LookUpAddresses(&resolver, &module,
+                                               data.size());
+    elapsed = MillisecondsSince(start);
+    if (i == 0 || elapsed < lookup_ms)
+      lookup_ms = elapsed;
+
+    start = Clock::now();
+    uint64_t compact_lookup_checksum =
+        LookUpAddresses(&compact_resolver, &module, data.size());
+    elapsed = MillisecondsSince(start);
+    if (i == 0 || elapsed < compact_lookup_ms)
+      compact_lookup_ms = elapsed;
+    if (lookup_checksum != compact_lookup_checksum) {
+      fprintf(stderr, "%s: compact lookups disagree\n", description.c_str());
+      return false;
+    }
+
+    if (options.parse_threads > 1) {
+      BasicSourceLineResolver parallel_resolver;
+      parallel_resolver.set_max_parse_threads(options.parse_threads);
+      start = Clock::now();
+      if (!parallel_resolver.LoadModuleUsingMapBuffer(&module, data)) {
+        fprintf(stderr, "%s: failed to load symbols\n", description.c_str());
+        return false;
+      }
+      elapsed = MillisecondsSince(start);
+      if (i == 0 || elapsed < parallel_load_ms)
+        parallel_load_ms = elapsed;
+    }
+
+    BasicSourceLineResolver lazy_resolver;
+    lazy_resolver.set_lazy_loading(true);
+    start = Clock::now();
+    if (!lazy_resolver.LoadModuleUsingMapBuffer(&module, data)) {
+      fprintf(stderr, "%s: failed to load symbols\n", description.c_str());
+      return false;
+    }
+    elapsed = MillisecondsSince(start);
+    if (i == 0 || elapsed < lazy_load_ms)
+      lazy_load_ms = elapsed;
+
+    // A stack walk only looks up a few addresses in each module.
+    start = Clock::now();
+    for (int lookup = 0; lookup < kLazyLookups; ++lookup) {
+      StackFrame frame;
+      frame.instruction = 0x1000 + lookup * 0x10000;
+      frame.module = &module;
+      lazy_resolver.FillSourceLineInfo(&frame);
+    }
+    elapsed = MillisecondsSince(start);
+    if (i == 0 || elapsed < lazy_lookup_ms)
+      lazy_lookup_ms = elapsed;
+  }
+
+  printf("  records:                     %llu\n",
+         static_cast<unsigned long long>(helper_result.records));
+  printf("  strtok_r/Tokenize/strtoull:  %10.2f ms\n", libc_ms);
+  printf("  SymbolParseHelper:           %10.2f ms (%.2fx)\n", helper_ms,
+         helper_ms > 0 ? libc_ms / helper_ms : 0);
+  printf("  BasicSourceLineResolver load:%10.2f ms\n", load_ms);
+  if (options.parse_threads > 1) {
+    printf("  ... on %2d threads:           %10.2f ms (%.2fx)\n",
+           options.parse_threads, parallel_load_ms,
+           parallel_load_ms > 0 ? load_ms / parallel_load_ms : 0);
+  }
+  printf("  ... into compact maps:       %10.2f ms (%.2fx)\n",
+         compact_load_ms, compact_load_ms > 0 ? load_ms / compact_load_ms : 0);
+  printf("  ... lazily:                  %10.2f ms (%.2fx)\n", lazy_load_ms,
+         lazy_load_ms > 0 ? load_ms / lazy_load_ms : 0);
+  printf("  ... then %d lookups:         %10.2f ms\n", kLazyLookups,
+         lazy_lookup_ms);
+  printf("  %d lookups:             %10.2f ms\n", kLookups, lookup_ms);
+  printf("  ... in compact maps:         %10.2f ms (%.2fx)\n",
+         compact_lookup_ms,
+         compact_lookup_ms > 0 ? lookup_ms / compact_lookup_ms : 0);
+
+  if (libc_result.records != helper_result.records ||
+      libc_result.checksum != helper_result.checksum) {
+    fprintf(stderr, "%s: parsers disagree\n", description.c_str());
+    return false;
+  }
+  return true;
+}
+
+bool ReadFile(const string &path, string *data) {
+  FILE *file = fopen(path.c_str(), "rb");
+  if (!file) {
+    fprintf(stderr, "Could not open %s\n", path.c_str());
+    return false;
+  }
+  char chunk[65536];
+  size_t read;
+  while ((read = fread(chunk, 1, sizeof(chunk), file)) > 0)
+    data->append(chunk, read);
+  bool ok = !ferror(file);
+  fclose(file);
+  return ok;
+}
+
+//=============================================================================
+static void Usage(int argc, const char *argv[], bool error) {
+  fprintf(error ? stderr : stdout,
+          "Usage: %s [options] [symbol-file] [...]\n"
+          "\n"
+          "Time parsing and loading of text symbol files.  Without\n"
+          "symbol-file arguments, synthetic symbol data is used.\n"
+          "\n"
+          "Options:\n"
+          "\n"
+          "  -f <count>  Synthetic FUNC records (default %d)\n"
+          "  -l <count>  Line records per function (default %d)\n"
+          "  -c <count>  STACK CFI delta records per function (default %d)\n"
+          "  -n <count>  Runs per input; the fastest is reported "
+          "(default %d)\n"
+          "  -t <count>  Also load symbols on this many threads\n",
+          google_breakpad::BaseName(argv[0]).c_str(),
+          200000, 8, 4, 3);
+}
+
+static int ParseCount(int argc, const char *argv[], const char *value) {
+  char *end;
+  long count = strtol(value, &end, 10);
+  if (*value == '\0' || *end != '\0' || count <= 0 || count > 100000000) {
+    fprintf(stderr, "%s: Invalid count %s\n", argv[0], value);
+    Usage(argc, argv, true);
+    exit(1);
+  }
+  return static_cast<int>(count);
+}
+
+static void SetupOptions(int argc, const char *argv[], Options *options) {
+  int ch;
+
+  options->functions = 200000;
+  options->lines_per_function = 8;
+  options->cfi_per_function = 4;
+  options->iterations = 3;
+  options->parse_threads = 1;
+
+  while ((ch = getopt(argc, (char * const *)argv, "c:f:hl:n:t:")) != -1) {
+    switch (ch) {
+      case 'h':
+        Usage(argc, argv, false);
+        exit(0);
+        break;
+
+      case 'c':
+        options->cfi_per_function = ParseCount(argc, argv, optarg);
+        break;
+      case 'f':
+        options->functions = ParseCount(argc, argv, optarg);
+        break;
+      case 'l':
+        options->lines_per_function = ParseCount(argc, argv, optarg);
+        break;
+      case 'n':
+        options->iterations = ParseCount(argc, argv, optarg);
+        break;
+      case 't':
+        options->parse_threads = ParseCount(argc, argv, optarg);
+        break;
+
+      case '?':
+        Usage(argc, argv, true);
+        exit(1);
+        break;
+    }
+  }
+
+  for (int argi = optind; argi < argc; ++argi)
+    options->symbol_files.push_back(argv[argi]);
+}
+
+}  // namespace
+
+int main(int argc, const char *argv[]) {
+  Options options;
+  SetupOptions(argc, argv, &options);
+
+  bool ok = true;
+  if (options.symbol_files.empty()) {
+    ok = RunBenchmark(options, "synthetic", GenerateSymbolData(options));
+  }
+  for (size_t i = 0; i < options.symbol_files.size(); ++i) {
+    string data;
+    if (!ReadFile(options.symbol_files[i], &data)) {
+      ok = false;
+      continue;
+    }
+    ok = RunBenchmark(options, options.symbol_files[i], data) && ok;
+  }
+  return ok ? 0 : 1;
+}
@@ -38,13 +38,17 @@
 #define PROCESSOR_BASIC_SOURCE_LINE_RESOLVER_TYPES_H__
 
 #include <map>
+#include <mutex>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "common/scoped_ptr.h"
 #include "google_breakpad/processor/basic_source_line_resolver.h"
 #include "processor/source_line_resolver_base_types.h"
 
 #include "processor/address_map-inl.h"
+#include "processor/compact_range_map-inl.h"
 #include "processor/range_map-inl.h"
 #include "processor/contained_range_map-inl.h"
 
@@ -65,7 +69,7 @@ BasicSourceLineResolver::Function : public SourceLineResolverBase::Function {
                                           code_size,
                                           set_parameter_size),
                                      lines() { }
-  RangeMap< MemAddr, linked_ptr<Line> > lines;
+  SelectableRangeMap<MemAddr, Line> lines;
  private:
   typedef SourceLineResolverBase::Function Base;
 };
@@ -73,9 +77,32 @@ BasicSourceLineResolver::Function : public SourceLineResolverBase::Function {
 
 class BasicSourceLineResolver::Module : public SourceLineResolverBase::Module {
  public:
-  explicit Module(const string &name) : name_(name), is_corrupt_(false) { }
+  explicit Module(const string &name)
+      : name_(name), is_corrupt_(false), max_parse_threads_(1), lazy_(false),
+        lazy_buffer_end_(NULL), compact_range_maps_(false),
+        memory_usage_(0), materialized_memory_usage_(0) { }
   virtual ~Module() { }
 
+  // Sets the number of threads LoadMapFromMemory may use.  With more than
+  // one, large symbol files are split into chunks of whole lines that are
+  // parsed concurrently and then merged in file order.
+  void set_max_parse_threads(unsigned int max_threads) {
+    max_parse_threads_ = max_threads ? max_threads : 1;
+  }
+
+  // Makes LoadMapFromMemory index the symbol data instead of parsing all of
+  // it; see BasicSourceLineResolver::set_lazy_loading.  The module then
+  // points into |memory_buffer|, which must outlive it.
+  void set_lazy_loading(bool lazy) { lazy_ = lazy; }
+
+  // Stores functions and their lines in CompactRangeMaps; see
+  // BasicSourceLineResolver::set_compact_range_maps.  Must be called before
+  // the module is loaded.
+  void set_compact_range_maps(bool compact) {
+    compact_range_maps_ = compact;
+    functions_.SetCompact(compact);
+  }
+
   // Loads a map from the given buffer in char* type.
   // Does NOT have ownership of memory_buffer.
   // The passed in |memory buffer| is of size |memory_buffer_size|.  If it is
@@ -89,8 +116,9 @@ class BasicSourceLineResolver::Module : public SourceLineResolverBase::Module {
   virtual bool IsCorrupt() const { return is_corrupt_; }
 
   // Looks up the given relative address, and fills the StackFrame struct
-  // with the result.
-  virtual void LookupAddress(StackFrame *frame) const;
+  // with the result, sharing the module's copies of the names found if
+  // SHARE_NAMES is true.
+  virtual void LookupAddress(StackFrame *frame, bool share_names) const;
 
   // If Windows stack walking information is available covering ADDRESS,
   // return a WindowsFrameInfo structure describing it. If the information
@@ -105,6 +133,18 @@ class BasicSourceLineResolver::Module : public SourceLineResolverBase::Module {
   // returned CFIFrameInfo object.
   virtual CFIFrameInfo *FindCFIFrameInfo(const StackFrame *frame) const;
 
+  virtual CFIFrameInfoCache::Stats CFIFrameInfoCacheStats() const {
+    return cfi_frame_info_cache_.stats();
+  }
+
+  // Counts the records parsed or indexed on load, and the functions a lazy
+  // load has parsed since.
+  virtual size_t MemoryUsage() const {
+    std::lock_guard<std::mutex> lock(lookup_mutex_);
+    return sizeof(*this) + memory_usage_ + materialized_memory_usage_ +
+           SharedNameMemoryUsage();
+  }
+
  private:
   // Friend declarations.
   friend class BasicSourceLineResolver;
@@ -120,29 +160,110 @@ class BasicSourceLineResolver::Module : public SourceLineResolverBase::Module {
       int line_number,
       int *num_errors);
 
+  // Records parsed from part of a symbol file; see LoadMapFromMemory.
+  struct ParseChunk;
+
+  // A FUNC record indexed by a lazy load.  The function's LINE records,
+  // which follow |lines| in the symbol data, are parsed the first time the
+  // function is looked up.
+  struct LazyFunction {
+    const char *name;
+    MemAddr address;
+    MemAddr size;
+    int parameter_size;
+    const char *lines;
+  };
+
+  // A PUBLIC record indexed by a lazy load.
+  struct LazyPublicSymbol {
+    const char *name;
+    int parameter_size;
+  };
+
+  // Finds the function whose range is nearest below |address|, as
+  // functions_.RetrieveNearestRange would, parsing its lines if the module
+  // was loaded lazily.
+  bool FindFunction(MemAddr address,
+                    linked_ptr<Function> *function,
+                    MemAddr *function_base,
+                    MemAddr *function_size) const;
+
+  // Finds the PUBLIC symbol at or below |address|, as
+  // public_symbols_.Retrieve would.
+  bool FindPublicSymbol(MemAddr address,
+                        linked_ptr<PublicSymbol> *public_symbol,
+                        MemAddr *public_address) const;
+
+  // Returns a Function built from |lazy_function| and its LINE records.
+  Function *MaterializeFunction(const LazyFunction &lazy_function) const;
+
+  // Returns the estimated memory taken by an entry of |entry_size| bytes in
+  // a range map, compact or not.
+  static size_t RangeEntryMemoryUsage(size_t entry_size, bool compact);
+
+  // Returns the estimated memory taken by |function| itself, not counting
+  // its lines or the map entry that holds it.
+  static size_t FunctionMemoryUsage(const Function &function);
+
+  // Indexes the FUNC record at |function_line| for a lazy load.  Its LINE
+  // records start at |lines|.  Returns false if the record is malformed.
+  bool IndexFunction(char *function_line, const char *lines,
+                     ParseChunk *chunk);
+
+  // Releases the spare capacity in the compact range maps, once the module
+  // is loaded.
+  void ShrinkRangeMaps();
+
+  // Parses the lines in |chunk|, storing or queueing the records found.
+  void ParseChunkRecords(ParseChunk *chunk);
+
+  // Stores the records queued by a chunk parsed on its own thread.
+  // |first_line| is the line number of the line before the chunk, and
+  // |*cur_func| is the function that the lines at the start of the chunk
+  // belong to, updated to the one that the next chunk's lines belong to.
+  void MergeChunk(ParseChunk *chunk,
+                  int first_line,
+                  linked_ptr<Function> *cur_func,
+                  int *num_errors);
+
+  // Logs or queues a parse error for the current line of |chunk|.
+  static void RecordParseError(ParseChunk *chunk, const char *message);
+
   // Parses a file declaration
-  bool ParseFile(char *file_line);
+  bool ParseFile(char *file_line, ParseChunk *chunk);
 
   // Parses a function declaration, returning a new Function object.
   Function* ParseFunction(char *function_line);
 
-  // Parses a line declaration, returning a new Line object.
-  Line* ParseLine(char *line_line);
+  // Returns a new Function with no lines, whose lines are stored as the
+  // module's options say.
+  Function *NewFunction(const string &name, MemAddr address, MemAddr size,
+                        int parameter_size) const;
+
+  // Parses a line declaration into |*line|.  Returns false if an error
+  // occurs.
+  bool ParseLine(char *line_line, Line *line) const;
+
+  // Parses a line declaration and stores it in |function|'s line map,
+  // recording an error if there is no current function or the record is
+  // malformed.
+  void ParseLineRecord(char *line_line, Function *function,
+                       ParseChunk *chunk);
 
   // Parses a PUBLIC symbol declaration, storing it in public_symbols_.
   // Returns false if an error occurs.
-  bool ParsePublicSymbol(char *public_line);
+  bool ParsePublicSymbol(char *public_line, ParseChunk *chunk);
 
   // Parses a STACK WIN or STACK CFI frame info declaration, storing
   // it in the appropriate table.
-  bool ParseStackInfo(char *stack_info_line);
+  bool ParseStackInfo(char *stack_info_line, ParseChunk *chunk);
 
   // Parses a STACK CFI record, storing it in cfi_frame_info_.
-  bool ParseCFIFrameInfo(char *stack_info_line);
+  bool ParseCFIFrameInfo(char *stack_info_line, ParseChunk *chunk);
 
   string name_;
   FileMap files_;
-  RangeMap< MemAddr, linked_ptr<Function> > functions_;
+  SelectableRangeMap< MemAddr, linked_ptr<Function> > functions_;
   AddressMap< MemAddr, linked_ptr<PublicSymbol> > public_symbols_;
   bool is_corrupt_;
 
@@ -170,6 +291,44 @@ class BasicSourceLineResolver::Module : public SourceLineResolverBase::Module {
   // this map, or the end of the range as given by the cfi_initial_rules_
   // entry (which FindCFIFrameInfo looks up first).
   std::map<MemAddr, string> cfi_delta_rules_;
+
+  // Rule sets FindCFIFrameInfo has already parsed and compiled, and the
+  // instruction addresses it has looked them up for.
+  mutable CFIFrameInfoCache cfi_frame_info_cache_;
+
+  // The number of threads LoadMapFromMemory may use.
+  unsigned int max_parse_threads_;
+
+  // When the module is loaded lazily, FUNC, PUBLIC and STACK CFI records
+  // are only indexed, in the maps below, which point into the symbol data
+  // and take the place of functions_, public_symbols_ and the cfi_ maps.
+  // FILE and STACK WIN records are still parsed on load.
+  bool lazy_;
+  const char *lazy_buffer_end_;
+  RangeMap<MemAddr, LazyFunction> lazy_functions_;
+  AddressMap<MemAddr, LazyPublicSymbol> lazy_public_symbols_;
+  RangeMap<MemAddr, const char*> lazy_cfi_initial_rules_;
+
+  // STACK CFI delta records, sorted by address once loading is done.
+  std::vector<std::pair<MemAddr, const char*> > lazy_cfi_delta_rules_;
+
+  // Held by LookupAddress and FindWindowsFrameInfo, which copy the
+  // linked_ptrs holding the module's records, and so update their shared
+  // reference rings, and may materialize functions.  FindCFIFrameInfo
+  // only reads the module, besides its cache, so it doesn't take it.
+  // Guards materialized_functions_ and materialized_memory_usage_.
+  mutable std::mutex lookup_mutex_;
+
+  // The functions parsed so far from lazy_functions_, by address.
+  mutable std::map<MemAddr, linked_ptr<Function> > materialized_functions_;
+
+  // Whether functions_ and each function's lines are CompactRangeMaps.
+  bool compact_range_maps_;
+
+  // The estimated memory taken by the records parsed or indexed on load,
+  // and by the functions materialized since; see MemoryUsage.
+  size_t memory_usage_;
+  mutable size_t materialized_memory_usage_;
 };
 
 }  // namespace google_breakpad
@@ -31,6 +31,7 @@
 #include <stdio.h>
 
 #include <string>
+#include <vector>
 
 #include "breakpad_googletest_includes.h"
 #include "common/scoped_ptr.h"
@@ -163,6 +164,50 @@ static void ClearSourceLineInfo(StackFrame *frame) {
   frame->source_line = 0;
 }
 
+// Checks that looking up each address below |max_address| in |module|
+// gives the same results from |resolver| and |other_resolver|.
+static void CheckSameLookups(BasicSourceLineResolver *resolver,
+                             BasicSourceLineResolver *other_resolver,
+                             const CodeModule *module,
+                             uint64_t max_address) {
+  for (uint64_t address = 0; address < max_address; ++address) {
+    StackFrame frame;
+    frame.instruction = address;
+    frame.module = module;
+    StackFrame other_frame = frame;
+    resolver->FillSourceLineInfo(&frame);
+    other_resolver->FillSourceLineInfo(&other_frame);
+    ASSERT_EQ(frame.function_name, other_frame.function_name);
+    ASSERT_EQ(frame.function_base, other_frame.function_base);
+    ASSERT_EQ(frame.source_file_name, other_frame.source_file_name);
+    ASSERT_EQ(frame.source_line, other_frame.source_line);
+    ASSERT_EQ(frame.source_line_base, other_frame.source_line_base);
+
+    scoped_ptr<WindowsFrameInfo> windows_frame_info(
+        resolver->FindWindowsFrameInfo(&frame));
+    scoped_ptr<WindowsFrameInfo> other_windows_frame_info(
+        other_resolver->FindWindowsFrameInfo(&other_frame));
+    ASSERT_EQ(!windows_frame_info.get(), !other_windows_frame_info.get());
+    if (windows_frame_info.get()) {
+      ASSERT_EQ(windows_frame_info->valid, other_windows_frame_info->valid);
+      ASSERT_EQ(windows_frame_info->parameter_size,
+                other_windows_frame_info->parameter_size);
+      ASSERT_EQ(windows_frame_info->program_string,
+                other_windows_frame_info->program_string);
+    }
+
+    scoped_ptr<CFIFrameInfo> cfi_frame_info(
+        resolver->FindCFIFrameInfo(&frame));
+    scoped_ptr<CFIFrameInfo> other_cfi_frame_info(
+        other_resolver->FindCFIFrameInfo(&other_frame));
+    ASSERT_EQ(!cfi_frame_info.get(), !other_cfi_frame_info.get());
+    if (cfi_frame_info.get()) {
+      ASSERT_EQ(cfi_frame_info->Serialize(),
+                other_cfi_frame_info->Serialize());
+    }
+  }
+}
+
 class TestBasicSourceLineResolver : public ::testing::Test {
 public:
   void SetUp() {
@@ -413,6 +458,493 @@ TEST_F(TestBasicSourceLineResolver, TestUnload)
   ASSERT_TRUE(resolver.HasModule(&module1));
 }
 
+// Records may end in "\r\n", and blank lines are skipped.
+TEST_F(TestBasicSourceLineResolver, TestLoadLineEndings)
+{
+  TestCodeModule module1("module1");
+  const string symbol_data =
+      "MODULE Linux x86 ABCDEF1 module1\r\n"
+      "FILE 1 file 1.cc\r\n"
+      "\r\n"
+      "FUNC 1000 20 0 Function(int, char)\r\n"
+      "1000 10 44 1\r\n"
+      "1010 10 45 1\n"
+      "\n"
+      "STACK CFI INIT 1000 20 .cfa: $esp 4 + .ra: .cfa 4 - ^\r\n"
+      "STACK CFI 1010 .cfa: $esp 8 +\r\n";
+  ASSERT_TRUE(resolver.LoadModuleUsingMapBuffer(&module1, symbol_data));
+  ASSERT_FALSE(resolver.IsModuleCorrupt(&module1));
+
+  StackFrame frame;
+  frame.instruction = 0x1014;
+  frame.module = &module1;
+  resolver.FillSourceLineInfo(&frame);
+  ASSERT_EQ(frame.function_name, "Function(int, char)");
+  ASSERT_EQ(frame.source_file_name, "file 1.cc");
+  ASSERT_EQ(frame.source_line, 45);
+  ASSERT_EQ(frame.source_line_base, 0x1010U);
+
+  scoped_ptr<CFIFrameInfo> cfi_frame_info(resolver.FindCFIFrameInfo(&frame));
+  ASSERT_TRUE(cfi_frame_info.get());
+  ASSERT_EQ(cfi_frame_info->Serialize(), ".cfa: $esp 8 + .ra: .cfa 4 - ^");
+}
+
+// Rule sets are cached by the last STACK CFI record applied, so lookups in
+// any order should yield the rules in effect at each address.
+TEST_F(TestBasicSourceLineResolver, TestCFIFrameInfoCache)
+{
+  TestCodeModule module1("module1");
+  const string symbol_data =
+      "MODULE Linux x86 ABCDEF1 module1\n"
+      "STACK CFI INIT 1000 40 .cfa: $esp 4 + .ra: .cfa 4 - ^\n"
+      "STACK CFI 1010 .cfa: $esp 8 +\n"
+      "STACK CFI 1020 .cfa: $esp 12 + $ebp: .cfa 8 - ^\n"
+      "STACK CFI INIT 1040 10 .cfa: $esp 16 + .ra: .cfa 4 - ^\n"
+      "STACK CFI INIT 2000 10 .cfa: $esp $T0 = $T0 .ra: .cfa ^\n";
+  const struct {
+    uint64_t address;
+    const char *rules;
+    bool compiled;
+  } kLookups[] = {
+    { 0x1020, ".cfa: $esp 12 + .ra: .cfa 4 - ^ $ebp: .cfa 8 - ^", true },
+    { 0x1000, ".cfa: $esp 4 + .ra: .cfa 4 - ^", true },
+    { 0x1014, ".cfa: $esp 8 + .ra: .cfa 4 - ^", true },
+    { 0x100f, ".cfa: $esp 4 + .ra: .cfa 4 - ^", true },
+    { 0x103f, ".cfa: $esp 12 + .ra: .cfa 4 - ^ $ebp: .cfa 8 - ^", true },
+    { 0x1040, ".cfa: $esp 16 + .ra: .cfa 4 - ^", true },
+    { 0x1010, ".cfa: $esp 8 + .ra: .cfa 4 - ^", true },
+    { 0x2004, ".cfa: $esp $T0 = $T0 .ra: .cfa ^", false },
+    { 0x1048, ".cfa: $esp 16 + .ra: .cfa 4 - ^", true },
+    { 0x2004, ".cfa: $esp $T0 = $T0 .ra: .cfa ^", false },
+    { 0x1024, ".cfa: $esp 12 + .ra: .cfa 4 - ^ $ebp: .cfa 8 - ^", true },
+  };
+
+  for (int lazy = 0; lazy < 2; ++lazy) {
+    BasicSourceLineResolver resolver;
+    resolver.set_lazy_loading(lazy);
+    ASSERT_TRUE(resolver.LoadModuleUsingMapBuffer(&module1, symbol_data));
+    for (int pass = 0; pass < 2; ++pass) {
+      for (size_t i = 0; i < sizeof(kLookups) / sizeof(kLookups[0]); ++i) {
+        StackFrame frame;
+        frame.instruction = kLookups[i].address;
+        frame.module = &module1;
+        scoped_ptr<CFIFrameInfo> cfi_frame_info(
+            resolver.FindCFIFrameInfo(&frame));
+        ASSERT_TRUE(cfi_frame_info.get());
+        ASSERT_EQ(kLookups[i].rules, cfi_frame_info->Serialize());
+        ASSERT_EQ(kLookups[i].compiled, cfi_frame_info->IsCompiled());
+      }
+    }
+    StackFrame frame;
+    frame.instruction = 0x1050;
+    frame.module = &module1;
+    ASSERT_TRUE(resolver.FindCFIFrameInfo(&frame) == NULL);
+
+    // Only the first lookup using each of the five rule sets builds it,
+    // and the counts outlive the module.
+    ASSERT_EQ(17U, resolver.cfi_cache_hits());
+    ASSERT_EQ(5U, resolver.cfi_cache_misses());
+    resolver.UnloadModule(&module1);
+    ASSERT_EQ(17U, resolver.cfi_cache_hits());
+    ASSERT_EQ(5U, resolver.cfi_cache_misses());
+  }
+}
+
+// Loading a large file on several threads gives the same module as loading
+// it on one.
+TEST_F(TestBasicSourceLineResolver, TestParallelLoad)
+{
+  const int kFunctions = 20000;
+  const int kLinesPerFunction = 7;
+  string symbol_data = "MODULE Linux x86 ABCDEF1 module1\n";
+  char record[128];
+  for (int i = 0; i < 100; ++i) {
+    snprintf(record, sizeof(record), "FILE %d file%d.cc\n", i, i);
+    symbol_data += record;
+  }
+  for (int i = 0; i < kFunctions; ++i) {
+    snprintf(record, sizeof(record), "FUNC %x %x %x Function%d\n",
+             0x1000 + i * 0x100, kLinesPerFunction * 0x10, i % 16, i);
+    symbol_data += record;
+    for (int j = 0; j < kLinesPerFunction; ++j) {
+      snprintf(record, sizeof(record), "%x 10 %d %d\n",
+               0x1000 + i * 0x100 + j * 0x10, i + j, i % 100);
+      symbol_data += record;
+    }
+    snprintf(record, sizeof(record), "PUBLIC %x 4 Public%d\n",
+             0x1080 + i * 0x100, i);
+    symbol_data += record;
+  }
+  for (int i = 0; i < kFunctions; ++i) {
+    snprintf(record, sizeof(record),
+             "STACK CFI INIT %x 80 .cfa: $esp 4 + .ra: .cfa 4 - ^\n"
+             "STACK CFI %x .cfa: $esp %d +\n",
+             0x1000 + i * 0x100, 0x1001 + i * 0x100, 8 + i % 16);
+    symbol_data += record;
+  }
+  // A duplicate public symbol makes the module corrupt, however it's loaded.
+  symbol_data += "PUBLIC 1080 4 Duplicate\n";
+
+  TestCodeModule module1("module1");
+  BasicSourceLineResolver parallel_resolver;
+  parallel_resolver.set_max_parse_threads(4);
+  ASSERT_EQ(parallel_resolver.max_parse_threads(), 4U);
+  ASSERT_TRUE(resolver.LoadModuleUsingMapBuffer(&module1, symbol_data));
+  ASSERT_TRUE(parallel_resolver.LoadModuleUsingMapBuffer(&module1,
+                                                         symbol_data));
+  ASSERT_TRUE(resolver.IsModuleCorrupt(&module1));
+  ASSERT_TRUE(parallel_resolver.IsModuleCorrupt(&module1));
+
+  for (int i = 0; i < kFunctions; ++i) {
+    for (int offset = 0; offset < 0x100; offset += 0x18) {
+      StackFrame frame;
+      frame.instruction = 0x1000 + i * 0x100 + offset;
+      frame.module = &module1;
+      StackFrame parallel_frame = frame;
+      resolver.FillSourceLineInfo(&frame);
+      parallel_resolver.FillSourceLineInfo(&parallel_frame);
+      ASSERT_EQ(frame.function_name, parallel_frame.function_name);
+      ASSERT_EQ(frame.function_base, parallel_frame.function_base);
+      ASSERT_EQ(frame.source_file_name, parallel_frame.source_file_name);
+      ASSERT_EQ(frame.source_line, parallel_frame.source_line);
+      ASSERT_EQ(frame.source_line_base, parallel_frame.source_line_base);
+
+      scoped_ptr<CFIFrameInfo> cfi_frame_info(
+          resolver.FindCFIFrameInfo(&frame));
+      scoped_ptr<CFIFrameInfo> parallel_cfi_frame_info(
+          parallel_resolver.FindCFIFrameInfo(&parallel_frame));
+      ASSERT_EQ(!cfi_frame_info.get(), !parallel_cfi_frame_info.get());
+      if (cfi_frame_info.get()) {
+        ASSERT_EQ(cfi_frame_info->Serialize(),
+                  parallel_cfi_frame_info->Serialize());
+      }
+    }
+  }
+}
+
+// Looking up addresses in lazily loaded modules gives the same results as
+// in fully loaded ones.
+// STACK CFI addresses and sizes are read the way strtoull reads hex
+// numbers: an optional sign and 0x prefix are accepted, negative numbers
+// wrap, and characters after the digits are ignored.  A field with no
+// digits, or one too large for 64 bits, makes the record a parse error.
+TEST_F(TestBasicSourceLineResolver, TestStackCFINumbers)
+{
+  TestCodeModule module1("module1");
+  const string symbol_data =
+      "MODULE Linux x86 ABCDEF1 module1\n"
+      "STACK CFI INIT 0x1000 +20 .cfa: $esp 4 + .ra: .cfa 4 - ^\n"
+      "STACK CFI 1010zz .cfa: $esp 8 +\n"
+      "STACK CFI INIT -2000 10 .cfa: $esp 12 + .ra: .cfa 4 - ^\n";
+  ASSERT_TRUE(resolver.LoadModuleUsingMapBuffer(&module1, symbol_data));
+  ASSERT_FALSE(resolver.IsModuleCorrupt(&module1));
+
+  StackFrame frame;
+  frame.instruction = 0x1014;
+  frame.module = &module1;
+  scoped_ptr<CFIFrameInfo> cfi_frame_info(resolver.FindCFIFrameInfo(&frame));
+  ASSERT_TRUE(cfi_frame_info.get());
+  ASSERT_EQ(cfi_frame_info->Serialize(), ".cfa: $esp 8 + .ra: .cfa 4 - ^");
+  frame.instruction = 0xffffffffffffe004ULL;
+  cfi_frame_info.reset(resolver.FindCFIFrameInfo(&frame));
+  ASSERT_TRUE(cfi_frame_info.get());
+  ASSERT_EQ(cfi_frame_info->Serialize(), ".cfa: $esp 12 + .ra: .cfa 4 - ^");
+
+  const char *kInvalidRecords[] = {
+    "STACK CFI INIT zz 20 .cfa: $esp 4 + .ra: .cfa 4 - ^\n",
+    "STACK CFI INIT 1000 - .cfa: $esp 4 + .ra: .cfa 4 - ^\n",
+    "STACK CFI INIT 10000000000000000 20 .cfa: $esp 4 + .ra: .cfa 4 - ^\n",
+    "STACK CFI INIT 1000 10000000000000000 .cfa: $esp 4 + .ra: .cfa 4 - ^\n",
+    "STACK CFI +x .cfa: $esp 8 +\n",
+    "STACK CFI -10000000000000000 .cfa: $esp 8 +\n",
+  };
+  for (size_t i = 0; i < sizeof(kInvalidRecords) / sizeof(kInvalidRecords[0]);
+       ++i) {
+    TestCodeModule module2("module2");
+    ASSERT_TRUE(resolver.LoadModuleUsingMapBuffer(
+        &module2, string("MODULE Linux x86 ABCDEF1 module2\n") +
+                  kInvalidRecords[i]));
+    ASSERT_TRUE(resolver.IsModuleCorrupt(&module2)) << kInvalidRecords[i];
+    resolver.UnloadModule(&module2);
+  }
+}
+
+TEST_F(TestBasicSourceLineResolver, TestLazyLoad)
+{
+  TestCodeModule module1("module1");
+  TestCodeModule module2("module2");
+  TestCodeModule module3("module3");
+  // LINE records interleaved with other records, line endings of both
+  // kinds, and a delta rule that replaces an earlier one at its address.
+  const string symbol_data =
+      "MODULE Linux x86 ABCDEF1 module3\r\n"
+      "FILE 1 file1.cc\r\n"
+      "FUNC 1000 30 4 Function1\r\n"
+      "1000 10 10 1\r\n"
+      "STACK CFI INIT 1000 30 .cfa: $esp 4 + .ra: .cfa 4 - ^\r\n"
+      "STACK CFI 1010 .cfa: $esp 8 +\n"
+      "FILE 2 file2.cc\n"
+      "1010 10 20 2\n"
+      "STACK CFI 1010 .cfa: $esp 12 +\n"
+      "\n"
+      "1020 10 30 1\n"
+      "PUBLIC 1040 8 Public1\n"
+      "FUNC 1100 10 0 Function2\n"
+      "1100 10 40 2";
+
+  BasicSourceLineResolver lazy_resolver;
+  lazy_resolver.set_lazy_loading(true);
+  ASSERT_TRUE(lazy_resolver.lazy_loading());
+  ASSERT_FALSE(lazy_resolver.ShouldDeleteMemoryBufferAfterLoadModule());
+  ASSERT_TRUE(resolver.LoadModule(&module1, testdata_dir + "/module1.out"));
+  ASSERT_TRUE(lazy_resolver.LoadModule(&module1,
+                                       testdata_dir + "/module1.out"));
+  ASSERT_TRUE(resolver.LoadModule(&module2, testdata_dir + "/module2.out"));
+  ASSERT_TRUE(lazy_resolver.LoadModule(&module2,
+                                       testdata_dir + "/module2.out"));
+  ASSERT_TRUE(resolver.LoadModuleUsingMapBuffer(&module3, symbol_data));
+  ASSERT_TRUE(lazy_resolver.LoadModuleUsingMapBuffer(&module3,
+                                                     symbol_data));
+  ASSERT_FALSE(lazy_resolver.IsModuleCorrupt(&module1));
+  ASSERT_FALSE(lazy_resolver.IsModuleCorrupt(&module3));
+
+  const CodeModule *modules[] = { &module1, &module2, &module3 };
+  for (size_t i = 0; i < sizeof(modules) / sizeof(modules[0]); ++i) {
+    CheckSameLookups(&resolver, &lazy_resolver, modules[i], 0x4000);
+  }
+
+  StackFrame frame;
+  frame.instruction = 0x1018;
+  frame.module = &module3;
+  lazy_resolver.FillSourceLineInfo(&frame);
+  ASSERT_EQ(frame.function_name, "Function1");
+  ASSERT_EQ(frame.source_file_name, "file2.cc");
+  ASSERT_EQ(frame.source_line, 20);
+  scoped_ptr<CFIFrameInfo> cfi_frame_info(
+      lazy_resolver.FindCFIFrameInfo(&frame));
+  ASSERT_TRUE(cfi_frame_info.get());
+  ASSERT_EQ(cfi_frame_info->Serialize(), ".cfa: $esp 12 + .ra: .cfa 4 - ^");
+
+  // Lines without a function are still detected on load.
+  TestCodeModule module4("module4");
+  ASSERT_TRUE(lazy_resolver.LoadModuleUsingMapBuffer(
+      &module4, "FILE 1 file1.cc\n1000 10 10 1\n"));
+  ASSERT_TRUE(lazy_resolver.IsModuleCorrupt(&module4));
+
+  lazy_resolver.UnloadModule(&module1);
+  ASSERT_FALSE(lazy_resolver.HasModule(&module1));
+}
+
+// Storing functions and lines in compact range maps doesn't change the
+// results of lookups.
+// Frames filled in sharing names hold the module's copies, eagerly or
+// lazily loaded.
+TEST_F(TestBasicSourceLineResolver, TestShareNames)
+{
+  TestCodeModule module("module");
+  const string symbol_data =
+      "MODULE Linux x86 ABCDEF1 module\n"
+      "FILE 1 file1.cc\n"
+      "FUNC 1000 30 4 Function1\n"
+      "1000 10 10 1\n"
+      "1010 10 20 1\n"
+      "PUBLIC 1040 8 Public1\n";
+
+  BasicSourceLineResolver lazy_resolver;
+  lazy_resolver.set_lazy_loading(true);
+  BasicSourceLineResolver *resolvers[] = { &resolver, &lazy_resolver };
+  for (int i = 0; i < 2; i++) {
+    ASSERT_TRUE(resolvers[i]->LoadModuleUsingMapBuffer(&module, symbol_data));
+    StackFrame first, second, public_frame;
+    first.instruction = 0x1000;
+    first.module = &module;
+    second.instruction = 0x1014;
+    second.module = &module;
+    public_frame.instruction = 0x1044;
+    public_frame.module = &module;
+    ASSERT_TRUE(resolvers[i]->FillSourceLineInfoSharingNames(&first));
+    ASSERT_TRUE(resolvers[i]->FillSourceLineInfoSharingNames(&second));
+    ASSERT_TRUE(resolvers[i]->FillSourceLineInfoSharingNames(&public_frame));
+
+    EXPECT_TRUE(first.function_name.empty());
+    EXPECT_TRUE(first.source_file_name.empty());
+    EXPECT_EQ("Function1", first.FunctionName());
+    EXPECT_EQ("file1.cc", first.SourceFileName());
+    EXPECT_EQ(0x1000U, second.function_base);
+    EXPECT_EQ(20, second.source_line);
+    EXPECT_EQ(first.interned_function_name, second.interned_function_name);
+    EXPECT_EQ(first.interned_source_file_name,
+              second.interned_source_file_name);
+    EXPECT_EQ("Public1", public_frame.FunctionName());
+    EXPECT_TRUE(public_frame.interned_source_file_name == NULL);
+
+    // The names outlive the module.
+    resolvers[i]->UnloadModule(&module);
+    EXPECT_EQ("Function1", second.FunctionName());
+    EXPECT_EQ("file1.cc", second.SourceFileName());
+  }
+}
+
+TEST_F(TestBasicSourceLineResolver, TestCompactRangeMaps)
+{
+  TestCodeModule module1("module1");
+  TestCodeModule module2("module2");
+  TestCodeModule module3("module3");
+  // Records out of address order, and overlapping ranges.
+  const string symbol_data =
+      "FILE 1 file1.cc\n"
+      "FUNC 1100 30 0 Function2\n"
+      "1120 10 12 1\n"
+      "1100 10 10 1\n"
+      "1108 10 11 1\n"
+      "FUNC 1000 30 4 Function1\n"
+      "1000 30 20 1\n"
+      "FUNC 1010 10 4 Overlapping\n"
+      "1010 10 30 1\n";
+
+  BasicSourceLineResolver compact_resolver;
+  compact_resolver.set_compact_range_maps(true);
+  ASSERT_TRUE(compact_resolver.compact_range_maps());
+  ASSERT_TRUE(resolver.LoadModule(&module1, testdata_dir + "/module1.out"));
+  ASSERT_TRUE(compact_resolver.LoadModule(&module1,
+                                          testdata_dir + "/module1.out"));
+  ASSERT_TRUE(resolver.LoadModule(&module2, testdata_dir + "/module2.out"));
+  ASSERT_TRUE(compact_resolver.LoadModule(&module2,
+                                          testdata_dir + "/module2.out"));
+  ASSERT_TRUE(resolver.LoadModuleUsingMapBuffer(&module3, symbol_data));
+  ASSERT_TRUE(compact_resolver.LoadModuleUsingMapBuffer(&module3,
+                                                        symbol_data));
+
+  CheckSameLookups(&resolver, &compact_resolver, &module1, 0x4000);
+  CheckSameLookups(&resolver, &compact_resolver, &module2, 0x4000);
+  CheckSameLookups(&resolver, &compact_resolver, &module3, 0x1200);
+
+  // Lazily loaded functions' lines are compact too.
+  BasicSourceLineResolver lazy_compact_resolver;
+  lazy_compact_resolver.set_compact_range_maps(true);
+  lazy_compact_resolver.set_lazy_loading(true);
+  ASSERT_TRUE(lazy_compact_resolver.LoadModuleUsingMapBuffer(&module3,
+                                                             symbol_data));
+  CheckSameLookups(&resolver, &lazy_compact_resolver, &module3, 0x1200);
+}
+
+TEST_F(TestBasicSourceLineResolver, TestSymbolDataBudget)
+{
+  TestCodeModule module1("module1");
+  TestCodeModule module2("module2");
+  TestCodeModule module3("module3");
+  ASSERT_EQ(resolver.symbol_data_budget(), 0U);
+  ASSERT_TRUE(resolver.LoadModule(&module1, testdata_dir + "/module1.out"));
+  size_t module1_data = resolver.loaded_symbol_data();
+  ASSERT_GT(module1_data, 0U);
+  ASSERT_TRUE(resolver.LoadModule(&module2, testdata_dir + "/module2.out"));
+  size_t module2_data = resolver.loaded_symbol_data() - module1_data;
+  ASSERT_GT(module2_data, 0U);
+
+  // Both modules fit, so setting the budget evicts nothing.
+  resolver.set_symbol_data_budget(module1_data + module2_data);
+  ASSERT_EQ(resolver.module_cache_evictions(), 0U);
+
+  // Using module1 leaves module2 as the least recently used module, so it is
+  // the one evicted to make room for module3.
+  StackFrame frame;
+  frame.instruction = 0x1000;
+  frame.module = &module1;
+  resolver.FillSourceLineInfo(&frame);
+  ASSERT_EQ(frame.function_name, "Function1_1");
+  ASSERT_TRUE(resolver.LoadModule(&module3, testdata_dir + "/module2.out"));
+  ASSERT_EQ(resolver.module_cache_evictions(), 1U);
+  ASSERT_EQ(resolver.loaded_symbol_data(), module1_data + module2_data);
+  ASSERT_TRUE(resolver.HasModule(&module1));
+  ASSERT_FALSE(resolver.HasModule(&module2));
+  ASSERT_TRUE(resolver.HasModule(&module3));
+  ASSERT_EQ(resolver.module_cache_hits(), 2U);
+  ASSERT_EQ(resolver.module_cache_misses(), 1U);
+
+  // An evicted module can be loaded again, at the expense of module3, which
+  // is now less recently used than module1.
+  ASSERT_TRUE(resolver.HasModule(&module1));
+  ASSERT_TRUE(resolver.LoadModule(&module2, testdata_dir + "/module2.out"));
+  ASSERT_EQ(resolver.module_cache_evictions(), 2U);
+  ASSERT_TRUE(resolver.HasModule(&module1));
+  ASSERT_TRUE(resolver.HasModule(&module2));
+  ASSERT_FALSE(resolver.HasModule(&module3));
+
+  // A module larger than the budget is kept once loaded, alone.
+  resolver.set_symbol_data_budget(1);
+  ASSERT_EQ(resolver.loaded_symbol_data(), 0U);
+  ASSERT_TRUE(resolver.LoadModule(&module1, testdata_dir + "/module1.out"));
+  ASSERT_TRUE(resolver.HasModule(&module1));
+  ASSERT_EQ(resolver.loaded_symbol_data(), module1_data);
+
+  // Explicit unloads are not evictions.
+  resolver.UnloadModule(&module1);
+  ASSERT_EQ(resolver.loaded_symbol_data(), 0U);
+  ASSERT_EQ(resolver.module_cache_evictions(), 4U);
+}
+
+// A lazily loaded module's memory grows as lookups parse its functions.
+TEST_F(TestBasicSourceLineResolver, TestLazyModuleMemoryGrows)
+{
+  TestCodeModule module1("module1");
+  BasicSourceLineResolver lazy_resolver;
+  lazy_resolver.set_lazy_loading(true);
+  ASSERT_TRUE(lazy_resolver.LoadModule(&module1,
+                                       testdata_dir + "/module1.out"));
+  size_t loaded = lazy_resolver.loaded_symbol_data();
+  ASSERT_GT(loaded, 0U);
+
+  StackFrame frame;
+  frame.instruction = 0x1000;
+  frame.module = &module1;
+  lazy_resolver.FillSourceLineInfo(&frame);
+  ASSERT_EQ(frame.function_name, "Function1_1");
+  ASSERT_GT(lazy_resolver.loaded_symbol_data(), loaded);
+}
+
+// Whether an evicted module's buffer is reported for freeing depends on
+// whether the module was loaded lazily, not on the current setting.
+TEST_F(TestBasicSourceLineResolver, TestEvictionAfterLazyLoadingChanges)
+{
+  TestCodeModule module1("module1");
+  TestCodeModule module2("module2");
+  char *buffer1;
+  size_t buffer1_size;
+  char *buffer2;
+  size_t buffer2_size;
+  ASSERT_TRUE(BasicSourceLineResolver::ReadSymbolFile(
+      testdata_dir + "/module1.out", &buffer1, &buffer1_size));
+  ASSERT_TRUE(BasicSourceLineResolver::ReadSymbolFile(
+      testdata_dir + "/module2.out", &buffer2, &buffer2_size));
+  resolver.set_symbol_data_budget(1);
+
+  // module1 keeps its buffer, so its eviction is reported even though
+  // lazy loading was turned off in between.
+  resolver.set_lazy_loading(true);
+  ASSERT_FALSE(resolver.ShouldDeleteMemoryBufferAfterLoadModule());
+  ASSERT_TRUE(resolver.LoadModuleUsingMemoryBuffer(&module1, buffer1,
+                                                   buffer1_size));
+  resolver.set_lazy_loading(false);
+  ASSERT_TRUE(resolver.ShouldDeleteMemoryBufferAfterLoadModule());
+  ASSERT_TRUE(resolver.LoadModuleUsingMemoryBuffer(&module2, buffer2,
+                                                   buffer2_size));
+  std::vector<string> unloaded;
+  resolver.TakeUnloadedModules(&unloaded);
+  ASSERT_EQ(unloaded.size(), 1U);
+  EXPECT_EQ(unloaded[0], "module1");
+  delete [] buffer1;
+
+  // module2 was parsed in full, and its buffer may already be gone, so its
+  // eviction isn't reported even though lazy loading is on again.
+  delete [] buffer2;
+  resolver.set_lazy_loading(true);
+  ASSERT_TRUE(resolver.LoadModule(&module1, testdata_dir + "/module1.out"));
+  ASSERT_FALSE(resolver.HasModule(&module2));
+  unloaded.clear();
+  resolver.TakeUnloadedModules(&unloaded);
+  EXPECT_TRUE(unloaded.empty());
+}
+
 // Test parsing of valid FILE lines.  The format is:
 // FILE <id> <filename>
 TEST(SymbolParseHelper, ParseFileValid) {
@@ -36,10 +36,26 @@
 #ifndef PROCESSOR_CFI_FRAME_INFO_INL_H_
 #define PROCESSOR_CFI_FRAME_INFO_INL_H_
 
+#include <assert.h>
 #include <string.h>
 
 namespace google_breakpad {
 
+template <typename RegisterType, class RawContextType>
+SimpleCFIWalker<RegisterType, RawContextType>::SimpleCFIWalker(
+    const RegisterSet *register_map, size_t map_size)
+    : register_map_(register_map), map_size_(map_size) {
+  assert(map_size_ + 2 <= static_cast<size_t>(RegisterTable::kMaxRegisters));
+  for (size_t i = 0; i < map_size_; i++) {
+    const RegisterSet &r = register_map_[i];
+    name_index_[i] = register_table_.Add(r.name);
+    alternate_name_index_[i] =
+        r.alternate_name ? register_table_.Add(r.alternate_name) : -1;
+  }
+  register_table_.Add(".cfa");
+  register_table_.Add(".ra");
+}
+
 template <typename RegisterType, class RawContextType>
 bool SimpleCFIWalker<RegisterType, RawContextType>::FindCallerRegisters(
     const MemoryRegion &memory,
@@ -48,17 +64,15 @@ bool SimpleCFIWalker<RegisterType, RawContextType>::FindCallerRegisters(
     int callee_validity,
     RawContextType *caller_context,
     int *caller_validity) const {
-  typedef CFIFrameInfo::RegisterValueMap<RegisterType> ValueMap;
-  ValueMap callee_registers;
-  ValueMap caller_registers;
-  // Just for brevity.
-  typename ValueMap::const_iterator caller_none = caller_registers.end();
+  typedef RegisterDictionary<RegisterType> Dictionary;
+  Dictionary callee_registers(&register_table_);
+  Dictionary caller_registers(&register_table_);
 
   // Populate callee_registers with register values from callee_context.
   for (size_t i = 0; i < map_size_; i++) {
     const RegisterSet &r = register_map_[i];
     if (callee_validity & r.validity_flag)
-      callee_registers[r.name] = callee_context.*r.context_member;
+      callee_registers.Set(name_index_[i], callee_context.*r.context_member);
   }
 
   // Apply the rules, and see what register values they yield.
@@ -72,27 +86,16 @@ bool SimpleCFIWalker<RegisterType, RawContextType>::FindCallerRegisters(
   *caller_validity = 0;
   for (size_t i = 0; i < map_size_; i++) {
     const RegisterSet &r = register_map_[i];
-    typename ValueMap::const_iterator caller_entry;
+    RegisterType *caller_value = &(caller_context->*r.context_member);
 
-    // Did the rules provide a value for this register by its name?
-    caller_entry = caller_registers.find(r.name);
-    if (caller_entry != caller_none) {
-      caller_context->*r.context_member = caller_entry->second;
+    // Did the rules provide a value for this register by its name, or
+    // under its alternate name?
+    if (caller_registers.Get(name_index_[i], caller_value) ||
+        caller_registers.Get(alternate_name_index_[i], caller_value)) {
       *caller_validity |= r.validity_flag;
       continue;
     }
 
-    // Did the rules provide a value for this register under its
-    // alternate name?
-    if (r.alternate_name) {
-      caller_entry = caller_registers.find(r.alternate_name);
-      if (caller_entry != caller_none) {
-        caller_context->*r.context_member = caller_entry->second;
-        *caller_validity |= r.validity_flag;
-        continue;
-      }
-    }
-
     // Is this a callee-saves register? The walker assumes that these
     // still hold the caller's value if the CFI doesn't mention them.
     //
@@ -57,9 +57,14 @@ bool CFIFrameInfo::FindCallerRegs(const RegisterValueMap<V> &registers,
                                   RegisterValueMap<V> *caller_registers) const {
   // If there are not rules for both .ra and .cfa in effect at this address,
   // don't use this CFI data for stack walking.
-  if (cfa_rule_.empty() || ra_rule_.empty())
+  if (rules_->cfa_rule.empty() || rules_->ra_rule.empty())
     return false;
 
+  if (rules_->compiled) {
+    caller_registers->clear();
+    return FindCallerRegsCompiled<V>(registers, memory, caller_registers);
+  }
+
   RegisterValueMap<V> working;
   PostfixEvaluator<V> evaluator(&working, &memory);
 
@@ -68,19 +73,19 @@ bool CFIFrameInfo::FindCallerRegs(const RegisterValueMap<V> &registers,
   // First, compute the CFA.
   V cfa;
   working = registers;
-  if (!evaluator.EvaluateForValue(cfa_rule_, &cfa))
+  if (!evaluator.EvaluateForValue(rules_->cfa_rule, &cfa))
     return false;
 
   // Then, compute the return address.
   V ra;
   working = registers;
   working[".cfa"] = cfa;
-  if (!evaluator.EvaluateForValue(ra_rule_, &ra))
+  if (!evaluator.EvaluateForValue(rules_->ra_rule, &ra))
     return false;
 
-  // Now, compute values for all the registers register_rules_ mentions.
-  for (RuleMap::const_iterator it = register_rules_.begin();
-       it != register_rules_.end(); it++) {
+  // Now, compute values for all the registers the register rules mention.
+  for (RuleMap::const_iterator it = rules_->register_rules.begin();
+       it != rules_->register_rules.end(); it++) {
     V value;
     working = registers;
     working[".cfa"] = cfa;
@@ -95,6 +100,140 @@ bool CFIFrameInfo::FindCallerRegs(const RegisterValueMap<V> &registers,
   return true;
 }
 
+template<typename V>
+bool CFIFrameInfo::FindCallerRegs(
+    const RegisterDictionary<V> &registers,
+    const MemoryRegion &memory,
+    RegisterDictionary<V> *caller_registers) const {
+  if (rules_->cfa_rule.empty() || rules_->ra_rule.empty())
+    return false;
+
+  caller_registers->Clear();
+  if (rules_->compiled && caller_registers->table() == registers.table()) {
+    return FindCallerRegsCompiled<V>(*Bind(registers.table()), registers,
+                                     memory, caller_registers);
+  }
+
+  // Rules that couldn't be compiled, or dictionaries with different
+  // tables, are evaluated with the registers in maps.
+  const RegisterTable *table = registers.table();
+  RegisterValueMap<V> register_map;
+  for (int i = 0; i < table->size(); i++) {
+    V value;
+    if (registers.Get(i, &value))
+      register_map[table->name(i)] = value;
+  }
+
+  RegisterValueMap<V> caller_register_map;
+  if (!FindCallerRegs(register_map, memory, &caller_register_map))
+    return false;
+  for (typename RegisterValueMap<V>::const_iterator it =
+           caller_register_map.begin();
+       it != caller_register_map.end(); it++) {
+    caller_registers->Set(it->first, it->second);
+  }
+  return true;
+}
+
+template<typename V>
+bool CFIFrameInfo::FindCallerRegsCompiled(
+    const RegisterValueMap<V> &registers,
+    const MemoryRegion &memory,
+    RegisterValueMap<V> *caller_registers) const {
+  // The programs see the CFA without it being added to a copy of
+  // REGISTERS, as it is for the evaluator in FindCallerRegs.
+  V cfa;
+  if (!rules_->compiled->cfa_rule.Evaluate(registers, static_cast<V*>(NULL),
+                                           memory, &cfa))
+    return false;
+
+  V ra;
+  if (!rules_->compiled->ra_rule.Evaluate(registers, &cfa, memory, &ra))
+    return false;
+
+  for (size_t i = 0; i < rules_->compiled->register_rules.size(); i++) {
+    V value;
+    if (!rules_->compiled->register_rules[i].second.Evaluate(
+            registers, &cfa, memory, &value))
+      return false;
+    (*caller_registers)[rules_->compiled->register_rules[i].first] = value;
+  }
+
+  (*caller_registers)[".ra"] = ra;
+  (*caller_registers)[".cfa"] = cfa;
+
+  return true;
+}
+
+template<typename V>
+bool CFIFrameInfo::FindCallerRegsCompiled(
+    const Binding &binding,
+    const RegisterDictionary<V> &registers,
+    const MemoryRegion &memory,
+    RegisterDictionary<V> *caller_registers) const {
+  V cfa;
+  if (!rules_->compiled->cfa_rule.Evaluate(registers, binding.cfa_rule,
+                                           static_cast<V*>(NULL), memory,
+                                           &cfa))
+    return false;
+
+  V ra;
+  if (!rules_->compiled->ra_rule.Evaluate(registers, binding.ra_rule, &cfa,
+                                          memory, &ra))
+    return false;
+
+  for (size_t i = 0; i < rules_->compiled->register_rules.size(); i++) {
+    V value;
+    if (!rules_->compiled->register_rules[i].second.Evaluate(
+            registers, binding.register_rules[i], &cfa, memory, &value))
+      return false;
+    caller_registers->Set(binding.registers[i], value);
+  }
+
+  caller_registers->Set(binding.ra, ra);
+  caller_registers->Set(binding.cfa, cfa);
+
+  return true;
+}
+
+const CFIFrameInfo::Binding *CFIFrameInfo::Bind(
+    const RegisterTable *table) const {
+  const Binding *head =
+      rules_->compiled->binding.load(std::memory_order_acquire);
+  for (;;) {
+    for (const Binding *binding = head; binding; binding = binding->previous) {
+      if (binding->table.SameNames(*table))
+        return binding;
+    }
+
+    scoped_ptr<Binding> new_binding(new Binding);
+    new_binding->table = *table;
+    rules_->compiled->cfa_rule.Bind(*table, &new_binding->cfa_rule);
+    rules_->compiled->ra_rule.Bind(*table, &new_binding->ra_rule);
+    size_t rule_count = rules_->compiled->register_rules.size();
+    new_binding->register_rules.resize(rule_count);
+    new_binding->registers.resize(rule_count);
+    for (size_t i = 0; i < rule_count; i++) {
+      rules_->compiled->register_rules[i].second.Bind(
+          *table, &new_binding->register_rules[i]);
+      new_binding->registers[i] =
+          table->IndexOf(rules_->compiled->register_rules[i].first);
+    }
+    new_binding->cfa = table->IndexOf(".cfa");
+    new_binding->ra = table->IndexOf(".ra");
+    new_binding->previous = head;
+
+    // Another thread may have added a binding meanwhile; if so, look
+    // through the bindings again, since it may be for the same names.
+    if (rules_->compiled->binding.compare_exchange_strong(
+            head, new_binding.get(), std::memory_order_acq_rel,
+            std::memory_order_acquire)) {
+      return new_binding.release();
+    }
+    new_binding->previous = NULL;
+  }
+}
+
 // Explicit instantiations for 32-bit and 64-bit architectures.
 template bool CFIFrameInfo::FindCallerRegs<uint32_t>(
     const RegisterValueMap<uint32_t> &registers,
@@ -104,20 +243,65 @@ template bool CFIFrameInfo::FindCallerRegs<uint64_t>(
     const RegisterValueMap<uint64_t> &registers,
     const MemoryRegion &memory,
     RegisterValueMap<uint64_t> *caller_registers) const;
+template bool CFIFrameInfo::FindCallerRegs<uint32_t>(
+    const RegisterDictionary<uint32_t> &registers,
+    const MemoryRegion &memory,
+    RegisterDictionary<uint32_t> *caller_registers) const;
+template bool CFIFrameInfo::FindCallerRegs<uint64_t>(
+    const RegisterDictionary<uint64_t> &registers,
+    const MemoryRegion &memory,
+    RegisterDictionary<uint64_t> *caller_registers) const;
+
+// static
+RegisterTable CFIFrameInfo::MakeRegisterTable(const char * const *names) {
+  RegisterTable table(names);
+  table.Add(".cfa");
+  table.Add(".ra");
+  return table;
+}
+
+CFIFrameInfo::Rules *CFIFrameInfo::MutableRules() {
+  // Only this object can reach rules no other copy shares, so no other
+  // copy can start sharing them while they are changed.
+  if (rules_.use_count() > 1)
+    rules_ = std::make_shared<Rules>(*rules_);
+  return rules_.get();
+}
+
+bool CFIFrameInfo::Compile() {
+  Rules *rules = MutableRules();
+  rules->compiled.reset();
+
+  std::shared_ptr<CompiledRules> compiled(new CompiledRules);
+  if (!compiled->cfa_rule.Compile(rules->cfa_rule) ||
+      !compiled->ra_rule.Compile(rules->ra_rule))
+    return false;
+  compiled->register_rules.resize(rules->register_rules.size());
+  size_t i = 0;
+  for (RuleMap::const_iterator it = rules->register_rules.begin();
+       it != rules->register_rules.end(); it++, i++) {
+    compiled->register_rules[i].first = it->first;
+    if (!compiled->register_rules[i].second.Compile(it->second))
+      return false;
+  }
+
+  rules->compiled = compiled;
+  return true;
+}
 
 string CFIFrameInfo::Serialize() const {
   std::ostringstream stream;
 
-  if (!cfa_rule_.empty()) {
-    stream << ".cfa: " << cfa_rule_;
+  if (!rules_->cfa_rule.empty()) {
+    stream << ".cfa: " << rules_->cfa_rule;
   }
-  if (!ra_rule_.empty()) {
+  if (!rules_->ra_rule.empty()) {
     if (static_cast<std::streamoff>(stream.tellp()) != 0)
       stream << " ";
-    stream << ".ra: " << ra_rule_;
+    stream << ".ra: " << rules_->ra_rule;
   }
-  for (RuleMap::const_iterator iter = register_rules_.begin();
-       iter != register_rules_.end();
+  for (RuleMap::const_iterator iter = rules_->register_rules.begin();
+       iter != rules_->register_rules.end();
        ++iter) {
     if (static_cast<std::streamoff>(stream.tellp()) != 0)
       stream << " ";
@@ -174,6 +358,53 @@ bool CFIRuleParser::Report() {
   return true;
 }
 
+CFIFrameInfo *CFIFrameInfoCache::FindByAddress(uint64_t address) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  map<uint64_t, const CFIFrameInfo*>::const_iterator it =
+      addresses_.find(address);
+  if (it == addresses_.end())
+    return NULL;
+  ++stats_.hits;
+  return new CFIFrameInfo(*it->second);
+}
+
+CFIFrameInfo *CFIFrameInfoCache::Find(uint64_t key, uint64_t address) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  map<uint64_t, CFIFrameInfo>::const_iterator it = entries_.find(key);
+  if (it == entries_.end()) {
+    ++stats_.misses;
+    return NULL;
+  }
+  ++stats_.hits;
+  AddAddress(address, &it->second);
+  return new CFIFrameInfo(it->second);
+}
+
+void CFIFrameInfoCache::Insert(uint64_t key, uint64_t address,
+                               const CFIFrameInfo &rules) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (entries_.size() >= kMaxEntries) {
+    // addresses_ points into entries_, so it must go too.
+    entries_.clear();
+    addresses_.clear();
+  }
+  CFIFrameInfo &entry = entries_[key];
+  entry = rules;
+  AddAddress(address, &entry);
+}
+
+CFIFrameInfoCache::Stats CFIFrameInfoCache::stats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stats_;
+}
+
+void CFIFrameInfoCache::AddAddress(uint64_t address,
+                                   const CFIFrameInfo *rules) {
+  if (addresses_.size() >= kMaxAddresses)
+    addresses_.clear();
+  addresses_[address] = rules;
+}
+
 void CFIFrameInfoParseHandler::CFARule(const string &expression) {
   frame_info_->SetCFARule(expression);
 }
@@ -38,11 +38,18 @@
 #ifndef PROCESSOR_CFI_FRAME_INFO_H_
 #define PROCESSOR_CFI_FRAME_INFO_H_
 
+#include <atomic>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "common/using_std_string.h"
 #include "google_breakpad/common/breakpad_types.h"
+#include "processor/postfix_program.h"
+#include "processor/register_dictionary.h"
 
 namespace google_breakpad {
 
@@ -69,15 +76,37 @@ class CFIFrameInfo {
   template<typename ValueType> class RegisterValueMap: 
     public map<string, ValueType> { };
 
+  // Copies share the rules, and their compiled form, until one of them
+  // is changed, so copying is cheap.
+  CFIFrameInfo() : rules_(std::make_shared<Rules>()) { }
+
   // Set the expression for computing a call frame address, return
   // address, or register's value. At least the CFA rule and the RA
   // rule must be set before calling FindCallerRegs.
-  void SetCFARule(const string &expression) { cfa_rule_ = expression; }
-  void SetRARule(const string &expression)  { ra_rule_ = expression; }
+  void SetCFARule(const string &expression) {
+    Rules *rules = MutableRules();
+    rules->cfa_rule = expression;
+    rules->compiled.reset();
+  }
+  void SetRARule(const string &expression) {
+    Rules *rules = MutableRules();
+    rules->ra_rule = expression;
+    rules->compiled.reset();
+  }
   void SetRegisterRule(const string &register_name, const string &expression) {
-    register_rules_[register_name] = expression;
+    Rules *rules = MutableRules();
+    rules->register_rules[register_name] = expression;
+    rules->compiled.reset();
   }
 
+  // Compile the rules into PostfixPrograms, so that FindCallerRegs can
+  // run them without parsing their text again. Return true if every rule
+  // could be compiled; if any can't, FindCallerRegs goes on evaluating
+  // the rule text. Setting a rule discards the compiled rules. Copies of
+  // this object share its compiled rules.
+  bool Compile();
+  bool IsCompiled() const { return rules_->compiled.get() != NULL; }
+
   // Compute the values of the calling frame's registers, according to
   // this rule set. Use ValueType in expression evaluation; this
   // should be uint32_t on machines with 32-bit addresses, or
@@ -100,38 +129,187 @@ class CFIFrameInfo {
                       const MemoryRegion &memory,
                       RegisterValueMap<ValueType> *caller_registers) const;
 
+  // As above, with the registers in RegisterDictionaries. Only registers
+  // in CALLER_REGISTERS' table, which should include ".ra" and ".cfa",
+  // receive values. The first call with a given table of names resolves
+  // the register names the compiled rules use to indices in it; later
+  // calls with dictionaries for a table holding the same names, even at
+  // another address, reuse those indices and don't allocate memory.
+  template<typename ValueType>
+  bool FindCallerRegs(const RegisterDictionary<ValueType> &registers,
+                      const MemoryRegion &memory,
+                      RegisterDictionary<ValueType> *caller_registers) const;
+
   // Serialize the rules in this object into a string in the format
   // of STACK CFI records.
   string Serialize() const;
 
+  // Return a table of the registers named in NAMES, an array ending with
+  // NULL, followed by the ".cfa" and ".ra" pseudo-registers, for use
+  // with FindCallerRegs. Register i in NAMES has index i in the table.
+  static RegisterTable MakeRegisterTable(const char * const *names);
+
  private:
 
   // A map from register names onto evaluation rules. 
   typedef map<string, string> RuleMap;
 
+  // The compiled rules' register names, resolved to indices in TABLE.
+  struct Binding {
+    Binding() : previous(NULL) { }
+    ~Binding() { delete previous; }
+
+    // A copy of the table the rules were bound to, so that a binding can
+    // be matched with tables holding the same names.
+    RegisterTable table;
+    // What PostfixProgram::Bind found for each program.
+    std::vector<int> cfa_rule;
+    std::vector<int> ra_rule;
+    std::vector<std::vector<int> > register_rules;
+    // The index of the register each register rule recovers, and of
+    // ".cfa" and ".ra"; -1 for any not in TABLE.
+    std::vector<int> registers;
+    int cfa;
+    int ra;
+
+    // The binding to another table that this one was added in front of,
+    // or NULL.
+    const Binding *previous;
+  };
+
+  // Implement FindCallerRegs with the compiled rules.
+  template<typename ValueType>
+  bool FindCallerRegsCompiled(const RegisterValueMap<ValueType> &registers,
+                              const MemoryRegion &memory,
+                              RegisterValueMap<ValueType> *caller_registers)
+      const;
+  template<typename ValueType>
+  bool FindCallerRegsCompiled(const Binding &binding,
+                              const RegisterDictionary<ValueType> &registers,
+                              const MemoryRegion &memory,
+                              RegisterDictionary<ValueType> *caller_registers)
+      const;
+
+  // Return the compiled rules' binding to a table holding the same names
+  // as TABLE, creating it if the rules have none yet.
+  const Binding *Bind(const RegisterTable *table) const;
+
+  // The rules below, compiled by Compile.
+  struct CompiledRules {
+    CompiledRules() : binding(NULL) { }
+    ~CompiledRules() { delete binding.load(std::memory_order_relaxed); }
+
+    PostfixProgram cfa_rule;
+    PostfixProgram ra_rule;
+    std::vector<std::pair<string, PostfixProgram> > register_rules;
+
+    // The rules' bindings to each table they have been used with, most
+    // recent first, or NULL. Rule sets come from one module, whose
+    // architecture's stack walker always uses the same names, so there is
+    // usually only one. Bindings are only ever added, atomically, since
+    // copies in several threads may share them, and are freed with the
+    // rules.
+    mutable std::atomic<const Binding*> binding;
+  };
+
   // In this type, a "postfix expression" is an expression of the sort
   // interpreted by google_breakpad::PostfixEvaluator.
+  struct Rules {
+    // A postfix expression for computing the current frame's CFA (call
+    // frame address). The CFA is a reference address for the frame that
+    // remains unchanged throughout the frame's lifetime. You should
+    // evaluate this expression with a dictionary initially populated
+    // with the values of the current frame's known registers.
+    string cfa_rule;
+
+    // The following expressions should be evaluated with a dictionary
+    // initially populated with the values of the current frame's known
+    // registers, and with ".cfa" set to the result of evaluating the
+    // cfa_rule expression, above.
+
+    // A postfix expression for computing the current frame's return
+    // address.
+    string ra_rule;
+
+    // For a register named REG, rules[REG] is a postfix expression
+    // which leaves the value of REG in the calling frame on the top of
+    // the stack. You should evaluate this expression
+    RuleMap register_rules;
+
+    // The compiled rules, or NULL if the rules haven't been compiled.
+    // Compiled rules are never modified, other than to be bound once.
+    std::shared_ptr<const CompiledRules> compiled;
+  };
+
+  // Return rules_ for changing, first giving this object its own copy if
+  // other copies share them.
+  Rules *MutableRules();
 
-  // A postfix expression for computing the current frame's CFA (call
-  // frame address). The CFA is a reference address for the frame that
-  // remains unchanged throughout the frame's lifetime. You should
-  // evaluate this expression with a dictionary initially populated
-  // with the values of the current frame's known registers.
-  string cfa_rule_;
-
-  // The following expressions should be evaluated with a dictionary
-  // initially populated with the values of the current frame's known
-  // registers, and with ".cfa" set to the result of evaluating the
-  // cfa_rule expression, above.
-
-  // A postfix expression for computing the current frame's return
-  // address. 
-  string ra_rule_;
-
-  // For a register named REG, rules[REG] is a postfix expression
-  // which leaves the value of REG in the calling frame on the top of
-  // the stack. You should evaluate this expression
-  RuleMap register_rules_;
+  // The rules, shared with copies of this object. Never NULL.
+  std::shared_ptr<Rules> rules_;
+};
+
+// A cache of compiled CFIFrameInfo rule sets for one module. Resolvers key
+// each rule set by the address of the last STACK CFI record that applies
+// to it: the STACK CFI INIT record if no delta records apply, or else the
+// last delta record applied. That address identifies the rule set in
+// effect at every instruction up to the next record.
+//
+// The cache also remembers which rule set each looked-up instruction
+// address used, so that frames at an address seen before (such as many
+// threads parked in the same wait) skip the record search entirely.
+//
+// Lookups change the cache, though resolver modules make them from their
+// const FindCFIFrameInfo, so the cache takes a lock of its own: several
+// threads may look up CFI in one module at once. The rule sets handed out
+// may be used from any thread.
+class CFIFrameInfoCache {
+ public:
+  // Lookup counts. A hit is a lookup answered from the cache, whether by
+  // instruction address or by rule set; a miss is a lookup that had to
+  // build the rule set from its STACK CFI records.
+  struct Stats {
+    Stats() : hits(0), misses(0) { }
+    uint64_t hits;
+    uint64_t misses;
+  };
+
+  // Return a new copy of the rule set a previous lookup found in effect
+  // at the module-relative instruction address ADDRESS, or NULL if there
+  // is none. The copy shares the cached rules rather than duplicating
+  // them. The caller takes ownership of the copy.
+  CFIFrameInfo *FindByAddress(uint64_t address);
+
+  // Return a new copy, sharing the cached rules, of the rule set cached
+  // under KEY, or NULL if there isn't one. On success, remember it as the
+  // rule set in effect at ADDRESS. The caller takes ownership of the copy.
+  CFIFrameInfo *Find(uint64_t key, uint64_t address);
+
+  // Cache RULES under KEY, as the rule set in effect at ADDRESS. When the
+  // cache is full, it is emptied first.
+  void Insert(uint64_t key, uint64_t address, const CFIFrameInfo &rules);
+
+  Stats stats() const;
+
+  // The most rule sets, and instruction addresses, the cache holds.
+  static const size_t kMaxEntries = 1024;
+  static const size_t kMaxAddresses = 4096;
+
+ private:
+  // Remember RULES, an entry in entries_, as in effect at ADDRESS. The
+  // caller must hold mutex_.
+  void AddAddress(uint64_t address, const CFIFrameInfo *rules);
+
+  // Guards everything below.
+  mutable std::mutex mutex_;
+
+  map<uint64_t, CFIFrameInfo> entries_;
+
+  // Instruction addresses looked up, and the entry in entries_ that was
+  // in effect at each.
+  map<uint64_t, const CFIFrameInfo*> addresses_;
+
+  Stats stats_;
 };
 
 // A parser for STACK CFI-style rule sets.
@@ -240,8 +418,7 @@ class SimpleCFIWalker {
   // architecture's register set. REGISTER_MAP is an array of
   // RegisterSet structures; MAP_SIZE is the number of elements in the
   // array.
-  SimpleCFIWalker(const RegisterSet *register_map, size_t map_size)
-      : register_map_(register_map), map_size_(map_size) { }
+  SimpleCFIWalker(const RegisterSet *register_map, size_t map_size);
 
   // Compute the calling frame's raw context given the callee's raw
   // context.
@@ -266,6 +443,14 @@ class SimpleCFIWalker {
  private:
   const RegisterSet *register_map_;
   size_t map_size_;
+
+  // A table of the names in register_map_, with ".cfa" and ".ra".
+  RegisterTable register_table_;
+
+  // For each register in register_map_, the index in register_table_ of
+  // its name, and of its alternate name or -1 if it has none.
+  int name_index_[RegisterTable::kMaxRegisters];
+  int alternate_name_index_[RegisterTable::kMaxRegisters];
 };
 
 }  // namespace google_breakpad
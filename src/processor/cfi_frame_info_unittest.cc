@@ -35,15 +35,20 @@
 #include <string.h>
 
 #include "breakpad_googletest_includes.h"
+#include "common/scoped_ptr.h"
 #include "common/using_std_string.h"
 #include "processor/cfi_frame_info.h"
 #include "google_breakpad/processor/memory_region.h"
 
 using google_breakpad::CFIFrameInfo;
+using google_breakpad::CFIFrameInfoCache;
 using google_breakpad::CFIFrameInfoParseHandler;
 using google_breakpad::CFIRuleParser;
 using google_breakpad::MemoryRegion;
+using google_breakpad::RegisterDictionary;
+using google_breakpad::RegisterTable;
 using google_breakpad::SimpleCFIWalker;
+using google_breakpad::scoped_ptr;
 using testing::_;
 using testing::A;
 using testing::AtMost;
@@ -290,6 +295,205 @@ TEST_F(Scope, SeparateTempsRA) {
                                              &caller_registers));
 }
 
+class Compiled: public CFIFixture, public Test { };
+
+// Compiled rules should yield the same values as the rule text.
+TEST_F(Compiled, SameAsText) {
+  ExpectNoMemoryReferences();
+
+  registers["$r1"] = 0x2cc7b2b1bd72e01fULL;
+  registers["$r2"] = 0x4f62fbf7b1be9b27ULL;
+  cfi.SetCFARule("$r1 16 +");
+  cfi.SetRARule(".cfa 8 -");
+  cfi.SetRegisterRule("$r1", "$r2 .cfa *");
+  cfi.SetRegisterRule("$r2", "$r1 64 @");
+  ASSERT_TRUE(cfi.FindCallerRegs<uint64_t>(registers, memory,
+                                            &caller_registers));
+  CFIFrameInfo::RegisterValueMap<uint64_t> text_caller_registers =
+      caller_registers;
+
+  ASSERT_TRUE(cfi.Compile());
+  ASSERT_TRUE(cfi.IsCompiled());
+  caller_registers["$leftover"] = 1;
+  ASSERT_TRUE(cfi.FindCallerRegs<uint64_t>(registers, memory,
+                                            &caller_registers));
+  ASSERT_TRUE(text_caller_registers == caller_registers);
+
+  // Copies share the compiled rules.
+  CFIFrameInfo copy(cfi);
+  ASSERT_TRUE(copy.IsCompiled());
+  ASSERT_EQ(cfi.Serialize(), copy.Serialize());
+
+  // Changing a rule discards them.
+  cfi.SetRegisterRule("$r2", "$r2");
+  ASSERT_FALSE(cfi.IsCompiled());
+  ASSERT_TRUE(copy.IsCompiled());
+}
+
+// Compiled rules should fail where the rule text does.
+TEST_F(Compiled, Fails) {
+  ExpectNoMemoryReferences();
+
+  cfi.SetCFARule("$r1");
+  cfi.SetRARule(".cfa");
+  ASSERT_TRUE(cfi.Compile());
+  ASSERT_FALSE(cfi.FindCallerRegs<uint64_t>(registers, memory,
+                                             &caller_registers));
+
+  registers["$r1"] = 8;
+  cfi.SetCFARule("$r1");
+  cfi.SetRARule(".ra");
+  ASSERT_TRUE(cfi.Compile());
+  ASSERT_FALSE(cfi.FindCallerRegs<uint64_t>(registers, memory,
+                                             &caller_registers));
+}
+
+// Rules that use assignment are left uncompiled, and still work.
+TEST_F(Compiled, Uncompilable) {
+  ExpectNoMemoryReferences();
+
+  cfi.SetCFARule("$temp1 76569129 = $temp1");
+  cfi.SetRARule("0");
+  ASSERT_FALSE(cfi.Compile());
+  ASSERT_FALSE(cfi.IsCompiled());
+  ASSERT_TRUE(cfi.FindCallerRegs<uint64_t>(registers, memory,
+                                            &caller_registers));
+  ASSERT_EQ(76569129U, caller_registers[".cfa"]);
+}
+
+// The rules should yield the same values given RegisterDictionaries as
+// given maps, compiled or not.
+TEST_F(Compiled, RegisterDictionary) {
+  ExpectNoMemoryReferences();
+
+  static const char *kNames[] = { "$r1", "$r2", "$r3", NULL };
+  const RegisterTable table = CFIFrameInfo::MakeRegisterTable(kNames);
+  RegisterDictionary<uint64_t> dictionary(&table);
+  RegisterDictionary<uint64_t> caller_dictionary(&table);
+  registers["$r1"] = 0x2cc7b2b1bd72e01fULL;
+  registers["$r2"] = 0x4f62fbf7b1be9b27ULL;
+  dictionary.Set("$r1", registers["$r1"]);
+  dictionary.Set("$r2", registers["$r2"]);
+  caller_dictionary.Set("$r3", 1);
+
+  cfi.SetCFARule("$r1 16 +");
+  cfi.SetRARule(".cfa 8 -");
+  cfi.SetRegisterRule("$r1", "$r2 .cfa *");
+  cfi.SetRegisterRule("$r2", "$r1 64 @");
+  cfi.SetRegisterRule("$r4", "$r1");
+  ASSERT_TRUE(cfi.FindCallerRegs<uint64_t>(registers, memory,
+                                            &caller_registers));
+
+  for (int compiled = 0; compiled < 2; compiled++) {
+    if (compiled) {
+      ASSERT_TRUE(cfi.Compile());
+    }
+    ASSERT_TRUE(cfi.FindCallerRegs<uint64_t>(dictionary, memory,
+                                              &caller_dictionary));
+    // Registers not in the table are dropped.
+    for (int i = 0; i < table.size(); i++) {
+      uint64_t value;
+      ASSERT_EQ(caller_registers.count(table.name(i)) != 0,
+                caller_dictionary.Get(i, &value));
+      if (caller_registers.count(table.name(i))) {
+        ASSERT_EQ(caller_registers[table.name(i)], value);
+      }
+    }
+  }
+
+  // Failures are reported the same way.
+  dictionary.Erase(0);
+  ASSERT_FALSE(cfi.FindCallerRegs<uint64_t>(dictionary, memory,
+                                             &caller_dictionary));
+}
+
+// Compiled rules resolve register names for each table of names they are
+// used with, and tables at other addresses holding the same names share
+// the binding.
+TEST_F(Compiled, RegisterDictionaryTables) {
+  ExpectNoMemoryReferences();
+
+  static const char *kNames[] = { "$r1", "$r2", NULL };
+  static const char *kOtherNames[] = { "$r0", "$r2", "$r1", NULL };
+  const RegisterTable table = CFIFrameInfo::MakeRegisterTable(kNames);
+  const RegisterTable other_table =
+      CFIFrameInfo::MakeRegisterTable(kOtherNames);
+  const RegisterTable same_table = CFIFrameInfo::MakeRegisterTable(kNames);
+
+  cfi.SetCFARule("$r1 16 +");
+  cfi.SetRARule(".cfa 8 -");
+  cfi.SetRegisterRule("$r2", "$r1 $r2 +");
+  ASSERT_TRUE(cfi.Compile());
+  CFIFrameInfo copy(cfi);
+
+  const RegisterTable *tables[] = { &table, &other_table, &same_table };
+  for (int i = 0; i < 3; i++) {
+    const RegisterTable *t = tables[i];
+    RegisterDictionary<uint64_t> dictionary(t);
+    RegisterDictionary<uint64_t> caller_dictionary(t);
+    dictionary.Set("$r1", 0x1000);
+    dictionary.Set("$r2", 0x20);
+    // The copy shares the binding the original made.
+    ASSERT_TRUE((i == 0 ? cfi : copy).FindCallerRegs<uint64_t>(
+        dictionary, memory, &caller_dictionary));
+    uint64_t value;
+    ASSERT_TRUE(caller_dictionary.Get(".cfa", &value));
+    EXPECT_EQ(0x1010U, value);
+    ASSERT_TRUE(caller_dictionary.Get(".ra", &value));
+    EXPECT_EQ(0x1008U, value);
+    ASSERT_TRUE(caller_dictionary.Get("$r2", &value));
+    EXPECT_EQ(0x1020U, value);
+    EXPECT_FALSE(caller_dictionary.Get("$r1", &value));
+  }
+}
+
+TEST(CFIFrameInfoCache, FindAndInsert) {
+  CFIFrameInfoCache cache;
+  ASSERT_TRUE(cache.FindByAddress(0x1004) == NULL);
+  ASSERT_TRUE(cache.Find(0x1000, 0x1004) == NULL);
+
+  CFIFrameInfo rules;
+  rules.SetCFARule("$sp 8 +");
+  rules.SetRARule(".cfa ^");
+  ASSERT_TRUE(rules.Compile());
+  cache.Insert(0x1000, 0x1004, rules);
+
+  scoped_ptr<CFIFrameInfo> found(cache.FindByAddress(0x1004));
+  ASSERT_TRUE(found.get() != NULL);
+  ASSERT_TRUE(found->IsCompiled());
+  ASSERT_EQ(rules.Serialize(), found->Serialize());
+  ASSERT_TRUE(cache.FindByAddress(0x1008) == NULL);
+
+  // Finding the rule set by key remembers the new address too.
+  found.reset(cache.Find(0x1000, 0x1008));
+  ASSERT_TRUE(found.get() != NULL);
+  ASSERT_EQ(rules.Serialize(), found->Serialize());
+  found.reset(cache.FindByAddress(0x1008));
+  ASSERT_TRUE(found.get() != NULL);
+  ASSERT_TRUE(cache.Find(0x1001, 0x1008) == NULL);
+
+  ASSERT_EQ(3U, cache.stats().hits);
+  ASSERT_EQ(2U, cache.stats().misses);
+
+  // The rule sets found share the cached rules, but changing one leaves
+  // the cache alone.
+  found->SetRARule(".cfa 8 -");
+  ASSERT_FALSE(found->IsCompiled());
+  found.reset(cache.FindByAddress(0x1008));
+  ASSERT_TRUE(found->IsCompiled());
+  ASSERT_EQ(rules.Serialize(), found->Serialize());
+
+  // A full cache is emptied to make room, addresses and all.
+  for (uint64_t key = 1; key <= CFIFrameInfoCache::kMaxEntries; key++)
+    cache.Insert(0x1000 + key, 0x2000 + key, rules);
+  ASSERT_TRUE(cache.Find(0x1000, 0x1004) == NULL);
+  ASSERT_TRUE(cache.FindByAddress(0x1004) == NULL);
+  found.reset(cache.Find(0x1000 + CFIFrameInfoCache::kMaxEntries, 0x1004));
+  ASSERT_TRUE(found.get() != NULL);
+  found.reset(cache.FindByAddress(0x2000 + CFIFrameInfoCache::kMaxEntries));
+  ASSERT_TRUE(found.get() != NULL);
+}
+
 class MockCFIRuleParserHandler: public CFIRuleParser::Handler {
  public:
   MOCK_METHOD1(CFARule, void(const string &));
@@ -0,0 +1,327 @@
+// Copyright (c) 2026 Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// code_modules_benchmark.cc: Measures how long it takes to find the module
+// containing an address.
+//
+// A synthetic process with many loaded modules is laid out, and addresses
+// in it are looked up both through a CodeModules implementation that keeps
+// its modules in a RangeMap, as BasicCodeModules and MinidumpModuleList
+// used to, and through BasicCodeModules.  The addresses are looked up in
+// two patterns: scattered over all of the modules, and in the runs of
+// lookups of the same address that a stack walk makes for each frame.  Both
+// implementations fold the modules they find into a checksum, and the
+// checksums must agree.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "common/path_helper.h"
+#include "common/scoped_ptr.h"
+#include "common/using_std_string.h"
+#include "google_breakpad/processor/code_module.h"
+#include "google_breakpad/processor/code_modules.h"
+#include "processor/basic_code_module.h"
+#include "processor/basic_code_modules.h"
+#include "processor/linked_ptr.h"
+#include "processor/range_map-inl.h"
+
+namespace {
+
+using google_breakpad::BasicCodeModule;
+using google_breakpad::BasicCodeModules;
+using google_breakpad::CodeModule;
+using google_breakpad::CodeModules;
+using google_breakpad::RangeMap;
+using google_breakpad::linked_ptr;
+using google_breakpad::scoped_ptr;
+using std::vector;
+
+struct Options {
+  int modules;
+  int lookups;
+  int lookups_per_frame;
+  int iterations;
+};
+
+typedef std::chrono::steady_clock Clock;
+
+double MillisecondsSince(Clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(Clock::now() - start)
+      .count();
+}
+
+// A CodeModules that finds modules by address the way BasicCodeModules
+// did before it had a flat index.
+class RangeMapCodeModules : public CodeModules {
+ public:
+  RangeMapCodeModules() {}
+
+  // Takes over ownership of |module|.
+  bool Add(const CodeModule *module) {
+    linked_ptr<const CodeModule> module_ptr(module);
+    modules_.push_back(module_ptr);
+    return map_.StoreRange(module->base_address(), module->size(),
+                           module_ptr);
+  }
+
+  virtual unsigned int module_count() const {
+    return static_cast<unsigned int>(modules_.size());
+  }
+  virtual const CodeModule* GetModuleForAddress(uint64_t address) const {
+    linked_ptr<const CodeModule> module;
+    if (!map_.RetrieveRange(address, &module, NULL /* base */,
+                            NULL /* delta */, NULL /* size */))
+      return NULL;
+    return module.get();
+  }
+  virtual const CodeModule* GetMainModule() const {
+    return modules_.empty() ? NULL : modules_[0].get();
+  }
+  virtual const CodeModule* GetModuleAtSequence(unsigned int sequence) const {
+    return GetModuleAtIndex(sequence);
+  }
+  virtual const CodeModule* GetModuleAtIndex(unsigned int index) const {
+    return index < modules_.size() ? modules_[index].get() : NULL;
+  }
+  virtual const CodeModules* Copy() const {
+    return new BasicCodeModules(this);
+  }
+  virtual vector<linked_ptr<const CodeModule> > GetShrunkRangeModules() const {
+    return vector<linked_ptr<const CodeModule> >();
+  }
+  virtual bool IsModuleShrinkEnabled() const { return false; }
+
+ private:
+  RangeMap<uint64_t, linked_ptr<const CodeModule> > map_;
+  vector<linked_ptr<const CodeModule> > modules_;
+
+  // Disallow copy constructor and assignment operator.
+  RangeMapCodeModules(const RangeMapCodeModules&);
+  void operator=(const RangeMapCodeModules&);
+};
+
+// A small deterministic pseudo-random number generator, so that every run
+// looks up the same addresses.
+class Random {
+ public:
+  Random() : state_(0x853c49e6748fea9bULL) {}
+
+  uint64_t Next() {
+    state_ = state_ * 6364136223846793005ULL + 1442695040888963407ULL;
+    return state_ >> 17;
+  }
+
+ private:
+  uint64_t state_;
+};
+
+// Lays out modules the way a shared library loader would: pages of code
+// from a few kilobytes to tens of megabytes, separated by gaps.  The
+// modules are stored in load order, not address order.
+void AddModules(const Options &options, RangeMapCodeModules *modules) {
+  Random random;
+  vector<uint64_t> bases;
+  uint64_t address = 0x7f0000000000ULL;
+  for (int i = 0; i < options.modules; ++i) {
+    uint64_t size = (1 + random.Next() % 4096) * 0x1000;
+    if (random.Next() % 16 == 0)
+      size *= 16;
+    bases.push_back(address);
+    char name[64];
+    snprintf(name, sizeof(name), "/system/lib/libmodule%d.so", i);
+    modules->Add(new BasicCodeModule(address, size, name, name,
+                                     "000102030405060708090A0B0C0D0E0F0", "",
+                                     ""));
+    address += size + (random.Next() % 64) * 0x1000;
+  }
+}
+
+// Returns addresses to look up in |modules|: runs of |lookups_per_frame|
+// lookups of the same address when |frames| is true, and a different
+// address for every lookup otherwise.  Every address is in a module.
+vector<uint64_t> MakeAddresses(const Options &options,
+                               const CodeModules &modules, bool frames) {
+  Random random;
+  vector<uint64_t> addresses;
+  addresses.reserve(options.lookups);
+  int repeat = frames ? options.lookups_per_frame : 1;
+  while (addresses.size() < static_cast<size_t>(options.lookups)) {
+    const CodeModule *module =
+        modules.GetModuleAtIndex(random.Next() % modules.module_count());
+    uint64_t address = module->base_address() +
+                       random.Next() % module->size();
+    for (int i = 0; i < repeat; ++i)
+      addresses.push_back(address);
+  }
+  addresses.resize(options.lookups);
+  return addresses;
+}
+
+// Looks up every address in |addresses|, returning the best time of
+// |options.iterations| runs in |best_ms| and a checksum of the modules found.
+uint64_t LookUpAddresses(const Options &options, const CodeModules &modules,
+                         const vector<uint64_t> &addresses, double *best_ms) {
+  uint64_t checksum = 0;
+  for (int i = 0; i < options.iterations; ++i) {
+    checksum = 0;
+    Clock::time_point start = Clock::now();
+    for (size_t j = 0; j < addresses.size(); ++j) {
+      const CodeModule *module = modules.GetModuleForAddress(addresses[j]);
+      if (module)
+        checksum += module->base_address();
+    }
+    double elapsed = MillisecondsSince(start);
+    if (i == 0 || elapsed < *best_ms)
+      *best_ms = elapsed;
+  }
+  return checksum;
+}
+
+// Runs the benchmark for one lookup pattern, returning false if the
+// implementations disagree.
+bool RunBenchmark(const Options &options, const string &description,
+                  const CodeModules &range_map_modules,
+                  const CodeModules &basic_modules, bool frames) {
+  vector<uint64_t> addresses =
+      MakeAddresses(options, range_map_modules, frames);
+  double range_map_ms = 0, basic_ms = 0;
+  uint64_t range_map_checksum =
+      LookUpAddresses(options, range_map_modules, addresses, &range_map_ms);
+  uint64_t basic_checksum =
+      LookUpAddresses(options, basic_modules, addresses, &basic_ms);
+
+  printf("%s: %d lookups, best of %d runs\n", description.c_str(),
+         options.lookups, options.iterations);
+  printf("  RangeMap:          %10.2f ms (%6.1f ns/lookup)\n", range_map_ms,
+         range_map_ms * 1e6 / options.lookups);
+  printf("  BasicCodeModules:  %10.2f ms (%6.1f ns/lookup, %.2fx)\n",
+         basic_ms, basic_ms * 1e6 / options.lookups,
+         basic_ms > 0 ? range_map_ms / basic_ms : 0);
+
+  if (range_map_checksum != basic_checksum) {
+    fprintf(stderr, "%s: lookups disagree\n", description.c_str());
+    return false;
+  }
+  return true;
+}
+
+//=============================================================================
+static void Usage(int argc, const char *argv[], bool error) {
+  fprintf(error ? stderr : stdout,
+          "Usage: %s [options]\n"
+          "\n"
+          "Time finding the modules that contain addresses in a synthetic\n"
+          "process.\n"
+          "\n"
+          "Options:\n"
+          "\n"
+          "  -m <count>  Loaded modules (default %d)\n"
+          "  -l <count>  Lookups per run (default %d)\n"
+          "  -f <count>  Lookups of each address in a stack frame "
+          "(default %d)\n"
+          "  -n <count>  Runs; the fastest is reported (default %d)\n",
+          google_breakpad::BaseName(argv[0]).c_str(),
+          600, 10000000, 4, 3);
+}
+
+static int ParseCount(int argc, const char *argv[], const char *value) {
+  char *end;
+  long count = strtol(value, &end, 10);
+  if (*value == '\0' || *end != '\0' || count <= 0 || count > 100000000) {
+    fprintf(stderr, "%s: Invalid count %s\n", argv[0], value);
+    Usage(argc, argv, true);
+    exit(1);
+  }
+  return static_cast<int>(count);
+}
+
+static void SetupOptions(int argc, const char *argv[], Options *options) {
+  int ch;
+
+  options->modules = 600;
+  options->lookups = 10000000;
+  options->lookups_per_frame = 4;
+  options->iterations = 3;
+
+  while ((ch = getopt(argc, (char * const *)argv, "f:hl:m:n:")) != -1) {
+    switch (ch) {
+      case 'h':
+        Usage(argc, argv, false);
+        exit(0);
+        break;
+
+      case 'f':
+        options->lookups_per_frame = ParseCount(argc, argv, optarg);
+        break;
+      case 'l':
+        options->lookups = ParseCount(argc, argv, optarg);
+        break;
+      case 'm':
+        options->modules = ParseCount(argc, argv, optarg);
+        break;
+      case 'n':
+        options->iterations = ParseCount(argc, argv, optarg);
+        break;
+
+      case '?':
+        Usage(argc, argv, true);
+        exit(1);
+        break;
+    }
+  }
+
+  if (optind != argc) {
+    Usage(argc, argv, true);
+    exit(1);
+  }
+}
+
+}  // namespace
+
+int main(int argc, const char *argv[]) {
+  Options options;
+  SetupOptions(argc, argv, &options);
+
+  RangeMapCodeModules range_map_modules;
+  AddModules(options, &range_map_modules);
+  scoped_ptr<const CodeModules> basic_modules(range_map_modules.Copy());
+  printf("%u modules\n", basic_modules->module_count());
+
+  bool ok = RunBenchmark(options, "scattered", range_map_modules,
+                         *basic_modules, false);
+  ok = RunBenchmark(options, "stack frames", range_map_modules,
+                    *basic_modules, true) && ok;
+  return ok ? 0 : 1;
+}
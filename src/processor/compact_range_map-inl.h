@@ -0,0 +1,365 @@
+// Copyright (c) 2026 Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// compact_range_map-inl.h: Compact range map implementation.
+//
+// See compact_range_map.h for documentation.  StoreRangeInternal follows
+// RangeMap::StoreRangeInternal step for step, so that both maps accept,
+// reject and shrink down the same ranges.
+
+#ifndef PROCESSOR_COMPACT_RANGE_MAP_INL_H__
+#define PROCESSOR_COMPACT_RANGE_MAP_INL_H__
+
+
+#include <assert.h>
+
+#include <algorithm>
+
+#include "processor/compact_range_map.h"
+#include "processor/logging.h"
+#include "processor/range_map-inl.h"
+
+
+namespace google_breakpad {
+
+template<typename AddressType, typename EntryType>
+void CompactRangeMap<AddressType, EntryType>::SetEnableShrinkDown(
+    bool enable_shrink_down) {
+  enable_shrink_down_ = enable_shrink_down;
+}
+
+template<typename AddressType, typename EntryType>
+bool CompactRangeMap<AddressType, EntryType>::IsShrinkDownEnabled() const {
+  return enable_shrink_down_;
+}
+
+template<typename AddressType, typename EntryType>
+bool CompactRangeMap<AddressType, EntryType>::StoreRange(
+    const AddressType &base, const AddressType &size, const EntryType &entry) {
+  return StoreRangeInternal(base, 0 /* delta */, size, entry);
+}
+
+template<typename AddressType, typename EntryType>
+bool CompactRangeMap<AddressType, EntryType>::StoreRangeInternal(
+    const AddressType &base, const AddressType &delta,
+    const AddressType &size, const EntryType &entry) {
+  AddressType high = base + (size - 1);
+
+  // Check for undersize or overflow.
+  if (size <= 0 || high < base) {
+    // As in RangeMap, don't log the common size == 0 case.
+    BPLOG_IF(INFO, size != 0) << "StoreRangeInternal failed, "
+                              << HexString(base) << "+" << HexString(size)
+                              << ", " << HexString(high)
+                              << ", delta: " << HexString(delta);
+    return false;
+  }
+
+  // Ensure that this range does not overlap with another one already in the
+  // map.
+  size_t index_base = LowerBound(base);
+  size_t index_high = LowerBound(high);
+
+  if (index_base != index_high) {
+    // Some other range begins in the space used by this range.  If
+    // enable_shrink_down_ is true, shrink the current range down, otherwise
+    // this is an error.
+    if (enable_shrink_down_) {
+      AddressType additional_delta = highs_[index_base] - base + 1;
+      return StoreRangeInternal(base + additional_delta,
+                                delta + additional_delta,
+                                size - additional_delta, entry);
+    }
+    return false;
+  }
+
+  if (index_high != highs_.size() && bases_[index_high] <= high) {
+    // The range above this one overlaps with this one.  If
+    // enable_shrink_down_ is true and the other range extends higher, shrink
+    // it down in place, since its high address doesn't change.  Otherwise
+    // this is an error.
+    if (enable_shrink_down_ && highs_[index_high] > high) {
+      AddressType additional_delta = high - bases_[index_high] + 1;
+      if (deltas_.empty())
+        deltas_.resize(highs_.size());
+      bases_[index_high] += additional_delta;
+      deltas_[index_high] += additional_delta;
+      // Retry to store this range.
+      return StoreRangeInternal(base, delta, size, entry);
+    }
+    return false;
+  }
+
+  if (delta != 0 && deltas_.empty())
+    deltas_.resize(highs_.size());
+
+  // Ranges stored in ascending order are appended; others are inserted,
+  // moving the ranges above them up.
+  if (index_high == highs_.size()) {
+    highs_.push_back(high);
+    bases_.push_back(base);
+    if (!deltas_.empty())
+      deltas_.push_back(delta);
+    entries_.push_back(entry);
+  } else {
+    highs_.insert(highs_.begin() + index_high, high);
+    bases_.insert(bases_.begin() + index_high, base);
+    if (!deltas_.empty())
+      deltas_.insert(deltas_.begin() + index_high, delta);
+    entries_.insert(entries_.begin() + index_high, entry);
+  }
+  return true;
+}
+
+
+template<typename AddressType, typename EntryType>
+bool CompactRangeMap<AddressType, EntryType>::RetrieveRange(
+    const AddressType &address, EntryType *entry, AddressType *entry_base,
+    AddressType *entry_delta, AddressType *entry_size) const {
+  BPLOG_IF(ERROR, !entry) << "CompactRangeMap::RetrieveRange requires |entry|";
+  assert(entry);
+
+  size_t index = LowerBound(address);
+  if (index == highs_.size())
+    return false;
+
+  // |address| is at or below the range's high address, but may still be
+  // below its base, in the gap under it.
+  if (address < bases_[index])
+    return false;
+
+  GetRange(index, entry, entry_base, entry_delta, entry_size);
+  return true;
+}
+
+
+template<typename AddressType, typename EntryType>
+bool CompactRangeMap<AddressType, EntryType>::RetrieveNearestRange(
+    const AddressType &address, EntryType *entry, AddressType *entry_base,
+    AddressType *entry_delta, AddressType *entry_size) const {
+  BPLOG_IF(ERROR, !entry) << "CompactRangeMap::RetrieveNearestRange requires "
+                             "|entry|";
+  assert(entry);
+
+  // If address is within a range, RetrieveRange can handle it.
+  if (RetrieveRange(address, entry, entry_base, entry_delta, entry_size))
+    return true;
+
+  // Otherwise use the last range whose high address is at or below
+  // |address|, if there is one.
+  size_t index = std::upper_bound(highs_.begin(), highs_.end(), address) -
+                 highs_.begin();
+  if (index == 0)
+    return false;
+
+  GetRange(index - 1, entry, entry_base, entry_delta, entry_size);
+  return true;
+}
+
+
+template<typename AddressType, typename EntryType>
+int CompactRangeMap<AddressType, EntryType>::FindRangeIndex(
+    const AddressType &address) const {
+  size_t index = LowerBound(address);
+  if (index == highs_.size() || address < bases_[index])
+    return -1;
+  return static_cast<int>(index);
+}
+
+
+template<typename AddressType, typename EntryType>
+bool CompactRangeMap<AddressType, EntryType>::RangeAtIndexContains(
+    int index, const AddressType &address) const {
+  return index >= 0 && index < GetCount() &&
+         bases_[index] <= address && address <= highs_[index];
+}
+
+
+template<typename AddressType, typename EntryType>
+const EntryType &CompactRangeMap<AddressType, EntryType>::EntryAtIndex(
+    int index) const {
+  assert(index >= 0 && index < GetCount());
+  return entries_[index];
+}
+
+
+template<typename AddressType, typename EntryType>
+bool CompactRangeMap<AddressType, EntryType>::RetrieveRangeAtIndex(
+    int index, EntryType *entry, AddressType *entry_base,
+    AddressType *entry_delta, AddressType *entry_size) const {
+  BPLOG_IF(ERROR, !entry) << "CompactRangeMap::RetrieveRangeAtIndex requires "
+                             "|entry|";
+  assert(entry);
+
+  if (index < 0 || index >= GetCount()) {
+    BPLOG(ERROR) << "Index out of range: " << index << "/" << GetCount();
+    return false;
+  }
+
+  GetRange(index, entry, entry_base, entry_delta, entry_size);
+  return true;
+}
+
+
+template<typename AddressType, typename EntryType>
+int CompactRangeMap<AddressType, EntryType>::GetCount() const {
+  return static_cast<int>(highs_.size());
+}
+
+
+template<typename AddressType, typename EntryType>
+void CompactRangeMap<AddressType, EntryType>::Clear() {
+  highs_.clear();
+  bases_.clear();
+  deltas_.clear();
+  entries_.clear();
+}
+
+
+template<typename AddressType, typename EntryType>
+void CompactRangeMap<AddressType, EntryType>::ShrinkToFit() {
+  highs_.shrink_to_fit();
+  bases_.shrink_to_fit();
+  deltas_.shrink_to_fit();
+  entries_.shrink_to_fit();
+}
+
+
+template<typename AddressType, typename EntryType>
+size_t CompactRangeMap<AddressType, EntryType>::LowerBound(
+    const AddressType &address) const {
+  size_t count = highs_.size();
+  if (count == 0)
+    return 0;
+
+  // Halve the candidates each step.  The index sought always lies between
+  // |first| and |first| + |count| inclusive.  The step into the upper half
+  // is computed rather than branched on: compilers turn a conditional
+  // expression here back into a branch, which is mispredicted about half
+  // of the time.
+  const AddressType *first = &highs_[0];
+  while (count > 1) {
+    size_t half = count / 2;
+    first += (first[half - 1] < address) * half;
+    count -= half;
+  }
+  return (first - &highs_[0]) + (*first < address ? 1 : 0);
+}
+
+
+template<typename AddressType, typename EntryType>
+void CompactRangeMap<AddressType, EntryType>::GetRange(
+    size_t index, EntryType *entry, AddressType *entry_base,
+    AddressType *entry_delta, AddressType *entry_size) const {
+  *entry = entries_[index];
+  if (entry_base)
+    *entry_base = bases_[index];
+  if (entry_delta)
+    *entry_delta = deltas_.empty() ? AddressType() : deltas_[index];
+  if (entry_size)
+    *entry_size = highs_[index] - bases_[index] + 1;
+}
+
+
+template<typename AddressType, typename EntryType>
+void SelectableRangeMap<AddressType, EntryType>::SetCompact(bool compact) {
+  assert(GetCount() == 0);
+  compact_range_map_.reset(
+      compact ? new CompactRangeMap<AddressType, EntryType>() : NULL);
+}
+
+
+template<typename AddressType, typename EntryType>
+bool SelectableRangeMap<AddressType, EntryType>::StoreRange(
+    const AddressType &base, const AddressType &size, const EntryType &entry) {
+  if (compact_range_map_.get())
+    return compact_range_map_->StoreRange(base, size, entry);
+  return range_map_.StoreRange(base, size, entry);
+}
+
+
+template<typename AddressType, typename EntryType>
+bool SelectableRangeMap<AddressType, EntryType>::RetrieveRange(
+    const AddressType &address, EntryType *entry, AddressType *entry_base,
+    AddressType *entry_delta, AddressType *entry_size) const {
+  if (compact_range_map_.get()) {
+    return compact_range_map_->RetrieveRange(address, entry, entry_base,
+                                             entry_delta, entry_size);
+  }
+  return range_map_.RetrieveRange(address, entry, entry_base, entry_delta,
+                                  entry_size);
+}
+
+
+template<typename AddressType, typename EntryType>
+bool SelectableRangeMap<AddressType, EntryType>::RetrieveNearestRange(
+    const AddressType &address, EntryType *entry, AddressType *entry_base,
+    AddressType *entry_delta, AddressType *entry_size) const {
+  if (compact_range_map_.get()) {
+    return compact_range_map_->RetrieveNearestRange(address, entry,
+                                                    entry_base, entry_delta,
+                                                    entry_size);
+  }
+  return range_map_.RetrieveNearestRange(address, entry, entry_base,
+                                         entry_delta, entry_size);
+}
+
+
+template<typename AddressType, typename EntryType>
+bool SelectableRangeMap<AddressType, EntryType>::RetrieveRangeAtIndex(
+    int index, EntryType *entry, AddressType *entry_base,
+    AddressType *entry_delta, AddressType *entry_size) const {
+  if (compact_range_map_.get()) {
+    return compact_range_map_->RetrieveRangeAtIndex(index, entry, entry_base,
+                                                    entry_delta, entry_size);
+  }
+  return range_map_.RetrieveRangeAtIndex(index, entry, entry_base,
+                                         entry_delta, entry_size);
+}
+
+
+template<typename AddressType, typename EntryType>
+int SelectableRangeMap<AddressType, EntryType>::GetCount() const {
+  if (compact_range_map_.get())
+    return compact_range_map_->GetCount();
+  return range_map_.GetCount();
+}
+
+
+template<typename AddressType, typename EntryType>
+void SelectableRangeMap<AddressType, EntryType>::ShrinkToFit() {
+  if (compact_range_map_.get())
+    compact_range_map_->ShrinkToFit();
+}
+
+
+}  // namespace google_breakpad
+
+
+#endif  // PROCESSOR_COMPACT_RANGE_MAP_INL_H__
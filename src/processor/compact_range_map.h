@@ -0,0 +1,173 @@
+// Copyright (c) 2026 Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// compact_range_map.h: Range maps stored in sorted arrays.
+//
+// CompactRangeMap has the same interface and semantics as RangeMap,
+// including shrink-down, but keeps its ranges in parallel arrays sorted by
+// high address instead of in a std::map.  That saves the tree node
+// overhead on every range and makes lookups a binary search over
+// contiguous memory.  It's meant to be built once and then queried many
+// times, as the maps of a loaded symbol file are: storing a range is
+// cheap when ranges are stored in ascending address order, as symbol files
+// list them, but otherwise moves every range above the new one.
+
+#ifndef PROCESSOR_COMPACT_RANGE_MAP_H__
+#define PROCESSOR_COMPACT_RANGE_MAP_H__
+
+
+#include <vector>
+
+#include "common/scoped_ptr.h"
+#include "processor/range_map.h"
+
+namespace google_breakpad {
+
+template<typename AddressType, typename EntryType>
+class CompactRangeMap {
+ public:
+  CompactRangeMap() : enable_shrink_down_(false) {}
+
+  // See RangeMap for documentation of these methods.
+  void SetEnableShrinkDown(bool enable_shrink_down);
+  bool IsShrinkDownEnabled() const;
+  bool StoreRange(const AddressType &base, const AddressType &size,
+                  const EntryType &entry);
+  bool RetrieveRange(const AddressType &address, EntryType *entry,
+                     AddressType *entry_base, AddressType *entry_delta,
+                     AddressType *entry_size) const;
+  bool RetrieveNearestRange(const AddressType &address, EntryType *entry,
+                            AddressType *entry_base, AddressType *entry_delta,
+                            AddressType *entry_size) const;
+
+  // Returns the index of the range containing |address|, suitable for
+  // RetrieveRangeAtIndex, or -1 if no range contains it.
+  int FindRangeIndex(const AddressType &address) const;
+
+  // Returns true if there is a range at |index| and it contains |address|.
+  // This lets a caller that remembers the index of its last hit check it
+  // before searching again.
+  bool RangeAtIndexContains(int index, const AddressType &address) const;
+
+  // Returns the entry of the range at |index|, which must be valid.  Unlike
+  // RetrieveRangeAtIndex, this doesn't copy the entry.
+  const EntryType &EntryAtIndex(int index) const;
+
+  // Unlike RangeMap's, this takes constant time.
+  bool RetrieveRangeAtIndex(int index, EntryType *entry,
+                            AddressType *entry_base, AddressType *entry_delta,
+                            AddressType *entry_size) const;
+
+  int GetCount() const;
+  void Clear();
+
+  // Releases the spare capacity left by storing ranges.  Call this once
+  // the map is built.
+  void ShrinkToFit();
+
+ private:
+  // Same as StoreRange() with the only exception that the |delta| can be
+  // passed in.
+  bool StoreRangeInternal(const AddressType &base, const AddressType &delta,
+                          const AddressType &size, const EntryType &entry);
+
+  // Returns the index of the first range whose high address is not below
+  // |address|.  The search is branchless, which is faster than
+  // std::lower_bound on the small, frequently searched maps of loaded
+  // modules, where the comparisons are unpredictable.
+  size_t LowerBound(const AddressType &address) const;
+
+  // Fills in the Retrieve* results for the range at |index|.
+  void GetRange(size_t index, EntryType *entry, AddressType *entry_base,
+                AddressType *entry_delta, AddressType *entry_size) const;
+
+  // Whether overlapping ranges can be shrunk down.
+  bool enable_shrink_down_;
+
+  // The ranges, sorted by high address.  The i'th range covers
+  // bases_[i] to highs_[i] inclusive, and has been shrunk down by
+  // deltas_[i].  Ranges are rarely shrunk down, so deltas_ stays empty,
+  // meaning all deltas are zero, until one is.
+  std::vector<AddressType> highs_;
+  std::vector<AddressType> bases_;
+  std::vector<AddressType> deltas_;
+  std::vector<EntryType> entries_;
+};
+
+
+// A RangeMap or a CompactRangeMap, chosen at run time.  Until SetCompact
+// is called, ranges are kept in a RangeMap.  The choice must be made
+// before anything is stored.
+template<typename AddressType, typename EntryType>
+class SelectableRangeMap {
+ public:
+  SelectableRangeMap() : range_map_(), compact_range_map_() {}
+
+  void SetCompact(bool compact);
+  bool IsCompact() const { return compact_range_map_.get() != NULL; }
+
+  // The map in use, depending on IsCompact().
+  const RangeMap<AddressType, EntryType> &range_map() const {
+    return range_map_;
+  }
+  const CompactRangeMap<AddressType, EntryType> &compact_range_map() const {
+    return *compact_range_map_;
+  }
+
+  // These forward to the map in use.
+  bool StoreRange(const AddressType &base, const AddressType &size,
+                  const EntryType &entry);
+  bool RetrieveRange(const AddressType &address, EntryType *entry,
+                     AddressType *entry_base, AddressType *entry_delta,
+                     AddressType *entry_size) const;
+  bool RetrieveNearestRange(const AddressType &address, EntryType *entry,
+                            AddressType *entry_base, AddressType *entry_delta,
+                            AddressType *entry_size) const;
+  bool RetrieveRangeAtIndex(int index, EntryType *entry,
+                            AddressType *entry_base, AddressType *entry_delta,
+                            AddressType *entry_size) const;
+  int GetCount() const;
+
+  // Calls CompactRangeMap::ShrinkToFit if the map is compact.
+  void ShrinkToFit();
+
+ private:
+  RangeMap<AddressType, EntryType> range_map_;
+  scoped_ptr<CompactRangeMap<AddressType, EntryType> > compact_range_map_;
+
+  // Disallow copy constructor and assignment operator.
+  SelectableRangeMap(const SelectableRangeMap&);
+  void operator=(const SelectableRangeMap&);
+};
+
+
+}  // namespace google_breakpad
+
+
+#endif  // PROCESSOR_COMPACT_RANGE_MAP_H__
@@ -0,0 +1,241 @@
+// Copyright (c) 2026 Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// compact_range_map_unittest.cc: Unit tests for CompactRangeMap, which
+// checks that it behaves exactly as RangeMap does.
+
+#include <stdlib.h>
+
+#include <vector>
+
+#include "breakpad_googletest_includes.h"
+#include "processor/compact_range_map-inl.h"
+#include "processor/range_map-inl.h"
+
+namespace {
+
+using google_breakpad::CompactRangeMap;
+using google_breakpad::RangeMap;
+using google_breakpad::SelectableRangeMap;
+using std::vector;
+
+typedef unsigned int AddressType;
+
+struct TestRange {
+  AddressType base;
+  AddressType size;
+};
+
+// Stores |ranges| in a RangeMap and a CompactRangeMap and checks that
+// every store and every lookup up to |max_address| gives the same result.
+void CheckSameAsRangeMap(const vector<TestRange> &ranges,
+                         bool enable_shrink_down,
+                         AddressType max_address) {
+  RangeMap<AddressType, int> range_map;
+  CompactRangeMap<AddressType, int> compact_map;
+  range_map.SetEnableShrinkDown(enable_shrink_down);
+  compact_map.SetEnableShrinkDown(enable_shrink_down);
+  ASSERT_EQ(compact_map.IsShrinkDownEnabled(), enable_shrink_down);
+
+  for (size_t i = 0; i < ranges.size(); ++i) {
+    ASSERT_EQ(range_map.StoreRange(ranges[i].base, ranges[i].size, i),
+              compact_map.StoreRange(ranges[i].base, ranges[i].size, i))
+        << "range " << i;
+  }
+  ASSERT_EQ(range_map.GetCount(), compact_map.GetCount());
+  compact_map.ShrinkToFit();
+
+  for (int index = 0; index < range_map.GetCount(); ++index) {
+    int entry = -1, compact_entry = -2;
+    AddressType base, delta, size, compact_base, compact_delta, compact_size;
+    ASSERT_TRUE(range_map.RetrieveRangeAtIndex(index, &entry, &base, &delta,
+                                               &size));
+    ASSERT_TRUE(compact_map.RetrieveRangeAtIndex(index, &compact_entry,
+                                                 &compact_base,
+                                                 &compact_delta,
+                                                 &compact_size));
+    ASSERT_EQ(entry, compact_entry);
+    ASSERT_EQ(base, compact_base);
+    ASSERT_EQ(delta, compact_delta);
+    ASSERT_EQ(size, compact_size);
+  }
+
+  for (AddressType address = 0; address <= max_address; ++address) {
+    int entry = -1, compact_entry = -2;
+    AddressType base = 0, delta = 0, size = 0;
+    AddressType compact_base = 1, compact_delta = 1, compact_size = 1;
+    bool found = range_map.RetrieveRange(address, &entry, &base, &delta,
+                                         &size);
+    ASSERT_EQ(found, compact_map.RetrieveRange(address, &compact_entry,
+                                               &compact_base, &compact_delta,
+                                               &compact_size))
+        << "address " << address;
+    if (found) {
+      ASSERT_EQ(entry, compact_entry);
+      ASSERT_EQ(base, compact_base);
+      ASSERT_EQ(delta, compact_delta);
+      ASSERT_EQ(size, compact_size);
+    }
+
+    int index = compact_map.FindRangeIndex(address);
+    ASSERT_EQ(found, index >= 0) << "address " << address;
+    ASSERT_EQ(found, compact_map.RangeAtIndexContains(index, address));
+    if (found) {
+      ASSERT_EQ(entry, compact_map.EntryAtIndex(index));
+    }
+
+    found = range_map.RetrieveNearestRange(address, &entry, &base, &delta,
+                                           &size);
+    ASSERT_EQ(found, compact_map.RetrieveNearestRange(address, &compact_entry,
+                                                      &compact_base,
+                                                      &compact_delta,
+                                                      &compact_size))
+        << "address " << address;
+    if (found) {
+      ASSERT_EQ(entry, compact_entry);
+      ASSERT_EQ(base, compact_base);
+      ASSERT_EQ(delta, compact_delta);
+      ASSERT_EQ(size, compact_size);
+    }
+  }
+}
+
+TEST(CompactRangeMap, Empty) {
+  CompactRangeMap<AddressType, int> compact_map;
+  int entry;
+  EXPECT_EQ(compact_map.GetCount(), 0);
+  EXPECT_FALSE(compact_map.RetrieveRange(0, &entry, NULL, NULL, NULL));
+  EXPECT_FALSE(compact_map.RetrieveNearestRange(100, &entry, NULL, NULL,
+                                                NULL));
+  EXPECT_FALSE(compact_map.RetrieveRangeAtIndex(0, &entry, NULL, NULL, NULL));
+  EXPECT_EQ(compact_map.FindRangeIndex(0), -1);
+  EXPECT_FALSE(compact_map.RangeAtIndexContains(0, 0));
+}
+
+TEST(CompactRangeMap, StoreAndRetrieve) {
+  CompactRangeMap<AddressType, int> compact_map;
+  EXPECT_TRUE(compact_map.StoreRange(10, 10, 1));
+  EXPECT_TRUE(compact_map.StoreRange(30, 5, 2));
+  EXPECT_TRUE(compact_map.StoreRange(20, 10, 3));  // Fills the gap.
+  EXPECT_FALSE(compact_map.StoreRange(15, 10, 4));  // Overlaps.
+  EXPECT_FALSE(compact_map.StoreRange(5, 0, 5));  // Empty.
+  EXPECT_FALSE(compact_map.StoreRange(0xfffffff0, 0x20, 6));  // Overflows.
+  EXPECT_EQ(compact_map.GetCount(), 3);
+
+  int entry;
+  AddressType base, size;
+  EXPECT_TRUE(compact_map.RetrieveRange(25, &entry, &base, NULL, &size));
+  EXPECT_EQ(entry, 3);
+  EXPECT_EQ(base, 20U);
+  EXPECT_EQ(size, 10U);
+  EXPECT_FALSE(compact_map.RetrieveRange(35, &entry, NULL, NULL, NULL));
+  EXPECT_TRUE(compact_map.RetrieveNearestRange(1000, &entry, &base, NULL,
+                                               NULL));
+  EXPECT_EQ(entry, 2);
+  EXPECT_TRUE(compact_map.RetrieveRangeAtIndex(1, &entry, NULL, NULL, NULL));
+  EXPECT_EQ(entry, 3);
+  EXPECT_EQ(compact_map.FindRangeIndex(25), 1);
+  EXPECT_EQ(compact_map.EntryAtIndex(1), 3);
+  EXPECT_EQ(compact_map.FindRangeIndex(35), -1);
+  EXPECT_TRUE(compact_map.RangeAtIndexContains(1, 29));
+  EXPECT_FALSE(compact_map.RangeAtIndexContains(1, 30));
+  EXPECT_FALSE(compact_map.RangeAtIndexContains(-1, 25));
+  EXPECT_FALSE(compact_map.RangeAtIndexContains(3, 25));
+
+  compact_map.Clear();
+  EXPECT_EQ(compact_map.GetCount(), 0);
+}
+
+TEST(CompactRangeMap, ShrinkDown) {
+  vector<TestRange> ranges;
+  TestRange contained = { 10, 10 };
+  TestRange overlapping_below = { 5, 10 };
+  TestRange overlapping_above = { 15, 20 };
+  TestRange containing = { 0, 100 };
+  ranges.push_back(contained);
+  ranges.push_back(overlapping_below);
+  ranges.push_back(overlapping_above);
+  ranges.push_back(containing);
+  CheckSameAsRangeMap(ranges, true, 120);
+  CheckSameAsRangeMap(ranges, false, 120);
+}
+
+TEST(CompactRangeMap, SameAsRangeMapAscending) {
+  vector<TestRange> ranges;
+  AddressType address = 0;
+  for (int i = 0; i < 500; ++i) {
+    address += rand() % 4;
+    TestRange range = { address, static_cast<AddressType>(1 + rand() % 8) };
+    ranges.push_back(range);
+    address += range.size;
+  }
+  CheckSameAsRangeMap(ranges, false, address + 10);
+  CheckSameAsRangeMap(ranges, true, address + 10);
+}
+
+TEST(CompactRangeMap, SameAsRangeMapRandom) {
+  srand(0);
+  for (int run = 0; run < 20; ++run) {
+    vector<TestRange> ranges;
+    for (int i = 0; i < 200; ++i) {
+      TestRange range = { static_cast<AddressType>(rand() % 2000),
+                          static_cast<AddressType>(rand() % 40) };
+      ranges.push_back(range);
+    }
+    CheckSameAsRangeMap(ranges, false, 2100);
+    CheckSameAsRangeMap(ranges, true, 2100);
+  }
+}
+
+TEST(SelectableRangeMap, ForwardsToMapInUse) {
+  for (int compact = 0; compact < 2; ++compact) {
+    SelectableRangeMap<AddressType, int> selectable_map;
+    selectable_map.SetCompact(compact);
+    EXPECT_EQ(selectable_map.IsCompact(), compact == 1);
+    EXPECT_TRUE(selectable_map.StoreRange(10, 10, 1));
+    EXPECT_TRUE(selectable_map.StoreRange(30, 10, 2));
+    EXPECT_FALSE(selectable_map.StoreRange(15, 10, 3));
+    EXPECT_EQ(selectable_map.GetCount(), 2);
+    EXPECT_EQ(compact ? selectable_map.compact_range_map().GetCount()
+                      : selectable_map.range_map().GetCount(), 2);
+
+    int entry;
+    AddressType base;
+    EXPECT_TRUE(selectable_map.RetrieveRange(35, &entry, &base, NULL, NULL));
+    EXPECT_EQ(entry, 2);
+    EXPECT_EQ(base, 30U);
+    EXPECT_FALSE(selectable_map.RetrieveRange(25, &entry, NULL, NULL, NULL));
+    EXPECT_TRUE(selectable_map.RetrieveNearestRange(25, &entry, NULL, NULL,
+                                                    NULL));
+    EXPECT_EQ(entry, 1);
+    selectable_map.ShrinkToFit();
+  }
+}
+
+}  // namespace
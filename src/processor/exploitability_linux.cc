@@ -98,12 +98,12 @@ ExploitabilityRating ExploitabilityLinux::CheckPlatformExploitability() {
     const vector<StackFrame*>& crashing_thread_frames =
         *crashing_thread->frames();
     for (size_t i = 0; i < crashing_thread_frames.size(); ++i) {
-      if (crashing_thread_frames[i]->function_name ==
+      if (crashing_thread_frames[i]->FunctionName() ==
           kStackCheckFailureFunction) {
         return EXPLOITABILITY_HIGH;
       }
 
-      if (crashing_thread_frames[i]->function_name ==
+      if (crashing_thread_frames[i]->FunctionName() ==
           kBoundsCheckFailureFunction) {
         return EXPLOITABILITY_HIGH;
       }
@@ -61,7 +61,8 @@ bool FastSourceLineResolver::ShouldDeleteMemoryBufferAfterLoadModule() {
   return false;
 }
 
-void FastSourceLineResolver::Module::LookupAddress(StackFrame *frame) const {
+void FastSourceLineResolver::Module::LookupAddress(StackFrame *frame,
+                                                   bool share_names) const {
   MemAddr address = frame->instruction - frame->module->base_address();
 
   // First, look for a FUNC record that covers address. Use
@@ -81,8 +82,14 @@ void FastSourceLineResolver::Module::LookupAddress(StackFrame *frame) const {
   if (functions_.RetrieveNearestRange(address, func_ptr,
                                       &function_base, &function_size) &&
       address >= function_base && address - function_base < function_size) {
-    func.get()->CopyFrom(func_ptr);
-    frame->function_name = func->name;
+    // Serialized functions and public symbols start with their names.
+    func.get()->CopyFrom(func_ptr, !share_names);
+    if (share_names) {
+      frame->interned_function_name =
+          SharedName(reinterpret_cast<const char*>(func_ptr));
+    } else {
+      frame->function_name = func->name;
+    }
     frame->function_base = frame->module->base_address() + function_base;
 
     scoped_ptr<Line> line(new Line);
@@ -92,8 +99,12 @@ void FastSourceLineResolver::Module::LookupAddress(StackFrame *frame) const {
       line.get()->CopyFrom(line_ptr);
       FileMap::iterator it = files_.find(line->source_file_id);
       if (it != files_.end()) {
-        frame->source_file_name =
-            files_.find(line->source_file_id).GetValuePtr();
+        if (share_names) {
+          frame->interned_source_file_name = SharedName(it.GetValuePtr());
+        } else {
+          frame->source_file_name =
+              files_.find(line->source_file_id).GetValuePtr();
+        }
       }
       frame->source_line = line->line;
       frame->source_line_base = frame->module->base_address() + line_base;
@@ -101,8 +112,13 @@ void FastSourceLineResolver::Module::LookupAddress(StackFrame *frame) const {
   } else if (public_symbols_.Retrieve(address,
                                       public_symbol_ptr, &public_address) &&
              (!func_ptr || public_address > function_base)) {
-    public_symbol.get()->CopyFrom(public_symbol_ptr);
-    frame->function_name = public_symbol->name;
+    if (share_names) {
+      frame->interned_function_name =
+          SharedName(reinterpret_cast<const char*>(public_symbol_ptr));
+    } else {
+      public_symbol.get()->CopyFrom(public_symbol_ptr);
+      frame->function_name = public_symbol->name;
+    }
     frame->function_base = frame->module->base_address() + public_address;
   }
 }
@@ -244,6 +260,11 @@ CFIFrameInfo *FastSourceLineResolver::Module::FindCFIFrameInfo(
   MemAddr initial_base, initial_size;
   const char* initial_rules = NULL;
 
+  // A frame at an address looked up before uses the rule set found then.
+  CFIFrameInfo *cached = cfi_frame_info_cache_.FindByAddress(address);
+  if (cached)
+    return cached;
+
   // Find the initial rule whose range covers this address. That
   // provides an initial set of register recovery rules. Then, walk
   // forward from the initial rule's starting address to frame's
@@ -253,22 +274,37 @@ CFIFrameInfo *FastSourceLineResolver::Module::FindCFIFrameInfo(
     return NULL;
   }
 
+  // Find the delta rules that fall within the initial rule's range, up to
+  // and including the frame's address. The last of them, or the initial
+  // rule if there are none, keys the rule set in the cache.
+  StaticMap<MemAddr, char>::iterator delta_begin =
+    cfi_delta_rules_.lower_bound(initial_base);
+  StaticMap<MemAddr, char>::iterator delta_end =
+    cfi_delta_rules_.upper_bound(address);
+  MemAddr key = initial_base;
+  if (delta_begin != delta_end) {
+    StaticMap<MemAddr, char>::iterator last_delta = delta_end;
+    key = (--last_delta).GetKey();
+  }
+  cached = cfi_frame_info_cache_.Find(key, address);
+  if (cached)
+    return cached;
+
   // Create a frame info structure, and populate it with the rules from
   // the STACK CFI INIT record.
   scoped_ptr<CFIFrameInfo> rules(new CFIFrameInfo());
   if (!ParseCFIRuleSet(initial_rules, rules.get()))
     return NULL;
 
-  // Find the first delta rule that falls within the initial rule's range.
-  StaticMap<MemAddr, char>::iterator delta =
-    cfi_delta_rules_.lower_bound(initial_base);
-
-  // Apply delta rules up to and including the frame's address.
-  while (delta != cfi_delta_rules_.end() && delta.GetKey() <= address) {
+  // Apply the delta rules.
+  for (StaticMap<MemAddr, char>::iterator delta = delta_begin;
+       delta != delta_end; delta++) {
     ParseCFIRuleSet(delta.GetValuePtr(), rules.get());
-    delta++;
   }
 
+  // Compile the rules once for every frame that uses them.
+  rules->Compile();
+  cfi_frame_info_cache_.Insert(key, address, *rules);
   return rules.release();
 }
 
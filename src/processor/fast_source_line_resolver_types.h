@@ -72,15 +72,17 @@ struct FastSourceLineResolver::Line : public SourceLineResolverBase::Line {
 
 struct FastSourceLineResolver::Function :
 public SourceLineResolverBase::Function {
-  void CopyFrom(const Function *func_ptr) {
+  void CopyFrom(const Function *func_ptr, bool copy_name = true) {
     const char *raw = reinterpret_cast<const char*>(func_ptr);
-    CopyFrom(raw);
+    CopyFrom(raw, copy_name);
   }
 
-  // De-serialize the memory data of a Function.
-  void CopyFrom(const char *raw) {
+  // De-serialize the memory data of a Function.  The data starts with the
+  // function's name, which is only copied if COPY_NAME is true.
+  void CopyFrom(const char *raw, bool copy_name = true) {
     size_t name_size = strlen(raw) + 1;
-    name = raw;
+    if (copy_name)
+      name = raw;
     address = *(reinterpret_cast<const MemAddr*>(raw + name_size));
     size = *(reinterpret_cast<const MemAddr*>(
         raw + name_size + sizeof(MemAddr)));
@@ -116,8 +118,9 @@ class FastSourceLineResolver::Module: public SourceLineResolverBase::Module {
   virtual ~Module() { }
 
   // Looks up the given relative address, and fills the StackFrame struct
-  // with the result.
-  virtual void LookupAddress(StackFrame *frame) const;
+  // with the result, sharing the module's copies of the names found if
+  // SHARE_NAMES is true.
+  virtual void LookupAddress(StackFrame *frame, bool share_names) const;
 
   // Loads a map from the given buffer in char* type.
   virtual bool LoadMapFromMemory(char *memory_buffer,
@@ -140,6 +143,16 @@ class FastSourceLineResolver::Module: public SourceLineResolverBase::Module {
   // returned CFIFrameInfo object.
   virtual CFIFrameInfo *FindCFIFrameInfo(const StackFrame *frame) const;
 
+  virtual CFIFrameInfoCache::Stats CFIFrameInfoCacheStats() const {
+    return cfi_frame_info_cache_.stats();
+  }
+
+  // The module's maps are views of the serialized data, which the resolver
+  // counts, so only the names shared with frames take memory of their own.
+  virtual size_t MemoryUsage() const {
+    return sizeof(*this) + SharedNameMemoryUsage();
+  }
+
   // Number of serialized map components of Module.
   static const int kNumberMaps_ = 5 + WindowsFrameInfo::STACK_INFO_LAST;
 
@@ -178,6 +191,11 @@ class FastSourceLineResolver::Module: public SourceLineResolverBase::Module {
   // this map, or the end of the range as given by the cfi_initial_rules_
   // entry (which FindCFIFrameInfo looks up first).
   StaticMap<MemAddr, char> cfi_delta_rules_;
+
+  // Rule sets FindCFIFrameInfo has already parsed and compiled, and the
+  // instruction addresses it has looked them up for. Updated by the const
+  // FindCFIFrameInfo; see CFIFrameInfoCache on threads.
+  mutable CFIFrameInfoCache cfi_frame_info_cache_;
 };
 
 }  // namespace google_breakpad
@@ -44,6 +44,8 @@
 #include <string>
 
 #include "breakpad_googletest_includes.h"
+#include "common/scoped_ptr.h"
+#include "common/tests/auto_tempdir.h"
 #include "common/using_std_string.h"
 #include "google_breakpad/processor/code_module.h"
 #include "google_breakpad/processor/stack_frame.h"
@@ -54,6 +56,7 @@
 
 namespace {
 
+using google_breakpad::AutoTempDir;
 using google_breakpad::SourceLineResolverBase;
 using google_breakpad::BasicSourceLineResolver;
 using google_breakpad::FastSourceLineResolver;
@@ -65,6 +68,7 @@ using google_breakpad::MemoryRegion;
 using google_breakpad::StackFrame;
 using google_breakpad::WindowsFrameInfo;
 using google_breakpad::linked_ptr;
+using google_breakpad::scoped_array;
 using google_breakpad::scoped_ptr;
 
 class TestCodeModule : public CodeModule {
@@ -466,6 +470,150 @@ TEST_F(TestFastSourceLineResolver, TestUnload) {
   ASSERT_TRUE(fast_resolver.HasModule(&module1));
 }
 
+// Frames filled in sharing names hold the module's copies.
+TEST_F(TestFastSourceLineResolver, TestShareNames) {
+  TestCodeModule module1("module1");
+  ASSERT_TRUE(basic_resolver.LoadModule(&module1, symbol_file(1)));
+  ASSERT_TRUE(serializer.ConvertOneModule(
+      module1.code_file(), &basic_resolver, &fast_resolver));
+
+  StackFrame first, second, public_frame;
+  first.instruction = 0x1000;
+  first.module = &module1;
+  second.instruction = 0x1008;
+  second.module = &module1;
+  public_frame.instruction = 0x2800;
+  public_frame.module = &module1;
+  ASSERT_TRUE(fast_resolver.FillSourceLineInfoSharingNames(&first));
+  ASSERT_TRUE(fast_resolver.FillSourceLineInfoSharingNames(&second));
+  ASSERT_TRUE(fast_resolver.FillSourceLineInfoSharingNames(&public_frame));
+
+  EXPECT_TRUE(first.function_name.empty());
+  EXPECT_TRUE(first.source_file_name.empty());
+  EXPECT_EQ("Function1_1", first.FunctionName());
+  EXPECT_EQ("file1_1.cc", first.SourceFileName());
+  EXPECT_EQ(0x1000U, second.function_base);
+  EXPECT_EQ(46, second.source_line);
+  EXPECT_EQ(first.interned_function_name, second.interned_function_name);
+  EXPECT_EQ(first.interned_source_file_name,
+            second.interned_source_file_name);
+  EXPECT_EQ("PublicSymbol", public_frame.FunctionName());
+  EXPECT_TRUE(public_frame.interned_source_file_name == NULL);
+
+  // The names outlive the module.
+  fast_resolver.UnloadModule(&module1);
+  EXPECT_EQ("Function1_1", second.FunctionName());
+  EXPECT_EQ("file1_1.cc", second.SourceFileName());
+}
+
+// Modules whose functions and lines are in compact range maps convert to
+// the same fast modules.
+TEST_F(TestFastSourceLineResolver, TestConvertCompactModule) {
+  TestCodeModule module1("module1");
+  BasicSourceLineResolver compact_resolver;
+  compact_resolver.set_compact_range_maps(true);
+  ASSERT_TRUE(basic_resolver.LoadModule(&module1, symbol_file(1)));
+  ASSERT_TRUE(compact_resolver.LoadModule(&module1, symbol_file(1)));
+  ASSERT_TRUE(serializer.ConvertOneModule(module1.code_file(),
+                                          &compact_resolver,
+                                          &fast_resolver));
+
+  for (uint64_t address = 0; address < 0x4000; ++address) {
+    StackFrame frame;
+    frame.instruction = address;
+    frame.module = &module1;
+    StackFrame fast_frame = frame;
+    basic_resolver.FillSourceLineInfo(&frame);
+    fast_resolver.FillSourceLineInfo(&fast_frame);
+    ASSERT_EQ(frame.function_name, fast_frame.function_name);
+    ASSERT_EQ(frame.function_base, fast_frame.function_base);
+    ASSERT_EQ(frame.source_file_name, fast_frame.source_file_name);
+    ASSERT_EQ(frame.source_line, fast_frame.source_line);
+    ASSERT_EQ(frame.source_line_base, fast_frame.source_line_base);
+  }
+}
+
+TEST_F(TestFastSourceLineResolver, TestSymbolDataBudget) {
+  TestCodeModule module1("module1");
+  TestCodeModule module2("module2");
+  ASSERT_TRUE(basic_resolver.LoadModule(&module1, symbol_file(1)));
+  ASSERT_TRUE(basic_resolver.LoadModule(&module2, symbol_file(2)));
+
+  ASSERT_TRUE(serializer.ConvertOneModule(module1.code_file(),
+                                          &basic_resolver,
+                                          &fast_resolver));
+  size_t module1_data = fast_resolver.loaded_symbol_data();
+  ASSERT_GT(module1_data, 0U);
+
+  // Leave room for module1 only, so that loading module2 evicts it.
+  fast_resolver.set_symbol_data_budget(module1_data);
+  ASSERT_TRUE(serializer.ConvertOneModule(module2.code_file(),
+                                          &basic_resolver,
+                                          &fast_resolver));
+  ASSERT_EQ(fast_resolver.module_cache_evictions(), 1U);
+  ASSERT_FALSE(fast_resolver.HasModule(&module1));
+  ASSERT_TRUE(fast_resolver.HasModule(&module2));
+  ASSERT_EQ(fast_resolver.module_cache_hits(), 1U);
+  ASSERT_EQ(fast_resolver.module_cache_misses(), 1U);
+
+  StackFrame frame;
+  frame.instruction = 0x2181;
+  frame.module = &module2;
+  fast_resolver.FillSourceLineInfo(&frame);
+  ASSERT_EQ(frame.function_name, "Function2_2");
+}
+
+TEST_F(TestFastSourceLineResolver, TestLoadMappedFile) {
+  char *symbol_data;
+  size_t symbol_data_size;
+  ASSERT_TRUE(SourceLineResolverBase::ReadSymbolFile(
+      symbol_file(1), &symbol_data, &symbol_data_size));
+  string symbol_data_string(symbol_data, symbol_data_size);
+  delete [] symbol_data;
+
+  unsigned int serialized_size;
+  scoped_array<char> serialized(
+      serializer.SerializeSymbolFileData(symbol_data_string,
+                                         &serialized_size));
+  ASSERT_TRUE(serialized.get());
+
+  AutoTempDir temp_dir;
+  string serialized_file = temp_dir.path() + "/module1.fast";
+  FILE *file = fopen(serialized_file.c_str(), "wb");
+  ASSERT_TRUE(file);
+  ASSERT_EQ(fwrite(serialized.get(), 1, serialized_size, file),
+            serialized_size);
+  ASSERT_EQ(fclose(file), 0);
+
+  TestCodeModule module1("module1");
+  ASSERT_TRUE(fast_resolver.LoadModuleUsingMappedFile(&module1,
+                                                      serialized_file));
+  ASSERT_TRUE(fast_resolver.HasModule(&module1));
+  ASSERT_FALSE(fast_resolver.IsModuleCorrupt(&module1));
+  ASSERT_FALSE(fast_resolver.LoadModuleUsingMappedFile(&module1,
+                                                       serialized_file));
+
+  StackFrame frame;
+  frame.instruction = 0x1000;
+  frame.module = &module1;
+  fast_resolver.FillSourceLineInfo(&frame);
+  ASSERT_EQ(frame.function_name, "Function1_1");
+  ASSERT_EQ(frame.source_file_name, "file1_1.cc");
+  ASSERT_EQ(frame.source_line, 44);
+
+  // The mapping goes away with the module, and a fresh one can be made.
+  fast_resolver.UnloadModule(&module1);
+  ASSERT_FALSE(fast_resolver.HasModule(&module1));
+  ASSERT_TRUE(fast_resolver.LoadModuleUsingMappedFile(&module1,
+                                                      serialized_file));
+  ASSERT_TRUE(fast_resolver.HasModule(&module1));
+
+  TestCodeModule module2("module2");
+  ASSERT_FALSE(fast_resolver.LoadModuleUsingMappedFile(
+      &module2, temp_dir.path() + "/invalid-filename"));
+  ASSERT_FALSE(fast_resolver.HasModule(&module2));
+}
+
 TEST_F(TestFastSourceLineResolver, CompareModule) {
   char *symbol_data;
   size_t symbol_data_size;
@@ -481,6 +629,9 @@ TEST_F(TestFastSourceLineResolver, CompareModule) {
     symbol_data_string.assign(symbol_data, symbol_data_size);
     delete [] symbol_data;
     ASSERT_TRUE(module_comparer.Compare(symbol_data_string));
+    module_comparer.set_compact_range_maps(true);
+    ASSERT_TRUE(module_comparer.Compare(symbol_data_string));
+    module_comparer.set_compact_range_maps(false);
   }
 }
 
@@ -0,0 +1,309 @@
+// Copyright (c) 2026 Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// fast_symbol_supplier.cc: A SymbolSupplier for FastSourceLineResolver.
+//
+// See fast_symbol_supplier.h for documentation.
+
+#include "processor/fast_symbol_supplier.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#ifndef _WIN32
+#include <stdlib.h>
+#include <unistd.h>
+#endif  // _WIN32
+
+#include "common/scoped_ptr.h"
+#include "common/using_std_string.h"
+#include "processor/logging.h"
+#include "processor/module_serializer.h"
+
+namespace google_breakpad {
+
+const char FastSymbolSupplier::kSymbolFileExtension[] = ".sym";
+const char FastSymbolSupplier::kSerializedSymbolFileExtension[] = ".fast";
+
+static bool ends_with(const string &s, const char *suffix) {
+  size_t suffix_length = strlen(suffix);
+  return s.size() >= suffix_length &&
+         s.compare(s.size() - suffix_length, suffix_length, suffix) == 0;
+}
+
+// Opens the file at |path| for reading without any newline translation, and
+// places its size in |size|.  Returns NULL on failure.
+static FILE *open_file(const string &path, size_t *size) {
+  FILE *file = fopen(path.c_str(), "rb");
+  if (!file) {
+    BPLOG(ERROR) << "Could not open " << path;
+    return NULL;
+  }
+
+  long file_size = fseek(file, 0, SEEK_END) == 0 ? ftell(file) : -1;
+  if (file_size < 0 || fseek(file, 0, SEEK_SET) != 0) {
+    BPLOG(ERROR) << "Could not read " << path;
+    fclose(file);
+    return NULL;
+  }
+  *size = static_cast<size_t>(file_size);
+  return file;
+}
+
+// Reads the whole file at |path| into |contents|.
+static bool read_file(const string &path, string *contents) {
+  size_t size;
+  FILE *file = open_file(path, &size);
+  if (!file)
+    return false;
+
+  contents->resize(size);
+  bool ok = size == 0 || fread(&(*contents)[0], 1, size, file) == size;
+  fclose(file);
+
+  BPLOG_IF(ERROR, !ok) << "Could not read " << path;
+  return ok;
+}
+
+// Reads the whole file at |path| into a buffer allocated with new[], which
+// the caller takes ownership of.
+static bool read_file(const string &path, char **contents, size_t *size) {
+  FILE *file = open_file(path, size);
+  if (!file)
+    return false;
+
+  scoped_array<char> buffer(new char[*size ? *size : 1]);
+  bool ok = *size == 0 || fread(buffer.get(), 1, *size, file) == *size;
+  fclose(file);
+
+  if (!ok) {
+    BPLOG(ERROR) << "Could not read " << path;
+    return false;
+  }
+  *contents = buffer.release();
+  return true;
+}
+
+string FastSymbolSupplier::SerializedSymbolFilePath(
+    const string &symbol_file) {
+  string path = symbol_file;
+  if (ends_with(path, kSymbolFileExtension))
+    path.resize(path.size() - strlen(kSymbolFileExtension));
+  return path + kSerializedSymbolFileExtension;
+}
+
+bool FastSymbolSupplier::ConvertSymbolFile(const string &symbol_file) {
+  char *serialized_data;
+  size_t serialized_size;
+  if (!SerializeSymbolFile(symbol_file, &serialized_data, &serialized_size))
+    return false;
+
+  scoped_array<char> serialized(serialized_data);
+  return WriteSerializedSymbolFile(SerializedSymbolFilePath(symbol_file),
+                                   serialized.get(), serialized_size);
+}
+
+SymbolSupplier::SymbolResult FastSymbolSupplier::GetSymbolFile(
+    const CodeModule *module,
+    const SystemInfo *system_info,
+    string *symbol_file,
+    string *symbol_data) {
+  assert(symbol_data);
+  symbol_data->clear();
+
+  char *data;
+  size_t size;
+  SymbolSupplier::SymbolResult s =
+      GetSerializedSymbolData(module, system_info, symbol_file, &data, &size);
+  if (s == FOUND) {
+    symbol_data->assign(data, size);
+    delete [] data;
+  }
+  return s;
+}
+
+SymbolSupplier::SymbolResult FastSymbolSupplier::GetCStringSymbolData(
+    const CodeModule *module,
+    const SystemInfo *system_info,
+    string *symbol_file,
+    char **symbol_data,
+    size_t *symbol_data_size) {
+  assert(symbol_data);
+  assert(symbol_data_size);
+
+  // The serialized data is handed over in the buffer it was read or
+  // serialized into.  FastSourceLineResolver reads it in place, and needs no
+  // terminating NUL.
+  SymbolSupplier::SymbolResult s = GetSerializedSymbolData(
+      module, system_info, symbol_file, symbol_data, symbol_data_size);
+  if (s == FOUND)
+    KeepSymbolData(module, *symbol_data);
+  return s;
+}
+
+bool FastSymbolSupplier::GetMappableSymbolFile(const CodeModule *module,
+                                               const SystemInfo *system_info,
+                                               string *symbol_file) {
+  if (GetSymbolFile(module, system_info, symbol_file) != FOUND)
+    return false;
+  if (ends_with(*symbol_file, kSerializedSymbolFileExtension))
+    return true;
+
+  if (!write_serialized_files_ || !ConvertSymbolFile(*symbol_file))
+    return false;
+  *symbol_file = SerializedSymbolFilePath(*symbol_file);
+  return true;
+}
+
+SymbolSupplier::SymbolResult FastSymbolSupplier::GetSymbolFileAtPathFromRoot(
+    const CodeModule *module, const SystemInfo *system_info,
+    const string &root_path, string *symbol_file) {
+  BPLOG_IF(ERROR, !symbol_file) << "FastSymbolSupplier::GetSymbolFileAtPath "
+                                   "requires |symbol_file|";
+  assert(symbol_file);
+  symbol_file->clear();
+
+  string path;
+  if (!GetSymbolFilePathFromRoot(module, root_path, &path))
+    return NOT_FOUND;
+
+  // A serialized file older than its text file was converted from an
+  // earlier version of it, so it is only used while it is as new.
+  string serialized_path = SerializedSymbolFilePath(path);
+  struct stat serialized_stat;
+  struct stat text_stat;
+  bool have_serialized = stat(serialized_path.c_str(), &serialized_stat) == 0;
+  bool have_text = stat(path.c_str(), &text_stat) == 0;
+  if (have_serialized &&
+      (!have_text || serialized_stat.st_mtime >= text_stat.st_mtime)) {
+    *symbol_file = serialized_path;
+    return FOUND;
+  }
+
+  if (!have_text) {
+    BPLOG(INFO) << "No symbol file at " << serialized_path << " or " << path;
+    return NOT_FOUND;
+  }
+
+  BPLOG_IF(INFO, have_serialized) << "Ignoring " << serialized_path <<
+                                     ", which is older than " << path;
+  *symbol_file = path;
+  return FOUND;
+}
+
+SymbolSupplier::SymbolResult FastSymbolSupplier::GetSerializedSymbolData(
+    const CodeModule *module,
+    const SystemInfo *system_info,
+    string *symbol_file,
+    char **symbol_data,
+    size_t *symbol_data_size) {
+  SymbolSupplier::SymbolResult s = GetSymbolFile(module, system_info,
+                                                 symbol_file);
+  if (s != FOUND)
+    return s;
+
+  if (ends_with(*symbol_file, kSerializedSymbolFileExtension)) {
+    return read_file(*symbol_file, symbol_data, symbol_data_size) ?
+           FOUND : NOT_FOUND;
+  }
+
+  // Only the text symbol file is usable, so it has to be parsed here.
+  if (!SerializeSymbolFile(*symbol_file, symbol_data, symbol_data_size))
+    return NOT_FOUND;
+
+  if (write_serialized_files_) {
+    string serialized_file = SerializedSymbolFilePath(*symbol_file);
+    if (WriteSerializedSymbolFile(serialized_file, *symbol_data,
+                                  *symbol_data_size)) {
+      *symbol_file = serialized_file;
+    }
+  }
+  return FOUND;
+}
+
+bool FastSymbolSupplier::SerializeSymbolFile(const string &symbol_file,
+                                             char **serialized_data,
+                                             size_t *serialized_size) {
+  string symbol_data;
+  if (!read_file(symbol_file, &symbol_data))
+    return false;
+
+  ModuleSerializer serializer;
+  unsigned int size = 0;
+  *serialized_data = serializer.SerializeSymbolFileData(symbol_data, &size);
+  if (!*serialized_data) {
+    BPLOG(ERROR) << "Could not serialize symbol file " << symbol_file;
+    return false;
+  }
+  *serialized_size = size;
+  return true;
+}
+
+bool FastSymbolSupplier::WriteSerializedSymbolFile(
+    const string &serialized_file,
+    const char *serialized_data,
+    size_t serialized_size) {
+  // Write to a temporary file and rename it into place, so that a reader
+  // never sees a partially written file.
+#ifdef _WIN32
+  string temp_file = serialized_file + ".tmp";
+  FILE *file = fopen(temp_file.c_str(), "wb");
+#else  // _WIN32
+  string temp_file = serialized_file + ".XXXXXX";
+  int fd = mkstemp(&temp_file[0]);
+  if (fd != -1)
+    fchmod(fd, 0644);
+  FILE *file = fd == -1 ? NULL : fdopen(fd, "wb");
+  if (!file && fd != -1)
+    close(fd);
+#endif  // _WIN32
+  if (!file) {
+    BPLOG(ERROR) << "Could not create a temporary file for " <<
+                    serialized_file;
+    return false;
+  }
+
+  bool ok = fwrite(serialized_data, 1, serialized_size, file) ==
+            serialized_size;
+  ok = fclose(file) == 0 && ok;
+  ok = ok && rename(temp_file.c_str(), serialized_file.c_str()) == 0;
+  if (!ok) {
+    BPLOG(ERROR) << "Could not write " << serialized_file;
+    remove(temp_file.c_str());
+    return false;
+  }
+
+  BPLOG(INFO) << "Wrote serialized symbol file " << serialized_file;
+  return true;
+}
+
+}  // namespace google_breakpad
@@ -0,0 +1,150 @@
+// Copyright (c) 2026 Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// fast_symbol_supplier.h: A SymbolSupplier for FastSourceLineResolver.
+//
+// FastSymbolSupplier looks up symbol files in the same directory layout as
+// SimpleSymbolSupplier, but supplies them in the serialized format that
+// FastSourceLineResolver loads without parsing (see module_serializer.h).
+// Next to each text symbol file, e.g. test_app.sym, it first looks for a
+// serialized sibling with the same base name, e.g. test_app.fast, as written
+// by the sym_to_fast tool, and uses it unless it is older than the text file.
+// Otherwise the text file is parsed and serialized each time it is supplied,
+// and optionally saved as a sibling so that the parse is never repeated.
+
+#ifndef PROCESSOR_FAST_SYMBOL_SUPPLIER_H__
+#define PROCESSOR_FAST_SYMBOL_SUPPLIER_H__
+
+#include <string>
+#include <vector>
+
+#include "common/using_std_string.h"
+#include "processor/simple_symbol_supplier.h"
+
+namespace google_breakpad {
+
+using std::vector;
+
+class FastSymbolSupplier : public SimpleSymbolSupplier {
+ public:
+  // Creates a new FastSymbolSupplier, using path as the root path where
+  // symbols are stored.
+  explicit FastSymbolSupplier(const string &path)
+      : SimpleSymbolSupplier(path), write_serialized_files_(false) {}
+
+  // Creates a new FastSymbolSupplier, using paths as a list of root
+  // paths where symbols may be stored.
+  explicit FastSymbolSupplier(const vector<string> &paths)
+      : SimpleSymbolSupplier(paths), write_serialized_files_(false) {}
+
+  virtual ~FastSymbolSupplier() {}
+
+  // When true, a text symbol file that has to be serialized because it has
+  // no serialized sibling gets one written next to it.  Off by default,
+  // since symbol stores are often read-only.
+  void set_write_serialized_files(bool write_serialized_files) {
+    write_serialized_files_ = write_serialized_files;
+  }
+
+  // Returns the path to the symbol file for the given module, which is the
+  // serialized sibling if there is one and the text file otherwise.
+  using SimpleSymbolSupplier::GetSymbolFile;
+
+  // Places the serialized symbol data for the given module in symbol_data,
+  // serializing the text symbol file if that is all there is.
+  virtual SymbolResult GetSymbolFile(const CodeModule *module,
+                                     const SystemInfo *system_info,
+                                     string *symbol_file,
+                                     string *symbol_data);
+
+  // Same as above, but places the serialized symbol data in the buffer it
+  // was read or serialized into, without a terminating NUL.
+  virtual SymbolResult GetCStringSymbolData(const CodeModule *module,
+                                            const SystemInfo *system_info,
+                                            string *symbol_file,
+                                            char **symbol_data,
+                                            size_t *symbol_data_size);
+
+  // Places the path of the module's serialized symbol file in symbol_file
+  // and returns true if there is one, so that a FastSourceLineResolver can
+  // map it rather than read it.  If there is only the text symbol file, it
+  // is serialized first when set_write_serialized_files is on.
+  virtual bool GetMappableSymbolFile(const CodeModule *module,
+                                     const SystemInfo *system_info,
+                                     string *symbol_file);
+
+  // Returns the path of the serialized sibling of the text symbol file at
+  // |symbol_file|.
+  static string SerializedSymbolFilePath(const string &symbol_file);
+
+  // Parses the text symbol file at |symbol_file| and writes its serialized
+  // form to SerializedSymbolFilePath(symbol_file).  Returns true on success.
+  static bool ConvertSymbolFile(const string &symbol_file);
+
+  // The extensions of text and serialized symbol files.
+  static const char kSymbolFileExtension[];
+  static const char kSerializedSymbolFileExtension[];
+
+ protected:
+  virtual SymbolResult GetSymbolFileAtPathFromRoot(
+      const CodeModule *module,
+      const SystemInfo *system_info,
+      const string &root_path,
+      string *symbol_file);
+
+ private:
+  // Places the serialized symbol data for the given module in a buffer
+  // allocated with new[], which the caller takes ownership of.  If the text
+  // symbol file is serialized and a serialized sibling written for it,
+  // symbol_file is the sibling's path.
+  SymbolResult GetSerializedSymbolData(const CodeModule *module,
+                                       const SystemInfo *system_info,
+                                       string *symbol_file,
+                                       char **symbol_data,
+                                       size_t *symbol_data_size);
+
+  // Parses the text symbol file at |symbol_file| and places its serialized
+  // form in a buffer allocated with new[], which the caller takes ownership
+  // of.  Returns true on success.
+  static bool SerializeSymbolFile(const string &symbol_file,
+                                  char **serialized_data,
+                                  size_t *serialized_size);
+
+  // Writes |serialized_data| to |serialized_file|, replacing any file
+  // already there atomically.  Returns true on success.
+  static bool WriteSerializedSymbolFile(const string &serialized_file,
+                                        const char *serialized_data,
+                                        size_t serialized_size);
+
+  bool write_serialized_files_;
+};
+
+}  // namespace google_breakpad
+
+#endif  // PROCESSOR_FAST_SYMBOL_SUPPLIER_H__
@@ -0,0 +1,320 @@
+// Copyright (c) 2026 Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// fast_symbol_supplier_unittest.cc: Unit tests for FastSymbolSupplier.
+
+#include <stdio.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <utime.h>
+
+#include <string>
+
+#include "breakpad_googletest_includes.h"
+#include "common/tests/auto_tempdir.h"
+#include "common/using_std_string.h"
+#include "google_breakpad/processor/fast_source_line_resolver.h"
+#include "google_breakpad/processor/stack_frame.h"
+#include "google_breakpad/processor/stack_frame_symbolizer.h"
+#include "processor/basic_code_module.h"
+#include "processor/fast_symbol_supplier.h"
+#include "processor/logging.h"
+#include "processor/stackwalker_unittest_utils.h"
+
+namespace {
+
+using google_breakpad::AutoTempDir;
+using google_breakpad::BasicCodeModule;
+using google_breakpad::CodeModule;
+using google_breakpad::FastSourceLineResolver;
+using google_breakpad::FastSymbolSupplier;
+using google_breakpad::SourceLineResolverBase;
+using google_breakpad::StackFrame;
+using google_breakpad::StackFrameSymbolizer;
+using google_breakpad::SymbolSupplier;
+using google_breakpad::SystemInfo;
+
+// A FastSymbolSupplier that counts the symbol data it reads into buffers.
+class CountingFastSymbolSupplier : public FastSymbolSupplier {
+ public:
+  explicit CountingFastSymbolSupplier(const string &path)
+      : FastSymbolSupplier(path), buffers_supplied_(0) {}
+
+  virtual SymbolResult GetCStringSymbolData(const CodeModule *module,
+                                            const SystemInfo *system_info,
+                                            string *symbol_file,
+                                            char **symbol_data,
+                                            size_t *symbol_data_size) {
+    ++buffers_supplied_;
+    return FastSymbolSupplier::GetCStringSymbolData(
+        module, system_info, symbol_file, symbol_data, symbol_data_size);
+  }
+
+  int buffers_supplied_;
+};
+
+class FastSymbolSupplierTest : public ::testing::Test {
+ public:
+  FastSymbolSupplierTest()
+      : module_(0, 0xb000, "module1", "", "module1.pdb", "ABCDEF1", "") {}
+
+  void SetUp() {
+    string testdata_dir = string(getenv("srcdir") ? getenv("srcdir") : ".") +
+                          "/src/processor/testdata";
+
+    // Lay out module1's symbols the way SimpleSymbolSupplier expects.
+    string directory = temp_dir_.path() + "/module1.pdb";
+    ASSERT_EQ(mkdir(directory.c_str(), 0755), 0);
+    directory += "/ABCDEF1";
+    ASSERT_EQ(mkdir(directory.c_str(), 0755), 0);
+    symbol_file_ = directory + "/module1.sym";
+    serialized_file_ = directory + "/module1.fast";
+
+    char* symbol_data;
+    size_t symbol_data_size;
+    ASSERT_TRUE(SourceLineResolverBase::ReadSymbolFile(
+        testdata_dir + "/module1.out", &symbol_data, &symbol_data_size));
+    FILE* file = fopen(symbol_file_.c_str(), "wb");
+    ASSERT_TRUE(file);
+    // ReadSymbolFile appends a terminating NUL that is not part of the file.
+    ASSERT_EQ(fwrite(symbol_data, 1, symbol_data_size - 1, file),
+              symbol_data_size - 1);
+    ASSERT_EQ(fclose(file), 0);
+    delete [] symbol_data;
+  }
+
+  // Loads |symbol_data| as supplied for module_ and checks a lookup in it.
+  void ExpectUsableSymbolData(const string& symbol_data) {
+    FastSourceLineResolver resolver;
+    ASSERT_TRUE(resolver.LoadModuleUsingMapBuffer(&module_, symbol_data));
+    ASSERT_FALSE(resolver.IsModuleCorrupt(&module_));
+
+    StackFrame frame;
+    frame.instruction = 0x1000;
+    frame.module = &module_;
+    resolver.FillSourceLineInfo(&frame);
+    EXPECT_EQ(frame.function_name, "Function1_1");
+    EXPECT_EQ(frame.source_file_name, "file1_1.cc");
+    EXPECT_EQ(frame.source_line, 44);
+  }
+
+  static bool FileExists(const string& path) {
+    struct stat sb;
+    return stat(path.c_str(), &sb) == 0;
+  }
+
+  AutoTempDir temp_dir_;
+  BasicCodeModule module_;
+  string symbol_file_;
+  string serialized_file_;
+};
+
+TEST_F(FastSymbolSupplierTest, SerializedFilePath) {
+  EXPECT_EQ(FastSymbolSupplier::SerializedSymbolFilePath("a/b/c.sym"),
+            "a/b/c.fast");
+  EXPECT_EQ(FastSymbolSupplier::SerializedSymbolFilePath("a/b/c"),
+            "a/b/c.fast");
+}
+
+TEST_F(FastSymbolSupplierTest, FallsBackToTextSymbols) {
+  FastSymbolSupplier supplier(temp_dir_.path());
+  string symbol_file;
+  string symbol_data;
+  ASSERT_EQ(supplier.GetSymbolFile(&module_, NULL, &symbol_file,
+                                   &symbol_data),
+            SymbolSupplier::FOUND);
+  EXPECT_EQ(symbol_file, symbol_file_);
+  ExpectUsableSymbolData(symbol_data);
+
+  // Nothing is written unless asked for.
+  EXPECT_FALSE(FileExists(serialized_file_));
+}
+
+TEST_F(FastSymbolSupplierTest, WritesSerializedSymbols) {
+  FastSymbolSupplier supplier(temp_dir_.path());
+  supplier.set_write_serialized_files(true);
+  string symbol_file;
+  string symbol_data;
+  ASSERT_EQ(supplier.GetSymbolFile(&module_, NULL, &symbol_file,
+                                   &symbol_data),
+            SymbolSupplier::FOUND);
+  EXPECT_EQ(symbol_file, serialized_file_);
+  ASSERT_TRUE(FileExists(serialized_file_));
+
+  // The serialized file is preferred from now on, even without the text.
+  ASSERT_EQ(remove(symbol_file_.c_str()), 0);
+  string serialized_data;
+  ASSERT_EQ(supplier.GetSymbolFile(&module_, NULL, &symbol_file,
+                                   &serialized_data),
+            SymbolSupplier::FOUND);
+  EXPECT_EQ(symbol_file, serialized_file_);
+  EXPECT_EQ(serialized_data, symbol_data);
+  ExpectUsableSymbolData(serialized_data);
+}
+
+TEST_F(FastSymbolSupplierTest, ConvertSymbolFile) {
+  ASSERT_TRUE(FastSymbolSupplier::ConvertSymbolFile(symbol_file_));
+  ASSERT_TRUE(FileExists(serialized_file_));
+
+  FastSymbolSupplier supplier(temp_dir_.path());
+  string symbol_file;
+  ASSERT_EQ(supplier.GetSymbolFile(&module_, NULL, &symbol_file),
+            SymbolSupplier::FOUND);
+  EXPECT_EQ(symbol_file, serialized_file_);
+
+  // The mapped load path accepts the converted file as is.
+  FastSourceLineResolver resolver;
+  ASSERT_TRUE(resolver.LoadModuleUsingMappedFile(&module_, serialized_file_));
+  StackFrame frame;
+  frame.instruction = 0x1000;
+  frame.module = &module_;
+  resolver.FillSourceLineInfo(&frame);
+  EXPECT_EQ(frame.function_name, "Function1_1");
+
+  EXPECT_FALSE(FastSymbolSupplier::ConvertSymbolFile(
+      temp_dir_.path() + "/invalid-filename.sym"));
+}
+
+// StackFrameSymbolizer has the resolver map the serialized file the supplier
+// finds, rather than have the supplier read it into a buffer.
+TEST_F(FastSymbolSupplierTest, SymbolizerMapsSerializedSymbols) {
+  // MockCodeModule names its debug file and identifier after its code file.
+  MockCodeModule module(0, 0xb000, "module1", "");
+  MockCodeModules modules;
+  modules.Add(&module);
+  string directory = temp_dir_.path() + "/module1";
+  ASSERT_EQ(mkdir(directory.c_str(), 0755), 0);
+  directory += "/module1";
+  ASSERT_EQ(mkdir(directory.c_str(), 0755), 0);
+  string symbol_file = directory + "/module1.sym";
+  ASSERT_EQ(rename(symbol_file_.c_str(), symbol_file.c_str()), 0);
+  ASSERT_TRUE(FastSymbolSupplier::ConvertSymbolFile(symbol_file));
+
+  CountingFastSymbolSupplier supplier(temp_dir_.path());
+  string mappable_file;
+  ASSERT_TRUE(supplier.GetMappableSymbolFile(&module, NULL, &mappable_file));
+  EXPECT_EQ(mappable_file, directory + "/module1.fast");
+
+  FastSourceLineResolver resolver;
+  StackFrameSymbolizer symbolizer(&supplier, &resolver);
+  StackFrame frame;
+  frame.instruction = 0x1000;
+  ASSERT_EQ(symbolizer.FillSourceLineInfo(&modules, NULL, NULL, &frame),
+            StackFrameSymbolizer::kNoError);
+  EXPECT_EQ(frame.function_name, "Function1_1");
+  EXPECT_EQ(frame.source_line, 44);
+  EXPECT_EQ(supplier.buffers_supplied_, 0);
+
+  // Without a serialized file, the symbols are read into a buffer, unless
+  // the supplier may write the serialized file first.
+  symbolizer.UnloadModule(&module);
+  ASSERT_EQ(remove(mappable_file.c_str()), 0);
+  EXPECT_FALSE(supplier.GetMappableSymbolFile(&module, NULL, &mappable_file));
+  ASSERT_EQ(symbolizer.FillSourceLineInfo(&modules, NULL, NULL, &frame),
+            StackFrameSymbolizer::kNoError);
+  EXPECT_EQ(frame.function_name, "Function1_1");
+  EXPECT_EQ(supplier.buffers_supplied_, 1);
+
+  symbolizer.UnloadModule(&module);
+  supplier.set_write_serialized_files(true);
+  ASSERT_EQ(symbolizer.FillSourceLineInfo(&modules, NULL, NULL, &frame),
+            StackFrameSymbolizer::kNoError);
+  EXPECT_EQ(frame.function_name, "Function1_1");
+  EXPECT_EQ(supplier.buffers_supplied_, 1);
+  EXPECT_TRUE(FileExists(directory + "/module1.fast"));
+}
+
+TEST_F(FastSymbolSupplierTest, CStringSymbolData) {
+  ASSERT_TRUE(FastSymbolSupplier::ConvertSymbolFile(symbol_file_));
+  string serialized_data;
+  FastSymbolSupplier supplier(temp_dir_.path());
+  string symbol_file;
+  ASSERT_EQ(supplier.GetSymbolFile(&module_, NULL, &symbol_file,
+                                   &serialized_data),
+            SymbolSupplier::FOUND);
+
+  // The buffer holds exactly the serialized data, whether it was read from
+  // the serialized file or serialized from the text file.
+  for (int i = 0; i < 2; ++i) {
+    if (i == 1) {
+      ASSERT_EQ(remove(serialized_file_.c_str()), 0);
+    }
+    char* symbol_data = NULL;
+    size_t symbol_data_size = 0;
+    ASSERT_EQ(supplier.GetCStringSymbolData(&module_, NULL, &symbol_file,
+                                            &symbol_data, &symbol_data_size),
+              SymbolSupplier::FOUND);
+    EXPECT_EQ(symbol_file, i == 0 ? serialized_file_ : symbol_file_);
+    EXPECT_EQ(string(symbol_data, symbol_data_size), serialized_data);
+    supplier.FreeSymbolData(&module_);
+  }
+}
+
+TEST_F(FastSymbolSupplierTest, IgnoresStaleSerializedSymbols) {
+  ASSERT_TRUE(FastSymbolSupplier::ConvertSymbolFile(symbol_file_));
+
+  // Make the serialized file older than the text file, as if the text file
+  // had been replaced since it was converted.
+  struct utimbuf times;
+  times.actime = times.modtime = 1;
+  ASSERT_EQ(utime(serialized_file_.c_str(), &times), 0);
+
+  FastSymbolSupplier supplier(temp_dir_.path());
+  string symbol_file;
+  ASSERT_EQ(supplier.GetSymbolFile(&module_, NULL, &symbol_file),
+            SymbolSupplier::FOUND);
+  EXPECT_EQ(symbol_file, symbol_file_);
+  EXPECT_FALSE(supplier.GetMappableSymbolFile(&module_, NULL, &symbol_file));
+
+  // Once the supplier may write serialized files, it replaces the stale one.
+  supplier.set_write_serialized_files(true);
+  ASSERT_TRUE(supplier.GetMappableSymbolFile(&module_, NULL, &symbol_file));
+  EXPECT_EQ(symbol_file, serialized_file_);
+  ASSERT_EQ(supplier.GetSymbolFile(&module_, NULL, &symbol_file),
+            SymbolSupplier::FOUND);
+  EXPECT_EQ(symbol_file, serialized_file_);
+}
+
+TEST_F(FastSymbolSupplierTest, MissingSymbols) {
+  FastSymbolSupplier supplier(temp_dir_.path());
+  BasicCodeModule other(0, 0xb000, "module2", "", "module2.pdb",
+                        "ABCDEF1", "");
+  string symbol_file;
+  string symbol_data;
+  EXPECT_EQ(supplier.GetSymbolFile(&other, NULL, &symbol_file, &symbol_data),
+            SymbolSupplier::NOT_FOUND);
+  EXPECT_TRUE(symbol_file.empty());
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -186,6 +186,70 @@ char *RangeMapSerializer<Address, Entry>::Serialize(
 }
 
 
+template<typename Address, typename Entry>
+size_t RangeMapSerializer<Address, Entry>::SizeOf(
+    const CompactRangeMap<Address, Entry> &m) const {
+  size_t size = (1 + m.GetCount()) * sizeof(uint32_t);
+  for (int index = 0; index < m.GetCount(); ++index) {
+    Entry entry;
+    Address base, range_size;
+    m.RetrieveRangeAtIndex(index, &entry, &base, NULL, &range_size);
+    size += address_serializer_.SizeOf(base + (range_size - 1));
+    size += address_serializer_.SizeOf(base);
+    size += entry_serializer_.SizeOf(entry);
+  }
+  return size;
+}
+
+template<typename Address, typename Entry>
+char *RangeMapSerializer<Address, Entry>::Write(
+    const CompactRangeMap<Address, Entry> &m, char *dest) const {
+  if (!dest) {
+    BPLOG(ERROR) << "RangeMapSerializer failed: write to NULL address.";
+    return NULL;
+  }
+  char *start_address = dest;
+  uint32_t count = m.GetCount();
+
+  // Same layout as for a RangeMap: the number of nodes, their offsets, the
+  // keys (high addresses), then each node's base and entry.
+  dest = SimpleSerializer<uint32_t>::Write(count, dest);
+  uint32_t *offsets = reinterpret_cast<uint32_t*>(dest);
+  dest += sizeof(uint32_t) * count;
+
+  char *key_address = dest;
+  dest += sizeof(Address) * count;
+
+  for (uint32_t index = 0; index < count; ++index) {
+    Entry entry;
+    Address base, range_size;
+    m.RetrieveRangeAtIndex(index, &entry, &base, NULL, &range_size);
+    offsets[index] = static_cast<uint32_t>(dest - start_address);
+    key_address = address_serializer_.Write(base + (range_size - 1),
+                                            key_address);
+    dest = address_serializer_.Write(base, dest);
+    dest = entry_serializer_.Write(entry, dest);
+  }
+  return dest;
+}
+
+template<typename Address, typename Entry>
+size_t RangeMapSerializer<Address, Entry>::SizeOf(
+    const SelectableRangeMap<Address, Entry> &m) const {
+  if (m.IsCompact())
+    return SizeOf(m.compact_range_map());
+  return SizeOf(m.range_map());
+}
+
+template<typename Address, typename Entry>
+char *RangeMapSerializer<Address, Entry>::Write(
+    const SelectableRangeMap<Address, Entry> &m, char *dest) const {
+  if (m.IsCompact())
+    return Write(m.compact_range_map(), dest);
+  return Write(m.range_map(), dest);
+}
+
+
 template<class AddrType, class EntryType>
 size_t ContainedRangeMapSerializer<AddrType, EntryType>::SizeOf(
     const ContainedRangeMap<AddrType, EntryType> *m) const {
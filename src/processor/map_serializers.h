@@ -28,7 +28,8 @@
 // OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 //
 // map_serializers.h: defines templates for serializing std::map and its
-// wrappers: AddressMap, RangeMap, and ContainedRangeMap.
+// wrappers: AddressMap, RangeMap, and ContainedRangeMap.  CompactRangeMaps
+// serialize exactly as RangeMaps holding the same ranges do.
 //
 // Author: Siyang Xie (lambxsy@google.com)
 
@@ -42,6 +43,7 @@
 #include "processor/simple_serializer.h"
 
 #include "processor/address_map-inl.h"
+#include "processor/compact_range_map-inl.h"
 #include "processor/range_map-inl.h"
 #include "processor/contained_range_map-inl.h"
 
@@ -123,6 +125,12 @@ class RangeMapSerializer {
   // Caller has the ownership of memory allocated as "new char[]".
   char* Serialize(const RangeMap<Address, Entry> &m, unsigned int *size) const;
 
+  // The same, for CompactRangeMaps and SelectableRangeMaps.
+  size_t SizeOf(const CompactRangeMap<Address, Entry> &m) const;
+  char* Write(const CompactRangeMap<Address, Entry> &m, char* dest) const;
+  size_t SizeOf(const SelectableRangeMap<Address, Entry> &m) const;
+  char* Write(const SelectableRangeMap<Address, Entry> &m, char* dest) const;
+
  private:
   // Convenient type name for Range.
   typedef typename RangeMap<Address, Entry>::Range Range;
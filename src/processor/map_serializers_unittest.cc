@@ -268,6 +268,33 @@ TEST_F(TestRangeMapSerializer, MapWithThreeRangesTestCase) {
   EXPECT_EQ(memcmp(correct_data, serialized_data_, correct_size), 0);
 }
 
+// A CompactRangeMap serializes just as a RangeMap with the same ranges.
+TEST_F(TestRangeMapSerializer, CompactMapWithThreeRangesTestCase) {
+  const int32_t correct_data[] = {
+      // # of nodes
+      3,
+      // Offsets
+      28,    36,    44,
+      // Keys: high address
+      5,     9,     20,
+      // Values: (low address, entry) pairs
+      2, 1,  6, 2,  10, 3
+  };
+  uint32_t correct_size = sizeof(correct_data);
+
+  google_breakpad::CompactRangeMap<AddrType, EntryType> compact_map;
+  ASSERT_TRUE(compact_map.StoreRange(10, 11, 3));
+  ASSERT_TRUE(compact_map.StoreRange(2, 4, 1));
+  ASSERT_TRUE(compact_map.StoreRange(6, 4, 2));
+
+  ASSERT_EQ(correct_size, serializer_.SizeOf(compact_map));
+  serialized_data_ = new char[correct_size];
+  char *end = serializer_.Write(compact_map, serialized_data_);
+
+  EXPECT_EQ(correct_size, static_cast<uint32_t>(end - serialized_data_));
+  EXPECT_EQ(memcmp(correct_data, serialized_data_, correct_size), 0);
+}
+
 
 class TestContainedRangeMapSerializer : public ::testing::Test {
  protected:
@@ -44,9 +44,9 @@
 #include "google_breakpad/common/minidump_cpu_arm.h"
 #include "google_breakpad/processor/code_module.h"
 #include "processor/basic_code_module.h"
+#include "processor/compact_range_map-inl.h"
 #include "processor/linked_ptr.h"
 #include "processor/logging.h"
-#include "processor/range_map-inl.h"
 
 namespace {
 static const char kGoogleBreakpadKey[] = "google-breakpad";
@@ -44,6 +44,8 @@
 #ifdef _WIN32
 #include <io.h>
 #else  // _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <unistd.h>
 #endif  // _WIN32
 
@@ -52,6 +54,7 @@
 #include <limits>
 #include <utility>
 
+#include "processor/compact_range_map-inl.h"
 #include "processor/range_map-inl.h"
 
 #include "common/scoped_ptr.h"
@@ -60,6 +63,7 @@
 #include "processor/basic_code_module.h"
 #include "processor/basic_code_modules.h"
 #include "processor/logging.h"
+#include "processor/minidump_page_cache.h"
 
 namespace google_breakpad {
 
@@ -1222,7 +1226,8 @@ uint32_t MinidumpMemoryRegion::max_bytes_ = 64 * 1024 * 1024;  // 64MB
 MinidumpMemoryRegion::MinidumpMemoryRegion(Minidump* minidump)
     : MinidumpObject(minidump),
       descriptor_(NULL),
-      memory_(NULL) {
+      memory_(NULL),
+      mapped_memory_(NULL) {
   hexdump_width_ = minidump_ ? minidump_->HexdumpMode() : 0;
   hexdump_ = hexdump_width_ != 0;
 }
@@ -1248,12 +1253,27 @@ const uint8_t* MinidumpMemoryRegion::GetMemory() const {
     return NULL;
   }
 
+  if (mapped_memory_)
+    return mapped_memory_;
+
   if (!memory_) {
     if (descriptor_->memory.data_size == 0) {
       BPLOG(ERROR) << "MinidumpMemoryRegion is empty";
       return NULL;
     }
 
+    if (minidump_->IsMemoryMapped()) {
+      // The region's bytes are already addressable in the mapping, so there
+      // is nothing to read and max_bytes_ doesn't apply: no memory is
+      // allocated regardless of the region's size.
+      mapped_memory_ = minidump_->GetMappedBytes(descriptor_->memory.rva,
+                                                 descriptor_->memory.data_size);
+      if (!mapped_memory_) {
+        BPLOG(ERROR) << "MinidumpMemoryRegion lies outside the minidump file";
+      }
+      return mapped_memory_;
+    }
+
     if (!minidump_->SeekSet(descriptor_->memory.rva)) {
       BPLOG(ERROR) << "MinidumpMemoryRegion could not seek to memory region";
       return NULL;
@@ -1304,6 +1324,7 @@ uint32_t MinidumpMemoryRegion::GetSize() const {
 void MinidumpMemoryRegion::FreeMemory() {
   delete memory_;
   memory_ = NULL;
+  mapped_memory_ = NULL;
 }
 
 
@@ -1333,16 +1354,30 @@ bool MinidumpMemoryRegion::GetMemoryAtAddressInternal(uint64_t address,
     return false;
   }
 
-  const uint8_t* memory = GetMemory();
-  if (!memory) {
-    // GetMemory already logged a perfectly good message.
-    return false;
-  }
+  uint64_t region_offset = address - descriptor_->start_of_memory_range;
+  if (!memory_ && minidump_->IsMemoryPaged()) {
+    // Copy just the value out of the page cache, without reading the rest
+    // of the region.
+    off_t rva = descriptor_->memory.rva;
+    if (!minidump_->ReadPagedBytes(rva + region_offset,
+                                   rva + descriptor_->memory.data_size,
+                                   value, sizeof(T))) {
+      BPLOG(ERROR) << "MinidumpMemoryRegion could not read paged memory at " <<
+                      HexString(address);
+      *value = 0;
+      return false;
+    }
+  } else {
+    const uint8_t* memory = GetMemory();
+    if (!memory) {
+      // GetMemory already logged a perfectly good message.
+      return false;
+    }
 
-  // If the CPU requires memory accesses to be aligned, this can crash.
-  // x86 and ppc are able to cope, though.
-  *value = *reinterpret_cast<const T*>(
-      &memory[address - descriptor_->start_of_memory_range]);
+    // If the CPU requires memory accesses to be aligned, this can crash.
+    // x86 and ppc are able to cope, though.
+    *value = *reinterpret_cast<const T*>(&memory[region_offset]);
+  }
 
   if (minidump_->swap())
     Swap(value);
@@ -1798,8 +1833,10 @@ MinidumpModule::MinidumpModule(Minidump* minidump)
       module_(),
       name_(NULL),
       cv_record_(NULL),
+      cv_record_data_(NULL),
       cv_record_signature_(MD_CVINFOUNKNOWN_SIGNATURE),
-      misc_record_(NULL) {
+      misc_record_(NULL),
+      misc_record_data_(NULL) {
 }
 
 
@@ -1816,9 +1853,11 @@ bool MinidumpModule::Read() {
   name_ = NULL;
   delete cv_record_;
   cv_record_ = NULL;
+  cv_record_data_ = NULL;
   cv_record_signature_ = MD_CVINFOUNKNOWN_SIGNATURE;
   delete misc_record_;
   misc_record_ = NULL;
+  misc_record_data_ = NULL;
 
   module_valid_ = false;
   has_debug_info_ = false;
@@ -1953,13 +1992,14 @@ string MinidumpModule::code_identifier() const {
     case MD_OS_ANDROID:
     case MD_OS_LINUX: {
       // If ELF CodeView data is present, return the debug id.
-      if (cv_record_ && cv_record_signature_ == MD_CVINFOELF_SIGNATURE) {
+      if (cv_record_data_ && cv_record_signature_ == MD_CVINFOELF_SIGNATURE) {
         const MDCVInfoELF* cv_record_elf =
-            reinterpret_cast<const MDCVInfoELF*>(&(*cv_record_)[0]);
+            reinterpret_cast<const MDCVInfoELF*>(cv_record_data_);
         assert(cv_record_elf->cv_signature == MD_CVINFOELF_SIGNATURE);
 
         for (unsigned int build_id_index = 0;
-             build_id_index < (cv_record_->size() - MDCVInfoELF_minsize);
+             build_id_index < (module_.cv_record.data_size -
+                               MDCVInfoELF_minsize);
              ++build_id_index) {
           char hexbyte[3];
           snprintf(hexbyte, sizeof(hexbyte), "%02x",
@@ -2007,11 +2047,11 @@ string MinidumpModule::debug_file() const {
 
   string file;
   // Prefer the CodeView record if present.
-  if (cv_record_) {
+  if (cv_record_data_) {
     if (cv_record_signature_ == MD_CVINFOPDB70_SIGNATURE) {
       // It's actually an MDCVInfoPDB70 structure.
       const MDCVInfoPDB70* cv_record_70 =
-          reinterpret_cast<const MDCVInfoPDB70*>(&(*cv_record_)[0]);
+          reinterpret_cast<const MDCVInfoPDB70*>(cv_record_data_);
       assert(cv_record_70->cv_signature == MD_CVINFOPDB70_SIGNATURE);
 
       // GetCVRecord guarantees pdb_file_name is null-terminated.
@@ -2019,14 +2059,14 @@ string MinidumpModule::debug_file() const {
     } else if (cv_record_signature_ == MD_CVINFOPDB20_SIGNATURE) {
       // It's actually an MDCVInfoPDB20 structure.
       const MDCVInfoPDB20* cv_record_20 =
-          reinterpret_cast<const MDCVInfoPDB20*>(&(*cv_record_)[0]);
+          reinterpret_cast<const MDCVInfoPDB20*>(cv_record_data_);
       assert(cv_record_20->cv_header.signature == MD_CVINFOPDB20_SIGNATURE);
 
       // GetCVRecord guarantees pdb_file_name is null-terminated.
       file = reinterpret_cast<const char*>(cv_record_20->pdb_file_name);
     } else if (cv_record_signature_ == MD_CVINFOELF_SIGNATURE) {
       // It's actually an MDCVInfoELF structure.
-      assert(reinterpret_cast<const MDCVInfoELF*>(&(*cv_record_)[0])->
+      assert(reinterpret_cast<const MDCVInfoELF*>(cv_record_data_)->
           cv_signature == MD_CVINFOELF_SIGNATURE);
 
       // For MDCVInfoELF, the debug file is the code file.
@@ -2039,9 +2079,8 @@ string MinidumpModule::debug_file() const {
 
   if (file.empty()) {
     // No usable CodeView record.  Try the miscellaneous debug record.
-    if (misc_record_) {
-      const MDImageDebugMisc* misc_record =
-          reinterpret_cast<const MDImageDebugMisc *>(&(*misc_record_)[0]);
+    if (misc_record_data_) {
+      const MDImageDebugMisc* misc_record = misc_record_data_;
       if (!misc_record->unicode) {
         // If it's not Unicode, just stuff it into the string.  It's unclear
         // if misc_record->data is 0-terminated, so use an explicit size.
@@ -2130,11 +2169,11 @@ string MinidumpModule::debug_identifier() const {
   string identifier;
 
   // Use the CodeView record if present.
-  if (cv_record_) {
+  if (cv_record_data_) {
     if (cv_record_signature_ == MD_CVINFOPDB70_SIGNATURE) {
       // It's actually an MDCVInfoPDB70 structure.
       const MDCVInfoPDB70* cv_record_70 =
-          reinterpret_cast<const MDCVInfoPDB70*>(&(*cv_record_)[0]);
+          reinterpret_cast<const MDCVInfoPDB70*>(cv_record_data_);
       assert(cv_record_70->cv_signature == MD_CVINFOPDB70_SIGNATURE);
 
       // Use the same format that the MS symbol server uses in filesystem
@@ -2144,7 +2183,7 @@ string MinidumpModule::debug_identifier() const {
     } else if (cv_record_signature_ == MD_CVINFOPDB20_SIGNATURE) {
       // It's actually an MDCVInfoPDB20 structure.
       const MDCVInfoPDB20* cv_record_20 =
-          reinterpret_cast<const MDCVInfoPDB20*>(&(*cv_record_)[0]);
+          reinterpret_cast<const MDCVInfoPDB20*>(cv_record_data_);
       assert(cv_record_20->cv_header.signature == MD_CVINFOPDB20_SIGNATURE);
 
       // Use the same format that the MS symbol server uses in filesystem
@@ -2156,7 +2195,7 @@ string MinidumpModule::debug_identifier() const {
     } else if (cv_record_signature_ == MD_CVINFOELF_SIGNATURE) {
       // It's actually an MDCVInfoELF structure.
       const MDCVInfoELF* cv_record_elf =
-          reinterpret_cast<const MDCVInfoELF*>(&(*cv_record_)[0]);
+          reinterpret_cast<const MDCVInfoELF*>(cv_record_data_);
       assert(cv_record_elf->cv_signature == MD_CVINFOELF_SIGNATURE);
 
       // For backwards-compatibility, stuff as many bytes as will fit into
@@ -2166,7 +2205,7 @@ string MinidumpModule::debug_identifier() const {
       // The full build id is available by calling code_identifier.
       MDGUID guid = {0};
       memcpy(&guid, &cv_record_elf->build_id,
-             std::min(cv_record_->size() - MDCVInfoELF_minsize,
+             std::min(module_.cv_record.data_size - MDCVInfoELF_minsize,
                       sizeof(MDGUID)));
       identifier = guid_and_age_to_debug_id(guid, 0);
     }
@@ -2276,18 +2315,13 @@ const uint8_t* MinidumpModule::GetCVRecord(uint32_t* size) {
     return NULL;
   }
 
-  if (!cv_record_) {
+  if (!cv_record_data_) {
     // This just guards against 0-sized CodeView records; more specific checks
     // are used when the signature is checked against various structure types.
     if (module_.cv_record.data_size == 0) {
       return NULL;
     }
 
-    if (!minidump_->SeekSet(module_.cv_record.rva)) {
-      BPLOG(ERROR) << "MinidumpModule could not seek to CodeView record";
-      return NULL;
-    }
-
     if (module_.cv_record.data_size > max_cv_bytes_) {
       BPLOG(ERROR) << "MinidumpModule CodeView record size " <<
                       module_.cv_record.data_size << " exceeds maximum " <<
@@ -2295,25 +2329,47 @@ const uint8_t* MinidumpModule::GetCVRecord(uint32_t* size) {
       return NULL;
     }
 
-    // Allocating something that will be accessed as MDCVInfoPDB70 or
-    // MDCVInfoPDB20 but is allocated as uint8_t[] can cause alignment
-    // problems.  x86 and ppc are able to cope, though.  This allocation
-    // style is needed because the MDCVInfoPDB70 or MDCVInfoPDB20 are
-    // variable-sized due to their pdb_file_name fields; these structures
-    // are not MDCVInfoPDB70_minsize or MDCVInfoPDB20_minsize and treating
-    // them as such would result in incomplete structures or overruns.
-    scoped_ptr< vector<uint8_t> > cv_record(
-        new vector<uint8_t>(module_.cv_record.data_size));
-
-    if (!minidump_->ReadBytes(&(*cv_record)[0], module_.cv_record.data_size)) {
-      BPLOG(ERROR) << "MinidumpModule could not read CodeView record";
-      return NULL;
+    scoped_ptr< vector<uint8_t> > cv_record;
+    const uint8_t* cv_record_data;
+    if (minidump_->IsMemoryMapped() && !minidump_->swap() &&
+        module_.cv_record.rva % sizeof(uint32_t) == 0) {
+      // The record can be used as it lies in the mapping: nothing in it
+      // needs swapping, and the mapping is page-aligned, so the record's
+      // fields are as aligned as its rva.
+      cv_record_data = minidump_->GetMappedBytes(module_.cv_record.rva,
+                                                 module_.cv_record.data_size);
+      if (!cv_record_data) {
+        BPLOG(ERROR) << "MinidumpModule CodeView record lies outside the "
+                        "minidump file";
+        return NULL;
+      }
+    } else {
+      if (!minidump_->SeekSet(module_.cv_record.rva)) {
+        BPLOG(ERROR) << "MinidumpModule could not seek to CodeView record";
+        return NULL;
+      }
+
+      // Allocating something that will be accessed as MDCVInfoPDB70 or
+      // MDCVInfoPDB20 but is allocated as uint8_t[] can cause alignment
+      // problems.  x86 and ppc are able to cope, though.  This allocation
+      // style is needed because the MDCVInfoPDB70 or MDCVInfoPDB20 are
+      // variable-sized due to their pdb_file_name fields; these structures
+      // are not MDCVInfoPDB70_minsize or MDCVInfoPDB20_minsize and treating
+      // them as such would result in incomplete structures or overruns.
+      cv_record.reset(new vector<uint8_t>(module_.cv_record.data_size));
+
+      if (!minidump_->ReadBytes(&(*cv_record)[0],
+                                module_.cv_record.data_size)) {
+        BPLOG(ERROR) << "MinidumpModule could not read CodeView record";
+        return NULL;
+      }
+      cv_record_data = &(*cv_record)[0];
     }
 
     uint32_t signature = MD_CVINFOUNKNOWN_SIGNATURE;
     if (module_.cv_record.data_size > sizeof(signature)) {
-      MDCVInfoPDB70* cv_record_signature =
-          reinterpret_cast<MDCVInfoPDB70*>(&(*cv_record)[0]);
+      const MDCVInfoPDB70* cv_record_signature =
+          reinterpret_cast<const MDCVInfoPDB70*>(cv_record_data);
       signature = cv_record_signature->cv_signature;
       if (minidump_->swap())
         Swap(&signature);
@@ -2330,6 +2386,7 @@ const uint8_t* MinidumpModule::GetCVRecord(uint32_t* size) {
       }
 
       if (minidump_->swap()) {
+        // Swapped records are always copied, so cv_record is present.
         MDCVInfoPDB70* cv_record_70 =
             reinterpret_cast<MDCVInfoPDB70*>(&(*cv_record)[0]);
         Swap(&cv_record_70->cv_signature);
@@ -2341,7 +2398,7 @@ const uint8_t* MinidumpModule::GetCVRecord(uint32_t* size) {
 
       // The last field of either structure is null-terminated 8-bit character
       // data.  Ensure that it's null-terminated.
-      if ((*cv_record)[module_.cv_record.data_size - 1] != '\0') {
+      if (cv_record_data[module_.cv_record.data_size - 1] != '\0') {
         BPLOG(ERROR) << "MinidumpModule CodeView7 record string is not "
                         "0-terminated";
         return NULL;
@@ -2356,6 +2413,7 @@ const uint8_t* MinidumpModule::GetCVRecord(uint32_t* size) {
         return NULL;
       }
       if (minidump_->swap()) {
+        // Swapped records are always copied, so cv_record is present.
         MDCVInfoPDB20* cv_record_20 =
             reinterpret_cast<MDCVInfoPDB20*>(&(*cv_record)[0]);
         Swap(&cv_record_20->cv_header.signature);
@@ -2368,7 +2426,7 @@ const uint8_t* MinidumpModule::GetCVRecord(uint32_t* size) {
 
       // The last field of either structure is null-terminated 8-bit character
       // data.  Ensure that it's null-terminated.
-      if ((*cv_record)[module_.cv_record.data_size - 1] != '\0') {
+      if (cv_record_data[module_.cv_record.data_size - 1] != '\0') {
         BPLOG(ERROR) << "MindumpModule CodeView2 record string is not "
                         "0-terminated";
         return NULL;
@@ -2393,13 +2451,14 @@ const uint8_t* MinidumpModule::GetCVRecord(uint32_t* size) {
     // Store the vector type because that's how storage was allocated, but
     // return it casted to uint8_t*.
     cv_record_ = cv_record.release();
+    cv_record_data_ = cv_record_data;
     cv_record_signature_ = signature;
   }
 
   if (size)
     *size = module_.cv_record.data_size;
 
-  return &(*cv_record_)[0];
+  return cv_record_data_;
 }
 
 
@@ -2409,7 +2468,7 @@ const MDImageDebugMisc* MinidumpModule::GetMiscRecord(uint32_t* size) {
     return NULL;
   }
 
-  if (!misc_record_) {
+  if (!misc_record_data_) {
     if (module_.misc_record.data_size == 0) {
       return NULL;
     }
@@ -2421,12 +2480,6 @@ const MDImageDebugMisc* MinidumpModule::GetMiscRecord(uint32_t* size) {
       return NULL;
     }
 
-    if (!minidump_->SeekSet(module_.misc_record.rva)) {
-      BPLOG(ERROR) << "MinidumpModule could not seek to miscellaneous "
-                      "debugging record";
-      return NULL;
-    }
-
     if (module_.misc_record.data_size > max_misc_bytes_) {
       BPLOG(ERROR) << "MinidumpModule miscellaneous debugging record size " <<
                       module_.misc_record.data_size << " exceeds maximum " <<
@@ -2434,24 +2487,49 @@ const MDImageDebugMisc* MinidumpModule::GetMiscRecord(uint32_t* size) {
       return NULL;
     }
 
-    // Allocating something that will be accessed as MDImageDebugMisc but
-    // is allocated as uint8_t[] can cause alignment problems.  x86 and
-    // ppc are able to cope, though.  This allocation style is needed
-    // because the MDImageDebugMisc is variable-sized due to its data field;
-    // this structure is not MDImageDebugMisc_minsize and treating it as such
-    // would result in an incomplete structure or an overrun.
-    scoped_ptr< vector<uint8_t> > misc_record_mem(
-        new vector<uint8_t>(module_.misc_record.data_size));
-    MDImageDebugMisc* misc_record =
-        reinterpret_cast<MDImageDebugMisc*>(&(*misc_record_mem)[0]);
-
-    if (!minidump_->ReadBytes(misc_record, module_.misc_record.data_size)) {
-      BPLOG(ERROR) << "MinidumpModule could not read miscellaneous debugging "
-                      "record";
-      return NULL;
+    scoped_ptr< vector<uint8_t> > misc_record_mem;
+    const MDImageDebugMisc* misc_record_data;
+    if (minidump_->IsMemoryMapped() && !minidump_->swap() &&
+        module_.misc_record.rva % sizeof(uint32_t) == 0) {
+      // As with the CodeView record, use the record in place.
+      misc_record_data = reinterpret_cast<const MDImageDebugMisc*>(
+          minidump_->GetMappedBytes(module_.misc_record.rva,
+                                    module_.misc_record.data_size));
+      if (!misc_record_data) {
+        BPLOG(ERROR) << "MinidumpModule miscellaneous debugging record lies "
+                        "outside the minidump file";
+        return NULL;
+      }
+    } else {
+      if (!minidump_->SeekSet(module_.misc_record.rva)) {
+        BPLOG(ERROR) << "MinidumpModule could not seek to miscellaneous "
+                        "debugging record";
+        return NULL;
+      }
+
+      // Allocating something that will be accessed as MDImageDebugMisc but
+      // is allocated as uint8_t[] can cause alignment problems.  x86 and
+      // ppc are able to cope, though.  This allocation style is needed
+      // because the MDImageDebugMisc is variable-sized due to its data
+      // field; this structure is not MDImageDebugMisc_minsize and treating
+      // it as such would result in an incomplete structure or an overrun.
+      misc_record_mem.reset(
+          new vector<uint8_t>(module_.misc_record.data_size));
+      misc_record_data =
+          reinterpret_cast<MDImageDebugMisc*>(&(*misc_record_mem)[0]);
+
+      if (!minidump_->ReadBytes(&(*misc_record_mem)[0],
+                                module_.misc_record.data_size)) {
+        BPLOG(ERROR) << "MinidumpModule could not read miscellaneous "
+                        "debugging record";
+        return NULL;
+      }
     }
 
     if (minidump_->swap()) {
+      // Swapped records are always copied, so misc_record_mem is present.
+      MDImageDebugMisc* misc_record =
+          reinterpret_cast<MDImageDebugMisc*>(&(*misc_record_mem)[0]);
       Swap(&misc_record->data_type);
       Swap(&misc_record->length);
       // Don't swap misc_record.unicode because it's an 8-bit quantity.
@@ -2467,22 +2545,23 @@ const MDImageDebugMisc* MinidumpModule::GetMiscRecord(uint32_t* size) {
       }
     }
 
-    if (module_.misc_record.data_size != misc_record->length) {
+    if (module_.misc_record.data_size != misc_record_data->length) {
       BPLOG(ERROR) << "MinidumpModule miscellaneous debugging record data "
                       "size mismatch, " << module_.misc_record.data_size <<
-                      " != " << misc_record->length;
+                      " != " << misc_record_data->length;
       return NULL;
     }
 
     // Store the vector type because that's how storage was allocated, but
     // return it casted to MDImageDebugMisc*.
     misc_record_ = misc_record_mem.release();
+    misc_record_data_ = misc_record_data;
   }
 
   if (size)
     *size = module_.misc_record.data_size;
 
-  return reinterpret_cast<MDImageDebugMisc*>(&(*misc_record_)[0]);
+  return misc_record_data_;
 }
 
 
@@ -2642,7 +2721,8 @@ uint32_t MinidumpModuleList::max_modules_ = 2048;
 
 MinidumpModuleList::MinidumpModuleList(Minidump* minidump)
     : MinidumpStream(minidump),
-      range_map_(new RangeMap<uint64_t, unsigned int>()),
+      range_map_(new CompactRangeMap<uint64_t, unsigned int>()),
+      last_hit_index_(-1),
       modules_(NULL),
       module_count_(0) {
   range_map_->SetEnableShrinkDown(minidump_->IsAndroid());
@@ -2658,6 +2738,7 @@ MinidumpModuleList::~MinidumpModuleList() {
 bool MinidumpModuleList::Read(uint32_t expected_size) {
   // Invalidate cached data.
   range_map_->Clear();
+  last_hit_index_ = -1;
   delete modules_;
   modules_ = NULL;
   module_count_ = 0;
@@ -2803,6 +2884,7 @@ bool MinidumpModuleList::Read(uint32_t expected_size) {
       last_end_address = base_address + module_size;
     }
 
+    range_map_->ShrinkToFit();
     modules_ = modules.release();
   }
 
@@ -2820,15 +2902,18 @@ const MinidumpModule* MinidumpModuleList::GetModuleForAddress(
     return NULL;
   }
 
-  unsigned int module_index;
-  if (!range_map_->RetrieveRange(address, &module_index, NULL /* base */,
-                                 NULL /* delta */, NULL /* size */)) {
-    BPLOG(INFO) << "MinidumpModuleList has no module at " <<
-                   HexString(address);
-    return NULL;
+  int index = last_hit_index_.load(std::memory_order_relaxed);
+  if (!range_map_->RangeAtIndexContains(index, address)) {
+    index = range_map_->FindRangeIndex(address);
+    if (index < 0) {
+      BPLOG(INFO) << "MinidumpModuleList has no module at " <<
+                     HexString(address);
+      return NULL;
+    }
+    last_hit_index_.store(index, std::memory_order_relaxed);
   }
 
-  return GetModuleAtIndex(module_index);
+  return GetModuleAtIndex(range_map_->EntryAtIndex(index));
 }
 
 
@@ -4762,14 +4847,26 @@ bool MinidumpLinuxMapsList::Read(uint32_t expected_size) {
     return false;
   }
 
-  // Create a vector to read stream data. The vector needs to have
-  // at least enough capacity to read all the data.
-  vector<char> mapping_bytes(length);
-  if (!minidump_->ReadBytes(&mapping_bytes[0], length)) {
-    BPLOG(ERROR) << "MinidumpLinuxMapsList failed to read bytes";
-    return false;
+  string map_string;
+  if (minidump_->IsMemoryMapped()) {
+    // Parse the text straight out of the mapping.
+    const uint8_t* mapping_bytes =
+        minidump_->GetMappedBytes(minidump_->Tell(), length);
+    if (!mapping_bytes) {
+      BPLOG(ERROR) << "MinidumpLinuxMapsList failed to read bytes";
+      return false;
+    }
+    map_string.assign(reinterpret_cast<const char*>(mapping_bytes), length);
+  } else {
+    // Create a vector to read stream data. The vector needs to have
+    // at least enough capacity to read all the data.
+    vector<char> mapping_bytes(length);
+    if (!minidump_->ReadBytes(&mapping_bytes[0], length)) {
+      BPLOG(ERROR) << "MinidumpLinuxMapsList failed to read bytes";
+      return false;
+    }
+    map_string.assign(mapping_bytes.begin(), mapping_bytes.end());
   }
-  string map_string(mapping_bytes.begin(), mapping_bytes.end());
   vector<MappedMemoryRegion> all_regions;
 
   // Parse string into mapping data.
@@ -5005,6 +5102,11 @@ Minidump::Minidump(const string& path, bool hexdump, unsigned int hexdump_width)
       stream_map_(new MinidumpStreamMap()),
       path_(path),
       stream_(NULL),
+      use_memory_mapping_(false),
+      mapped_data_(NULL),
+      mapped_size_(0),
+      mapped_position_(0),
+      page_cache_(NULL),
       swap_(false),
       valid_(false),
       hexdump_(hexdump),
@@ -5017,6 +5119,11 @@ Minidump::Minidump(istream& stream)
       stream_map_(new MinidumpStreamMap()),
       path_(),
       stream_(&stream),
+      use_memory_mapping_(false),
+      mapped_data_(NULL),
+      mapped_size_(0),
+      mapped_position_(0),
+      page_cache_(NULL),
       swap_(false),
       valid_(false),
       hexdump_(false),
@@ -5024,19 +5131,22 @@ Minidump::Minidump(istream& stream)
 }
 
 Minidump::~Minidump() {
-  if (stream_) {
+  if (stream_ || mapped_data_) {
     BPLOG(INFO) << "Minidump closing minidump";
   }
   if (!path_.empty()) {
     delete stream_;
   }
+  // Streams may hold pointers into the mapping, so release them first.
   delete directory_;
   delete stream_map_;
+  delete page_cache_;
+  UnmapFile();
 }
 
 
 bool Minidump::Open() {
-  if (stream_ != NULL) {
+  if (stream_ != NULL || mapped_data_ != NULL) {
     BPLOG(INFO) << "Minidump reopening minidump " << path_;
 
     // The file is already open.  Seek to the beginning, which is the position
@@ -5044,6 +5154,23 @@ bool Minidump::Open() {
     return SeekSet(0);
   }
 
+  if (use_memory_mapping_ && !path_.empty()) {
+    if (MapFile()) {
+      BPLOG(INFO) << "Minidump mapped minidump " << path_;
+      // The mapping is paged in on demand already; a page cache would
+      // only copy it.
+      if (page_cache_) {
+        BPLOG(INFO) << "Minidump not using its page cache for mapped "
+                       "minidump " << path_;
+        delete page_cache_;
+        page_cache_ = NULL;
+      }
+      return true;
+    }
+    BPLOG(INFO) << "Minidump could not map minidump " << path_ <<
+                   ", reading it as a stream";
+  }
+
   stream_ = new ifstream(path_.c_str(), std::ios::in | std::ios::binary);
   if (!stream_ || !stream_->good()) {
     string error_string;
@@ -5057,6 +5184,58 @@ bool Minidump::Open() {
   return true;
 }
 
+bool Minidump::MapFile() {
+#ifdef _WIN32
+  return false;
+#else  // _WIN32
+  int fd = open(path_.c_str(), O_RDONLY);
+  if (fd == -1) {
+    string error_string;
+    int error_code = ErrnoString(&error_string);
+    BPLOG(ERROR) << "Minidump could not open minidump " << path_ <<
+                    ", error " << error_code << ": " << error_string;
+    return false;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size <= 0 ||
+      static_cast<uint64_t>(st.st_size) > numeric_limits<size_t>::max()) {
+    close(fd);
+    return false;
+  }
+
+  size_t size = static_cast<size_t>(st.st_size);
+  void* data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  // The mapping holds its own reference to the file.
+  close(fd);
+  if (data == MAP_FAILED) {
+    string error_string;
+    int error_code = ErrnoString(&error_string);
+    BPLOG(ERROR) << "Minidump could not map minidump " << path_ <<
+                    ", error " << error_code << ": " << error_string;
+    return false;
+  }
+
+  mapped_data_ = static_cast<const uint8_t*>(data);
+  mapped_size_ = size;
+  mapped_position_ = 0;
+  return true;
+#endif  // _WIN32
+}
+
+
+void Minidump::UnmapFile() {
+#ifndef _WIN32
+  if (mapped_data_) {
+    munmap(const_cast<uint8_t*>(mapped_data_), mapped_size_);
+  }
+#endif  // _WIN32
+  mapped_data_ = NULL;
+  mapped_size_ = 0;
+  mapped_position_ = 0;
+}
+
+
 bool Minidump::GetContextCPUFlagsFromSystemInfo(uint32_t *context_cpu_flags) {
   // Initialize output parameters
   *context_cpu_flags = 0;
@@ -5495,6 +5674,17 @@ const MDRawDirectory* Minidump::GetDirectoryEntryAtIndex(unsigned int index)
 bool Minidump::ReadBytes(void* bytes, size_t count) {
   // Can't check valid_ because Read needs to call this method before
   // validity can be determined.
+  if (mapped_data_) {
+    if (count > mapped_size_ - mapped_position_) {
+      BPLOG(ERROR) << "ReadBytes: read " << mapped_size_ - mapped_position_ <<
+                      "/" << count;
+      mapped_position_ = mapped_size_;
+      return false;
+    }
+    memcpy(bytes, mapped_data_ + mapped_position_, count);
+    mapped_position_ += count;
+    return true;
+  }
   if (!stream_) {
     return false;
   }
@@ -5527,6 +5717,16 @@ bool Minidump::ReadBytes(void* bytes, size_t count) {
 bool Minidump::SeekSet(off_t offset) {
   // Can't check valid_ because Read needs to call this method before
   // validity can be determined.
+  if (mapped_data_) {
+    // Like an istream, allow seeking to the end of the file but not past it.
+    if (offset < 0 || static_cast<uint64_t>(offset) > mapped_size_) {
+      BPLOG(ERROR) << "SeekSet: offset " << offset << " outside of " <<
+                      mapped_size_ << "-byte minidump";
+      return false;
+    }
+    mapped_position_ = static_cast<size_t>(offset);
+    return true;
+  }
   if (!stream_) {
     return false;
   }
@@ -5541,6 +5741,9 @@ bool Minidump::SeekSet(off_t offset) {
 }
 
 off_t Minidump::Tell() {
+  if (valid_ && mapped_data_) {
+    return static_cast<off_t>(mapped_position_);
+  }
   if (!valid_ || !stream_) {
     return (off_t)-1;
   }
@@ -5557,6 +5760,44 @@ off_t Minidump::Tell() {
 }
 
 
+const uint8_t* Minidump::GetMappedBytes(off_t offset, size_t count) const {
+  if (!mapped_data_ || offset < 0 ||
+      static_cast<uint64_t>(offset) > mapped_size_ ||
+      count > mapped_size_ - static_cast<size_t>(offset)) {
+    return NULL;
+  }
+  return mapped_data_ + offset;
+}
+
+
+void Minidump::set_memory_page_cache(uint32_t page_size, size_t max_pages) {
+  delete page_cache_;
+  page_cache_ = NULL;
+  if (max_pages == 0) {
+    return;
+  }
+  if (page_size == 0) {
+    BPLOG(ERROR) << "Minidump memory page size must not be 0";
+    return;
+  }
+  if (mapped_data_) {
+    BPLOG(INFO) << "Minidump not using a page cache for mapped minidump " <<
+                   path_;
+    return;
+  }
+  page_cache_ = new MinidumpPageCache(this, page_size, max_pages);
+}
+
+
+bool Minidump::ReadPagedBytes(off_t offset, off_t limit,
+                              void* bytes, size_t count) {
+  if (!IsMemoryPaged() || offset < 0 || limit < offset) {
+    return false;
+  }
+  return page_cache_->Read(offset, limit, bytes, count);
+}
+
+
 string* Minidump::ReadString(off_t offset) {
   if (!valid_) {
     BPLOG(ERROR) << "Invalid Minidump for ReadString";
@@ -0,0 +1,139 @@
+// Copyright (c) 2026 Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// minidump_page_cache.cc: A bounded cache of fixed-size pages of a minidump
+// file.
+//
+// See minidump_page_cache.h for documentation.
+
+#include "processor/minidump_page_cache.h"
+
+#include <assert.h>
+#include <string.h>
+
+#include <algorithm>
+
+#include "google_breakpad/processor/minidump.h"
+#include "processor/logging.h"
+
+namespace google_breakpad {
+
+MinidumpPageCache::MinidumpPageCache(Minidump* minidump,
+                                     uint32_t page_size,
+                                     size_t max_pages)
+    : minidump_(minidump),
+      page_size_(page_size),
+      max_pages_(max_pages),
+      pages_(),
+      page_index_(),
+      page_reads_(0) {
+  assert(page_size_ != 0);
+  assert(max_pages_ != 0);
+}
+
+bool MinidumpPageCache::Read(uint64_t offset, uint64_t limit,
+                             void* bytes, size_t count) {
+  if (count > limit || offset > limit - count) {
+    BPLOG(ERROR) << "MinidumpPageCache read " << offset << "+" << count <<
+                    " extends past " << limit;
+    return false;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  uint8_t* destination = static_cast<uint8_t*>(bytes);
+  while (count > 0) {
+    uint64_t index = offset / page_size_;
+    uint64_t page_start = index * page_size_;
+    size_t size = static_cast<size_t>(
+        std::min<uint64_t>(page_size_, limit - page_start));
+    const Page* page = GetPage(index, size);
+    if (!page) {
+      return false;
+    }
+
+    size_t page_offset = static_cast<size_t>(offset - page_start);
+    size_t chunk = std::min(count, size - page_offset);
+    memcpy(destination, &page->data[page_offset], chunk);
+    destination += chunk;
+    offset += chunk;
+    count -= chunk;
+  }
+  return true;
+}
+
+size_t MinidumpPageCache::cached_pages() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return pages_.size();
+}
+
+uint64_t MinidumpPageCache::page_reads() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return page_reads_;
+}
+
+const MinidumpPageCache::Page* MinidumpPageCache::GetPage(uint64_t index,
+                                                          size_t size) {
+  PageList::iterator page;
+  std::map<uint64_t, PageList::iterator>::iterator found =
+      page_index_.find(index);
+  if (found != page_index_.end()) {
+    page = found->second;
+    pages_.splice(pages_.begin(), pages_, page);
+    if (page->data.size() >= size) {
+      return &*page;
+    }
+    // The page was read for data ending earlier in it; read it again
+    // further.
+  } else if (pages_.size() < max_pages_) {
+    pages_.push_front(Page());
+    page = pages_.begin();
+    page->index = index;
+    page_index_[index] = page;
+  } else {
+    // Reuse the least recently used page, and its buffer.
+    page = --pages_.end();
+    page_index_.erase(page->index);
+    pages_.splice(pages_.begin(), pages_, page);
+    page->index = index;
+    page_index_[index] = page;
+  }
+
+  page->data.resize(size);
+  ++page_reads_;
+  if (!minidump_->SeekSet(index * page_size_) ||
+      !minidump_->ReadBytes(&page->data[0], size)) {
+    BPLOG(ERROR) << "MinidumpPageCache could not read page " << index;
+    page_index_.erase(index);
+    pages_.erase(page);
+    return NULL;
+  }
+  return &*page;
+}
+
+}  // namespace google_breakpad
@@ -0,0 +1,115 @@
+// Copyright (c) 2026 Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// minidump_page_cache.h: A bounded cache of fixed-size pages of a minidump
+// file, shared by the minidump's memory regions.
+//
+// Regions read through the cache copy out only the bytes they're asked
+// for, a page at a time, rather than reading the whole region into the
+// heap on first access.  At most max_pages pages are held; once full, the
+// least recently used page is reused for the next page read.  Pages are
+// aligned to the file, so regions that share bytes of the file, like a
+// thread's stack and the same memory in the memory list, share pages.
+
+#ifndef PROCESSOR_MINIDUMP_PAGE_CACHE_H__
+#define PROCESSOR_MINIDUMP_PAGE_CACHE_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <list>
+#include <map>
+#include <mutex>
+#include <vector>
+
+#include "common/basictypes.h"
+
+namespace google_breakpad {
+
+class Minidump;
+
+class MinidumpPageCache {
+ public:
+  // The page size used when none is given.
+  static const uint32_t kDefaultPageSize = 64 * 1024;
+
+  // Reads pages of |minidump|, which must outlive the cache.  page_size
+  // and max_pages must not be 0.
+  MinidumpPageCache(Minidump* minidump, uint32_t page_size, size_t max_pages);
+
+  uint32_t page_size() const { return page_size_; }
+  size_t max_pages() const { return max_pages_; }
+
+  // Copies the count bytes at offset in the minidump file into bytes.
+  // limit is the offset at which the data containing them ends in the
+  // file, such as the end of a memory region: pages are read no further
+  // than that, so a read never runs past the data it was asked about.
+  // Returns false if the bytes couldn't be read.  This may be called from
+  // several threads at once, as long as the minidump isn't otherwise being
+  // read meanwhile.
+  bool Read(uint64_t offset, uint64_t limit, void* bytes, size_t count);
+
+  // The number of pages currently held, and the number of times a page
+  // has been read from the file.
+  size_t cached_pages() const;
+  uint64_t page_reads() const;
+
+ private:
+  struct Page {
+    uint64_t index;
+    // The page's bytes, from the start of the page up to the end of the
+    // file or of the data it was read for, whichever is first.
+    std::vector<uint8_t> data;
+  };
+
+  // Most recently used first.
+  typedef std::list<Page> PageList;
+
+  // Returns the page at index with at least its first size bytes read,
+  // reading it or reusing the least recently used page if needed, and
+  // marks it most recently used.  Returns NULL if it couldn't be read.
+  // mutex_ must be held.
+  const Page* GetPage(uint64_t index, size_t size);
+
+  Minidump* minidump_;
+  const uint32_t page_size_;
+  const size_t max_pages_;
+
+  PageList pages_;
+  std::map<uint64_t, PageList::iterator> page_index_;
+  uint64_t page_reads_;
+
+  mutable std::mutex mutex_;
+
+  DISALLOW_COPY_AND_ASSIGN(MinidumpPageCache);
+};
+
+}  // namespace google_breakpad
+
+#endif  // PROCESSOR_MINIDUMP_PAGE_CACHE_H__
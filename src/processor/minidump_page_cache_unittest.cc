@@ -0,0 +1,145 @@
+// Copyright (c) 2026 Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// minidump_page_cache_unittest.cc: Unit tests for MinidumpPageCache.
+
+#include <stdint.h>
+#include <string.h>
+
+#include <sstream>
+#include <string>
+
+#include "breakpad_googletest_includes.h"
+#include "common/using_std_string.h"
+#include "google_breakpad/processor/minidump.h"
+#include "processor/minidump_page_cache.h"
+
+namespace {
+
+using google_breakpad::Minidump;
+using google_breakpad::MinidumpPageCache;
+using std::istringstream;
+
+const size_t kFileSize = 1000;
+
+class MinidumpPageCacheTest : public ::testing::Test {
+ public:
+  MinidumpPageCacheTest()
+      : contents_(Contents()), stream_(contents_), minidump_(stream_) {}
+
+  static string Contents() {
+    string contents(kFileSize, '\0');
+    for (size_t i = 0; i < kFileSize; ++i)
+      contents[i] = static_cast<char>(i * 7);
+    return contents;
+  }
+
+  // Reads count bytes at offset through cache, and checks them against the
+  // file's contents.
+  void ExpectRead(MinidumpPageCache* cache, uint64_t offset, uint64_t limit,
+                  size_t count) {
+    char bytes[64];
+    ASSERT_LE(count, sizeof(bytes));
+    ASSERT_TRUE(cache->Read(offset, limit, bytes, count));
+    EXPECT_EQ(0, memcmp(contents_.data() + offset, bytes, count));
+  }
+
+  string contents_;
+  istringstream stream_;
+  Minidump minidump_;
+};
+
+TEST_F(MinidumpPageCacheTest, ReadsAcrossPages) {
+  MinidumpPageCache cache(&minidump_, 64, 4);
+  EXPECT_EQ(64U, cache.page_size());
+  EXPECT_EQ(4U, cache.max_pages());
+
+  ExpectRead(&cache, 60, kFileSize, 10);
+  EXPECT_EQ(2U, cache.page_reads());
+  EXPECT_EQ(2U, cache.cached_pages());
+
+  // Both pages are cached now.
+  ExpectRead(&cache, 0, kFileSize, 64);
+  ExpectRead(&cache, 64, kFileSize, 64);
+  EXPECT_EQ(2U, cache.page_reads());
+
+  // The last page is short.
+  ExpectRead(&cache, kFileSize - 10, kFileSize, 10);
+  EXPECT_EQ(3U, cache.page_reads());
+  EXPECT_EQ(3U, cache.cached_pages());
+}
+
+TEST_F(MinidumpPageCacheTest, EvictsLeastRecentlyUsed) {
+  MinidumpPageCache cache(&minidump_, 64, 2);
+  ExpectRead(&cache, 0, kFileSize, 4);
+  ExpectRead(&cache, 64, kFileSize, 4);
+  ExpectRead(&cache, 0, kFileSize, 4);
+  EXPECT_EQ(2U, cache.page_reads());
+
+  // Page 1 is the least recently used, so it makes way for page 2.
+  ExpectRead(&cache, 128, kFileSize, 4);
+  EXPECT_EQ(3U, cache.page_reads());
+  EXPECT_EQ(2U, cache.cached_pages());
+  ExpectRead(&cache, 0, kFileSize, 4);
+  EXPECT_EQ(3U, cache.page_reads());
+  ExpectRead(&cache, 64, kFileSize, 4);
+  EXPECT_EQ(4U, cache.page_reads());
+  EXPECT_EQ(2U, cache.cached_pages());
+}
+
+TEST_F(MinidumpPageCacheTest, ReadsNoFurtherThanLimit) {
+  MinidumpPageCache cache(&minidump_, 64, 4);
+
+  // Page 0 is read up to the limit, and read again when more of it is
+  // needed.
+  ExpectRead(&cache, 10, 20, 10);
+  EXPECT_EQ(1U, cache.page_reads());
+  ExpectRead(&cache, 30, kFileSize, 4);
+  EXPECT_EQ(2U, cache.page_reads());
+  ExpectRead(&cache, 10, 20, 10);
+  EXPECT_EQ(2U, cache.page_reads());
+  EXPECT_EQ(1U, cache.cached_pages());
+}
+
+TEST_F(MinidumpPageCacheTest, Failures) {
+  MinidumpPageCache cache(&minidump_, 64, 4);
+  char bytes[16];
+
+  // Reads extending past their limit.
+  EXPECT_FALSE(cache.Read(10, 12, bytes, 4));
+  EXPECT_FALSE(cache.Read(0, 2, bytes, 4));
+  EXPECT_EQ(0U, cache.page_reads());
+
+  // Reads extending past the end of the file.
+  EXPECT_FALSE(cache.Read(kFileSize - 4, kFileSize + 4, bytes, 8));
+  EXPECT_FALSE(cache.Read(kFileSize + 64, kFileSize + 68, bytes, 4));
+  EXPECT_EQ(0U, cache.cached_pages());
+}
+
+}  // namespace
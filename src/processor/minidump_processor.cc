@@ -31,12 +31,19 @@
 
 #include <assert.h>
 
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include "common/scoped_ptr.h"
 #include "common/stdio_wrapper.h"
 #include "common/using_std_string.h"
 #include "google_breakpad/processor/call_stack.h"
+#include "google_breakpad/processor/code_modules.h"
 #include "google_breakpad/processor/minidump.h"
 #include "google_breakpad/processor/process_state.h"
 #include "google_breakpad/processor/exploitability.h"
@@ -47,12 +54,186 @@
 
 namespace google_breakpad {
 
+namespace {
+
+// A lock that any number of readers may hold at once, or one writer alone.
+// A waiting writer keeps new readers out, so that lookups on some threads
+// can't hold off a module load on another indefinitely.
+class ReaderWriterLock {
+ public:
+  ReaderWriterLock() : readers_(0), writing_(false), waiting_writers_(0) {}
+
+  void LockShared() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    condition_.wait(lock, [this]() {
+      return !writing_ && waiting_writers_ == 0;
+    });
+    ++readers_;
+  }
+
+  void UnlockShared() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (--readers_ == 0)
+      condition_.notify_all();
+  }
+
+  void Lock() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    ++waiting_writers_;
+    condition_.wait(lock, [this]() { return !writing_ && readers_ == 0; });
+    --waiting_writers_;
+    writing_ = true;
+  }
+
+  void Unlock() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    writing_ = false;
+    condition_.notify_all();
+  }
+
+ private:
+  std::mutex mutex_;
+  std::condition_variable condition_;
+  unsigned int readers_;
+  bool writing_;
+  unsigned int waiting_writers_;
+};
+
+// Holds a ReaderWriterLock, shared or not, for as long as it lives.
+class ScopedReaderWriterLock {
+ public:
+  ScopedReaderWriterLock(ReaderWriterLock* lock, bool shared)
+      : lock_(lock), shared_(shared) {
+    if (shared_)
+      lock_->LockShared();
+    else
+      lock_->Lock();
+  }
+
+  ~ScopedReaderWriterLock() {
+    if (shared_)
+      lock_->UnlockShared();
+    else
+      lock_->Unlock();
+  }
+
+ private:
+  ReaderWriterLock* lock_;
+  bool shared_;
+};
+
+// Lets concurrent stack walks share another StackFrameSymbolizer.  Lookups
+// in modules that are already loaded, which are most of them once each
+// module has been seen, hold a shared lock, so that walks fill in frames
+// and find CFI side by side; see
+// StackFrameSymbolizer::FillSourceLineInfoFromLoadedModule.  Loading a
+// module, and anything else, holds the lock alone.  If the symbolizer
+// doesn't support concurrent lookups, every call holds the lock alone.
+class ConcurrentStackFrameSymbolizer : public StackFrameSymbolizer {
+ public:
+  explicit ConcurrentStackFrameSymbolizer(StackFrameSymbolizer* symbolizer)
+      : StackFrameSymbolizer(symbolizer->supplier(), symbolizer->resolver()),
+        symbolizer_(symbolizer),
+        concurrent_lookups_(symbolizer->SupportsConcurrentLookups()) {}
+
+  virtual SymbolizerResult FillSourceLineInfo(
+      const CodeModules* modules,
+      const CodeModules* unloaded_modules,
+      const SystemInfo* system_info,
+      StackFrame* stack_frame) {
+    if (concurrent_lookups_) {
+      ScopedReaderWriterLock lock(&lock_, true /* shared */);
+      SymbolizerResult result;
+      if (symbolizer_->FillSourceLineInfoFromLoadedModule(
+              modules, unloaded_modules, stack_frame, &result)) {
+        return result;
+      }
+    }
+    ScopedReaderWriterLock lock(&lock_, false /* shared */);
+    return symbolizer_->FillSourceLineInfo(modules, unloaded_modules,
+                                           system_info, stack_frame);
+  }
+
+  virtual WindowsFrameInfo* FindWindowsFrameInfo(const StackFrame* frame) {
+    ScopedReaderWriterLock lock(&lock_, concurrent_lookups_);
+    return symbolizer_->FindWindowsFrameInfo(frame);
+  }
+
+  virtual CFIFrameInfo* FindCFIFrameInfo(const StackFrame* frame) {
+    ScopedReaderWriterLock lock(&lock_, concurrent_lookups_);
+    return symbolizer_->FindCFIFrameInfo(frame);
+  }
+
+  virtual void Reset() {
+    ScopedReaderWriterLock lock(&lock_, false /* shared */);
+    symbolizer_->Reset();
+  }
+
+  virtual bool HasImplementation() {
+    ScopedReaderWriterLock lock(&lock_, false /* shared */);
+    return symbolizer_->HasImplementation();
+  }
+
+ private:
+  StackFrameSymbolizer* symbolizer_;
+  const bool concurrent_lookups_;
+  ReaderWriterLock lock_;
+};
+
+// A stack walk deferred until all of the minidump's threads have been read,
+// so that it can run concurrently with the others.
+struct PendingStackWalk {
+  PendingStackWalk()
+      : stackwalker(NULL), stack(NULL), thread_id(0), walk_serially(false),
+        interrupted(false) {}
+
+  Stackwalker* stackwalker;
+  CallStack* stack;
+  uint32_t thread_id;
+  string thread_string;
+  // Set when the thread's stack memory couldn't be read ahead of time.
+  // Reading it during the walk would access the minidump, which isn't
+  // thread-safe, so such walks run alone once the pool has finished.
+  bool walk_serially;
+  bool interrupted;
+  vector<const CodeModule*> modules_without_symbols;
+  vector<const CodeModule*> modules_with_corrupt_symbols;
+};
+
+void RunPendingStackWalk(PendingStackWalk* walk) {
+  if (!walk->stackwalker->Walk(walk->stack,
+                               &walk->modules_without_symbols,
+                               &walk->modules_with_corrupt_symbols)) {
+    BPLOG(INFO) << "Stackwalker interrupt (missing symbols?) at "
+                << walk->thread_string;
+    walk->interrupted = true;
+  }
+  // Walk clears the stack, including its thread ID.
+  walk->stack->set_tid(walk->thread_id);
+}
+
+// Appends the modules in |from| that are not already in |to|, preserving
+// order, so that merging per-walk lists in thread order yields the same
+// list a sequential walk would have built.
+void MergeSpecialAttentionModules(const vector<const CodeModule*>& from,
+                                  vector<const CodeModule*>* to) {
+  for (vector<const CodeModule*>::const_iterator it = from.begin();
+       it != from.end(); ++it) {
+    if (std::find(to->begin(), to->end(), *it) == to->end())
+      to->push_back(*it);
+  }
+}
+
+}  // namespace
+
 MinidumpProcessor::MinidumpProcessor(SymbolSupplier *supplier,
                                      SourceLineResolverInterface *resolver)
     : frame_symbolizer_(new StackFrameSymbolizer(supplier, resolver)),
       own_frame_symbolizer_(true),
       enable_exploitability_(false),
-      enable_objdump_(false) {
+      enable_objdump_(false),
+      max_stackwalk_threads_(1),
+      crashing_thread_only_(false) {
 }
 
 MinidumpProcessor::MinidumpProcessor(SymbolSupplier *supplier,
@@ -61,7 +242,9 @@ MinidumpProcessor::MinidumpProcessor(SymbolSupplier *supplier,
     : frame_symbolizer_(new StackFrameSymbolizer(supplier, resolver)),
       own_frame_symbolizer_(true),
       enable_exploitability_(enable_exploitability),
-      enable_objdump_(false) {
+      enable_objdump_(false),
+      max_stackwalk_threads_(1),
+      crashing_thread_only_(false) {
 }
 
 MinidumpProcessor::MinidumpProcessor(StackFrameSymbolizer *frame_symbolizer,
@@ -69,7 +252,9 @@ MinidumpProcessor::MinidumpProcessor(StackFrameSymbolizer *frame_symbolizer,
     : frame_symbolizer_(frame_symbolizer),
       own_frame_symbolizer_(false),
       enable_exploitability_(enable_exploitability),
-      enable_objdump_(false) {
+      enable_objdump_(false),
+      max_stackwalk_threads_(1),
+      crashing_thread_only_(false) {
   assert(frame_symbolizer_);
 }
 
@@ -147,18 +332,40 @@ ProcessResult MinidumpProcessor::Process(
     process_state->unloaded_modules_ = unloaded_module_list->Copy();
   }
 
-  MinidumpMemoryList *memory_list = dump->GetMemoryList();
-  if (memory_list) {
-    BPLOG(INFO) << "Found " << memory_list->region_count()
-                << " memory regions.";
-  }
-
   MinidumpThreadList *threads = dump->GetThreadList();
   if (!threads) {
     BPLOG(ERROR) << "Minidump " << dump->path() << " has no thread list";
     return PROCESS_ERROR_NO_THREAD_LIST;
   }
 
+  // If the requesting thread can't be walked, because it isn't in the
+  // thread list or is the thread that wrote the dump, walk all of the
+  // threads instead of none.
+  bool walk_requesting_thread_only =
+      crashing_thread_only_ && has_requesting_thread;
+  if (walk_requesting_thread_only &&
+      (!threads->GetThreadByID(requesting_thread_id) ||
+       (has_dump_thread && requesting_thread_id == dump_thread_id))) {
+    BPLOG(ERROR) << "Minidump " << dump->path() << " requesting thread " <<
+        HexString(requesting_thread_id) << " can't be walked, walking all "
+        "threads";
+    walk_requesting_thread_only = false;
+  }
+
+  // Only the requesting thread's stack might need to be looked up in the
+  // memory list when walking that thread alone, so the list is read on
+  // demand then.
+  MinidumpMemoryList *memory_list = NULL;
+  bool memory_list_read = false;
+  if (!walk_requesting_thread_only) {
+    memory_list = dump->GetMemoryList();
+    memory_list_read = true;
+    if (memory_list) {
+      BPLOG(INFO) << "Found " << memory_list->region_count()
+                  << " memory regions.";
+    }
+  }
+
   BPLOG(INFO) << "Minidump " << dump->path() << " has " <<
       (has_cpu_info            ? "" : "no ") << "CPU info, " <<
       (has_os_info             ? "" : "no ") << "OS info, " <<
@@ -177,6 +384,21 @@ ProcessResult MinidumpProcessor::Process(
   // Reset frame_symbolizer_ at the beginning of stackwalk for each minidump.
   frame_symbolizer_->Reset();
 
+  // When walking concurrently, the walks are set up while reading each
+  // thread below, and run once the whole thread list has been read.
+  bool concurrent = max_stackwalk_threads_ > 1;
+  // The walks share process_state's module lists, whose lookups are safe
+  // to make from several threads at once: see CodeModules.
+  scoped_ptr<ConcurrentStackFrameSymbolizer> concurrent_symbolizer;
+  vector<PendingStackWalk> pending_walks;
+  if (concurrent) {
+    concurrent_symbolizer.reset(
+        new ConcurrentStackFrameSymbolizer(frame_symbolizer_));
+    pending_walks.reserve(thread_count);
+  }
+  // Owns the Stackwalkers of pending_walks, including on early return.
+  vector<linked_ptr<Stackwalker> > pending_stackwalkers;
+
   for (unsigned int thread_index = 0;
        thread_index < thread_count;
        ++thread_index) {
@@ -208,6 +430,10 @@ ProcessResult MinidumpProcessor::Process(
       continue;
     }
 
+    if (walk_requesting_thread_only && thread_id != requesting_thread_id) {
+      continue;
+    }
+
     MinidumpContext *context = thread->GetContext();
 
     if (has_requesting_thread && thread_id == requesting_thread_id) {
@@ -244,6 +470,10 @@ ProcessResult MinidumpProcessor::Process(
     // in the memory descriptor inside MINIDUMP_THREAD, try to locate and use
     // a memory region (containing the stack) from the minidump memory list.
     MinidumpMemoryRegion *thread_memory = thread->GetMemory();
+    if (!thread_memory && !memory_list_read) {
+      memory_list = dump->GetMemoryList();
+      memory_list_read = true;
+    }
     if (!thread_memory && memory_list) {
       uint64_t start_stack_memory_range = thread->GetStartOfStackMemoryRange();
       if (start_stack_memory_range) {
@@ -263,6 +493,38 @@ ProcessResult MinidumpProcessor::Process(
     // returns.  process_state->modules_ is owned by the ProcessState object
     // (just like the StackFrame objects), and is much more suitable for this
     // task.
+    if (concurrent) {
+      // Fault the stack memory in now, while the minidump is only being read
+      // from this thread.  Paged memory needn't be: the page cache may be
+      // read from several threads at once.
+      bool memory_read = !thread_memory || dump->IsMemoryPaged() ||
+                         thread_memory->GetMemory();
+      Stackwalker* stackwalker = Stackwalker::StackwalkerForCPU(
+          process_state->system_info(),
+          context,
+          thread_memory,
+          process_state->modules_,
+          process_state->unloaded_modules_,
+          concurrent_symbolizer.get());
+      CallStack* stack = new CallStack();
+      stack->set_tid(thread_id);
+      process_state->threads_.push_back(stack);
+      process_state->thread_memory_regions_.push_back(thread_memory);
+      if (stackwalker) {
+        pending_stackwalkers.push_back(linked_ptr<Stackwalker>(stackwalker));
+        pending_walks.push_back(PendingStackWalk());
+        PendingStackWalk& walk = pending_walks.back();
+        walk.stackwalker = stackwalker;
+        walk.stack = stack;
+        walk.thread_id = thread_id;
+        walk.thread_string = thread_string;
+        walk.walk_serially = !memory_read;
+      } else {
+        BPLOG(ERROR) << "No stackwalker for " << thread_string;
+      }
+      continue;
+    }
+
     scoped_ptr<Stackwalker> stackwalker(
         Stackwalker::StackwalkerForCPU(process_state->system_info(),
                                        context,
@@ -291,6 +553,44 @@ ProcessResult MinidumpProcessor::Process(
     process_state->thread_memory_regions_.push_back(thread_memory);
   }
 
+  if (concurrent && !pending_walks.empty()) {
+    vector<PendingStackWalk*> parallel_walks;
+    for (size_t i = 0; i < pending_walks.size(); ++i) {
+      if (!pending_walks[i].walk_serially)
+        parallel_walks.push_back(&pending_walks[i]);
+    }
+
+    // Each pool thread, and the calling thread, claims the next walk until
+    // none are left.
+    std::atomic<size_t> next_walk(0);
+    auto run_walks = [&parallel_walks, &next_walk]() {
+      size_t index;
+      while ((index = next_walk++) < parallel_walks.size())
+        RunPendingStackWalk(parallel_walks[index]);
+    };
+    size_t pool_size = std::min<size_t>(max_stackwalk_threads_,
+                                        parallel_walks.size());
+    vector<std::thread> pool;
+    for (size_t i = 1; i < pool_size; ++i)
+      pool.push_back(std::thread(run_walks));
+    run_walks();
+    for (size_t i = 0; i < pool.size(); ++i)
+      pool[i].join();
+
+    for (size_t i = 0; i < pending_walks.size(); ++i) {
+      PendingStackWalk& walk = pending_walks[i];
+      if (walk.walk_serially)
+        RunPendingStackWalk(&walk);
+      interrupted |= walk.interrupted;
+      MergeSpecialAttentionModules(
+          walk.modules_without_symbols,
+          &process_state->modules_without_symbols_);
+      MergeSpecialAttentionModules(
+          walk.modules_with_corrupt_symbols,
+          &process_state->modules_with_corrupt_symbols_);
+    }
+  }
+
   if (interrupted) {
     BPLOG(INFO) << "Processing interrupted for " << dump->path();
     return PROCESS_SYMBOL_SUPPLIER_INTERRUPTED;
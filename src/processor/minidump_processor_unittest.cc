@@ -36,6 +36,7 @@
 #include <iostream>
 #include <fstream>
 #include <map>
+#include <sstream>
 #include <utility>
 
 #include "breakpad_googletest_includes.h"
@@ -52,6 +53,7 @@
 #include "google_breakpad/processor/symbol_supplier.h"
 #include "processor/logging.h"
 #include "processor/stackwalker_unittest_utils.h"
+#include "processor/synth_minidump.h"
 
 using std::map;
 
@@ -161,6 +163,8 @@ namespace {
 using google_breakpad::BasicSourceLineResolver;
 using google_breakpad::CallStack;
 using google_breakpad::CodeModule;
+using google_breakpad::linked_ptr;
+using google_breakpad::Minidump;
 using google_breakpad::MinidumpContext;
 using google_breakpad::MinidumpMemoryRegion;
 using google_breakpad::MinidumpMiscInfo;
@@ -177,8 +181,11 @@ using google_breakpad::MockMinidumpUnloadedModule;
 using google_breakpad::MockMinidumpUnloadedModuleList;
 using google_breakpad::ProcessState;
 using google_breakpad::scoped_ptr;
+using google_breakpad::StackFrame;
 using google_breakpad::SymbolSupplier;
 using google_breakpad::SystemInfo;
+using google_breakpad::test_assembler::kLittleEndian;
+using std::istringstream;
 using ::testing::_;
 using ::testing::AnyNumber;
 using ::testing::DoAll;
@@ -739,6 +746,272 @@ TEST_F(MinidumpProcessorTest, TestThreadMissingContext) {
   ASSERT_EQ(0U, state.threads()->at(0)->frames()->size());
 }
 
+// Checks that two ProcessStates describe the same thread stacks.
+void ExpectSameStacks(const ProcessState& expected,
+                      const ProcessState& actual) {
+  ASSERT_EQ(expected.threads()->size(), actual.threads()->size());
+  EXPECT_EQ(expected.requesting_thread(), actual.requesting_thread());
+  for (size_t t = 0; t < expected.threads()->size(); ++t) {
+    const CallStack* expected_stack = expected.threads()->at(t);
+    const CallStack* actual_stack = actual.threads()->at(t);
+    EXPECT_EQ(expected_stack->tid(), actual_stack->tid());
+    ASSERT_EQ(expected_stack->frames()->size(),
+              actual_stack->frames()->size());
+    for (size_t f = 0; f < expected_stack->frames()->size(); ++f) {
+      const StackFrame* expected_frame = expected_stack->frames()->at(f);
+      const StackFrame* actual_frame = actual_stack->frames()->at(f);
+      EXPECT_EQ(expected_frame->instruction, actual_frame->instruction);
+      EXPECT_EQ(expected_frame->trust, actual_frame->trust);
+      EXPECT_EQ(expected_frame->function_name, actual_frame->function_name);
+      EXPECT_EQ(expected_frame->source_file_name,
+                actual_frame->source_file_name);
+      EXPECT_EQ(expected_frame->source_line, actual_frame->source_line);
+      ASSERT_EQ(expected_frame->module == NULL, actual_frame->module == NULL);
+      if (expected_frame->module) {
+        EXPECT_EQ(expected_frame->module->code_file(),
+                  actual_frame->module->code_file());
+      }
+    }
+  }
+
+  ASSERT_EQ(expected.modules_without_symbols()->size(),
+            actual.modules_without_symbols()->size());
+  for (size_t m = 0; m < expected.modules_without_symbols()->size(); ++m) {
+    EXPECT_EQ(expected.modules_without_symbols()->at(m)->code_file(),
+              actual.modules_without_symbols()->at(m)->code_file());
+  }
+}
+
+TEST_F(MinidumpProcessorTest, TestConcurrentStackwalkWithSymbols) {
+  string minidump_file = string(getenv("srcdir") ? getenv("srcdir") : ".") +
+                         "/src/processor/testdata/minidump2.dmp";
+
+  TestSymbolSupplier serial_supplier;
+  BasicSourceLineResolver serial_resolver;
+  MinidumpProcessor serial_processor(&serial_supplier, &serial_resolver);
+  ProcessState serial_state;
+  ASSERT_EQ(google_breakpad::PROCESS_OK,
+            serial_processor.Process(minidump_file, &serial_state));
+
+  TestSymbolSupplier concurrent_supplier;
+  BasicSourceLineResolver concurrent_resolver;
+  MinidumpProcessor concurrent_processor(&concurrent_supplier,
+                                         &concurrent_resolver);
+  concurrent_processor.set_max_stackwalk_threads(4);
+  ProcessState concurrent_state;
+  ASSERT_EQ(google_breakpad::PROCESS_OK,
+            concurrent_processor.Process(minidump_file, &concurrent_state));
+
+  ExpectSameStacks(serial_state, concurrent_state);
+  ASSERT_EQ(4U, concurrent_state.threads()->at(0)->frames()->size());
+  EXPECT_EQ("main",
+            concurrent_state.threads()->at(0)->frames()->at(1)->function_name);
+
+  // An interrupt from the supplier is still reported.
+  concurrent_state.Clear();
+  concurrent_supplier.set_interrupt(true);
+  concurrent_resolver.UnloadModule(
+      serial_state.threads()->at(0)->frames()->at(0)->module);
+  ASSERT_EQ(google_breakpad::PROCESS_SYMBOL_SUPPLIER_INTERRUPTED,
+            concurrent_processor.Process(minidump_file, &concurrent_state));
+}
+
+TEST_F(MinidumpProcessorTest, TestConcurrentStackwalkManyThreads) {
+  using google_breakpad::SynthMinidump::Context;
+  using google_breakpad::SynthMinidump::Dump;
+  using google_breakpad::SynthMinidump::Memory;
+  using google_breakpad::SynthMinidump::Module;
+  using google_breakpad::SynthMinidump::String;
+  using google_breakpad::SynthMinidump::SystemInfo;
+  using google_breakpad::SynthMinidump::Thread;
+
+  // Two modules, and a few dozen threads whose stacks hold addresses in
+  // them, so that each walk scans its way through several frames.
+  const uint32_t kModuleBase[] = { 0x10000000, 0x20000000 };
+  const uint32_t kModuleSize = 0x10000;
+  const int kThreadCount = 37;
+
+  Dump dump(0, kLittleEndian);
+  String csd_version(dump, SystemInfo::windows_x86_csd_version);
+  SystemInfo system_info(dump, SystemInfo::windows_x86, csd_version);
+  String module1_name(dump, "module1.dll");
+  String module2_name(dump, "module2.dll");
+  Module module1(dump, kModuleBase[0], kModuleSize, module1_name);
+  Module module2(dump, kModuleBase[1], kModuleSize, module2_name);
+  dump.Add(&csd_version);
+  dump.Add(&system_info);
+  dump.Add(&module1_name);
+  dump.Add(&module2_name);
+  dump.Add(&module1);
+  dump.Add(&module2);
+
+  std::vector<linked_ptr<Memory> > stacks;
+  std::vector<linked_ptr<Context> > contexts;
+  std::vector<linked_ptr<Thread> > threads;
+  for (int i = 0; i < kThreadCount; ++i) {
+    uint32_t stack_base = 0x80000000 + i * 0x1000;
+    linked_ptr<Memory> stack(new Memory(dump, stack_base));
+    for (int word = 0; word < 24; ++word) {
+      // Mix return addresses in both modules with non-code values.
+      uint32_t value = (word + i) % 3 == 0 ?
+          0xdead0000 + word :
+          kModuleBase[(word + i) % 2] + 0x100 * (word + 1) + i;
+      stack->D32(value);
+    }
+
+    MDRawContextX86 raw_context;
+    memset(&raw_context, 0, sizeof(raw_context));
+    raw_context.context_flags = MD_CONTEXT_X86_INTEGER | MD_CONTEXT_X86_CONTROL;
+    raw_context.eip = kModuleBase[i % 2] + 0x40 + i;
+    raw_context.esp = stack_base;
+    raw_context.ebp = 0;
+    linked_ptr<Context> context(new Context(dump, raw_context));
+    linked_ptr<Thread> thread(new Thread(dump, 0x100 + i, *stack, *context));
+    dump.Add(stack.get());
+    dump.Add(context.get());
+    dump.Add(thread.get());
+    stacks.push_back(stack);
+    contexts.push_back(context);
+    threads.push_back(thread);
+  }
+  dump.Finish();
+
+  string contents;
+  ASSERT_TRUE(dump.GetContents(&contents));
+
+  istringstream serial_stream(contents);
+  Minidump serial_dump(serial_stream);
+  ASSERT_TRUE(serial_dump.Read());
+  BasicSourceLineResolver serial_resolver;
+  MinidumpProcessor serial_processor(NULL, &serial_resolver);
+  ProcessState serial_state;
+  ASSERT_EQ(google_breakpad::PROCESS_OK,
+            serial_processor.Process(&serial_dump, &serial_state));
+  ASSERT_EQ(static_cast<size_t>(kThreadCount), serial_state.threads()->size());
+  ASSERT_LT(1U, serial_state.threads()->at(0)->frames()->size());
+  ASSERT_EQ(2U, serial_state.modules_without_symbols()->size());
+
+  for (unsigned int pool_size = 2; pool_size <= 8; pool_size *= 2) {
+    istringstream concurrent_stream(contents);
+    Minidump concurrent_dump(concurrent_stream);
+    ASSERT_TRUE(concurrent_dump.Read());
+    BasicSourceLineResolver concurrent_resolver;
+    MinidumpProcessor concurrent_processor(NULL, &concurrent_resolver);
+    concurrent_processor.set_max_stackwalk_threads(pool_size);
+    ProcessState concurrent_state;
+    ASSERT_EQ(google_breakpad::PROCESS_OK,
+              concurrent_processor.Process(&concurrent_dump,
+                                           &concurrent_state));
+    ExpectSameStacks(serial_state, concurrent_state);
+  }
+}
+
+TEST_F(MinidumpProcessorTest, TestCrashingThreadOnly) {
+  using google_breakpad::SynthMinidump::Context;
+  using google_breakpad::SynthMinidump::Dump;
+  using google_breakpad::SynthMinidump::Exception;
+  using google_breakpad::SynthMinidump::Memory;
+  using google_breakpad::SynthMinidump::String;
+  using google_breakpad::SynthMinidump::SystemInfo;
+  using google_breakpad::SynthMinidump::Thread;
+
+  const int kThreadCount = 3;
+  const uint32_t kCrashedThreadID = 0x101;
+  const uint32_t kMissingThreadID = 0x1ff;
+
+  // Dumps of three threads: without an exception, with one in the second
+  // thread, and with one in a thread missing from the thread list.
+  string contents[3];
+  for (int variant = 0; variant < 3; ++variant) {
+    Dump dump(0, kLittleEndian);
+    String csd_version(dump, SystemInfo::windows_x86_csd_version);
+    SystemInfo system_info(dump, SystemInfo::windows_x86, csd_version);
+    dump.Add(&csd_version);
+    dump.Add(&system_info);
+
+    std::vector<linked_ptr<Memory> > stacks;
+    std::vector<linked_ptr<Context> > contexts;
+    std::vector<linked_ptr<Thread> > threads;
+    for (int i = 0; i < kThreadCount; ++i) {
+      uint32_t stack_base = 0x80000000 + i * 0x1000;
+      linked_ptr<Memory> stack(new Memory(dump, stack_base));
+      stack->D32(0).D32(0);
+      MDRawContextX86 raw_context;
+      memset(&raw_context, 0, sizeof(raw_context));
+      raw_context.context_flags =
+          MD_CONTEXT_X86_INTEGER | MD_CONTEXT_X86_CONTROL;
+      raw_context.eip = 0x10000000 + i;
+      raw_context.esp = stack_base;
+      linked_ptr<Context> context(new Context(dump, raw_context));
+      linked_ptr<Thread> thread(new Thread(dump, 0x100 + i, *stack,
+                                           *context));
+      dump.Add(stack.get());
+      dump.Add(context.get());
+      dump.Add(thread.get());
+      stacks.push_back(stack);
+      contexts.push_back(context);
+      threads.push_back(thread);
+    }
+
+    MDRawContextX86 raw_exception_context;
+    memset(&raw_exception_context, 0, sizeof(raw_exception_context));
+    raw_exception_context.context_flags =
+        MD_CONTEXT_X86_INTEGER | MD_CONTEXT_X86_CONTROL;
+    raw_exception_context.eip = 0x10000040;
+    raw_exception_context.esp = 0x80001000;
+    Context exception_context(dump, raw_exception_context);
+    Exception exception(dump, exception_context,
+                        variant == 2 ? kMissingThreadID : kCrashedThreadID,
+                        MD_EXCEPTION_CODE_WIN_ACCESS_VIOLATION);
+    if (variant > 0) {
+      dump.Add(&exception_context);
+      dump.Add(&exception);
+    }
+    dump.Finish();
+    ASSERT_TRUE(dump.GetContents(&contents[variant]));
+  }
+
+  BasicSourceLineResolver resolver;
+  MinidumpProcessor processor(NULL, &resolver);
+  processor.set_crashing_thread_only(true);
+  ASSERT_TRUE(processor.crashing_thread_only());
+
+  // Only the crashed thread is walked, from the exception's context.
+  istringstream crashed_stream(contents[1]);
+  Minidump crashed_dump(crashed_stream);
+  ASSERT_TRUE(crashed_dump.Read());
+  ProcessState state;
+  ASSERT_EQ(google_breakpad::PROCESS_OK,
+            processor.Process(&crashed_dump, &state));
+  ASSERT_TRUE(state.crashed());
+  ASSERT_EQ(1U, state.threads()->size());
+  EXPECT_EQ(kCrashedThreadID, state.threads()->at(0)->tid());
+  EXPECT_EQ(0, state.requesting_thread());
+  ASSERT_LE(1U, state.threads()->at(0)->frames()->size());
+  EXPECT_EQ(0x10000040U,
+            state.threads()->at(0)->frames()->at(0)->instruction);
+  EXPECT_EQ(1U, state.thread_memory_regions()->size());
+
+  // Without a crash there is no thread to single out, so all are walked.
+  istringstream uncrashed_stream(contents[0]);
+  Minidump uncrashed_dump(uncrashed_stream);
+  ASSERT_TRUE(uncrashed_dump.Read());
+  ASSERT_EQ(google_breakpad::PROCESS_OK,
+            processor.Process(&uncrashed_dump, &state));
+  ASSERT_FALSE(state.crashed());
+  EXPECT_EQ(static_cast<size_t>(kThreadCount), state.threads()->size());
+
+  // Nor is there when the crashed thread isn't in the thread list.
+  istringstream missing_stream(contents[2]);
+  Minidump missing_dump(missing_stream);
+  ASSERT_TRUE(missing_dump.Read());
+  ASSERT_EQ(google_breakpad::PROCESS_OK,
+            processor.Process(&missing_dump, &state));
+  ASSERT_TRUE(state.crashed());
+  EXPECT_EQ(static_cast<size_t>(kThreadCount), state.threads()->size());
+  EXPECT_EQ(-1, state.requesting_thread());
+}
+
 }  // namespace
 
 int main(int argc, char *argv[]) {
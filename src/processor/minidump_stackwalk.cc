@@ -33,6 +33,7 @@
 // Author: Mark Mentovai
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 
@@ -47,7 +48,10 @@
 #include "google_breakpad/processor/minidump.h"
 #include "google_breakpad/processor/minidump_processor.h"
 #include "google_breakpad/processor/process_state.h"
+#include "google_breakpad/processor/stack_frame_symbolizer.h"
 #include "processor/logging.h"
+#include "processor/minidump_page_cache.h"
+#include "processor/process_state_serializer.h"
 #include "processor/simple_symbol_supplier.h"
 #include "processor/stackwalk_common.h"
 
@@ -56,7 +60,17 @@ namespace {
 
 struct Options {
   bool machine_readable;
+  bool serialize;
+  google_breakpad::ProcessStateSerializer::Format serialize_format;
   bool output_stack_contents;
+  bool use_memory_mapping;
+  unsigned int memory_cache_mb;
+  unsigned int stackwalk_threads;
+  unsigned int parse_threads;
+  bool lazy_symbol_loading;
+  bool compact_symbols;
+  bool crashing_thread_only;
+  bool memoize_frames;
 
   string minidump_file;
   std::vector<string> symbol_paths;
@@ -65,10 +79,13 @@ struct Options {
 using google_breakpad::BasicSourceLineResolver;
 using google_breakpad::Minidump;
 using google_breakpad::MinidumpMemoryList;
+using google_breakpad::MinidumpPageCache;
 using google_breakpad::MinidumpThreadList;
 using google_breakpad::MinidumpProcessor;
 using google_breakpad::ProcessState;
+using google_breakpad::ProcessStateSerializer;
 using google_breakpad::SimpleSymbolSupplier;
+using google_breakpad::StackFrameSymbolizer;
 using google_breakpad::scoped_ptr;
 
 // Processes |options.minidump_file| using MinidumpProcessor.
@@ -80,8 +97,9 @@ using google_breakpad::scoped_ptr;
 // Returns the value of MinidumpProcessor::Process.  If processing succeeds,
 // prints identifying OS and CPU information from the minidump, crash
 // information if the minidump was produced as a result of a crash, and
-// call stacks for each thread contained in the minidump.  All information
-// is printed to stdout.
+// call stacks for each thread contained in the minidump, or with -o, writes
+// them as a ProcessStateProto message.  All information is printed to
+// stdout.
 bool PrintMinidumpProcess(const Options& options) {
   scoped_ptr<SimpleSymbolSupplier> symbol_supplier;
   if (!options.symbol_paths.empty()) {
@@ -90,13 +108,29 @@ bool PrintMinidumpProcess(const Options& options) {
   }
 
   BasicSourceLineResolver resolver;
-  MinidumpProcessor minidump_processor(symbol_supplier.get(), &resolver);
+  resolver.set_max_parse_threads(options.parse_threads);
+  resolver.set_lazy_loading(options.lazy_symbol_loading);
+  resolver.set_compact_range_maps(options.compact_symbols);
+  // Frames only need their names for printing, so with -r they may share
+  // them as well.
+  StackFrameSymbolizer symbolizer(symbol_supplier.get(), &resolver);
+  symbolizer.set_memoize_frames(options.memoize_frames);
+  symbolizer.set_intern_names(options.memoize_frames);
+  MinidumpProcessor minidump_processor(&symbolizer, false);
+  minidump_processor.set_max_stackwalk_threads(options.stackwalk_threads);
+  minidump_processor.set_crashing_thread_only(options.crashing_thread_only);
 
   // Increase the maximum number of threads and regions.
   MinidumpThreadList::set_max_threads(std::numeric_limits<uint32_t>::max());
   MinidumpMemoryList::set_max_regions(std::numeric_limits<uint32_t>::max());
   // Process the minidump.
   Minidump dump(options.minidump_file);
+  dump.set_use_memory_mapping(options.use_memory_mapping);
+  if (options.memory_cache_mb) {
+    const uint32_t kPageSize = MinidumpPageCache::kDefaultPageSize;
+    dump.set_memory_page_cache(
+        kPageSize, options.memory_cache_mb * (1024 * 1024 / kPageSize));
+  }
   if (!dump.Read()) {
      BPLOG(ERROR) << "Minidump " << dump.path() << " could not be read";
      return false;
@@ -108,7 +142,10 @@ bool PrintMinidumpProcess(const Options& options) {
     return false;
   }
 
-  if (options.machine_readable) {
+  if (options.serialize) {
+    ProcessStateSerializer serializer(options.serialize_format);
+    return serializer.Write(process_state, stdout);
+  } else if (options.machine_readable) {
     PrintProcessStateMachineReadable(process_state);
   } else {
     PrintProcessState(process_state, options.output_stack_contents, &resolver);
@@ -128,7 +165,22 @@ static void Usage(int argc, const char *argv[], bool error) {
           "Options:\n"
           "\n"
           "  -m         Output in machine-readable format\n"
-          "  -s         Output stack contents\n",
+          "  -o <fmt>   Output a ProcessStateProto message (see\n"
+          "             proto/process_state.proto) as json or proto\n"
+          "  -s         Output stack contents\n"
+          "  -M         Read the minidump through a memory mapping\n"
+          "  -P <n>     Read memory in pages through a cache of at most "
+          "n MB\n"
+          "  -j <n>     Walk thread stacks on up to n threads (default 1),\n"
+          "             loading symbol files on one thread at a time\n"
+          "  -p <n>     Parse each symbol file on up to n threads "
+          "(default 1)\n"
+          "  -l         Load symbol files lazily, parsing only the records "
+          "looked up\n"
+          "  -C         Store functions and lines in compact sorted arrays\n"
+          "  -c         Walk only the crashing (requesting) thread\n"
+          "  -r         Remember symbolized frames, reusing them for later\n"
+          "             frames at the same addresses, and share their names\n",
           google_breakpad::BaseName(argv[0]).c_str());
 }
 
@@ -136,9 +188,19 @@ static void SetupOptions(int argc, const char *argv[], Options* options) {
   int ch;
 
   options->machine_readable = false;
+  options->serialize = false;
+  options->serialize_format = ProcessStateSerializer::FORMAT_JSON;
   options->output_stack_contents = false;
+  options->use_memory_mapping = false;
+  options->memory_cache_mb = 0;
+  options->stackwalk_threads = 1;
+  options->parse_threads = 1;
+  options->lazy_symbol_loading = false;
+  options->compact_symbols = false;
+  options->crashing_thread_only = false;
+  options->memoize_frames = false;
 
-  while ((ch = getopt(argc, (char * const *)argv, "hms")) != -1) {
+  while ((ch = getopt(argc, (char * const *)argv, "hmo:sMP:j:p:lCcr")) != -1) {
     switch (ch) {
       case 'h':
         Usage(argc, argv, false);
@@ -148,9 +210,69 @@ static void SetupOptions(int argc, const char *argv[], Options* options) {
       case 'm':
         options->machine_readable = true;
         break;
+      case 'o':
+        options->serialize = true;
+        if (strcmp(optarg, "json") == 0) {
+          options->serialize_format = ProcessStateSerializer::FORMAT_JSON;
+        } else if (strcmp(optarg, "proto") == 0) {
+          options->serialize_format = ProcessStateSerializer::FORMAT_PROTO;
+        } else {
+          fprintf(stderr, "%s: Invalid output format %s\n", argv[0], optarg);
+          Usage(argc, argv, true);
+          exit(1);
+        }
+        break;
       case 's':
         options->output_stack_contents = true;
         break;
+      case 'M':
+        options->use_memory_mapping = true;
+        break;
+      case 'P': {
+        char* end;
+        long megabytes = strtol(optarg, &end, 10);
+        if (*end != '\0' || megabytes < 1 || megabytes > 1024 * 1024) {
+          fprintf(stderr, "%s: Invalid cache size %s\n", argv[0], optarg);
+          Usage(argc, argv, true);
+          exit(1);
+        }
+        options->memory_cache_mb = static_cast<unsigned int>(megabytes);
+        break;
+      }
+      case 'j': {
+        char* end;
+        long threads = strtol(optarg, &end, 10);
+        if (*end != '\0' || threads < 1) {
+          fprintf(stderr, "%s: Invalid thread count %s\n", argv[0], optarg);
+          Usage(argc, argv, true);
+          exit(1);
+        }
+        options->stackwalk_threads = static_cast<unsigned int>(threads);
+        break;
+      }
+      case 'p': {
+        char* end;
+        long threads = strtol(optarg, &end, 10);
+        if (*end != '\0' || threads < 1) {
+          fprintf(stderr, "%s: Invalid thread count %s\n", argv[0], optarg);
+          Usage(argc, argv, true);
+          exit(1);
+        }
+        options->parse_threads = static_cast<unsigned int>(threads);
+        break;
+      }
+      case 'l':
+        options->lazy_symbol_loading = true;
+        break;
+      case 'C':
+        options->compact_symbols = true;
+        break;
+      case 'c':
+        options->crashing_thread_only = true;
+        break;
+      case 'r':
+        options->memoize_frames = true;
+        break;
 
       case '?':
         Usage(argc, argv, true);
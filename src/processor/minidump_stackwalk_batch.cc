@@ -0,0 +1,496 @@
+// Copyright (c) 2026 Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// minidump_stackwalk_batch.cc: Process a stream of minidumps with a single
+// MinidumpProcessor, printing the results of each one.
+//
+// minidump_stackwalk loads every symbol file it needs from scratch each time
+// it runs.  This tool instead reads minidump paths, one per line, from stdin
+// or from clients of a local (AF_UNIX) socket, and keeps the symbols it has
+// loaded resident in one resolver for as long as it runs.  It can also use
+// FastSourceLineResolver with serialized symbol files written by sym_to_fast,
+// which are loaded without parsing.  Each dump's output
+// is the same as minidump_stackwalk's, followed by a line of the form
+// "==== OK <path>" or "==== FAILED <path>" so that consumers can tell where
+// one result ends and the next begins.
+
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <limits>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "common/path_helper.h"
+#include "common/scoped_ptr.h"
+#include "common/using_std_string.h"
+#include "google_breakpad/processor/basic_source_line_resolver.h"
+#include "google_breakpad/processor/code_module.h"
+#include "google_breakpad/processor/code_modules.h"
+#include "google_breakpad/processor/fast_source_line_resolver.h"
+#include "google_breakpad/processor/minidump.h"
+#include "google_breakpad/processor/minidump_processor.h"
+#include "google_breakpad/processor/process_state.h"
+#include "google_breakpad/processor/stack_frame.h"
+#include "google_breakpad/processor/stack_frame_symbolizer.h"
+#include "processor/fast_symbol_supplier.h"
+#include "processor/logging.h"
+#include "processor/simple_symbol_supplier.h"
+#include "processor/stackwalk_common.h"
+
+
+namespace {
+
+struct Options {
+  bool machine_readable;
+  bool output_stack_contents;
+  bool use_memory_mapping;
+  unsigned int stackwalk_threads;
+  unsigned int parse_threads;
+  bool lazy_symbol_loading;
+  bool compact_symbols;
+  size_t symbol_data_budget;
+  bool use_serialized_symbols;
+  bool write_serialized_symbols;
+  bool memoize_frames;
+
+  string socket_path;
+  std::vector<string> symbol_paths;
+};
+
+using google_breakpad::BasicSourceLineResolver;
+using google_breakpad::CodeModule;
+using google_breakpad::CodeModules;
+using google_breakpad::FastSourceLineResolver;
+using google_breakpad::FastSymbolSupplier;
+using google_breakpad::Minidump;
+using google_breakpad::MinidumpMemoryList;
+using google_breakpad::MinidumpThreadList;
+using google_breakpad::MinidumpProcessor;
+using google_breakpad::ProcessState;
+using google_breakpad::SimpleSymbolSupplier;
+using google_breakpad::SourceLineResolverBase;
+using google_breakpad::SourceLineResolverInterface;
+using google_breakpad::StackFrame;
+using google_breakpad::StackFrameSymbolizer;
+using google_breakpad::SymbolSupplier;
+using google_breakpad::SystemInfo;
+using google_breakpad::scoped_ptr;
+
+// The resolver identifies loaded modules by code file alone, which is fine
+// for a single dump but not across many: two dumps may well contain
+// different builds of the same library.  BatchStackFrameSymbolizer remembers
+// which debug identifier each resident module was loaded for, and unloads
+// the module, freeing the supplier's copy of its symbols, when a frame needs
+// a different build of it.
+class BatchStackFrameSymbolizer : public StackFrameSymbolizer {
+ public:
+  BatchStackFrameSymbolizer(SymbolSupplier* supplier,
+                            SourceLineResolverInterface* resolver)
+      : StackFrameSymbolizer(supplier, resolver) {}
+
+  SymbolizerResult FillSourceLineInfo(const CodeModules* modules,
+                                      const CodeModules* unloaded_modules,
+                                      const SystemInfo* system_info,
+                                      StackFrame* frame) override {
+    const CodeModule* module = NULL;
+    if (modules && frame)
+      module = modules->GetModuleForAddress(frame->instruction);
+    if (!module || !resolver_) {
+      return StackFrameSymbolizer::FillSourceLineInfo(
+          modules, unloaded_modules, system_info, frame);
+    }
+
+    const string code_file = module->code_file();
+    const string debug_identifier = module->debug_identifier();
+    std::map<string, string>::iterator loaded =
+        loaded_identifiers_.find(code_file);
+    if (loaded != loaded_identifiers_.end() &&
+        loaded->second != debug_identifier) {
+      UnloadModule(module);
+      loaded_identifiers_.erase(loaded);
+    }
+
+    SymbolizerResult result = StackFrameSymbolizer::FillSourceLineInfo(
+        modules, unloaded_modules, system_info, frame);
+    if (result == kNoError || result == kWarningCorruptSymbols)
+      loaded_identifiers_[code_file] = debug_identifier;
+    return result;
+  }
+
+  // A module loaded for another build must be unloaded first, which only
+  // FillSourceLineInfo may do.
+  bool FillSourceLineInfoFromLoadedModule(const CodeModules* modules,
+                                          const CodeModules* unloaded_modules,
+                                          StackFrame* frame,
+                                          SymbolizerResult* result) override {
+    const CodeModule* module = NULL;
+    if (modules && frame)
+      module = modules->GetModuleForAddress(frame->instruction);
+    if (module) {
+      std::map<string, string>::const_iterator loaded =
+          loaded_identifiers_.find(module->code_file());
+      if (loaded != loaded_identifiers_.end() &&
+          loaded->second != module->debug_identifier()) {
+        return false;
+      }
+    }
+    return StackFrameSymbolizer::FillSourceLineInfoFromLoadedModule(
+        modules, unloaded_modules, frame, result);
+  }
+
+ private:
+  // Maps the code file of each module resident in the resolver to the debug
+  // identifier it was loaded for.
+  std::map<string, string> loaded_identifiers_;
+};
+
+// Holds the state shared by every minidump processed in one run.
+class BatchProcessor {
+ public:
+  explicit BatchProcessor(const Options& options)
+      : options_(options),
+        symbol_supplier_(CreateSymbolSupplier(options)),
+        resolver_(options.use_serialized_symbols ?
+                  static_cast<SourceLineResolverBase*>(&fast_resolver_) :
+                  &basic_resolver_),
+        symbolizer_(symbol_supplier_.get(), resolver_),
+        processor_(&symbolizer_, true) {
+    processor_.set_max_stackwalk_threads(options.stackwalk_threads);
+    basic_resolver_.set_max_parse_threads(options.parse_threads);
+    basic_resolver_.set_lazy_loading(options.lazy_symbol_loading);
+    basic_resolver_.set_compact_range_maps(options.compact_symbols);
+    resolver_->set_symbol_data_budget(options.symbol_data_budget);
+    // Dumps in a batch mostly share builds, so with -r, frames symbolized
+    // for one dump are remembered for the next, sharing their names.
+    symbolizer_.set_memoize_frames(options.memoize_frames);
+    symbolizer_.set_keep_memo_across_dumps(options.memoize_frames);
+    symbolizer_.set_intern_names(options.memoize_frames);
+  }
+
+  // Processes the minidump at |path| and prints the results to stdout,
+  // followed by a terminating status line.  Returns true on success.
+  bool ProcessMinidump(const string& path) {
+    bool ok = PrintMinidumpProcess(path);
+    printf("==== %s %s\n", ok ? "OK" : "FAILED", path.c_str());
+    fflush(stdout);
+    BPLOG(INFO) << "Symbol cache: " << resolver_->module_cache_hits() <<
+                   " hits, " << resolver_->module_cache_misses() <<
+                   " misses, " << resolver_->module_cache_evictions() <<
+                   " evictions, " << resolver_->loaded_symbol_data() <<
+                   " bytes of symbols in memory";
+    BPLOG(INFO) << "CFI rule cache: " << resolver_->cfi_cache_hits() <<
+                   " hits, " << resolver_->cfi_cache_misses() << " misses";
+    BPLOG(INFO) << "Symbolized frame memo: " << symbolizer_.memo_hits() <<
+                   " hits, " << symbolizer_.memo_misses() << " misses";
+    return ok;
+  }
+
+  // Processes each minidump path read from |input| until end of file.
+  void ProcessStream(FILE* input) {
+    char* line = NULL;
+    size_t line_capacity = 0;
+    ssize_t length;
+    while ((length = getline(&line, &line_capacity, input)) != -1) {
+      while (length > 0 &&
+             (line[length - 1] == '\n' || line[length - 1] == '\r')) {
+        line[--length] = '\0';
+      }
+      if (length == 0)
+        continue;
+      ProcessMinidump(line);
+    }
+    free(line);
+  }
+
+ private:
+  static SymbolSupplier* CreateSymbolSupplier(const Options& options) {
+    if (options.symbol_paths.empty())
+      return NULL;
+    if (!options.use_serialized_symbols)
+      return new SimpleSymbolSupplier(options.symbol_paths);
+
+    FastSymbolSupplier* supplier = new FastSymbolSupplier(options.symbol_paths);
+    supplier->set_write_serialized_files(options.write_serialized_symbols);
+    return supplier;
+  }
+
+  bool PrintMinidumpProcess(const string& path) {
+    Minidump dump(path);
+    dump.set_use_memory_mapping(options_.use_memory_mapping);
+    if (!dump.Read()) {
+      BPLOG(ERROR) << "Minidump " << dump.path() << " could not be read";
+      return false;
+    }
+    ProcessState process_state;
+    if (processor_.Process(&dump, &process_state) !=
+        google_breakpad::PROCESS_OK) {
+      BPLOG(ERROR) << "MinidumpProcessor::Process failed";
+      return false;
+    }
+
+    if (options_.machine_readable) {
+      PrintProcessStateMachineReadable(process_state);
+    } else {
+      PrintProcessState(process_state, options_.output_stack_contents,
+                        resolver_);
+    }
+    return true;
+  }
+
+  const Options& options_;
+  scoped_ptr<SymbolSupplier> symbol_supplier_;
+  BasicSourceLineResolver basic_resolver_;
+  FastSourceLineResolver fast_resolver_;
+  // Whichever of the two resolvers above is in use.
+  SourceLineResolverBase* resolver_;
+  BatchStackFrameSymbolizer symbolizer_;
+  MinidumpProcessor processor_;
+};
+
+// Serves clients of the AF_UNIX socket at |options.socket_path| one at a
+// time.  Each client writes minidump paths, one per line, and receives the
+// results on the same connection.  Only returns if the socket cannot be set
+// up, or accepting clients fails with an error that is not transient.
+bool ServeSocket(const Options& options, BatchProcessor* batch) {
+  struct sockaddr_un address;
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  if (options.socket_path.size() >= sizeof(address.sun_path)) {
+    BPLOG(ERROR) << "Socket path " << options.socket_path << " is too long";
+    return false;
+  }
+  strncpy(address.sun_path, options.socket_path.c_str(),
+          sizeof(address.sun_path) - 1);
+
+  int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (listener == -1) {
+    BPLOG(ERROR) << "socket: " << strerror(errno);
+    return false;
+  }
+  unlink(options.socket_path.c_str());
+  if (bind(listener, reinterpret_cast<struct sockaddr*>(&address),
+           sizeof(address)) == -1 ||
+      listen(listener, SOMAXCONN) == -1) {
+    BPLOG(ERROR) << "Could not listen on " << options.socket_path << ": " <<
+                    strerror(errno);
+    close(listener);
+    return false;
+  }
+
+  // A client that goes away mid-result must not take the daemon with it.
+  signal(SIGPIPE, SIG_IGN);
+
+  // The printing routines write to stdout, so stdout is pointed at each
+  // client for the duration of its connection.
+  fflush(stdout);
+  int saved_stdout = dup(STDOUT_FILENO);
+  for (;;) {
+    int client = accept(listener, NULL, NULL);
+    if (client == -1) {
+      if (errno == EINTR || errno == ECONNABORTED)
+        continue;
+      BPLOG(ERROR) << "accept: " << strerror(errno);
+      if (errno == EMFILE || errno == ENFILE || errno == ENOBUFS ||
+          errno == ENOMEM) {
+        // Wait for descriptors or memory to be freed, rather than spin.
+        sleep(1);
+        continue;
+      }
+      close(listener);
+      close(saved_stdout);
+      return false;
+    }
+
+    FILE* input = fdopen(client, "r");
+    if (!input) {
+      close(client);
+      continue;
+    }
+    dup2(client, STDOUT_FILENO);
+    batch->ProcessStream(input);
+    fflush(stdout);
+    dup2(saved_stdout, STDOUT_FILENO);
+    fclose(input);
+  }
+}
+
+}  // namespace
+
+static void Usage(int argc, const char *argv[], bool error) {
+  fprintf(error ? stderr : stdout,
+          "Usage: %s [options] [symbol-path ...]\n"
+          "\n"
+          "Output a stack trace for each minidump path read from stdin, one\n"
+          "per line, keeping symbols loaded between minidumps\n"
+          "\n"
+          "Options:\n"
+          "\n"
+          "  -m         Output in machine-readable format\n"
+          "  -s         Output stack contents\n"
+          "  -M         Read minidumps through a memory mapping\n"
+          "  -j <n>     Walk thread stacks on up to n threads (default 1)\n"
+          "  -p <n>     Parse each text symbol file on up to n threads\n"
+          "             (default 1)\n"
+          "  -l         Load text symbol files lazily, parsing only the\n"
+          "             records looked up\n"
+          "  -C         Store functions and lines from text symbol files in\n"
+          "             compact sorted arrays\n"
+          "  -c <mb>    Keep loaded modules within about mb megabytes of\n"
+          "             estimated memory, unloading the least recently used\n"
+          "             modules first\n"
+          "  -F         Use serialized symbol files (see sym_to_fast), parsing\n"
+          "             text symbol files only where there are none\n"
+          "  -w         With -F, save serialized symbol files for text symbol\n"
+          "             files that had none\n"
+          "  -S <path>  Read minidump paths from clients of a local socket\n"
+          "             at path instead of stdin\n"
+          "  -r         Remember symbolized frames, reusing them for later\n"
+          "             frames at the same addresses in any minidump, and\n"
+          "             share their names\n",
+          google_breakpad::BaseName(argv[0]).c_str());
+}
+
+static void SetupOptions(int argc, const char *argv[], Options* options) {
+  int ch;
+
+  options->machine_readable = false;
+  options->output_stack_contents = false;
+  options->use_memory_mapping = false;
+  options->stackwalk_threads = 1;
+  options->parse_threads = 1;
+  options->lazy_symbol_loading = false;
+  options->compact_symbols = false;
+  options->symbol_data_budget = 0;
+  options->use_serialized_symbols = false;
+  options->write_serialized_symbols = false;
+  options->memoize_frames = false;
+
+  while ((ch = getopt(argc, (char * const *)argv, "hmsMj:p:lCc:FwS:r")) != -1) {
+    switch (ch) {
+      case 'h':
+        Usage(argc, argv, false);
+        exit(0);
+        break;
+
+      case 'm':
+        options->machine_readable = true;
+        break;
+      case 's':
+        options->output_stack_contents = true;
+        break;
+      case 'M':
+        options->use_memory_mapping = true;
+        break;
+      case 'j': {
+        char* end;
+        long threads = strtol(optarg, &end, 10);
+        if (*end != '\0' || threads < 1) {
+          fprintf(stderr, "%s: Invalid thread count %s\n", argv[0], optarg);
+          Usage(argc, argv, true);
+          exit(1);
+        }
+        options->stackwalk_threads = static_cast<unsigned int>(threads);
+        break;
+      }
+      case 'p': {
+        char* end;
+        long threads = strtol(optarg, &end, 10);
+        if (*end != '\0' || threads < 1) {
+          fprintf(stderr, "%s: Invalid thread count %s\n", argv[0], optarg);
+          Usage(argc, argv, true);
+          exit(1);
+        }
+        options->parse_threads = static_cast<unsigned int>(threads);
+        break;
+      }
+      case 'l':
+        options->lazy_symbol_loading = true;
+        break;
+      case 'C':
+        options->compact_symbols = true;
+        break;
+      case 'c': {
+        char* end;
+        long megabytes = strtol(optarg, &end, 10);
+        if (*end != '\0' || megabytes < 1) {
+          fprintf(stderr, "%s: Invalid symbol data budget %s\n", argv[0],
+                  optarg);
+          Usage(argc, argv, true);
+          exit(1);
+        }
+        options->symbol_data_budget = static_cast<size_t>(megabytes) << 20;
+        break;
+      }
+      case 'F':
+        options->use_serialized_symbols = true;
+        break;
+      case 'w':
+        options->write_serialized_symbols = true;
+        break;
+      case 'S':
+        options->socket_path = optarg;
+        break;
+      case 'r':
+        options->memoize_frames = true;
+        break;
+
+      case '?':
+        Usage(argc, argv, true);
+        exit(1);
+        break;
+    }
+  }
+
+  for (int argi = optind; argi < argc; ++argi)
+    options->symbol_paths.push_back(argv[argi]);
+}
+
+int main(int argc, const char* argv[]) {
+  Options options;
+  SetupOptions(argc, argv, &options);
+
+  // Increase the maximum number of threads and regions.
+  MinidumpThreadList::set_max_threads(std::numeric_limits<uint32_t>::max());
+  MinidumpMemoryList::set_max_regions(std::numeric_limits<uint32_t>::max());
+
+  BatchProcessor batch(options);
+  if (!options.socket_path.empty())
+    return ServeSocket(options, &batch) ? 0 : 1;
+
+  batch.ProcessStream(stdin);
+  return 0;
+}
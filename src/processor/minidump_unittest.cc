@@ -34,18 +34,24 @@
 #include <fstream>
 #include <sstream>
 #include <stdlib.h>
+#include <string.h>
 #include <string>
 #include <vector>
 
 #include "breakpad_googletest_includes.h"
+#include "common/scoped_ptr.h"
 #include "common/using_std_string.h"
 #include "google_breakpad/common/minidump_format.h"
+#include "google_breakpad/processor/code_module.h"
+#include "google_breakpad/processor/code_modules.h"
 #include "google_breakpad/processor/minidump.h"
 #include "processor/logging.h"
 #include "processor/synth_minidump.h"
 
 namespace {
 
+using google_breakpad::CodeModule;
+using google_breakpad::CodeModules;
 using google_breakpad::Minidump;
 using google_breakpad::MinidumpContext;
 using google_breakpad::MinidumpException;
@@ -71,6 +77,7 @@ using google_breakpad::SynthMinidump::Stream;
 using google_breakpad::SynthMinidump::String;
 using google_breakpad::SynthMinidump::SystemInfo;
 using google_breakpad::SynthMinidump::Thread;
+using google_breakpad::scoped_ptr;
 using google_breakpad::test_assembler::kBigEndian;
 using google_breakpad::test_assembler::kLittleEndian;
 using std::ifstream;
@@ -130,6 +137,114 @@ TEST_F(MinidumpTest, TestMinidumpFromStream) {
   //TODO: add more checks here
 }
 
+TEST_F(MinidumpTest, TestMinidumpMemoryMapped) {
+  Minidump streamed(minidump_file_);
+  ASSERT_TRUE(streamed.Read());
+  ASSERT_FALSE(streamed.IsMemoryMapped());
+
+  Minidump mapped(minidump_file_);
+  mapped.set_use_memory_mapping(true);
+  ASSERT_TRUE(mapped.Read());
+  ASSERT_TRUE(mapped.IsMemoryMapped());
+  ASSERT_EQ(streamed.GetDirectoryEntryCount(),
+            mapped.GetDirectoryEntryCount());
+
+  MinidumpModuleList* streamed_modules = streamed.GetModuleList();
+  MinidumpModuleList* mapped_modules = mapped.GetModuleList();
+  ASSERT_TRUE(streamed_modules != NULL);
+  ASSERT_TRUE(mapped_modules != NULL);
+  ASSERT_EQ(streamed_modules->module_count(), mapped_modules->module_count());
+  int in_place_cv_records = 0;
+  for (unsigned int i = 0; i < mapped_modules->module_count(); ++i) {
+    EXPECT_EQ(streamed_modules->GetModuleAtIndex(i)->code_file(),
+              mapped_modules->GetModuleAtIndex(i)->code_file());
+    EXPECT_EQ(streamed_modules->GetModuleAtIndex(i)->debug_identifier(),
+              mapped_modules->GetModuleAtIndex(i)->debug_identifier());
+
+    // The CodeView record is used in place in the mapping when it's
+    // aligned well enough to be accessed as a structure there.
+    MinidumpModule* streamed_module =
+        const_cast<MinidumpModule*>(streamed_modules->GetModuleAtIndex(i));
+    MinidumpModule* mapped_module =
+        const_cast<MinidumpModule*>(mapped_modules->GetModuleAtIndex(i));
+    uint32_t streamed_cv_size = 0, mapped_cv_size = 0;
+    const uint8_t* streamed_cv =
+        streamed_module->GetCVRecord(&streamed_cv_size);
+    const uint8_t* mapped_cv = mapped_module->GetCVRecord(&mapped_cv_size);
+    ASSERT_TRUE(streamed_cv != NULL);
+    ASSERT_TRUE(mapped_cv != NULL);
+    ASSERT_EQ(streamed_cv_size, mapped_cv_size);
+    EXPECT_EQ(0, memcmp(streamed_cv, mapped_cv, mapped_cv_size));
+    MDRVA cv_rva = mapped_module->module()->cv_record.rva;
+    if (cv_rva % sizeof(uint32_t) == 0) {
+      EXPECT_EQ(mapped.GetMappedBytes(cv_rva, mapped_cv_size), mapped_cv);
+      ++in_place_cv_records;
+    } else {
+      EXPECT_NE(mapped.GetMappedBytes(cv_rva, mapped_cv_size), mapped_cv);
+    }
+  }
+  EXPECT_LT(0, in_place_cv_records);
+
+  MinidumpThreadList* streamed_threads = streamed.GetThreadList();
+  MinidumpThreadList* mapped_threads = mapped.GetThreadList();
+  ASSERT_TRUE(streamed_threads != NULL);
+  ASSERT_TRUE(mapped_threads != NULL);
+  ASSERT_EQ(streamed_threads->thread_count(), mapped_threads->thread_count());
+  for (unsigned int i = 0; i < mapped_threads->thread_count(); ++i) {
+    MinidumpMemoryRegion* streamed_stack =
+        streamed_threads->GetThreadAtIndex(i)->GetMemory();
+    MinidumpMemoryRegion* mapped_stack =
+        mapped_threads->GetThreadAtIndex(i)->GetMemory();
+    ASSERT_TRUE(streamed_stack != NULL);
+    ASSERT_TRUE(mapped_stack != NULL);
+    ASSERT_EQ(streamed_stack->GetBase(), mapped_stack->GetBase());
+    ASSERT_EQ(streamed_stack->GetSize(), mapped_stack->GetSize());
+
+    // The mapped region is served from the mapping without a copy.
+    const uint8_t* mapped_bytes = mapped_stack->GetMemory();
+    ASSERT_TRUE(mapped_bytes != NULL);
+    EXPECT_EQ(mapped_bytes, mapped_stack->GetMemory());
+    EXPECT_EQ(0, memcmp(streamed_stack->GetMemory(), mapped_bytes,
+                        mapped_stack->GetSize()));
+
+    uint32_t streamed_word, mapped_word;
+    ASSERT_TRUE(streamed_stack->GetMemoryAtAddress(streamed_stack->GetBase(),
+                                                   &streamed_word));
+    ASSERT_TRUE(mapped_stack->GetMemoryAtAddress(mapped_stack->GetBase(),
+                                                 &mapped_word));
+    EXPECT_EQ(streamed_word, mapped_word);
+  }
+}
+
+// A mapped minidump doesn't read its memory through a page cache.
+TEST_F(MinidumpTest, TestMinidumpMemoryMappedNotPaged) {
+  Minidump mapped(minidump_file_);
+  mapped.set_use_memory_mapping(true);
+  mapped.set_memory_page_cache(4096, 16);
+  ASSERT_TRUE(mapped.IsMemoryPaged());
+  ASSERT_TRUE(mapped.Read());
+  ASSERT_TRUE(mapped.IsMemoryMapped());
+  EXPECT_FALSE(mapped.IsMemoryPaged());
+
+  MinidumpThreadList* threads = mapped.GetThreadList();
+  ASSERT_TRUE(threads != NULL);
+  ASSERT_LT(0U, threads->thread_count());
+  MinidumpMemoryRegion* stack = threads->GetThreadAtIndex(0)->GetMemory();
+  ASSERT_TRUE(stack != NULL);
+  uint32_t word;
+  ASSERT_TRUE(stack->GetMemoryAtAddress(stack->GetBase(), &word));
+  const uint8_t* bytes = stack->GetMemory();
+  ASSERT_TRUE(bytes != NULL);
+  uint32_t mapped_word;
+  memcpy(&mapped_word, bytes, sizeof(mapped_word));
+  ASSERT_FALSE(mapped.swap());
+  EXPECT_EQ(mapped_word, word);
+
+  // Asking for a cache once the minidump is mapped has no effect.
+  mapped.set_memory_page_cache(4096, 16);
+  EXPECT_FALSE(mapped.IsMemoryPaged());
+}
+
 TEST(Dump, ReadBackEmpty) {
   Dump dump(0);
   dump.Finish();
@@ -217,6 +332,56 @@ TEST(Dump, OneMemory) {
   ASSERT_TRUE(memcmp("memory contents", region1_bytes, 15) == 0);
 }
 
+TEST(Dump, PagedMemory) {
+  Dump dump(0, kBigEndian);
+  Memory memory1(dump, 0x1000);
+  Memory memory2(dump, 0x2000);
+  for (uint32_t i = 0; i < 64; ++i) {
+    memory1.D32(0x10000000 + i);
+    memory2.D32(0x20000000 + i);
+  }
+  dump.Add(&memory1);
+  dump.Add(&memory2);
+  dump.Finish();
+
+  string contents;
+  ASSERT_TRUE(dump.GetContents(&contents));
+  istringstream minidump_stream(contents);
+  Minidump minidump(minidump_stream);
+  minidump.set_memory_page_cache(32, 2);
+  ASSERT_TRUE(minidump.IsMemoryPaged());
+  ASSERT_TRUE(minidump.Read());
+
+  MinidumpMemoryList *memory_list = minidump.GetMemoryList();
+  ASSERT_TRUE(memory_list != NULL);
+  ASSERT_EQ(2U, memory_list->region_count());
+
+  // Regions larger than max_bytes can't be read whole, but can still be
+  // read a page at a time.
+  uint32_t max_bytes = MinidumpMemoryRegion::max_bytes();
+  MinidumpMemoryRegion::set_max_bytes(64);
+  for (uint32_t i = 0; i < 64; ++i) {
+    uint32_t value;
+    ASSERT_TRUE(memory_list->GetMemoryRegionAtIndex(0)->
+                GetMemoryAtAddress(0x1000 + i * 4, &value));
+    EXPECT_EQ(0x10000000 + i, value);
+    ASSERT_TRUE(memory_list->GetMemoryRegionAtIndex(1)->
+                GetMemoryAtAddress(0x2000 + i * 4, &value));
+    EXPECT_EQ(0x20000000 + i, value);
+  }
+  uint64_t value64;
+  ASSERT_TRUE(memory_list->GetMemoryRegionAtIndex(1)->
+              GetMemoryAtAddress(0x20fc - 4, &value64));
+  EXPECT_EQ(0x2000003e2000003fULL, value64);
+  EXPECT_FALSE(memory_list->GetMemoryRegionAtIndex(1)->
+               GetMemoryAtAddress(0x20fc - 3, &value64));
+  EXPECT_TRUE(memory_list->GetMemoryRegionAtIndex(1)->GetMemory() == NULL);
+  MinidumpMemoryRegion::set_max_bytes(max_bytes);
+
+  minidump.set_memory_page_cache(32, 0);
+  EXPECT_FALSE(minidump.IsMemoryPaged());
+}
+
 // One thread --- and its requisite entourage.
 TEST(Dump, OneThread) {
   Dump dump(0, kLittleEndian);
@@ -966,6 +1131,27 @@ TEST(Dump, BigDump) {
   EXPECT_EQ(0x95fc1544da321b6cULL,
             md_module_list->GetModuleAtIndex(2)->base_address());
 
+  // Look the modules up by address, in the list and in a copy of it,
+  // repeating and alternating lookups so that the module last found is
+  // sometimes the right one and sometimes not.
+  scoped_ptr<const CodeModules> module_copy(md_module_list->Copy());
+  const CodeModules *module_lists[] = { md_module_list, module_copy.get() };
+  for (size_t list = 0; list < 2; ++list) {
+    const CodeModules *modules = module_lists[list];
+    for (int pass = 0; pass < 2; ++pass) {
+      for (unsigned int i = 0; i < 3; ++i) {
+        const CodeModule *module = md_module_list->GetModuleAtIndex(i);
+        uint64_t base = module->base_address();
+        uint64_t high = base + module->size() - 1;
+        EXPECT_EQ(base, modules->GetModuleForAddress(base)->base_address());
+        EXPECT_EQ(base, modules->GetModuleForAddress(high)->base_address());
+        EXPECT_EQ(NULL, modules->GetModuleForAddress(high + 1));
+        EXPECT_EQ(base, modules->GetModuleForAddress(high)->base_address());
+        EXPECT_EQ(NULL, modules->GetModuleForAddress(base - 1));
+      }
+    }
+  }
+
   // Check unloaded modules
   MinidumpUnloadedModuleList *md_unloaded_module_list =
       minidump.GetUnloadedModuleList();
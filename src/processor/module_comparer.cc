@@ -55,6 +55,7 @@ namespace google_breakpad {
 bool ModuleComparer::Compare(const string &symbol_data) {
   scoped_ptr<BasicModule> basic_module(new BasicModule("test_module"));
   scoped_ptr<FastModule> fast_module(new FastModule("test_module"));
+  basic_module->set_compact_range_maps(compact_range_maps_);
 
   // Load symbol data into basic_module
   scoped_array<char> buffer(new char[symbol_data.size() + 1]);
@@ -105,22 +106,23 @@ bool ModuleComparer::CompareModule(const BasicModule *basic_module,
     ASSERT_TRUE(iter2 == fast_module->files_.end());
   }
 
-  // Compare functions_:
+  // Compare functions_, by index so that compact range maps are compared
+  // as well:
   {
-    RangeMap<MemAddr, linked_ptr<BasicFunc> >::MapConstIterator iter1;
     StaticRangeMap<MemAddr, FastFunc>::MapConstIterator iter2;
-    iter1 = basic_module->functions_.map_.begin();
     iter2 = fast_module->functions_.map_.begin();
-    while (iter1 != basic_module->functions_.map_.end()
-        && iter2 != fast_module->functions_.map_.end()) {
-      ASSERT_TRUE(iter1->first == iter2.GetKey());
-      ASSERT_TRUE(iter1->second.base() == iter2.GetValuePtr()->base());
-      ASSERT_TRUE(CompareFunction(
-          iter1->second.entry().get(), iter2.GetValuePtr()->entryptr()));
-      ++iter1;
+    for (int i = 0; i < basic_module->functions_.GetCount(); ++i) {
+      ASSERT_TRUE(iter2 != fast_module->functions_.map_.end());
+      linked_ptr<BasicFunc> func;
+      MemAddr base, size;
+      ASSERT_TRUE(basic_module->functions_.RetrieveRangeAtIndex(
+          i, &func, &base, NULL, &size));
+      ASSERT_TRUE(base + size - 1 == iter2.GetKey());
+      ASSERT_TRUE(base == iter2.GetValuePtr()->base());
+      ASSERT_TRUE(CompareFunction(func.get(),
+                                  iter2.GetValuePtr()->entryptr()));
       ++iter2;
     }
-    ASSERT_TRUE(iter1 == basic_module->functions_.map_.end());
     ASSERT_TRUE(iter2 == fast_module->functions_.map_.end());
   }
 
@@ -196,21 +198,20 @@ bool ModuleComparer::CompareFunction(const BasicFunc *basic_func,
   ASSERT_TRUE(basic_func->address == fast_func->address);
   ASSERT_TRUE(basic_func->size == fast_func->size);
 
-  // compare range map of lines:
-  RangeMap<MemAddr, linked_ptr<BasicLine> >::MapConstIterator iter1;
+  // compare range map of lines, by index as for functions:
   StaticRangeMap<MemAddr, FastLine>::MapConstIterator iter2;
-  iter1 = basic_func->lines.map_.begin();
   iter2 = fast_func->lines.map_.begin();
-  while (iter1 != basic_func->lines.map_.end()
-      && iter2 != fast_func->lines.map_.end()) {
-    ASSERT_TRUE(iter1->first == iter2.GetKey());
-    ASSERT_TRUE(iter1->second.base() == iter2.GetValuePtr()->base());
-    ASSERT_TRUE(CompareLine(iter1->second.entry().get(),
-                            iter2.GetValuePtr()->entryptr()));
-    ++iter1;
+  for (int i = 0; i < basic_func->lines.GetCount(); ++i) {
+    ASSERT_TRUE(iter2 != fast_func->lines.map_.end());
+    BasicLine line;
+    MemAddr base, size;
+    ASSERT_TRUE(basic_func->lines.RetrieveRangeAtIndex(i, &line, &base, NULL,
+                                                       &size));
+    ASSERT_TRUE(base + size - 1 == iter2.GetKey());
+    ASSERT_TRUE(base == iter2.GetValuePtr()->base());
+    ASSERT_TRUE(CompareLine(&line, iter2.GetValuePtr()->entryptr()));
     ++iter2;
   }
-  ASSERT_TRUE(iter1 == basic_func->lines.map_.end());
   ASSERT_TRUE(iter2 == fast_func->lines.map_.end());
 
   delete fast_func;
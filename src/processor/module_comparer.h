@@ -53,7 +53,8 @@ namespace google_breakpad {
 class ModuleComparer {
  public:
   ModuleComparer(): fast_resolver_(new FastSourceLineResolver),
-                   basic_resolver_(new BasicSourceLineResolver) { }
+                   basic_resolver_(new BasicSourceLineResolver),
+                   compact_range_maps_(false) { }
   ~ModuleComparer() {
     delete fast_resolver_;
     delete basic_resolver_;
@@ -66,6 +67,10 @@ class ModuleComparer {
   // return true if both modules contain exactly same data.
   bool Compare(const string &symbol_data);
 
+  // Whether Compare loads the basic module's functions and lines into
+  // compact range maps; see BasicSourceLineResolver::set_compact_range_maps.
+  void set_compact_range_maps(bool compact) { compact_range_maps_ = compact; }
+
  private:
   typedef BasicSourceLineResolver::Module BasicModule;
   typedef FastSourceLineResolver::Module FastModule;
@@ -91,6 +96,7 @@ class ModuleComparer {
   FastSourceLineResolver *fast_resolver_;
   BasicSourceLineResolver *basic_resolver_;
   ModuleSerializer serializer_;
+  bool compact_range_maps_;
 };
 
 }  // namespace google_breakpad
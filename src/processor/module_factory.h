@@ -51,11 +51,35 @@ class ModuleFactory {
 
 class BasicModuleFactory : public ModuleFactory {
  public:
+  BasicModuleFactory()
+      : max_parse_threads_(1), lazy_loading_(false),
+        compact_range_maps_(false) { }
   virtual ~BasicModuleFactory() { }
   virtual BasicSourceLineResolver::Module* CreateModule(
       const string &name) const {
-    return new BasicSourceLineResolver::Module(name);
+    BasicSourceLineResolver::Module *module =
+        new BasicSourceLineResolver::Module(name);
+    module->set_max_parse_threads(max_parse_threads_);
+    module->set_lazy_loading(lazy_loading_);
+    module->set_compact_range_maps(compact_range_maps_);
+    return module;
   }
+
+  void set_max_parse_threads(unsigned int max_threads) {
+    max_parse_threads_ = max_threads ? max_threads : 1;
+  }
+  unsigned int max_parse_threads() const { return max_parse_threads_; }
+
+  void set_lazy_loading(bool lazy) { lazy_loading_ = lazy; }
+  bool lazy_loading() const { return lazy_loading_; }
+
+  void set_compact_range_maps(bool compact) { compact_range_maps_ = compact; }
+  bool compact_range_maps() const { return compact_range_maps_; }
+
+ private:
+  unsigned int max_parse_threads_;
+  bool lazy_loading_;
+  bool compact_range_maps_;
 };
 
 class FastModuleFactory : public ModuleFactory {
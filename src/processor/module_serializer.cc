@@ -45,7 +45,7 @@ namespace google_breakpad {
 
 // Definition of static member variable in SimplerSerializer<Funcion>, which
 // is declared in file "simple_serializer-inl.h"
-RangeMapSerializer< MemAddr, linked_ptr<BasicSourceLineResolver::Line> >
+RangeMapSerializer<MemAddr, BasicSourceLineResolver::Line>
 SimpleSerializer<BasicSourceLineResolver::Function>::range_map_serializer_;
 
 size_t ModuleSerializer::SizeOf(const BasicSourceLineResolver::Module &module) {
@@ -102,6 +102,15 @@ char *ModuleSerializer::Write(const BasicSourceLineResolver::Module &module,
 
 char* ModuleSerializer::Serialize(
     const BasicSourceLineResolver::Module &module, unsigned int *size) {
+  // A lazily loaded module keeps most of its records unparsed, in maps that
+  // are not serialized.
+  if (module.lazy_) {
+    BPLOG(ERROR) << "ModuleSerializer: cannot serialize lazily loaded "
+                 << "module " << module.name_;
+    if (size) *size = 0;
+    return NULL;
+  }
+
   // Compute size of memory to allocate.
   unsigned int size_to_alloc = SizeOf(module);
 
@@ -0,0 +1,352 @@
+// Copyright (c) 2026 Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// postfix_program.cc: Implementation of PostfixProgram.
+// See postfix_program.h for details.
+
+#include "processor/postfix_program.h"
+
+#include <assert.h>
+#include <stdio.h>
+
+#include <sstream>
+
+#include "google_breakpad/processor/memory_region.h"
+#include "processor/logging.h"
+
+namespace google_breakpad {
+
+using std::istringstream;
+
+namespace {
+
+// Read TOKEN as a literal the way PostfixEvaluator does, so that the
+// compiled program treats every token exactly as the evaluator would.
+template<typename ValueType>
+bool ParseLiteral(const string &token, ValueType *value) {
+  istringstream token_stream(token);
+  ValueType literal = ValueType();
+  bool negative;
+  if (token_stream.peek() == '-') {
+    negative = true;
+    token_stream.get();
+  } else {
+    negative = false;
+  }
+  if (!(token_stream >> literal) || token_stream.peek() != EOF)
+    return false;
+  *value = negative ? -literal : literal;
+  return true;
+}
+
+// Look identifiers up by name in a map.
+template<typename ValueType>
+class MapLookup {
+ public:
+  MapLookup(const map<string, ValueType> &dictionary,
+            const vector<string> &identifiers)
+      : dictionary_(dictionary), identifiers_(identifiers) {}
+
+  bool operator()(uint32_t identifier, ValueType *value) const {
+    typename map<string, ValueType>::const_iterator iterator =
+        dictionary_.find(identifiers_[identifier]);
+    if (iterator == dictionary_.end()) {
+      BPLOG(INFO) << "Identifier " << identifiers_[identifier] <<
+                     " not in dictionary";
+      return false;
+    }
+    *value = iterator->second;
+    return true;
+  }
+
+ private:
+  const map<string, ValueType> &dictionary_;
+  const vector<string> &identifiers_;
+};
+
+// Look identifiers up in a RegisterDictionary, by the indices
+// PostfixProgram::Bind found for them.
+template<typename ValueType>
+class RegisterLookup {
+ public:
+  RegisterLookup(const RegisterDictionary<ValueType> &dictionary,
+                 const vector<int> &indices,
+                 const vector<string> &identifiers)
+      : dictionary_(dictionary), indices_(indices),
+        identifiers_(identifiers) {}
+
+  bool operator()(uint32_t identifier, ValueType *value) const {
+    if (!dictionary_.Get(indices_[identifier], value)) {
+      BPLOG(INFO) << "Identifier " << identifiers_[identifier] <<
+                     " not in dictionary";
+      return false;
+    }
+    return true;
+  }
+
+ private:
+  const RegisterDictionary<ValueType> &dictionary_;
+  const vector<int> &indices_;
+  const vector<string> &identifiers_;
+};
+
+}  // namespace
+
+const size_t PostfixProgram::kMaxStackDepth;
+
+bool PostfixProgram::Compile(const string &expression) {
+  expression_.clear();
+  code_.clear();
+  literals_.clear();
+  identifiers_.clear();
+
+  vector<Instruction> code;
+  size_t depth = 0;
+  bool compiled = true;
+  istringstream stream(expression);
+  string token;
+  while (compiled && stream >> token) {
+    // Assignment, possibly smashed up against the next token, can't be
+    // compiled.
+    if (token[0] == '=') {
+      compiled = false;
+      break;
+    }
+
+    Opcode opcode;
+    if (token == "+")
+      opcode = OP_ADD;
+    else if (token == "-")
+      opcode = OP_SUBTRACT;
+    else if (token == "*")
+      opcode = OP_MULTIPLY;
+    else if (token == "/")
+      opcode = OP_DIVIDE_QUOTIENT;
+    else if (token == "%")
+      opcode = OP_DIVIDE_MODULUS;
+    else if (token == "@")
+      opcode = OP_ALIGN;
+    else if (token == "^")
+      opcode = OP_DEREFERENCE;
+    else if (token == ".cfa")
+      opcode = OP_PUSH_CFA;
+    else
+      opcode = OP_PUSH_LITERAL;
+
+    switch (opcode) {
+      case OP_PUSH_LITERAL: {
+        Literal literal;
+        if (!ParseLiteral(token, &literal.value64)) {
+          code.push_back(Instruction(OP_PUSH_IDENTIFIER,
+                                     AddIdentifier(token)));
+        } else {
+          literal.is_value32 = ParseLiteral(token, &literal.value32);
+          literal.identifier =
+              literal.is_value32 ? 0 : AddIdentifier(token);
+          code.push_back(Instruction(OP_PUSH_LITERAL, literals_.size()));
+          literals_.push_back(literal);
+        }
+        depth++;
+        break;
+      }
+      case OP_PUSH_CFA:
+        code.push_back(Instruction(OP_PUSH_CFA, AddIdentifier(token)));
+        depth++;
+        break;
+      case OP_DEREFERENCE:
+        compiled = depth >= 1;
+        code.push_back(Instruction(opcode, 0));
+        break;
+      default:
+        compiled = depth >= 2;
+        code.push_back(Instruction(opcode, 0));
+        depth--;
+        break;
+    }
+    if (depth > kMaxStackDepth)
+      compiled = false;
+  }
+
+  // A program must yield exactly one value.
+  if (!compiled || depth != 1) {
+    literals_.clear();
+    identifiers_.clear();
+    return false;
+  }
+
+  expression_ = expression;
+  code_.swap(code);
+  return true;
+}
+
+uint32_t PostfixProgram::AddIdentifier(const string &identifier) {
+  for (size_t i = 0; i < identifiers_.size(); ++i) {
+    if (identifiers_[i] == identifier)
+      return i;
+  }
+  identifiers_.push_back(identifier);
+  return identifiers_.size() - 1;
+}
+
+void PostfixProgram::Bind(const RegisterTable &table,
+                          vector<int> *indices) const {
+  indices->resize(identifiers_.size());
+  for (size_t i = 0; i < identifiers_.size(); ++i)
+    (*indices)[i] = table.IndexOf(identifiers_[i]);
+}
+
+template<typename ValueType>
+bool PostfixProgram::Evaluate(const map<string, ValueType> &dictionary,
+                              const ValueType *cfa,
+                              const MemoryRegion &memory,
+                              ValueType *result) const {
+  return EvaluateInternal(MapLookup<ValueType>(dictionary, identifiers_),
+                          cfa, memory, result);
+}
+
+template<typename ValueType>
+bool PostfixProgram::Evaluate(const RegisterDictionary<ValueType> &dictionary,
+                              const vector<int> &indices,
+                              const ValueType *cfa,
+                              const MemoryRegion &memory,
+                              ValueType *result) const {
+  assert(indices.size() == identifiers_.size());
+  return EvaluateInternal(
+      RegisterLookup<ValueType>(dictionary, indices, identifiers_),
+      cfa, memory, result);
+}
+
+template<typename ValueType, typename Lookup>
+bool PostfixProgram::EvaluateInternal(const Lookup &lookup,
+                                      const ValueType *cfa,
+                                      const MemoryRegion &memory,
+                                      ValueType *result) const {
+  if (code_.empty())
+    return false;
+
+  ValueType stack[kMaxStackDepth];
+  size_t depth = 0;
+  for (vector<Instruction>::const_iterator instruction = code_.begin();
+       instruction != code_.end(); ++instruction) {
+    switch (instruction->opcode) {
+      case OP_PUSH_LITERAL: {
+        const Literal &literal = literals_[instruction->operand];
+        if (!LiteralValue(literal, &stack[depth]) &&
+            !lookup(literal.identifier, &stack[depth])) {
+          return false;
+        }
+        depth++;
+        break;
+      }
+      case OP_PUSH_CFA:
+        if (cfa) {
+          stack[depth++] = *cfa;
+          break;
+        }
+        // Without a CFA, ".cfa" is an identifier like any other.
+        // Fall through.
+      case OP_PUSH_IDENTIFIER:
+        if (!lookup(instruction->operand, &stack[depth]))
+          return false;
+        depth++;
+        break;
+      case OP_DEREFERENCE: {
+        ValueType address = stack[depth - 1];
+        if (!memory.GetMemoryAtAddress(address, &stack[depth - 1])) {
+          BPLOG(ERROR) << "Could not dereference memory at address " <<
+                          HexString(address) << ": " << expression_;
+          return false;
+        }
+        break;
+      }
+      default: {
+        ValueType operand2 = stack[--depth];
+        ValueType &operand1 = stack[depth - 1];
+        switch (instruction->opcode) {
+          case OP_ADD:
+            operand1 += operand2;
+            break;
+          case OP_SUBTRACT:
+            operand1 -= operand2;
+            break;
+          case OP_MULTIPLY:
+            operand1 *= operand2;
+            break;
+          case OP_DIVIDE_QUOTIENT:
+          case OP_DIVIDE_MODULUS:
+            if (operand2 == 0) {
+              BPLOG(ERROR) << "Division by zero: " << expression_;
+              return false;
+            }
+            if (instruction->opcode == OP_DIVIDE_QUOTIENT)
+              operand1 /= operand2;
+            else
+              operand1 %= operand2;
+            break;
+          case OP_ALIGN:
+            operand1 &= static_cast<ValueType>(-1) ^ (operand2 - 1);
+            break;
+          default:
+            BPLOG(ERROR) << "Not reached!";
+            return false;
+        }
+        break;
+      }
+    }
+  }
+
+  *result = stack[0];
+  return true;
+}
+
+// Explicit instantiations for 32-bit and 64-bit architectures.
+template bool PostfixProgram::Evaluate<uint32_t>(
+    const map<string, uint32_t> &dictionary,
+    const uint32_t *cfa,
+    const MemoryRegion &memory,
+    uint32_t *result) const;
+template bool PostfixProgram::Evaluate<uint64_t>(
+    const map<string, uint64_t> &dictionary,
+    const uint64_t *cfa,
+    const MemoryRegion &memory,
+    uint64_t *result) const;
+template bool PostfixProgram::Evaluate<uint32_t>(
+    const RegisterDictionary<uint32_t> &dictionary,
+    const vector<int> &indices,
+    const uint32_t *cfa,
+    const MemoryRegion &memory,
+    uint32_t *result) const;
+template bool PostfixProgram::Evaluate<uint64_t>(
+    const RegisterDictionary<uint64_t> &dictionary,
+    const vector<int> &indices,
+    const uint64_t *cfa,
+    const MemoryRegion &memory,
+    uint64_t *result) const;
+
+}  // namespace google_breakpad
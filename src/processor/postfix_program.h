@@ -0,0 +1,167 @@
+// Copyright (c) 2026 Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// postfix_program.h: A postfix expression compiled for repeated evaluation.
+//
+// PostfixProgram compiles an expression in the language PostfixEvaluator
+// accepts into a short sequence of instructions, resolving each token
+// once.  Evaluating the program needs no tokenizing, string conversions,
+// or heap allocation, so it suits expressions such as STACK CFI rules that
+// are evaluated again and again.
+//
+// Only expressions that compute a single value are compiled: assignment
+// (=) isn't supported, and an expression that would leave anything other
+// than one value on the stack is rejected.  Callers should evaluate such
+// expressions with PostfixEvaluator instead.
+
+#ifndef PROCESSOR_POSTFIX_PROGRAM_H__
+#define PROCESSOR_POSTFIX_PROGRAM_H__
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "common/using_std_string.h"
+#include "google_breakpad/common/breakpad_types.h"
+#include "processor/register_dictionary.h"
+
+namespace google_breakpad {
+
+using std::map;
+using std::vector;
+
+class MemoryRegion;
+
+class PostfixProgram {
+ public:
+  PostfixProgram() {}
+
+  // Compile EXPRESSION, replacing any program compiled before.  Return
+  // false if EXPRESSION can't be compiled, leaving the program empty.
+  bool Compile(const string &expression);
+
+  // Return true if the program holds a compiled expression.
+  bool IsCompiled() const { return !code_.empty(); }
+
+  // Run the program, storing the value it computes in *RESULT.  Return
+  // false if evaluation fails, as PostfixEvaluator::EvaluateForValue
+  // would.  Identifiers are looked up in DICTIONARY, except that if CFA
+  // is non-NULL, the identifier ".cfa" has the value *CFA.  MEMORY is
+  // used for dereferencing (^).
+  template<typename ValueType>
+  bool Evaluate(const map<string, ValueType> &dictionary,
+                const ValueType *cfa,
+                const MemoryRegion &memory,
+                ValueType *result) const;
+
+  // Store in *INDICES the index in TABLE of each identifier the program
+  // uses, or -1 for any that isn't in TABLE, for the Evaluate below.
+  // Identifiers are resolved this way once, rather than on every
+  // evaluation.
+  void Bind(const RegisterTable &table, vector<int> *indices) const;
+
+  // As above, reading identifiers' values from DICTIONARY at the INDICES
+  // that Bind found in DICTIONARY's table.  This doesn't allocate memory.
+  template<typename ValueType>
+  bool Evaluate(const RegisterDictionary<ValueType> &dictionary,
+                const vector<int> &indices,
+                const ValueType *cfa,
+                const MemoryRegion &memory,
+                ValueType *result) const;
+
+  // The deepest stack a compiled program may need.  Deeper expressions
+  // aren't compiled.
+  static const size_t kMaxStackDepth = 32;
+
+ private:
+  enum Opcode {
+    OP_PUSH_LITERAL,     // Push literals_[operand].
+    OP_PUSH_IDENTIFIER,  // Push the value of identifiers_[operand].
+    OP_PUSH_CFA,         // Push the CFA, or the value of identifiers_[operand]
+                         // if there isn't one.
+    OP_ADD,
+    OP_SUBTRACT,
+    OP_MULTIPLY,
+    OP_DIVIDE_QUOTIENT,
+    OP_DIVIDE_MODULUS,
+    OP_ALIGN,
+    OP_DEREFERENCE
+  };
+
+  struct Instruction {
+    Instruction(Opcode op, uint32_t arg) : opcode(op), operand(arg) {}
+    Opcode opcode;
+    uint32_t operand;
+  };
+
+  // A literal, as PostfixEvaluator would read it for each value type.
+  // Literals too large for 32 bits are identifiers when evaluating with
+  // 32-bit values, and are looked up as identifiers_[identifier].
+  struct Literal {
+    uint64_t value64;
+    uint32_t value32;
+    bool is_value32;
+    uint32_t identifier;
+  };
+
+  // Implement both Evaluate methods.  LOOKUP stores the value of
+  // identifiers_[i] in *VALUE when called as LOOKUP(i, VALUE), returning
+  // false if the identifier has none.
+  template<typename ValueType, typename Lookup>
+  bool EvaluateInternal(const Lookup &lookup,
+                        const ValueType *cfa,
+                        const MemoryRegion &memory,
+                        ValueType *result) const;
+
+  // Add IDENTIFIER to identifiers_ if it isn't there already, and return
+  // its index.
+  uint32_t AddIdentifier(const string &identifier);
+
+  // Retrieve LITERAL's value as ValueType.  Return false if it must be
+  // looked up as an identifier instead.
+  static bool LiteralValue(const Literal &literal, uint32_t *value) {
+    *value = literal.value32;
+    return literal.is_value32;
+  }
+  static bool LiteralValue(const Literal &literal, uint64_t *value) {
+    *value = literal.value64;
+    return true;
+  }
+
+  // The expression this program was compiled from, for error messages.
+  string expression_;
+
+  vector<Instruction> code_;
+  vector<Literal> literals_;
+  vector<string> identifiers_;
+};
+
+}  // namespace google_breakpad
+
+#endif  // PROCESSOR_POSTFIX_PROGRAM_H__
@@ -0,0 +1,236 @@
+// Copyright (c) 2026 Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// postfix_program_unittest.cc: Unit tests for PostfixProgram.
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "breakpad_googletest_includes.h"
+#include "common/using_std_string.h"
+#include "google_breakpad/common/breakpad_types.h"
+#include "google_breakpad/processor/memory_region.h"
+#include "processor/postfix_evaluator-inl.h"
+#include "processor/postfix_program.h"
+
+namespace {
+
+using std::map;
+using google_breakpad::MemoryRegion;
+using google_breakpad::PostfixEvaluator;
+using google_breakpad::PostfixProgram;
+using google_breakpad::RegisterDictionary;
+using google_breakpad::RegisterTable;
+
+// Dereferencing an address yields one more than the address, except that
+// address 13 can't be read.
+class FakeMemoryRegion : public MemoryRegion {
+ public:
+  uint64_t GetBase() const { return 0; }
+  uint32_t GetSize() const { return 0; }
+  bool GetMemoryAtAddress(uint64_t address, uint8_t  *value) const {
+    return Get(address, value);
+  }
+  bool GetMemoryAtAddress(uint64_t address, uint16_t *value) const {
+    return Get(address, value);
+  }
+  bool GetMemoryAtAddress(uint64_t address, uint32_t *value) const {
+    return Get(address, value);
+  }
+  bool GetMemoryAtAddress(uint64_t address, uint64_t *value) const {
+    return Get(address, value);
+  }
+  void Print() const { }
+
+ private:
+  template<typename T> bool Get(uint64_t address, T *value) const {
+    if (address == 13)
+      return false;
+    *value = address + 1;
+    return true;
+  }
+};
+
+// Expressions that compile, and should evaluate just as
+// PostfixEvaluator::EvaluateForValue does.
+const char *kCompilable[] = {
+  "28907223",
+  "89854293 40010015 +",
+  "-870245 8769343 +",
+  "$ebp 4 - ^",
+  "$esp 12 +",
+  "$ebp 8 * 3 / 5 %",
+  "$esp 16 @",
+  "$esp $ebp -",
+  "4294967296 1 +",              // Too large for 32 bits.
+  "18446744073709551616",        // Too large for 64 bits.
+  "-1",
+  "12 1 + ^",
+  "13 ^",                        // Can't be dereferenced.
+  "$missing",
+  "4294967296",                  // Found in the dictionary for 32 bits.
+  ".cfa 8 +",
+  "\t$esp   4\n+ ",
+};
+
+// Expressions that don't compile.
+const char *kUncompilable[] = {
+  "",
+  "+",
+  "2 +",
+  "^",
+  "2 2",
+  "$T0 2 =",
+  "$T0 2 = $T0",
+  "$T0 2 =$T0",
+};
+
+template<typename ValueType>
+void CheckSameAsEvaluator() {
+  FakeMemoryRegion memory;
+  map<string, ValueType> dictionary;
+  dictionary["$ebp"] = 0xbfff0010;
+  dictionary["$esp"] = 0xbfff0000;
+  dictionary["4294967296"] = 7;
+  dictionary[".cfa"] = 0x10000;
+  PostfixEvaluator<ValueType> evaluator(&dictionary, &memory);
+
+  static const char *kNames[] = {
+    "$eax", "$ebp", "$esp", "4294967296", ".cfa", NULL
+  };
+  const RegisterTable table(kNames);
+  RegisterDictionary<ValueType> registers(&table);
+  for (typename map<string, ValueType>::const_iterator it =
+           dictionary.begin();
+       it != dictionary.end(); ++it) {
+    registers.Set(it->first, it->second);
+  }
+
+  for (size_t i = 0; i < sizeof(kCompilable) / sizeof(kCompilable[0]); i++) {
+    const string expression = kCompilable[i];
+    PostfixProgram program;
+    ASSERT_TRUE(program.Compile(expression)) << expression;
+    ASSERT_TRUE(program.IsCompiled());
+
+    ValueType expected = 0, actual = 0;
+    bool evaluated = evaluator.EvaluateForValue(expression, &expected);
+    EXPECT_EQ(evaluated,
+              program.Evaluate(dictionary, static_cast<ValueType*>(NULL),
+                               memory, &actual)) << expression;
+    if (evaluated) {
+      EXPECT_EQ(expected, actual) << expression;
+    }
+
+    // Evaluating with a RegisterDictionary, by the identifiers' indices,
+    // gives the same results.
+    std::vector<int> indices;
+    program.Bind(table, &indices);
+    actual = 0;
+    EXPECT_EQ(evaluated,
+              program.Evaluate(registers, indices,
+                               static_cast<ValueType*>(NULL), memory,
+                               &actual)) << expression;
+    if (evaluated) {
+      EXPECT_EQ(expected, actual) << expression;
+    }
+  }
+}
+
+TEST(PostfixProgram, SameAsEvaluator32) {
+  CheckSameAsEvaluator<uint32_t>();
+}
+
+TEST(PostfixProgram, SameAsEvaluator64) {
+  CheckSameAsEvaluator<uint64_t>();
+}
+
+TEST(PostfixProgram, Uncompilable) {
+  for (size_t i = 0; i < sizeof(kUncompilable) / sizeof(kUncompilable[0]);
+       i++) {
+    PostfixProgram program;
+    EXPECT_FALSE(program.Compile(kUncompilable[i])) << kUncompilable[i];
+    EXPECT_FALSE(program.IsCompiled());
+  }
+}
+
+TEST(PostfixProgram, TooDeep) {
+  string expression;
+  for (size_t i = 0; i < PostfixProgram::kMaxStackDepth; i++)
+    expression += "1 ";
+  for (size_t i = 1; i < PostfixProgram::kMaxStackDepth; i++)
+    expression += "+ ";
+
+  FakeMemoryRegion memory;
+  map<string, uint64_t> dictionary;
+  PostfixProgram program;
+  ASSERT_TRUE(program.Compile(expression));
+  uint64_t value;
+  ASSERT_TRUE(program.Evaluate(dictionary, static_cast<uint64_t*>(NULL),
+                               memory, &value));
+  EXPECT_EQ(PostfixProgram::kMaxStackDepth, value);
+
+  EXPECT_FALSE(program.Compile("1 " + expression + "+"));
+  EXPECT_FALSE(program.IsCompiled());
+}
+
+TEST(PostfixProgram, CFA) {
+  FakeMemoryRegion memory;
+  map<string, uint64_t> dictionary;
+  dictionary[".cfa"] = 100;
+  PostfixProgram program;
+  ASSERT_TRUE(program.Compile(".cfa 8 -"));
+
+  // The CFA passed in takes the place of any .cfa in the dictionary.
+  uint64_t cfa = 1000, value;
+  ASSERT_TRUE(program.Evaluate(dictionary, &cfa, memory, &value));
+  EXPECT_EQ(992U, value);
+  ASSERT_TRUE(program.Evaluate(dictionary, static_cast<uint64_t*>(NULL),
+                               memory, &value));
+  EXPECT_EQ(92U, value);
+  dictionary.clear();
+  EXPECT_FALSE(program.Evaluate(dictionary, static_cast<uint64_t*>(NULL),
+                                memory, &value));
+}
+
+TEST(PostfixProgram, DivideByZero) {
+  FakeMemoryRegion memory;
+  map<string, uint32_t> dictionary;
+  dictionary["$zero"] = 0;
+  PostfixProgram program;
+  uint32_t value;
+  ASSERT_TRUE(program.Compile("10 $zero /"));
+  EXPECT_FALSE(program.Evaluate(dictionary, static_cast<uint32_t*>(NULL),
+                                memory, &value));
+  ASSERT_TRUE(program.Compile("10 $zero %"));
+  EXPECT_FALSE(program.Evaluate(dictionary, static_cast<uint32_t*>(NULL),
+                                memory, &value));
+}
+
+}  // namespace
@@ -0,0 +1,377 @@
+// Copyright (c) 2026 Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// process_state_serializer.cc: Writes a ProcessState as a ProcessStateProto
+// message.
+//
+// See process_state_serializer.h for documentation.  The message is walked
+// once, by WriteProcessState, and each format supplies a writer that turns
+// the fields it's handed into bytes.  The field numbers and names passed to
+// the writers are those in proto/process_state.proto.
+
+#include "processor/process_state_serializer.h"
+
+#include <assert.h>
+#include <string.h>
+
+#include <vector>
+
+#include "google_breakpad/processor/call_stack.h"
+#include "google_breakpad/processor/code_module.h"
+#include "google_breakpad/processor/code_modules.h"
+#include "google_breakpad/processor/process_state.h"
+#include "google_breakpad/processor/stack_frame.h"
+#include "processor/logging.h"
+
+namespace google_breakpad {
+
+namespace {
+
+using std::vector;
+
+// Writes the protobuf binary wire format.  Nested messages are preceded by
+// their length, which isn't known until the message has been written, so
+// one byte is reserved for it when the message begins.  That's enough for
+// most modules and frames; longer messages are moved up to make room once
+// their length is known.
+class ProtoWriter {
+ public:
+  explicit ProtoWriter(string *buffer) : buffer_(buffer), depth_(0) {}
+
+  void BeginRoot() {}
+  void EndRoot() {}
+
+  void BeginMessage(int field, const char *name) {
+    AppendTag(field, kLengthDelimited);
+    assert(depth_ < kMaxDepth);
+    starts_[depth_++] = buffer_->size();
+    buffer_->push_back('\0');
+  }
+
+  void EndMessage() {
+    size_t start = starts_[--depth_];
+    char length[kMaxVarintBytes];
+    size_t length_bytes = EncodeVarint(buffer_->size() - start - 1, length);
+    if (length_bytes > 1)
+      buffer_->insert(start + 1, length_bytes - 1, '\0');
+    memcpy(&(*buffer_)[start], length, length_bytes);
+  }
+
+  // Repeated fields are just the field repeated.
+  void BeginRepeated(int field, const char *name) {}
+  void EndRepeated() {}
+  void BeginElement(int field) { BeginMessage(field, NULL); }
+  void EndElement() { EndMessage(); }
+
+  void Int64(int field, const char *name, int64_t value) {
+    AppendTag(field, kVarint);
+    AppendVarint(static_cast<uint64_t>(value));
+  }
+
+  // As in protobuf, negative int32 values are sign-extended to 64 bits.
+  void Int32(int field, const char *name, int32_t value) {
+    Int64(field, name, value);
+  }
+
+  void String(int field, const char *name, const string &value) {
+    AppendTag(field, kLengthDelimited);
+    AppendVarint(value.size());
+    buffer_->append(value);
+  }
+
+ private:
+  enum WireType {
+    kVarint = 0,
+    kLengthDelimited = 2
+  };
+
+  // ProcessStateProto nests no deeper than Thread, StackFrame, CodeModule.
+  static const int kMaxDepth = 3;
+
+  static const size_t kMaxVarintBytes = 10;
+
+  static size_t EncodeVarint(uint64_t value, char *bytes) {
+    size_t count = 0;
+    while (value >= 0x80) {
+      bytes[count++] = static_cast<char>((value & 0x7f) | 0x80);
+      value >>= 7;
+    }
+    bytes[count++] = static_cast<char>(value);
+    return count;
+  }
+
+  void AppendVarint(uint64_t value) {
+    char bytes[kMaxVarintBytes];
+    buffer_->append(bytes, EncodeVarint(value, bytes));
+  }
+
+  void AppendTag(int field, WireType wire_type) {
+    AppendVarint((static_cast<uint64_t>(field) << 3) | wire_type);
+  }
+
+  string *buffer_;
+  size_t starts_[kMaxDepth];
+  int depth_;
+};
+
+// Writes the protobuf JSON mapping.  Names and values are separated by
+// commas as they're written, by looking at what came before them.
+class JsonWriter {
+ public:
+  explicit JsonWriter(string *buffer) : buffer_(buffer) {}
+
+  void BeginRoot() { buffer_->push_back('{'); }
+  void EndRoot() { buffer_->append("}\n"); }
+
+  void BeginMessage(int field, const char *name) {
+    AppendName(name);
+    buffer_->push_back('{');
+  }
+  void EndMessage() { buffer_->push_back('}'); }
+
+  void BeginRepeated(int field, const char *name) {
+    AppendName(name);
+    buffer_->push_back('[');
+  }
+  void EndRepeated() { buffer_->push_back(']'); }
+
+  void BeginElement(int field) {
+    AppendSeparator();
+    buffer_->push_back('{');
+  }
+  void EndElement() { buffer_->push_back('}'); }
+
+  // 64-bit integers are quoted, since JSON numbers are often doubles.
+  void Int64(int field, const char *name, int64_t value) {
+    AppendName(name);
+    buffer_->push_back('"');
+    AppendDecimal(value);
+    buffer_->push_back('"');
+  }
+
+  void Int32(int field, const char *name, int32_t value) {
+    AppendName(name);
+    AppendDecimal(value);
+  }
+
+  // Strings are copied as they are, apart from escapes, so they're
+  // expected to be UTF-8, as protobuf strings are.
+  void String(int field, const char *name, const string &value) {
+    AppendName(name);
+    buffer_->push_back('"');
+    const char *run = value.data();
+    const char *end = run + value.size();
+    for (const char *c = run; c != end; ++c) {
+      unsigned char byte = static_cast<unsigned char>(*c);
+      if (byte >= 0x20 && byte != '"' && byte != '\\')
+        continue;
+      buffer_->append(run, c - run);
+      run = c + 1;
+      switch (byte) {
+        case '"': buffer_->append("\\\""); break;
+        case '\\': buffer_->append("\\\\"); break;
+        case '\n': buffer_->append("\\n"); break;
+        case '\r': buffer_->append("\\r"); break;
+        case '\t': buffer_->append("\\t"); break;
+        default: {
+          static const char kHexDigits[] = "0123456789abcdef";
+          char escape[] = { '\\', 'u', '0', '0', kHexDigits[byte >> 4],
+                            kHexDigits[byte & 0xf] };
+          buffer_->append(escape, sizeof(escape));
+          break;
+        }
+      }
+    }
+    buffer_->append(run, end - run);
+    buffer_->push_back('"');
+  }
+
+ private:
+  void AppendSeparator() {
+    char last = (*buffer_)[buffer_->size() - 1];
+    if (last != '{' && last != '[')
+      buffer_->push_back(',');
+  }
+
+  void AppendName(const char *name) {
+    AppendSeparator();
+    buffer_->push_back('"');
+    buffer_->append(name);
+    buffer_->append("\":");
+  }
+
+  void AppendDecimal(int64_t value) {
+    // Work in unsigned arithmetic, so that the most negative value can be
+    // negated.
+    uint64_t magnitude = static_cast<uint64_t>(value);
+    if (value < 0) {
+      buffer_->push_back('-');
+      magnitude = 0 - magnitude;
+    }
+    char digits[20];
+    size_t count = 0;
+    do {
+      digits[sizeof(digits) - ++count] = '0' + magnitude % 10;
+      magnitude /= 10;
+    } while (magnitude);
+    buffer_->append(digits + sizeof(digits) - count, count);
+  }
+
+  string *buffer_;
+};
+
+template<typename Writer>
+void WriteCodeModule(const CodeModule &module, Writer *writer) {
+  writer->Int64(1, "base_address", module.base_address());
+  writer->Int64(2, "size", module.size());
+  writer->String(3, "code_file", module.code_file());
+  writer->String(4, "code_identifier", module.code_identifier());
+  writer->String(5, "debug_file", module.debug_file());
+  writer->String(6, "debug_identifier", module.debug_identifier());
+  writer->String(7, "version", module.version());
+}
+
+template<typename Writer>
+void WriteStackFrame(const StackFrame &frame, Writer *writer) {
+  writer->Int64(1, "instruction", frame.instruction);
+  if (frame.module) {
+    writer->BeginMessage(2, "module");
+    WriteCodeModule(*frame.module, writer);
+    writer->EndMessage();
+  }
+  // Frames without symbols omit the fields that symbols would fill in.
+  if (!frame.FunctionName().empty()) {
+    writer->String(3, "function_name", frame.FunctionName());
+    writer->Int64(4, "function_base", frame.function_base);
+  }
+  if (!frame.SourceFileName().empty()) {
+    writer->String(5, "source_file_name", frame.SourceFileName());
+    writer->Int32(6, "source_line", frame.source_line);
+    writer->Int64(7, "source_line_base", frame.source_line_base);
+  }
+}
+
+template<typename Writer>
+void WriteProcessState(const ProcessState &process_state, Writer *writer) {
+  writer->BeginRoot();
+  writer->Int64(1, "time_date_stamp", process_state.time_date_stamp());
+
+  if (process_state.crashed()) {
+    writer->BeginMessage(2, "crash");
+    writer->String(1, "reason", process_state.crash_reason());
+    writer->Int64(2, "address", process_state.crash_address());
+    writer->EndMessage();
+  }
+
+  string assertion = process_state.assertion();
+  if (!assertion.empty())
+    writer->String(3, "assertion", assertion);
+
+  if (process_state.requesting_thread() >= 0)
+    writer->Int32(4, "requesting_thread", process_state.requesting_thread());
+
+  const vector<CallStack*> *threads = process_state.threads();
+  if (!threads->empty()) {
+    writer->BeginRepeated(5, "threads");
+    for (size_t i = 0; i < threads->size(); ++i) {
+      writer->BeginElement(5);
+      const vector<StackFrame*> *frames = threads->at(i)->frames();
+      if (!frames->empty()) {
+        writer->BeginRepeated(1, "frames");
+        for (size_t j = 0; j < frames->size(); ++j) {
+          writer->BeginElement(1);
+          WriteStackFrame(*frames->at(j), writer);
+          writer->EndElement();
+        }
+        writer->EndRepeated();
+      }
+      writer->EndElement();
+    }
+    writer->EndRepeated();
+  }
+
+  const CodeModules *modules = process_state.modules();
+  if (modules && modules->module_count() > 0) {
+    writer->BeginRepeated(6, "modules");
+    for (unsigned int i = 0; i < modules->module_count(); ++i) {
+      const CodeModule *module = modules->GetModuleAtSequence(i);
+      if (!module)
+        continue;
+      writer->BeginElement(6);
+      WriteCodeModule(*module, writer);
+      writer->EndElement();
+    }
+    writer->EndRepeated();
+  }
+
+  const SystemInfo *system_info = process_state.system_info();
+  if (!system_info->os.empty())
+    writer->String(7, "os", system_info->os);
+  if (!system_info->os_short.empty())
+    writer->String(8, "os_short", system_info->os_short);
+  if (!system_info->os_version.empty())
+    writer->String(9, "os_version", system_info->os_version);
+  if (!system_info->cpu.empty())
+    writer->String(10, "cpu", system_info->cpu);
+  if (!system_info->cpu_info.empty())
+    writer->String(11, "cpu_info", system_info->cpu_info);
+  writer->Int32(12, "cpu_count", system_info->cpu_count);
+
+  writer->Int64(13, "process_create_time",
+                process_state.process_create_time());
+  writer->EndRoot();
+}
+
+}  // namespace
+
+const string &ProcessStateSerializer::Serialize(
+    const ProcessState &process_state) {
+  buffer_.clear();
+  if (format_ == FORMAT_PROTO) {
+    ProtoWriter writer(&buffer_);
+    WriteProcessState(process_state, &writer);
+  } else {
+    JsonWriter writer(&buffer_);
+    WriteProcessState(process_state, &writer);
+  }
+  return buffer_;
+}
+
+bool ProcessStateSerializer::Write(const ProcessState &process_state,
+                                   FILE *file) {
+  const string &buffer = Serialize(process_state);
+  if (fwrite(buffer.data(), 1, buffer.size(), file) != buffer.size()) {
+    BPLOG(ERROR) << "ProcessStateSerializer could not write " <<
+                    buffer.size() << " bytes";
+    return false;
+  }
+  return true;
+}
+
+}  // namespace google_breakpad
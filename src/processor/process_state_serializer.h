@@ -0,0 +1,89 @@
+// Copyright (c) 2026 Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// process_state_serializer.h: Writes a ProcessState as a ProcessStateProto
+// message, defined in proto/process_state.proto, in either the protobuf
+// binary wire format or the protobuf JSON mapping.
+//
+// The message is written directly from the ProcessState, without going
+// through text output or a protobuf library, into a buffer owned by the
+// serializer.  The buffer is reused by each call, so serializing one dump
+// after another doesn't allocate once the buffer has grown large enough.
+
+#ifndef PROCESSOR_PROCESS_STATE_SERIALIZER_H__
+#define PROCESSOR_PROCESS_STATE_SERIALIZER_H__
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <string>
+
+#include "common/using_std_string.h"
+
+namespace google_breakpad {
+
+class ProcessState;
+
+class ProcessStateSerializer {
+ public:
+  enum Format {
+    // The protobuf binary wire format.
+    FORMAT_PROTO,
+
+    // The protobuf JSON mapping, using the field names from the .proto
+    // file, on a single line ending in a newline.  As the mapping
+    // requires, 64-bit integers are written as strings.
+    FORMAT_JSON
+  };
+
+  explicit ProcessStateSerializer(Format format) : format_(format) {}
+
+  Format format() const { return format_; }
+
+  // Serializes |process_state|, replacing the contents of the buffer, and
+  // returns the buffer.  The returned reference is valid until the next
+  // call.
+  const string &Serialize(const ProcessState &process_state);
+
+  // Serializes |process_state| and writes it to |file|.  Returns false if
+  // it couldn't be written.
+  bool Write(const ProcessState &process_state, FILE *file);
+
+ private:
+  Format format_;
+  string buffer_;
+
+  // Disallow copy constructor and assignment operator.
+  ProcessStateSerializer(const ProcessStateSerializer&);
+  void operator=(const ProcessStateSerializer&);
+};
+
+}  // namespace google_breakpad
+
+#endif  // PROCESSOR_PROCESS_STATE_SERIALIZER_H__
@@ -0,0 +1,236 @@
+// Copyright (c) 2026 Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// process_state_serializer_unittest.cc: Unit tests for
+// ProcessStateSerializer.  The protobuf output is read back with a small
+// wire format decoder, so that the tests don't need a protobuf library.
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <string>
+#include <vector>
+
+#include "breakpad_googletest_includes.h"
+#include "common/using_std_string.h"
+#include "google_breakpad/processor/basic_source_line_resolver.h"
+#include "google_breakpad/processor/minidump_processor.h"
+#include "google_breakpad/processor/process_state.h"
+#include "google_breakpad/processor/system_info.h"
+#include "processor/process_state_serializer.h"
+#include "processor/simple_symbol_supplier.h"
+
+namespace {
+
+using google_breakpad::BasicSourceLineResolver;
+using google_breakpad::MinidumpProcessor;
+using google_breakpad::ProcessState;
+using google_breakpad::ProcessStateSerializer;
+using google_breakpad::SimpleSymbolSupplier;
+using google_breakpad::SystemInfo;
+using std::vector;
+
+// A field read from a serialized message.
+struct Field {
+  int number;
+  uint64_t value;  // For varint fields.
+  string bytes;    // For length-delimited fields.
+};
+
+bool ReadVarint(const string &data, size_t *offset, uint64_t *value) {
+  *value = 0;
+  for (int shift = 0; shift < 64 && *offset < data.size(); shift += 7) {
+    unsigned char byte = data[(*offset)++];
+    *value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+    if (!(byte & 0x80))
+      return true;
+  }
+  return false;
+}
+
+// Splits |data| into its fields, returning false if it isn't a well-formed
+// message made of varint and length-delimited fields.
+bool ReadFields(const string &data, vector<Field> *fields) {
+  fields->clear();
+  size_t offset = 0;
+  while (offset < data.size()) {
+    uint64_t tag;
+    if (!ReadVarint(data, &offset, &tag))
+      return false;
+    Field field;
+    field.number = static_cast<int>(tag >> 3);
+    field.value = 0;
+    if ((tag & 7) == 0) {
+      if (!ReadVarint(data, &offset, &field.value))
+        return false;
+    } else if ((tag & 7) == 2) {
+      uint64_t length;
+      if (!ReadVarint(data, &offset, &length) ||
+          length > data.size() - offset)
+        return false;
+      field.bytes = data.substr(offset, length);
+      offset += length;
+    } else {
+      return false;
+    }
+    fields->push_back(field);
+  }
+  return true;
+}
+
+// Returns the fields of |fields| numbered |number|.
+vector<Field> FieldsNumbered(const vector<Field> &fields, int number) {
+  vector<Field> numbered;
+  for (size_t i = 0; i < fields.size(); ++i) {
+    if (fields[i].number == number)
+      numbered.push_back(fields[i]);
+  }
+  return numbered;
+}
+
+size_t CountOccurrences(const string &haystack, const string &needle) {
+  size_t count = 0;
+  for (size_t offset = haystack.find(needle); offset != string::npos;
+       offset = haystack.find(needle, offset + 1))
+    ++count;
+  return count;
+}
+
+class ProcessStateSerializerTest : public ::testing::Test {
+ public:
+  void SetUp() {
+    string testdata_dir = string(getenv("srcdir") ? getenv("srcdir") : ".") +
+                          "/src/processor/testdata";
+    SimpleSymbolSupplier supplier(testdata_dir + "/symbols");
+    BasicSourceLineResolver resolver;
+    MinidumpProcessor processor(&supplier, &resolver);
+    ASSERT_EQ(google_breakpad::PROCESS_OK,
+              processor.Process(testdata_dir + "/minidump2.dmp", &state_));
+  }
+
+  ProcessState state_;
+};
+
+TEST_F(ProcessStateSerializerTest, Proto) {
+  ProcessStateSerializer serializer(ProcessStateSerializer::FORMAT_PROTO);
+  EXPECT_EQ(ProcessStateSerializer::FORMAT_PROTO, serializer.format());
+  vector<Field> fields;
+  ASSERT_TRUE(ReadFields(serializer.Serialize(state_), &fields));
+
+  vector<Field> numbered = FieldsNumbered(fields, 1);
+  ASSERT_EQ(1U, numbered.size());
+  EXPECT_EQ(1171480435U, numbered[0].value);
+
+  numbered = FieldsNumbered(fields, 2);
+  ASSERT_EQ(1U, numbered.size());
+  vector<Field> crash;
+  ASSERT_TRUE(ReadFields(numbered[0].bytes, &crash));
+  ASSERT_EQ(2U, crash.size());
+  EXPECT_EQ("EXCEPTION_ACCESS_VIOLATION_WRITE", crash[0].bytes);
+  EXPECT_EQ(0x45U, crash[1].value);
+
+  numbered = FieldsNumbered(fields, 4);
+  ASSERT_EQ(1U, numbered.size());
+  EXPECT_EQ(0U, numbered[0].value);
+
+  // The thread is long enough that its length takes more than one byte.
+  numbered = FieldsNumbered(fields, 5);
+  ASSERT_EQ(1U, numbered.size());
+  EXPECT_GT(numbered[0].bytes.size(), 127U);
+  vector<Field> thread;
+  ASSERT_TRUE(ReadFields(numbered[0].bytes, &thread));
+  ASSERT_EQ(4U, thread.size());
+  vector<Field> frame;
+  ASSERT_TRUE(ReadFields(thread[1].bytes, &frame));
+  EXPECT_EQ("main", FieldsNumbered(frame, 3).at(0).bytes);
+  EXPECT_EQ("c:\\test_app.cc", FieldsNumbered(frame, 5).at(0).bytes);
+  EXPECT_EQ(65U, FieldsNumbered(frame, 6).at(0).value);
+  vector<Field> module;
+  ASSERT_TRUE(ReadFields(FieldsNumbered(frame, 2).at(0).bytes, &module));
+  EXPECT_EQ(0x400000U, FieldsNumbered(module, 1).at(0).value);
+  EXPECT_EQ("c:\\test_app.exe", FieldsNumbered(module, 3).at(0).bytes);
+
+  // kernel32.dll's symbols have no source lines.
+  ASSERT_TRUE(ReadFields(thread[3].bytes, &frame));
+  EXPECT_FALSE(FieldsNumbered(frame, 3).empty());
+  EXPECT_TRUE(FieldsNumbered(frame, 5).empty());
+
+  EXPECT_EQ(13U, FieldsNumbered(fields, 6).size());
+  EXPECT_EQ("Windows NT", FieldsNumbered(fields, 7).at(0).bytes);
+  EXPECT_EQ("x86", FieldsNumbered(fields, 10).at(0).bytes);
+  EXPECT_EQ(1171480435U, FieldsNumbered(fields, 13).at(0).value);
+}
+
+TEST_F(ProcessStateSerializerTest, JSON) {
+  ProcessStateSerializer serializer(ProcessStateSerializer::FORMAT_JSON);
+  const string &json = serializer.Serialize(state_);
+
+  EXPECT_EQ(0U, json.find("{\"time_date_stamp\":\"1171480435\","
+                          "\"crash\":{\"reason\":"
+                          "\"EXCEPTION_ACCESS_VIOLATION_WRITE\","
+                          "\"address\":\"69\"},"
+                          "\"requesting_thread\":0,"
+                          "\"threads\":[{\"frames\":[{\"instruction\":"));
+  EXPECT_NE(string::npos,
+            json.find("\"function_name\":\"main\",\"function_base\":"));
+  EXPECT_NE(string::npos,
+            json.find("\"source_file_name\":\"c:\\\\test_app.cc\","
+                      "\"source_line\":65,"));
+  // Thirteen modules, and the four frames' modules.
+  EXPECT_EQ(17U, CountOccurrences(json, "{\"base_address\":"));
+  EXPECT_NE(string::npos, json.find("]}],\"modules\":[{"));
+  EXPECT_NE(string::npos,
+            json.find("],\"os\":\"Windows NT\",\"os_short\":\"windows\","));
+  const string kEnd = ",\"process_create_time\":\"1171480435\"}\n";
+  EXPECT_EQ(json.size() - kEnd.size(), json.find(kEnd));
+  EXPECT_EQ(1U, CountOccurrences(json, "\n"));
+}
+
+TEST_F(ProcessStateSerializerTest, JSONEscapes) {
+  // ProcessState has no setters, but its SystemInfo can be modified in
+  // place.
+  SystemInfo *system_info = const_cast<SystemInfo*>(state_.system_info());
+  system_info->os = string("quote\" backslash\\ tab\t nul") + '\0' +
+                    "\x1f \xc3\xa9";
+  ProcessStateSerializer serializer(ProcessStateSerializer::FORMAT_JSON);
+  EXPECT_NE(string::npos,
+            serializer.Serialize(state_).find(
+                "\"os\":\"quote\\\" backslash\\\\ tab\\t nul\\u0000"
+                "\\u001f \xc3\xa9\","));
+}
+
+TEST_F(ProcessStateSerializerTest, ReusesBuffer) {
+  ProcessStateSerializer serializer(ProcessStateSerializer::FORMAT_PROTO);
+  string first = serializer.Serialize(state_);
+  const char *data = serializer.Serialize(state_).data();
+  EXPECT_EQ(first, serializer.Serialize(state_));
+  EXPECT_EQ(data, serializer.Serialize(state_).data());
+}
+
+}  // namespace
@@ -47,6 +47,8 @@
         'cfi_frame_info-inl.h',
         'cfi_frame_info.cc',
         'cfi_frame_info.h',
+        'compact_range_map-inl.h',
+        'compact_range_map.h',
         'contained_range_map-inl.h',
         'contained_range_map.h',
         'disassembler_x86.cc',
@@ -60,6 +62,8 @@
         'exploitability_win.h',
         'fast_source_line_resolver.cc',
         'fast_source_line_resolver_types.h',
+        'fast_symbol_supplier.cc',
+        'fast_symbol_supplier.h',
         'linked_ptr.h',
         'logging.cc',
         'logging.h',
@@ -67,6 +71,8 @@
         'map_serializers.h',
         'microdump_processor.cc',
         'minidump.cc',
+        'minidump_page_cache.cc',
+        'minidump_page_cache.h',
         'minidump_processor.cc',
         'module_comparer.cc',
         'module_comparer.h',
@@ -77,10 +83,15 @@
         'pathname_stripper.h',
         'postfix_evaluator-inl.h',
         'postfix_evaluator.h',
+        'postfix_program.cc',
+        'postfix_program.h',
         'proc_maps_linux.cc',
         'process_state.cc',
+        'process_state_serializer.cc',
+        'process_state_serializer.h',
         'range_map-inl.h',
         'range_map.h',
+        'register_dictionary.h',
         'simple_serializer-inl.h',
         'simple_serializer.h',
         'simple_symbol_supplier.cc',
@@ -144,18 +155,25 @@
         'address_map_unittest.cc',
         'basic_source_line_resolver_unittest.cc',
         'cfi_frame_info_unittest.cc',
+        'compact_range_map_unittest.cc',
         'contained_range_map_unittest.cc',
         'disassembler_x86_unittest.cc',
         'exploitability_unittest.cc',
         'fast_source_line_resolver_unittest.cc',
+        'fast_symbol_supplier_unittest.cc',
         'map_serializers_unittest.cc',
         'microdump_processor_unittest.cc',
+        'minidump_page_cache_unittest.cc',
         'minidump_processor_unittest.cc',
         'minidump_unittest.cc',
         'pathname_stripper_unittest.cc',
         'postfix_evaluator_unittest.cc',
+        'postfix_program_unittest.cc',
+        'process_state_serializer_unittest.cc',
         'range_map_shrink_down_unittest.cc',
         'range_map_unittest.cc',
+        'register_dictionary_unittest.cc',
+        'stack_frame_symbolizer_unittest.cc',
         'stackwalker_address_list_unittest.cc',
         'stackwalker_amd64_unittest.cc',
         'stackwalker_arm64_unittest.cc',
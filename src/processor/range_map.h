@@ -128,7 +128,7 @@ class RangeMap {
 
     AddressType base() const { return base_; }
     AddressType delta() const { return delta_; }
-    EntryType entry() const { return entry_; }
+    const EntryType &entry() const { return entry_; }
 
    private:
     // The base address of the range.  The high address does not need to
@@ -0,0 +1,181 @@
+// Copyright (c) 2026 Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// register_dictionary.h: A fixed-size dictionary of register values.
+//
+// RegisterTable lists the register names an architecture's stack walker
+// deals with, and RegisterDictionary holds a value for any of those
+// registers.  Unlike a map from names to values, a RegisterDictionary is
+// a plain array indexed by each register's position in its table, so
+// filling one in, copying it, and looking registers up never allocate
+// memory.  A stack walker builds its table once, and can then track each
+// frame's registers in RegisterDictionaries on the stack.
+
+#ifndef PROCESSOR_REGISTER_DICTIONARY_H__
+#define PROCESSOR_REGISTER_DICTIONARY_H__
+
+#include <string.h>
+
+#include <string>
+
+#include "common/using_std_string.h"
+#include "google_breakpad/common/breakpad_types.h"
+
+namespace google_breakpad {
+
+class RegisterTable {
+ public:
+  // The most registers a table can hold.
+  static const int kMaxRegisters = 64;
+
+  RegisterTable() : count_(0) {}
+
+  // Create a table holding the registers named in NAMES, an array ending
+  // with NULL.  The names must outlive the table.
+  explicit RegisterTable(const char * const *names) : count_(0) {
+    for (; *names; names++)
+      Add(*names);
+  }
+
+  // Add the register named NAME, which must outlive the table, and return
+  // its index.  If NAME is already present, return its existing index.
+  // Return -1 if the table is full.
+  int Add(const char *name) {
+    int index = IndexOf(name);
+    if (index >= 0)
+      return index;
+    if (count_ == kMaxRegisters)
+      return -1;
+    names_[count_] = name;
+    return count_++;
+  }
+
+  // Return the index of the register named NAME, or -1 if there is none.
+  int IndexOf(const char *name) const {
+    for (int i = 0; i < count_; i++) {
+      if (strcmp(names_[i], name) == 0)
+        return i;
+    }
+    return -1;
+  }
+  int IndexOf(const string &name) const { return IndexOf(name.c_str()); }
+
+  int size() const { return count_; }
+  const char *name(int index) const { return names_[index]; }
+
+  // Return true if OTHER holds the same names as this table, at the same
+  // indices.
+  bool SameNames(const RegisterTable &other) const {
+    if (count_ != other.count_)
+      return false;
+    for (int i = 0; i < count_; i++) {
+      if (names_[i] != other.names_[i] &&
+          strcmp(names_[i], other.names_[i]) != 0)
+        return false;
+    }
+    return true;
+  }
+
+ private:
+  const char *names_[kMaxRegisters];
+  int count_;
+};
+
+template<typename ValueType>
+class RegisterDictionary {
+ public:
+  // Create an empty dictionary for the registers in TABLE, which must
+  // outlive the dictionary.
+  explicit RegisterDictionary(const RegisterTable *table)
+      : table_(table), valid_(0) {}
+
+  const RegisterTable *table() const { return table_; }
+
+  // Return true if the register at INDEX has a value.  If VALUE is
+  // non-NULL, store the value there.  INDEX may be -1, for a register
+  // that isn't in the table, in which case return false.
+  bool Get(int index, ValueType *value) const {
+    if (index < 0 || !(valid_ & Bit(index)))
+      return false;
+    if (value)
+      *value = values_[index];
+    return true;
+  }
+
+  // As above, for the register named NAME.
+  bool Get(const char *name, ValueType *value) const {
+    return Get(table_->IndexOf(name), value);
+  }
+  bool Get(const string &name, ValueType *value) const {
+    return Get(table_->IndexOf(name), value);
+  }
+
+  // Give the register at INDEX the value VALUE.  Return false, doing
+  // nothing, if INDEX is -1.
+  bool Set(int index, ValueType value) {
+    if (index < 0)
+      return false;
+    values_[index] = value;
+    valid_ |= Bit(index);
+    return true;
+  }
+
+  // As above, for the register named NAME.  Return false if the table has
+  // no register by that name.
+  bool Set(const char *name, ValueType value) {
+    return Set(table_->IndexOf(name), value);
+  }
+  bool Set(const string &name, ValueType value) {
+    return Set(table_->IndexOf(name), value);
+  }
+
+  // Forget the value of the register at INDEX.
+  void Erase(int index) {
+    if (index >= 0)
+      valid_ &= ~Bit(index);
+  }
+
+  // Forget every register's value.
+  void Clear() { valid_ = 0; }
+
+  bool empty() const { return valid_ == 0; }
+
+ private:
+  static uint64_t Bit(int index) { return static_cast<uint64_t>(1) << index; }
+
+  const RegisterTable *table_;
+
+  // Bit i of valid_ is set if values_[i] holds a value.
+  uint64_t valid_;
+  ValueType values_[RegisterTable::kMaxRegisters];
+};
+
+}  // namespace google_breakpad
+
+#endif  // PROCESSOR_REGISTER_DICTIONARY_H__
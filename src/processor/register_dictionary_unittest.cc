@@ -0,0 +1,131 @@
+// Copyright (c) 2026 Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// register_dictionary_unittest.cc: Unit tests for RegisterTable and
+// RegisterDictionary.
+
+#include <string>
+
+#include "breakpad_googletest_includes.h"
+#include "common/using_std_string.h"
+#include "processor/register_dictionary.h"
+
+namespace {
+
+using google_breakpad::RegisterDictionary;
+using google_breakpad::RegisterTable;
+
+const char *kNames[] = { "$eip", "$esp", "$ebp", NULL };
+
+TEST(RegisterTable, Names) {
+  RegisterTable table(kNames);
+  ASSERT_EQ(3, table.size());
+  EXPECT_EQ(0, table.IndexOf("$eip"));
+  EXPECT_EQ(2, table.IndexOf(string("$ebp")));
+  EXPECT_EQ(-1, table.IndexOf("$ebx"));
+  EXPECT_STREQ("$esp", table.name(1));
+
+  // Adding a name that's already present yields its index.
+  EXPECT_EQ(1, table.Add("$esp"));
+  EXPECT_EQ(3, table.Add(".cfa"));
+  EXPECT_EQ(4, table.size());
+}
+
+TEST(RegisterTable, Full) {
+  static const char *kManyNames[RegisterTable::kMaxRegisters + 1];
+  static char storage[RegisterTable::kMaxRegisters + 1][8];
+  RegisterTable table;
+  for (int i = 0; i <= RegisterTable::kMaxRegisters; i++) {
+    snprintf(storage[i], sizeof(storage[i]), "r%d", i);
+    kManyNames[i] = storage[i];
+  }
+  for (int i = 0; i < RegisterTable::kMaxRegisters; i++)
+    ASSERT_EQ(i, table.Add(kManyNames[i]));
+  EXPECT_EQ(-1, table.Add(kManyNames[RegisterTable::kMaxRegisters]));
+  EXPECT_EQ(static_cast<int>(RegisterTable::kMaxRegisters), table.size());
+}
+
+TEST(RegisterDictionary, SetAndGet) {
+  RegisterTable table(kNames);
+  RegisterDictionary<uint32_t> dictionary(&table);
+  uint32_t value = 0;
+  EXPECT_TRUE(dictionary.empty());
+  EXPECT_FALSE(dictionary.Get(0, &value));
+  EXPECT_FALSE(dictionary.Get(-1, &value));
+
+  EXPECT_TRUE(dictionary.Set(1, 0x1000));
+  EXPECT_TRUE(dictionary.Set("$ebp", 0x1010));
+  EXPECT_FALSE(dictionary.Set("$ebx", 0x1020));
+  EXPECT_FALSE(dictionary.Set(-1, 0x1030));
+  EXPECT_FALSE(dictionary.empty());
+
+  EXPECT_TRUE(dictionary.Get("$esp", &value));
+  EXPECT_EQ(0x1000U, value);
+  EXPECT_TRUE(dictionary.Get(string("$ebp"), &value));
+  EXPECT_EQ(0x1010U, value);
+  EXPECT_TRUE(dictionary.Get(1, NULL));
+  EXPECT_FALSE(dictionary.Get("$eip", &value));
+  EXPECT_FALSE(dictionary.Get("$ebx", &value));
+  EXPECT_EQ(0x1010U, value);
+
+  // Copies are independent.
+  RegisterDictionary<uint32_t> copy(dictionary);
+  copy.Erase(1);
+  EXPECT_FALSE(copy.Get(1, &value));
+  EXPECT_TRUE(dictionary.Get(1, &value));
+
+  dictionary.Clear();
+  EXPECT_TRUE(dictionary.empty());
+  EXPECT_FALSE(dictionary.Get("$ebp", &value));
+  EXPECT_EQ(&table, dictionary.table());
+}
+
+TEST(RegisterDictionary, WholeTable) {
+  static const char *kManyNames[RegisterTable::kMaxRegisters];
+  static char storage[RegisterTable::kMaxRegisters][8];
+  RegisterTable table;
+  for (int i = 0; i < RegisterTable::kMaxRegisters; i++) {
+    snprintf(storage[i], sizeof(storage[i]), "r%d", i);
+    kManyNames[i] = storage[i];
+    table.Add(kManyNames[i]);
+  }
+
+  RegisterDictionary<uint64_t> dictionary(&table);
+  for (int i = 0; i < RegisterTable::kMaxRegisters; i += 3)
+    dictionary.Set(i, i * 0x100000001ULL);
+  for (int i = 0; i < RegisterTable::kMaxRegisters; i++) {
+    uint64_t value;
+    ASSERT_EQ(i % 3 == 0, dictionary.Get(i, &value));
+    if (i % 3 == 0) {
+      EXPECT_EQ(i * 0x100000001ULL, value);
+    }
+  }
+}
+
+}  // namespace
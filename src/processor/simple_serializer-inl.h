@@ -207,7 +207,7 @@ class SimpleSerializer<BasicSourceLineResolver::Function> {
   }
  private:
   // This static member is defined in module_serializer.cc.
-  static RangeMapSerializer< MemAddr, linked_ptr<Line> > range_map_serializer_;
+  static RangeMapSerializer<MemAddr, Line> range_map_serializer_;
 };
 
 template<>
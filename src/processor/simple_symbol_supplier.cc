@@ -118,11 +118,25 @@ SymbolSupplier::SymbolResult SimpleSymbolSupplier::GetCStringSymbolData(
     }
     memcpy(*symbol_data, symbol_data_string.c_str(), symbol_data_string.size());
     (*symbol_data)[symbol_data_string.size()] = '\0';
-    memory_buffers_.insert(make_pair(module->code_file(), *symbol_data));
+    KeepSymbolData(module, *symbol_data);
   }
   return s;
 }
 
+void SimpleSymbolSupplier::KeepSymbolData(const CodeModule *module,
+                                          char *symbol_data) {
+  // A resolver that keeps the buffer (see
+  // ShouldDeleteMemoryBufferAfterLoadModule) may have unloaded the module
+  // it was loaded into, in which case an older buffer is still held here.
+  map<string, char *>::iterator it = memory_buffers_.find(module->code_file());
+  if (it != memory_buffers_.end()) {
+    delete [] it->second;
+    it->second = symbol_data;
+  } else {
+    memory_buffers_.insert(make_pair(module->code_file(), symbol_data));
+  }
+}
+
 void SimpleSymbolSupplier::FreeSymbolData(const CodeModule *module) {
   if (!module) {
     BPLOG(INFO) << "Cannot free symbol data buffer for NULL module";
@@ -147,9 +161,24 @@ SymbolSupplier::SymbolResult SimpleSymbolSupplier::GetSymbolFileAtPathFromRoot(
   assert(symbol_file);
   symbol_file->clear();
 
-  if (!module)
+  string path;
+  if (!GetSymbolFilePathFromRoot(module, root_path, &path))
     return NOT_FOUND;
 
+  if (!file_exists(path)) {
+    BPLOG(INFO) << "No symbol file at " << path;
+    return NOT_FOUND;
+  }
+
+  *symbol_file = path;
+  return FOUND;
+}
+
+bool SimpleSymbolSupplier::GetSymbolFilePathFromRoot(
+    const CodeModule *module, const string &root_path, string *symbol_file) {
+  if (!module)
+    return false;
+
   // Start with the base path.
   string path = root_path;
 
@@ -160,7 +189,7 @@ SymbolSupplier::SymbolResult SimpleSymbolSupplier::GetSymbolFileAtPathFromRoot(
     BPLOG(ERROR) << "Can't construct symbol file path without debug_file "
                     "(code_file = " <<
                     PathnameStripper::File(module->code_file()) << ")";
-    return NOT_FOUND;
+    return false;
   }
   path.append(debug_file_name);
 
@@ -172,7 +201,7 @@ SymbolSupplier::SymbolResult SimpleSymbolSupplier::GetSymbolFileAtPathFromRoot(
                     "(code_file = " <<
                     PathnameStripper::File(module->code_file()) <<
                     ", debug_file = " << debug_file_name << ")";
-    return NOT_FOUND;
+    return false;
   }
   path.append(identifier);
 
@@ -192,13 +221,8 @@ SymbolSupplier::SymbolResult SimpleSymbolSupplier::GetSymbolFileAtPathFromRoot(
   }
   path.append(".sym");
 
-  if (!file_exists(path)) {
-    BPLOG(INFO) << "No symbol file at " << path;
-    return NOT_FOUND;
-  }
-
   *symbol_file = path;
-  return FOUND;
+  return true;
 }
 
 }  // namespace google_breakpad
@@ -125,10 +125,23 @@ class SimpleSymbolSupplier : public SymbolSupplier {
   virtual void FreeSymbolData(const CodeModule *module);
 
  protected:
-  SymbolResult GetSymbolFileAtPathFromRoot(const CodeModule *module,
-                                           const SystemInfo *system_info,
-                                           const string &root_path,
-                                           string *symbol_file);
+  virtual SymbolResult GetSymbolFileAtPathFromRoot(
+      const CodeModule *module,
+      const SystemInfo *system_info,
+      const string &root_path,
+      string *symbol_file);
+
+  // Builds the path that the symbol file for |module| would have under
+  // |root_path|, whether or not it exists, and places it in |symbol_file|.
+  // Returns false if |module| lacks the information needed to build it.
+  bool GetSymbolFilePathFromRoot(const CodeModule *module,
+                                 const string &root_path,
+                                 string *symbol_file);
+
+  // Takes ownership of |symbol_data|, a buffer allocated with new[] for
+  // GetCStringSymbolData to return, until FreeSymbolData is called for
+  // |module|.
+  void KeepSymbolData(const CodeModule *module, char *symbol_data);
 
  private:
   map<string, char *> memory_buffers_;
@@ -38,6 +38,12 @@
 #include <string.h>
 #include <sys/stat.h>
 
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif  // _WIN32
+
 #include <map>
 #include <utility>
 
@@ -55,7 +61,13 @@ SourceLineResolverBase::SourceLineResolverBase(
   : modules_(new ModuleMap),
     corrupt_modules_(new ModuleSet),
     memory_buffers_(new MemoryMap),
-    module_factory_(module_factory) {
+    module_factory_(module_factory),
+    symbol_data_budget_(0),
+    module_cache_hits_(0),
+    module_cache_misses_(0),
+    module_cache_evictions_(0),
+    unloaded_cfi_cache_hits_(0),
+    unloaded_cfi_cache_misses_(0) {
 }
 
 SourceLineResolverBase::~SourceLineResolverBase() {
@@ -81,6 +93,13 @@ SourceLineResolverBase::~SourceLineResolverBase() {
   delete memory_buffers_;
   memory_buffers_ = NULL;
 
+#ifndef _WIN32
+  MappedFileMap::iterator mapped_iter = mapped_files_.begin();
+  for (; mapped_iter != mapped_files_.end(); ++mapped_iter) {
+    munmap(mapped_iter->second.data, mapped_iter->second.size);
+  }
+#endif  // _WIN32
+
   delete module_factory_;
   module_factory_ = NULL;
 }
@@ -252,9 +271,84 @@ bool SourceLineResolverBase::LoadModuleUsingMemoryBuffer(
   if (basic_module->IsCorrupt()) {
     corrupt_modules_->insert(module->code_file());
   }
+
+  module_use_list_.push_front(module->code_file());
+  ModuleUsage usage;
+  usage.position = module_use_list_.begin();
+  usage.module = basic_module;
+  usage.buffer_size = memory_buffer_size;
+  usage.keeps_buffer = !ShouldDeleteMemoryBufferAfterLoadModule();
+  module_usage_.insert(make_pair(module->code_file(), usage));
+  EnforceSymbolDataBudget(module->code_file());
   return true;
 }
 
+bool SourceLineResolverBase::LoadModuleUsingMappedFile(
+    const CodeModule *module, const string &map_file) {
+  if (module == NULL)
+    return false;
+
+  if (ShouldDeleteMemoryBufferAfterLoadModule()) {
+    BPLOG(ERROR) << "Cannot load symbols for module " << module->code_file()
+                 << " from a mapped file: the resolver modifies its buffers";
+    return false;
+  }
+
+#ifdef _WIN32
+  return LoadModule(module, map_file);
+#else  // _WIN32
+  // Make sure we don't already have a module with the given name.
+  if (modules_->find(module->code_file()) != modules_->end()) {
+    BPLOG(INFO) << "Symbols for module " << module->code_file()
+                << " already loaded";
+    return false;
+  }
+
+  BPLOG(INFO) << "Loading symbols for module " << module->code_file()
+              << " from mapped file " << map_file;
+
+  int fd = open(map_file.c_str(), O_RDONLY);
+  if (fd == -1) {
+    string error_string;
+    int error_code = ErrnoString(&error_string);
+    BPLOG(ERROR) << "Could not open " << map_file <<
+        ", error " << error_code << ": " << error_string;
+    return false;
+  }
+
+  struct stat buf;
+  if (fstat(fd, &buf) == -1 || buf.st_size <= 0) {
+    BPLOG(ERROR) << "Could not determine a usable size for " << map_file;
+    close(fd);
+    return false;
+  }
+
+  size_t size = static_cast<size_t>(buf.st_size);
+  void *data = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED) {
+    string error_string;
+    int error_code = ErrnoString(&error_string);
+    BPLOG(ERROR) << "Could not map " << map_file <<
+        ", error " << error_code << ": " << error_string;
+    return false;
+  }
+
+  // The mapping is read-only; LoadModuleUsingMemoryBuffer takes a char*
+  // only because other resolvers parse their buffer in place.
+  if (!LoadModuleUsingMemoryBuffer(module, static_cast<char *>(data), size)) {
+    munmap(data, size);
+    return false;
+  }
+
+  MappedFile mapped_file;
+  mapped_file.data = data;
+  mapped_file.size = size;
+  mapped_files_.insert(make_pair(module->code_file(), mapped_file));
+  return true;
+#endif  // _WIN32
+}
+
 bool SourceLineResolverBase::ShouldDeleteMemoryBufferAfterLoadModule() {
   return true;
 }
@@ -263,30 +357,71 @@ void SourceLineResolverBase::UnloadModule(const CodeModule *code_module) {
   if (!code_module)
     return;
 
-  ModuleMap::iterator mod_iter = modules_->find(code_module->code_file());
+  UnloadModuleByCodeFile(code_module->code_file());
+}
+
+void SourceLineResolverBase::TakeUnloadedModules(
+    std::vector<string> *code_files) {
+  code_files->insert(code_files->end(), unloaded_modules_.begin(),
+                     unloaded_modules_.end());
+  unloaded_modules_.clear();
+}
+
+void SourceLineResolverBase::UnloadModuleByCodeFile(const string &code_file) {
+  ModuleMap::iterator mod_iter = modules_->find(code_file);
   if (mod_iter != modules_->end()) {
     Module *symbol_module = mod_iter->second;
+    CFIFrameInfoCache::Stats cfi_stats =
+        symbol_module->CFIFrameInfoCacheStats();
+    unloaded_cfi_cache_hits_ += cfi_stats.hits;
+    unloaded_cfi_cache_misses_ += cfi_stats.misses;
     delete symbol_module;
     corrupt_modules_->erase(mod_iter->first);
     modules_->erase(mod_iter);
   }
 
-  if (ShouldDeleteMemoryBufferAfterLoadModule()) {
-    // No-op.  Because we never store any memory buffers.
-  } else {
-    // There may be a buffer stored locally, we need to find and delete it.
-    MemoryMap::iterator iter = memory_buffers_->find(code_module->code_file());
-    if (iter != memory_buffers_->end()) {
-      delete [] iter->second;
-      memory_buffers_->erase(iter);
-    }
+  ModuleUsageMap::iterator usage_iter = module_usage_.find(code_file);
+  if (usage_iter != module_usage_.end()) {
+    module_use_list_.erase(usage_iter->second.position);
+    module_usage_.erase(usage_iter);
+  }
+
+  // There may be a buffer stored locally, we need to find and delete it.
+  // Check even if ShouldDeleteMemoryBufferAfterLoadModule now says no
+  // buffers are stored: it may have said otherwise when the module loaded.
+  MemoryMap::iterator iter = memory_buffers_->find(code_file);
+  if (iter != memory_buffers_->end()) {
+    delete [] iter->second;
+    memory_buffers_->erase(iter);
+  }
+
+  MappedFileMap::iterator mapped_iter = mapped_files_.find(code_file);
+  if (mapped_iter != mapped_files_.end()) {
+#ifndef _WIN32
+    munmap(mapped_iter->second.data, mapped_iter->second.size);
+#endif  // _WIN32
+    mapped_files_.erase(mapped_iter);
   }
 }
 
 bool SourceLineResolverBase::HasModule(const CodeModule *module) {
   if (!module)
     return false;
-  return modules_->find(module->code_file()) != modules_->end();
+  bool loaded = IsModuleLoaded(module);
+  {
+    std::lock_guard<std::mutex> lock(module_use_mutex_);
+    if (loaded)
+      ++module_cache_hits_;
+    else
+      ++module_cache_misses_;
+  }
+  if (loaded)
+    TouchModule(module->code_file());
+  return loaded;
+}
+
+bool SourceLineResolverBase::IsModuleLoaded(const CodeModule *module) {
+  return module && modules_->find(module->code_file()) != modules_->end();
 }
 
 bool SourceLineResolverBase::IsModuleCorrupt(const CodeModule *module) {
@@ -299,16 +434,30 @@ void SourceLineResolverBase::FillSourceLineInfo(StackFrame *frame) {
   if (frame->module) {
     ModuleMap::const_iterator it = modules_->find(frame->module->code_file());
     if (it != modules_->end()) {
-      it->second->LookupAddress(frame);
+      TouchModule(it->first);
+      it->second->LookupAddress(frame, false /* share_names */);
     }
   }
 }
 
+bool SourceLineResolverBase::FillSourceLineInfoSharingNames(
+    StackFrame *frame) {
+  if (frame->module) {
+    ModuleMap::const_iterator it = modules_->find(frame->module->code_file());
+    if (it != modules_->end()) {
+      TouchModule(it->first);
+      it->second->LookupAddress(frame, true /* share_names */);
+    }
+  }
+  return true;
+}
+
 WindowsFrameInfo *SourceLineResolverBase::FindWindowsFrameInfo(
     const StackFrame *frame) {
   if (frame->module) {
     ModuleMap::const_iterator it = modules_->find(frame->module->code_file());
     if (it != modules_->end()) {
+      TouchModule(it->first);
       return it->second->FindWindowsFrameInfo(frame);
     }
   }
@@ -320,17 +469,116 @@ CFIFrameInfo *SourceLineResolverBase::FindCFIFrameInfo(
   if (frame->module) {
     ModuleMap::const_iterator it = modules_->find(frame->module->code_file());
     if (it != modules_->end()) {
+      TouchModule(it->first);
       return it->second->FindCFIFrameInfo(frame);
     }
   }
   return NULL;
 }
 
+uint64_t SourceLineResolverBase::cfi_cache_hits() const {
+  uint64_t hits = unloaded_cfi_cache_hits_;
+  for (ModuleMap::const_iterator it = modules_->begin();
+       it != modules_->end(); ++it) {
+    hits += it->second->CFIFrameInfoCacheStats().hits;
+  }
+  return hits;
+}
+
+uint64_t SourceLineResolverBase::cfi_cache_misses() const {
+  uint64_t misses = unloaded_cfi_cache_misses_;
+  for (ModuleMap::const_iterator it = modules_->begin();
+       it != modules_->end(); ++it) {
+    misses += it->second->CFIFrameInfoCacheStats().misses;
+  }
+  return misses;
+}
+
+size_t SourceLineResolverBase::loaded_symbol_data() const {
+  size_t total = 0;
+  for (ModuleUsageMap::const_iterator it = module_usage_.begin();
+       it != module_usage_.end(); ++it) {
+    total += ModuleMemoryUsage(it->second);
+  }
+  return total;
+}
+
+void SourceLineResolverBase::set_symbol_data_budget(size_t max_bytes) {
+  symbol_data_budget_ = max_bytes;
+  EnforceSymbolDataBudget(string());
+}
+
+void SourceLineResolverBase::TouchModule(const string &code_file) {
+  if (symbol_data_budget_ == 0)
+    return;
+
+  ModuleUsageMap::iterator iter = module_usage_.find(code_file);
+  std::lock_guard<std::mutex> lock(module_use_mutex_);
+  if (iter != module_usage_.end() &&
+      iter->second.position != module_use_list_.begin()) {
+    module_use_list_.splice(module_use_list_.begin(), module_use_list_,
+                            iter->second.position);
+  }
+}
+
+// static
+size_t SourceLineResolverBase::ModuleMemoryUsage(const ModuleUsage &usage) {
+  return usage.module->MemoryUsage() +
+         (usage.keeps_buffer ? usage.buffer_size : 0);
+}
+
+void SourceLineResolverBase::EnforceSymbolDataBudget(const string &keep) {
+  if (symbol_data_budget_ == 0)
+    return;
+
+  // Modules may have grown since they were loaded, so their memory is
+  // totalled afresh rather than kept as a running count.
+  size_t loaded = loaded_symbol_data();
+  while (loaded > symbol_data_budget_ && !module_use_list_.empty()) {
+    // |keep| was just loaded and so is at the front; reaching it means it
+    // is the only module left.
+    const string victim = module_use_list_.back();
+    if (victim == keep)
+      break;
+    BPLOG(INFO) << "Evicting symbols for module " << victim
+                << " to stay within " << symbol_data_budget_
+                << " bytes of symbols in memory";
+    // Whoever passed in the buffer the module was loaded from, if the
+    // module kept it, must be told that it can be freed.
+    if (module_usage_[victim].keeps_buffer &&
+        memory_buffers_->find(victim) == memory_buffers_->end() &&
+        mapped_files_.find(victim) == mapped_files_.end()) {
+      unloaded_modules_.push_back(victim);
+    }
+    loaded -= ModuleMemoryUsage(module_usage_[victim]);
+    UnloadModuleByCodeFile(victim);
+    ++module_cache_evictions_;
+  }
+}
+
 bool SourceLineResolverBase::CompareString::operator()(
     const string &s1, const string &s2) const {
   return strcmp(s1.c_str(), s2.c_str()) < 0;
 }
 
+std::shared_ptr<const string> SourceLineResolverBase::Module::SharedName(
+    const char *name) const {
+  if (!*name)
+    return std::shared_ptr<const string>();
+  std::lock_guard<std::mutex> lock(shared_names_mutex_);
+  SharedNameSet::const_iterator it = shared_names_.find(name);
+  if (it != shared_names_.end())
+    return *it;
+  std::shared_ptr<const string> shared = std::make_shared<const string>(name);
+  // make_shared allocates one block for the string and the two reference
+  // counts.
+  shared_name_memory_usage_ += kMapNodeOverhead + sizeof(shared) +
+                               kHeapBlockOverhead + 2 * sizeof(long) +
+                               sizeof(string) +
+                               StringMemoryUsage(shared->size());
+  return *shared_names_.insert(shared).first;
+}
+
 bool SourceLineResolverBase::Module::ParseCFIRuleSet(
     const string &rule_set, CFIFrameInfo *frame_info) const {
   CFIFrameInfoParseHandler handler(frame_info);
@@ -39,8 +39,12 @@
 // Author: Siyang Xie (lambxsy@google.com)
 
 #include <stdio.h>
+#include <string.h>
 
 #include <map>
+#include <memory>
+#include <mutex>
+#include <set>
 #include <string>
 
 #include "google_breakpad/common/breakpad_types.h"
@@ -117,6 +121,7 @@ struct SourceLineResolverBase::PublicSymbol {
 
 class SourceLineResolverBase::Module {
  public:
+  Module() : shared_name_memory_usage_(0) { }
   virtual ~Module() { };
   // Loads a map from the given buffer in char* type.
   // Does NOT take ownership of memory_buffer (the caller, source line resolver,
@@ -132,8 +137,11 @@ class SourceLineResolverBase::Module {
   virtual bool IsCorrupt() const = 0;
 
   // Looks up the given relative address, and fills the StackFrame struct
-  // with the result.
-  virtual void LookupAddress(StackFrame *frame) const = 0;
+  // with the result.  If SHARE_NAMES is true, the names found go in the
+  // frame's interned_function_name and interned_source_file_name, as
+  // copies shared with the module (see SharedName), rather than in
+  // function_name and source_file_name.
+  virtual void LookupAddress(StackFrame *frame, bool share_names) const = 0;
 
   // If Windows stack walking information is available covering ADDRESS,
   // return a WindowsFrameInfo structure describing it. If the information
@@ -148,9 +156,72 @@ class SourceLineResolverBase::Module {
   // is not available, return NULL. The caller takes ownership of any
   // returned CFIFrameInfo object.
   virtual CFIFrameInfo *FindCFIFrameInfo(const StackFrame *frame) const = 0;
+
+  // Returns the hit and miss counts of the cache FindCFIFrameInfo keeps,
+  // if it keeps one.
+  virtual CFIFrameInfoCache::Stats CFIFrameInfoCacheStats() const {
+    return CFIFrameInfoCache::Stats();
+  }
+
+  // Returns an estimate, in bytes, of the memory the module takes, other
+  // than the symbol data it was loaded from, which the resolver counts
+  // itself if the module keeps it.  It grows as lookups add to what the
+  // module holds: functions parsed on first use, and shared names.  The
+  // CFI rule cache, which is bounded, is not counted.
+  virtual size_t MemoryUsage() const = 0;
+
  protected:
+  // Rough costs, in bytes, for MemoryUsage estimates: the heap's overhead
+  // for each block, and a std::map node's, besides its key and value.
+  static const size_t kHeapBlockOverhead = 16;
+  static const size_t kMapNodeOverhead = kHeapBlockOverhead + 32;
+
+  // Returns the heap memory a string of LENGTH characters takes beyond
+  // the string object itself; short strings are held within the object.
+  static size_t StringMemoryUsage(size_t length) {
+    return length < 16 ? 0 : kHeapBlockOverhead + length + 1;
+  }
+
   virtual bool ParseCFIRuleSet(const string &rule_set,
                                CFIFrameInfo *frame_info) const;
+
+  // Returns the module's shared copy of NAME, making it the first time
+  // NAME is asked for, or NULL if NAME is empty.  Frames that hold a copy
+  // keep it alive after the module is unloaded.  Several threads may call
+  // it at once.
+  std::shared_ptr<const string> SharedName(const char *name) const;
+
+  // The estimated memory taken by the names SharedName has made.
+  size_t SharedNameMemoryUsage() const {
+    std::lock_guard<std::mutex> lock(shared_names_mutex_);
+    return shared_name_memory_usage_;
+  }
+
+ private:
+  // Orders shared names by their contents, and finds them by C string
+  // without copying it.
+  struct CompareSharedName {
+    typedef void is_transparent;
+    bool operator()(const std::shared_ptr<const string> &a,
+                    const std::shared_ptr<const string> &b) const {
+      return *a < *b;
+    }
+    bool operator()(const std::shared_ptr<const string> &a,
+                    const char *b) const {
+      return strcmp(a->c_str(), b) < 0;
+    }
+    bool operator()(const char *a,
+                    const std::shared_ptr<const string> &b) const {
+      return strcmp(a, b->c_str()) < 0;
+    }
+  };
+  typedef std::set<std::shared_ptr<const string>, CompareSharedName>
+      SharedNameSet;
+
+  // The names SharedName has handed out, guarded by shared_names_mutex_.
+  mutable std::mutex shared_names_mutex_;
+  mutable SharedNameSet shared_names_;
+  mutable size_t shared_name_memory_usage_;
 };
 
 }  // namespace google_breakpad
@@ -36,6 +36,8 @@
 
 #include <assert.h>
 
+#include <vector>
+
 #include "common/scoped_ptr.h"
 #include "google_breakpad/processor/code_module.h"
 #include "google_breakpad/processor/code_modules.h"
@@ -51,7 +53,25 @@ namespace google_breakpad {
 StackFrameSymbolizer::StackFrameSymbolizer(
     SymbolSupplier* supplier,
     SourceLineResolverInterface* resolver) : supplier_(supplier),
-                                             resolver_(resolver) { }
+                                             resolver_(resolver),
+                                             memoized_frames_(0),
+                                             memoize_frames_(false),
+                                             keep_memo_across_dumps_(false),
+                                             intern_names_(false),
+                                             memo_hits_(0),
+                                             memo_misses_(0) { }
+
+void StackFrameSymbolizer::Reset() {
+  no_symbol_modules_.clear();
+  if (!keep_memo_across_dumps_)
+    ClearMemo();
+}
+
+void StackFrameSymbolizer::ClearMemo() {
+  memo_.clear();
+  names_.clear();
+  memoized_frames_ = 0;
+}
 
 StackFrameSymbolizer::SymbolizerResult StackFrameSymbolizer::FillSourceLineInfo(
     const CodeModules* modules,
@@ -60,14 +80,7 @@ StackFrameSymbolizer::SymbolizerResult StackFrameSymbolizer::FillSourceLineInfo(
     StackFrame* frame) {
   assert(frame);
 
-  const CodeModule* module = NULL;
-  if (modules) {
-    module = modules->GetModuleForAddress(frame->instruction);
-  }
-  if (!module && unloaded_modules) {
-    module = unloaded_modules->GetModuleForAddress(frame->instruction);
-  }
-
+  const CodeModule* module = FindModule(modules, unloaded_modules, frame);
   if (!module) return kError;
   frame->module = module;
 
@@ -78,20 +91,119 @@ StackFrameSymbolizer::SymbolizerResult StackFrameSymbolizer::FillSourceLineInfo(
     return kError;
   }
 
-  // If module is already loaded, go ahead to fill source line info and return.
-  if (resolver_->HasModule(frame->module)) {
+  // Make sure the module is loaded even when the frame is filled in from
+  // the memo below: the stack walker looks up the frame's CFI or Windows
+  // frame info next, and the resolver may have unloaded the module since
+  // the frame was memoized.
+  if (!resolver_->HasModule(frame->module)) {
+    SymbolizerResult load_result = LoadModule(module, system_info);
+    if (load_result != kNoError)
+      return load_result;
+  }
+  return FillFromLoadedModule(module, frame);
+}
+
+bool StackFrameSymbolizer::FillSourceLineInfoFromLoadedModule(
+    const CodeModules* modules,
+    const CodeModules* unloaded_modules,
+    StackFrame* frame,
+    SymbolizerResult* result) {
+  assert(frame);
+
+  if (!SupportsConcurrentLookups())
+    return false;
+  const CodeModule* module = FindModule(modules, unloaded_modules, frame);
+  if (!module)
+    return false;
+  if (no_symbol_modules_.find(module->code_file()) !=
+      no_symbol_modules_.end()) {
+    frame->module = module;
+    *result = kError;
+    return true;
+  }
+  // Only count the module as used if it is loaded: otherwise, the
+  // FillSourceLineInfo call that loads it counts it.
+  if (!resolver_->IsModuleLoaded(module) || !resolver_->HasModule(module))
+    return false;
+
+  frame->module = module;
+  *result = FillFromLoadedModule(module, frame);
+  return true;
+}
+
+bool StackFrameSymbolizer::SupportsConcurrentLookups() {
+  return resolver_ && resolver_->SupportsConcurrentLookups();
+}
+
+// static
+const CodeModule* StackFrameSymbolizer::FindModule(
+    const CodeModules* modules,
+    const CodeModules* unloaded_modules,
+    const StackFrame* frame) {
+  const CodeModule* module = NULL;
+  if (modules) {
+    module = modules->GetModuleForAddress(frame->instruction);
+  }
+  if (!module && unloaded_modules) {
+    module = unloaded_modules->GetModuleForAddress(frame->instruction);
+  }
+  return module;
+}
+
+StackFrameSymbolizer::SymbolizerResult
+StackFrameSymbolizer::FillFromLoadedModule(const CodeModule* module,
+                                           StackFrame* frame) {
+  // If this address has been symbolized before, fill in the same results.
+  // The memo is only locked around its own use, so that the resolver may
+  // fill in other frames meanwhile.
+  ModuleMemo* memo = NULL;
+  if (memoize_frames_) {
+    std::lock_guard<std::mutex> lock(memo_mutex_);
+    memo = GetModuleMemo(module);
+    std::map<uint64_t, MemoizedFrame>::const_iterator memoized =
+        memo->frames.find(frame->instruction - module->base_address());
+    if (memoized != memo->frames.end()) {
+      ++memo_hits_;
+      FillFromMemo(memoized->second, frame);
+      return memoized->second.result;
+    }
+  }
+
+  // Resolvers that can't share their own copies of names fill in copies,
+  // which are then interned here.
+  if (!intern_names_ || !resolver_->FillSourceLineInfoSharingNames(frame)) {
     resolver_->FillSourceLineInfo(frame);
-    return resolver_->IsModuleCorrupt(frame->module) ?
-        kWarningCorruptSymbols : kNoError;
+    if (intern_names_)
+      InternNames(frame);
   }
+  return Memoize(memo, frame,
+                 resolver_->IsModuleCorrupt(frame->module) ?
+                 kWarningCorruptSymbols : kNoError);
+}
 
+StackFrameSymbolizer::SymbolizerResult StackFrameSymbolizer::LoadModule(
+    const CodeModule* module,
+    const SystemInfo* system_info) {
   // Module needs to fetch symbol file. First check to see if supplier exists.
   if (!supplier_) {
     return kError;
   }
 
-  // Start fetching symbol from supplier.
+  // If the resolver keeps the buffers it loads from, and the supplier has a
+  // symbol file the resolver can load from a mapping, map it instead of
+  // having the supplier read it into a buffer.  A mapped module is unmapped
+  // by the resolver itself, so the supplier holds nothing for it.
   string symbol_file;
+  if (!resolver_->ShouldDeleteMemoryBufferAfterLoadModule() &&
+      supplier_->GetMappableSymbolFile(module, system_info, &symbol_file)) {
+    if (resolver_->LoadModuleUsingMappedFile(module, symbol_file)) {
+      FreeUnloadedSymbolData();
+      return kNoError;
+    }
+    BPLOG(INFO) << "Could not map " << symbol_file << ", reading it instead";
+  }
+
+  // Start fetching symbol from supplier.
   char* symbol_data = NULL;
   size_t symbol_data_size;
   SymbolSupplier::SymbolResult symbol_result = supplier_->GetCStringSymbolData(
@@ -100,17 +212,18 @@ StackFrameSymbolizer::SymbolizerResult StackFrameSymbolizer::FillSourceLineInfo(
   switch (symbol_result) {
     case SymbolSupplier::FOUND: {
       bool load_success = resolver_->LoadModuleUsingMemoryBuffer(
-          frame->module,
+          module,
           symbol_data,
           symbol_data_size);
       if (resolver_->ShouldDeleteMemoryBufferAfterLoadModule()) {
         supplier_->FreeSymbolData(module);
+      } else if (load_success) {
+        supplied_modules_[module->code_file()].reset(module->Copy());
       }
+      FreeUnloadedSymbolData();
 
       if (load_success) {
-        resolver_->FillSourceLineInfo(frame);
-        return resolver_->IsModuleCorrupt(frame->module) ?
-            kWarningCorruptSymbols : kNoError;
+        return kNoError;
       } else {
         BPLOG(ERROR) << "Failed to load symbol file in resolver.";
         no_symbol_modules_.insert(module->code_file());
@@ -132,6 +245,129 @@ StackFrameSymbolizer::SymbolizerResult StackFrameSymbolizer::FillSourceLineInfo(
   return kError;
 }
 
+void StackFrameSymbolizer::FreeUnloadedSymbolData() {
+  std::vector<string> unloaded;
+  resolver_->TakeUnloadedModules(&unloaded);
+  for (size_t i = 0; i < unloaded.size(); ++i) {
+    std::map<string, std::shared_ptr<const CodeModule> >::iterator it =
+        supplied_modules_.find(unloaded[i]);
+    if (it != supplied_modules_.end()) {
+      supplier_->FreeSymbolData(it->second.get());
+      supplied_modules_.erase(it);
+    }
+  }
+}
+
+void StackFrameSymbolizer::UnloadModule(const CodeModule* module) {
+  if (!resolver_ || !module)
+    return;
+  resolver_->UnloadModule(module);
+  std::map<string, std::shared_ptr<const CodeModule> >::iterator it =
+      supplied_modules_.find(module->code_file());
+  if (it != supplied_modules_.end()) {
+    // Pass the module the symbol data was supplied for, which may be
+    // another build than |module|.
+    supplier_->FreeSymbolData(it->second.get());
+    supplied_modules_.erase(it);
+  }
+}
+
+StackFrameSymbolizer::ModuleMemo* StackFrameSymbolizer::GetModuleMemo(
+    const CodeModule* module) {
+  ModuleMemo* memo = &memo_[module->code_file()];
+  const string debug_identifier = module->debug_identifier();
+  if (memo->debug_identifier != debug_identifier) {
+    memoized_frames_ -= memo->frames.size();
+    memo->frames.clear();
+    memo->debug_identifier = debug_identifier;
+  }
+  return memo;
+}
+
+StackFrameSymbolizer::SymbolizerResult StackFrameSymbolizer::Memoize(
+    ModuleMemo* memo, StackFrame* frame, SymbolizerResult result) {
+  if (!memoize_frames_)
+    return result;
+
+  std::lock_guard<std::mutex> lock(memo_mutex_);
+  if (memoized_frames_ >= kMaxMemoizedFrames) {
+    // Keep the module memos, which |memo| may be, but empty them.
+    for (std::map<string, ModuleMemo>::iterator it = memo_.begin();
+         it != memo_.end(); ++it) {
+      it->second.frames.clear();
+    }
+    names_.clear();
+    memoized_frames_ = 0;
+  }
+
+  // Concurrent lookups may both have missed the same address, so the
+  // frame may be memoized already.
+  size_t memo_size = memo->frames.size();
+  MemoizedFrame& memoized =
+      memo->frames[frame->instruction - frame->module->base_address()];
+  if (memo->frames.size() > memo_size)
+    ++memoized_frames_;
+  memoized.result = result;
+  memoized.module_base = frame->module->base_address();
+  if (intern_names_) {
+    memoized.interned_function_name = frame->interned_function_name;
+    memoized.interned_source_file_name = frame->interned_source_file_name;
+  } else {
+    memoized.function_name = frame->function_name;
+    memoized.source_file_name = frame->source_file_name;
+  }
+  memoized.function_base = frame->function_base;
+  memoized.source_line = frame->source_line;
+  memoized.source_line_base = frame->source_line_base;
+  ++memo_misses_;
+  return result;
+}
+
+void StackFrameSymbolizer::InternNames(StackFrame* frame) {
+  std::lock_guard<std::mutex> lock(memo_mutex_);
+  // Swap rather than clear, to free the frame's own copies.
+  frame->interned_function_name = Intern(frame->function_name);
+  string().swap(frame->function_name);
+  frame->interned_source_file_name = Intern(frame->source_file_name);
+  string().swap(frame->source_file_name);
+}
+
+void StackFrameSymbolizer::FillFromMemo(const MemoizedFrame& memoized,
+                                        StackFrame* frame) const {
+  if (intern_names_) {
+    frame->interned_function_name = memoized.interned_function_name;
+    frame->interned_source_file_name = memoized.interned_source_file_name;
+  } else {
+    if (!memoized.function_name.empty())
+      frame->function_name = memoized.function_name;
+    if (!memoized.source_file_name.empty())
+      frame->source_file_name = memoized.source_file_name;
+  }
+
+  // The memo may come from a dump in which the module was loaded elsewhere.
+  // Addresses the resolver didn't fill in were left zero, and stay that way.
+  uint64_t rebase = frame->module->base_address() - memoized.module_base;
+  if (memoized.function_base)
+    frame->function_base = memoized.function_base + rebase;
+  frame->source_line = memoized.source_line;
+  if (memoized.source_line_base)
+    frame->source_line_base = memoized.source_line_base + rebase;
+}
+
+std::shared_ptr<const string> StackFrameSymbolizer::Intern(
+    const string& name) {
+  if (name.empty())
+    return std::shared_ptr<const string>();
+
+  // Look |name| up through a pointer that doesn't own it, so that only new
+  // names are copied.
+  std::shared_ptr<const string> key(std::shared_ptr<const string>(), &name);
+  NamePool::const_iterator it = names_.find(key);
+  if (it != names_.end())
+    return *it;
+  return *names_.insert(std::make_shared<const string>(name)).first;
+}
+
 WindowsFrameInfo* StackFrameSymbolizer::FindWindowsFrameInfo(
     const StackFrame* frame) {
   return resolver_ ? resolver_->FindWindowsFrameInfo(frame) : NULL;
@@ -0,0 +1,432 @@
+// Copyright (c) 2026 Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// stack_frame_symbolizer_unittest.cc: Unit tests for StackFrameSymbolizer's
+// memo of symbolized addresses, and its handling of supplied symbol data.
+
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "breakpad_googletest_includes.h"
+#include "common/using_std_string.h"
+#include "google_breakpad/processor/basic_source_line_resolver.h"
+#include "google_breakpad/processor/fast_source_line_resolver.h"
+#include "google_breakpad/processor/stack_frame.h"
+#include "google_breakpad/processor/stack_frame_symbolizer.h"
+#include "google_breakpad/processor/symbol_supplier.h"
+#include "processor/cfi_frame_info.h"
+#include "processor/module_serializer.h"
+#include "processor/stackwalker_unittest_utils.h"
+
+namespace {
+
+using google_breakpad::BasicSourceLineResolver;
+using google_breakpad::CFIFrameInfo;
+using google_breakpad::CodeModule;
+using google_breakpad::FastSourceLineResolver;
+using google_breakpad::ModuleSerializer;
+using google_breakpad::StackFrame;
+using google_breakpad::StackFrameSymbolizer;
+using google_breakpad::SymbolSupplier;
+using google_breakpad::SystemInfo;
+
+// A resolver that counts the frames it is asked to fill in, and that can
+// be made to refuse to share its names.
+class CountingResolver : public BasicSourceLineResolver {
+ public:
+  CountingResolver() : fill_count(0), share_names(true) { }
+
+  void FillSourceLineInfo(StackFrame* frame) {
+    ++fill_count;
+    BasicSourceLineResolver::FillSourceLineInfo(frame);
+  }
+
+  bool FillSourceLineInfoSharingNames(StackFrame* frame) {
+    if (!share_names)
+      return false;
+    ++fill_count;
+    return BasicSourceLineResolver::FillSourceLineInfoSharingNames(frame);
+  }
+
+  int fill_count;
+  bool share_names;
+};
+
+// A module whose debug identifier differs from its code file, standing in
+// for another build of the same library.
+class OtherBuildModule : public MockCodeModule {
+ public:
+  OtherBuildModule(uint64_t base_address, uint64_t size,
+                   const string& code_file)
+      : MockCodeModule(base_address, size, code_file, "") { }
+  string debug_identifier() const { return "other build"; }
+};
+
+const char kSymbols[] =
+    "MODULE Linux x86 ABCDEF1 module1\n"
+    "FILE 1 file1.cc\n"
+    "FUNC 100 40 0 Function1\n"
+    "100 20 10 1\n"
+    "120 20 11 1\n"
+    "PUBLIC 200 0 Public1\n"
+    "STACK CFI INIT 100 40 .cfa: $esp 4 + .ra: .cfa 4 - ^\n";
+
+class StackFrameSymbolizerMemo : public ::testing::Test {
+ public:
+  StackFrameSymbolizerMemo()
+      : module1(0x10000, 0x1000, "module1", "version1"),
+        symbolizer(NULL, &resolver) {
+    modules.Add(&module1);
+    symbolizer.set_memoize_frames(true);
+  }
+
+  void SetUp() {
+    ASSERT_TRUE(resolver.LoadModuleUsingMapBuffer(&module1, kSymbols));
+  }
+
+  // Symbolizes a fresh frame at |instruction| into |frame|.
+  StackFrameSymbolizer::SymbolizerResult Symbolize(uint64_t instruction,
+                                                   StackFrame* frame) {
+    frame->instruction = instruction;
+    return symbolizer.FillSourceLineInfo(&modules, NULL, NULL, frame);
+  }
+
+  MockCodeModule module1;
+  MockCodeModules modules;
+  CountingResolver resolver;
+  StackFrameSymbolizer symbolizer;
+};
+
+TEST_F(StackFrameSymbolizerMemo, RepeatedAddress) {
+  StackFrame first, second, public_frame;
+  ASSERT_EQ(StackFrameSymbolizer::kNoError, Symbolize(0x10124, &first));
+  ASSERT_EQ(StackFrameSymbolizer::kNoError, Symbolize(0x10124, &second));
+  ASSERT_EQ(StackFrameSymbolizer::kNoError, Symbolize(0x10204, &public_frame));
+  EXPECT_EQ(2, resolver.fill_count);
+  EXPECT_EQ(1U, symbolizer.memo_hits());
+  EXPECT_EQ(2U, symbolizer.memo_misses());
+
+  EXPECT_EQ(&module1, second.module);
+  EXPECT_EQ("Function1", second.function_name);
+  EXPECT_EQ(0x10100U, second.function_base);
+  EXPECT_EQ("file1.cc", second.source_file_name);
+  EXPECT_EQ(11, second.source_line);
+  EXPECT_EQ(0x10120U, second.source_line_base);
+  EXPECT_EQ("Public1", public_frame.function_name);
+  EXPECT_EQ(0x10200U, public_frame.function_base);
+  EXPECT_EQ("", public_frame.source_file_name);
+  EXPECT_EQ(0U, public_frame.source_line_base);
+
+  // Without symbols for a module, nothing is remembered.
+  StackFrame outside;
+  ASSERT_EQ(StackFrameSymbolizer::kError, Symbolize(0x20000, &outside));
+  EXPECT_EQ(2U, symbolizer.memo_misses());
+}
+
+TEST_F(StackFrameSymbolizerMemo, Reset) {
+  StackFrame frame;
+  Symbolize(0x10124, &frame);
+  symbolizer.Reset();
+  StackFrame again;
+  Symbolize(0x10124, &again);
+  EXPECT_EQ(2, resolver.fill_count);
+  EXPECT_EQ("Function1", again.function_name);
+}
+
+TEST_F(StackFrameSymbolizerMemo, AcrossDumps) {
+  symbolizer.set_keep_memo_across_dumps(true);
+  StackFrame frame;
+  Symbolize(0x10124, &frame);
+  symbolizer.Reset();
+
+  // The same build, loaded elsewhere in the next dump.
+  MockCodeModule moved(0x50000, 0x1000, "module1", "version1");
+  MockCodeModules moved_modules;
+  moved_modules.Add(&moved);
+  StackFrame moved_frame;
+  moved_frame.instruction = 0x50124;
+  ASSERT_EQ(StackFrameSymbolizer::kNoError,
+            symbolizer.FillSourceLineInfo(&moved_modules, NULL, NULL,
+                                          &moved_frame));
+  EXPECT_EQ(1, resolver.fill_count);
+  EXPECT_EQ("Function1", moved_frame.function_name);
+  EXPECT_EQ(0x50100U, moved_frame.function_base);
+  EXPECT_EQ(11, moved_frame.source_line);
+  EXPECT_EQ(0x50120U, moved_frame.source_line_base);
+
+  // Another build of the module doesn't use the memo.
+  OtherBuildModule other(0x10000, 0x1000, "module1");
+  MockCodeModules other_modules;
+  other_modules.Add(&other);
+  StackFrame other_frame;
+  other_frame.instruction = 0x10124;
+  symbolizer.FillSourceLineInfo(&other_modules, NULL, NULL, &other_frame);
+  EXPECT_EQ(2, resolver.fill_count);
+}
+
+TEST_F(StackFrameSymbolizerMemo, Disabled) {
+  // Frames are only memoized when asked for.
+  EXPECT_FALSE(StackFrameSymbolizer(NULL, &resolver).memoize_frames());
+
+  symbolizer.set_memoize_frames(false);
+  StackFrame first, second;
+  ASSERT_EQ(StackFrameSymbolizer::kNoError, Symbolize(0x10124, &first));
+  ASSERT_EQ(StackFrameSymbolizer::kNoError, Symbolize(0x10124, &second));
+  EXPECT_EQ(2, resolver.fill_count);
+  EXPECT_EQ(0U, symbolizer.memo_hits());
+  EXPECT_EQ(0U, symbolizer.memo_misses());
+  EXPECT_EQ("Function1", second.function_name);
+  EXPECT_EQ(11, second.source_line);
+
+  // Names are still interned if asked for.
+  symbolizer.set_intern_names(true);
+  StackFrame third, fourth;
+  Symbolize(0x10124, &third);
+  Symbolize(0x10104, &fourth);
+  EXPECT_EQ(4, resolver.fill_count);
+  EXPECT_EQ("", third.function_name);
+  EXPECT_EQ("Function1", third.FunctionName());
+  EXPECT_EQ(third.interned_function_name, fourth.interned_function_name);
+}
+
+TEST_F(StackFrameSymbolizerMemo, InternNames) {
+  symbolizer.set_intern_names(true);
+  StackFrame first, second, other_line, public_frame;
+  Symbolize(0x10124, &first);
+  Symbolize(0x10124, &second);
+  Symbolize(0x10104, &other_line);
+  Symbolize(0x10204, &public_frame);
+  EXPECT_EQ(3, resolver.fill_count);
+
+  // Frames leave their own names empty, and share one copy of each.
+  EXPECT_EQ("", first.function_name);
+  EXPECT_EQ("", first.source_file_name);
+  EXPECT_EQ("Function1", first.FunctionName());
+  EXPECT_EQ("file1.cc", first.SourceFileName());
+  EXPECT_EQ(10, other_line.source_line);
+  EXPECT_EQ(first.interned_function_name, second.interned_function_name);
+  EXPECT_EQ(first.interned_function_name, other_line.interned_function_name);
+  EXPECT_EQ(first.interned_source_file_name,
+            other_line.interned_source_file_name);
+  EXPECT_EQ("Public1", public_frame.FunctionName());
+  EXPECT_EQ("", public_frame.SourceFileName());
+  EXPECT_TRUE(public_frame.interned_source_file_name == NULL);
+
+  // The names outlive the memo.
+  symbolizer.Reset();
+  EXPECT_EQ("Function1", second.FunctionName());
+}
+
+// Names from a resolver that can't share its own are interned by the
+// symbolizer.
+TEST_F(StackFrameSymbolizerMemo, InternNamesWithoutSharing) {
+  resolver.share_names = false;
+  symbolizer.set_memoize_frames(false);
+  symbolizer.set_intern_names(true);
+  StackFrame first, other_line;
+  Symbolize(0x10124, &first);
+  Symbolize(0x10104, &other_line);
+  EXPECT_EQ(2, resolver.fill_count);
+  EXPECT_EQ("", first.function_name);
+  EXPECT_EQ("Function1", first.FunctionName());
+  EXPECT_EQ("file1.cc", other_line.SourceFileName());
+  EXPECT_EQ(first.interned_function_name, other_line.interned_function_name);
+  EXPECT_EQ(first.interned_source_file_name,
+            other_line.interned_source_file_name);
+}
+
+// Several threads may fill in frames in a loaded module, and find their
+// CFI, at once.
+TEST_F(StackFrameSymbolizerMemo, ConcurrentLookups) {
+  symbolizer.set_intern_names(true);
+  ASSERT_TRUE(symbolizer.SupportsConcurrentLookups());
+  const int kThreads = 4;
+  const int kLookups = 1000;
+  std::vector<int> failures(kThreads, 0);
+  std::vector<std::thread> threads;
+  for (int i = 0; i < kThreads; ++i) {
+    threads.push_back(std::thread([this, i, &failures]() {
+      const uint64_t kInstructions[] = { 0x10104, 0x10124, 0x10204 };
+      const char* const kNames[] = { "Function1", "Function1", "Public1" };
+      for (int lookup = 0; lookup < kLookups; ++lookup) {
+        StackFrame frame;
+        frame.instruction = kInstructions[lookup % 3];
+        StackFrameSymbolizer::SymbolizerResult result;
+        if (!symbolizer.FillSourceLineInfoFromLoadedModule(&modules, NULL,
+                                                           &frame, &result) ||
+            result != StackFrameSymbolizer::kNoError ||
+            frame.FunctionName() != kNames[lookup % 3]) {
+          ++failures[i];
+        }
+        CFIFrameInfo* cfi = symbolizer.FindCFIFrameInfo(&frame);
+        if (lookup % 3 != 2 && !cfi)
+          ++failures[i];
+        delete cfi;
+      }
+    }));
+  }
+  for (int i = 0; i < kThreads; ++i) {
+    threads[i].join();
+    EXPECT_EQ(0, failures[i]);
+  }
+  EXPECT_EQ(static_cast<uint64_t>(kThreads * kLookups),
+            symbolizer.memo_hits() + symbolizer.memo_misses());
+}
+
+// Supplies kSymbols, serialized, for every module, and keeps track of the
+// buffers it hands out until they are freed.
+class SerializedSymbolSupplier : public SymbolSupplier {
+ public:
+  ~SerializedSymbolSupplier() {
+    for (std::map<string, char*>::iterator it = buffers.begin();
+         it != buffers.end(); ++it) {
+      delete [] it->second;
+    }
+  }
+
+  SymbolResult GetSymbolFile(const CodeModule* module,
+                             const SystemInfo* system_info,
+                             string* symbol_file) {
+    return NOT_FOUND;
+  }
+  SymbolResult GetSymbolFile(const CodeModule* module,
+                             const SystemInfo* system_info,
+                             string* symbol_file,
+                             string* symbol_data) {
+    return NOT_FOUND;
+  }
+  SymbolResult GetCStringSymbolData(const CodeModule* module,
+                                    const SystemInfo* system_info,
+                                    string* symbol_file,
+                                    char** symbol_data,
+                                    size_t* symbol_data_size) {
+    ModuleSerializer serializer;
+    unsigned int size;
+    *symbol_data = serializer.SerializeSymbolFileData(kSymbols, &size);
+    *symbol_data_size = size;
+    delete [] buffers[module->code_file()];
+    buffers[module->code_file()] = *symbol_data;
+    return FOUND;
+  }
+  void FreeSymbolData(const CodeModule* module) {
+    std::map<string, char*>::iterator it = buffers.find(module->code_file());
+    if (it != buffers.end()) {
+      delete [] it->second;
+      buffers.erase(it);
+    }
+  }
+
+  std::map<string, char*> buffers;
+};
+
+TEST(StackFrameSymbolizerSupplier, FreesEvictedSymbolData) {
+  MockCodeModule module1(0x10000, 0x1000, "module1", "version1");
+  MockCodeModule module2(0x20000, 0x1000, "module2", "version1");
+  MockCodeModule module3(0x30000, 0x1000, "module3", "version1");
+  MockCodeModules modules;
+  modules.Add(&module1);
+  modules.Add(&module2);
+  modules.Add(&module3);
+
+  // Leave room for one module's symbol data, but not two.
+  unsigned int symbol_data_size;
+  delete [] ModuleSerializer().SerializeSymbolFileData(kSymbols,
+                                                       &symbol_data_size);
+  SerializedSymbolSupplier supplier;
+  FastSourceLineResolver resolver;
+  resolver.set_symbol_data_budget(symbol_data_size + 1);
+  StackFrameSymbolizer symbolizer(&supplier, &resolver);
+
+  // Each module loaded evicts the one before, and the supplier's buffer for
+  // it is freed.
+  for (uint64_t base = 0x10000; base <= 0x30000; base += 0x10000) {
+    StackFrame frame;
+    frame.instruction = base + 0x124;
+    ASSERT_EQ(StackFrameSymbolizer::kNoError,
+              symbolizer.FillSourceLineInfo(&modules, NULL, NULL, &frame));
+    EXPECT_EQ("Function1", frame.function_name);
+    EXPECT_EQ(1U, supplier.buffers.size());
+    EXPECT_EQ(frame.module->code_file(), supplier.buffers.begin()->first);
+  }
+  EXPECT_EQ(2U, resolver.module_cache_evictions());
+}
+
+// Lookups that would need a module loaded are left to FillSourceLineInfo,
+// which alone counts the module cache miss.
+TEST(StackFrameSymbolizerSupplier, FillsFromLoadedModuleOnly) {
+  MockCodeModule module1(0x10000, 0x1000, "module1", "version1");
+  MockCodeModules modules;
+  modules.Add(&module1);
+  SerializedSymbolSupplier supplier;
+  FastSourceLineResolver resolver;
+  StackFrameSymbolizer symbolizer(&supplier, &resolver);
+
+  StackFrame frame;
+  frame.instruction = 0x10124;
+  StackFrameSymbolizer::SymbolizerResult result;
+  EXPECT_FALSE(symbolizer.FillSourceLineInfoFromLoadedModule(
+      &modules, NULL, &frame, &result));
+  EXPECT_EQ(0U, resolver.module_cache_misses());
+  ASSERT_EQ(StackFrameSymbolizer::kNoError,
+            symbolizer.FillSourceLineInfo(&modules, NULL, NULL, &frame));
+  EXPECT_EQ(1U, resolver.module_cache_misses());
+
+  StackFrame loaded_frame;
+  loaded_frame.instruction = 0x10124;
+  ASSERT_TRUE(symbolizer.FillSourceLineInfoFromLoadedModule(
+      &modules, NULL, &loaded_frame, &result));
+  EXPECT_EQ(StackFrameSymbolizer::kNoError, result);
+  EXPECT_EQ("Function1", loaded_frame.function_name);
+  EXPECT_EQ(1U, resolver.module_cache_misses());
+}
+
+TEST(StackFrameSymbolizerSupplier, UnloadModuleFreesSymbolData) {
+  MockCodeModule module1(0x10000, 0x1000, "module1", "version1");
+  MockCodeModules modules;
+  modules.Add(&module1);
+  SerializedSymbolSupplier supplier;
+  FastSourceLineResolver resolver;
+  StackFrameSymbolizer symbolizer(&supplier, &resolver);
+
+  StackFrame frame;
+  frame.instruction = 0x10124;
+  ASSERT_EQ(StackFrameSymbolizer::kNoError,
+            symbolizer.FillSourceLineInfo(&modules, NULL, NULL, &frame));
+  EXPECT_EQ(1U, supplier.buffers.size());
+
+  // Another build of the module replaces it.
+  OtherBuildModule other(0x10000, 0x1000, "module1");
+  symbolizer.UnloadModule(&other);
+  EXPECT_FALSE(resolver.HasModule(&module1));
+  EXPECT_EQ(0U, supplier.buffers.size());
+}
+
+}  // namespace
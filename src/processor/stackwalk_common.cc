@@ -267,10 +267,10 @@ static void PrintStack(const CallStack *stack,
 
     if (frame->module) {
       printf("%s", PathnameStripper::File(frame->module->code_file()).c_str());
-      if (!frame->function_name.empty()) {
-        printf("!%s", frame->function_name.c_str());
-        if (!frame->source_file_name.empty()) {
-          string source_file = PathnameStripper::File(frame->source_file_name);
+      if (!frame->FunctionName().empty()) {
+        printf("!%s", frame->FunctionName().c_str());
+        if (!frame->SourceFileName().empty()) {
+          string source_file = PathnameStripper::File(frame->SourceFileName());
           printf(" [%s : %d + 0x%" PRIx64 "]",
                  source_file.c_str(),
                  frame->source_line,
@@ -634,13 +634,13 @@ static void PrintStackMachineReadable(int thread_num, const CallStack *stack) {
       assert(!frame->module->code_file().empty());
       printf("%s", StripSeparator(PathnameStripper::File(
                      frame->module->code_file())).c_str());
-      if (!frame->function_name.empty()) {
+      if (!frame->FunctionName().empty()) {
         printf("%c%s", kOutputSeparator,
-               StripSeparator(frame->function_name).c_str());
-        if (!frame->source_file_name.empty()) {
+               StripSeparator(frame->FunctionName()).c_str());
+        if (!frame->SourceFileName().empty()) {
           printf("%c%s%c%d%c0x%" PRIx64,
                  kOutputSeparator,
-                 StripSeparator(frame->source_file_name).c_str(),
+                 StripSeparator(frame->SourceFileName()).c_str(),
                  kOutputSeparator,
                  frame->source_line,
                  kOutputSeparator,
@@ -37,6 +37,9 @@
 
 #include <assert.h>
 
+#include <algorithm>
+#include <limits>
+
 #include "common/scoped_ptr.h"
 #include "google_breakpad/processor/call_stack.h"
 #include "google_breakpad/processor/code_module.h"
@@ -78,7 +81,8 @@ Stackwalker::Stackwalker(const SystemInfo* system_info,
       memory_(memory),
       modules_(modules),
       unloaded_modules_(NULL),
-      frame_symbolizer_(frame_symbolizer) {
+      frame_symbolizer_(frame_symbolizer),
+      module_ranges_built_(false) {
   assert(frame_symbolizer_);
 }
 
@@ -327,7 +331,63 @@ bool Stackwalker::InstructionAddressSeemsValid(uint64_t address) const {
     return true;
   }
 
-  return !frame.function_name.empty();
+  return !frame.FunctionName().empty();
+}
+
+void Stackwalker::FindScanCandidates() {
+  const size_t count = scan_words_.size();
+  scan_candidates_.assign(count, 0);
+  if (count == 0 || !modules_)
+    return;
+
+  if (!module_ranges_built_) {
+    module_ranges_built_ = true;
+    for (unsigned int i = 0; i < modules_->module_count(); ++i) {
+      const CodeModule* module = modules_->GetModuleAtIndex(i);
+      if (module && module->size() > 0) {
+        module_ranges_.push_back(
+            std::make_pair(module->base_address(),
+                           module->base_address() + module->size() - 1));
+      }
+    }
+    std::sort(module_ranges_.begin(), module_ranges_.end());
+    size_t merged = 0;
+    for (size_t i = 0; i < module_ranges_.size(); ++i) {
+      if (merged > 0 &&
+          module_ranges_[i].first - 1 <= module_ranges_[merged - 1].second) {
+        module_ranges_[merged - 1].second =
+            std::max(module_ranges_[merged - 1].second,
+                     module_ranges_[i].second);
+      } else {
+        module_ranges_[merged++] = module_ranges_[i];
+      }
+    }
+    module_ranges_.resize(merged);
+  }
+  if (module_ranges_.empty())
+    return;
+
+  // Most stack words are data, not code addresses, and lie outside the span
+  // from the lowest module to the highest.  This first pass is a plain
+  // compare over contiguous arrays, which compilers vectorize.
+  const uint64_t low = module_ranges_.front().first;
+  const uint64_t span = module_ranges_.back().second - low;
+  const uint64_t* words = &scan_words_[0];
+  uint8_t* candidates = &scan_candidates_[0];
+  for (size_t i = 0; i < count; ++i)
+    candidates[i] = words[i] - low <= span;
+
+  // Then find the range each remaining word would fall in, if any.
+  for (size_t i = 0; i < count; ++i) {
+    if (!candidates[i])
+      continue;
+    vector<std::pair<uint64_t, uint64_t> >::const_iterator range =
+        std::upper_bound(module_ranges_.begin(), module_ranges_.end(),
+                         std::make_pair(words[i],
+                                        std::numeric_limits<uint64_t>::max()));
+    candidates[i] = range != module_ranges_.begin() &&
+                    words[i] <= (range - 1)->second;
+  }
 }
 
 }  // namespace google_breakpad
@@ -97,9 +97,7 @@ StackwalkerAMD64::StackwalkerAMD64(const SystemInfo* system_info,
                                    const CodeModules* modules,
                                    StackFrameSymbolizer* resolver_helper)
     : Stackwalker(system_info, memory, modules, resolver_helper),
-      context_(context),
-      cfi_walker_(cfi_register_map_,
-                  (sizeof(cfi_register_map_) / sizeof(cfi_register_map_[0]))) {
+      context_(context) {
 }
 
 uint64_t StackFrameAMD64::ReturnAddress() const {
@@ -130,8 +128,13 @@ StackFrameAMD64* StackwalkerAMD64::GetCallerByCFIFrameInfo(
     CFIFrameInfo* cfi_frame_info) {
   StackFrameAMD64* last_frame = static_cast<StackFrameAMD64*>(frames.back());
 
+  // One walker, and so one register table, serves every stack walk.
+  static const CFIWalker cfi_walker(
+      cfi_register_map_,
+      sizeof(cfi_register_map_) / sizeof(cfi_register_map_[0]));
+
   scoped_ptr<StackFrameAMD64> frame(new StackFrameAMD64());
-  if (!cfi_walker_
+  if (!cfi_walker
       .FindCallerRegisters(*memory_, *cfi_frame_info,
                            last_frame->context, last_frame->context_validity,
                            &frame->context, &frame->context_validity))
@@ -94,11 +94,8 @@ class StackwalkerAMD64 : public Stackwalker {
   // be returned by GetContextFrame.
   const MDRawContextAMD64* context_;
 
-  // Our register map, for cfi_walker_.
+  // Our register map, for the CFI frame walker.
   static const CFIWalker::RegisterSet cfi_register_map_[];
-
-  // Our CFI frame walker.
-  const CFIWalker cfi_walker_;
 };
 
 
@@ -302,6 +302,67 @@ TEST_F(GetCallerFrame, ScanWithoutSymbols) {
   EXPECT_EQ(frame2_sp.Value(), frame2->context.rsp);
 }
 
+TEST_F(GetCallerFrame, ScanAtModuleEdges) {
+  // Words just outside each module's address range are passed over
+  // when scanning; the last byte of a module is not.
+  stack_section.start() = 0x8000000080000000ULL;
+  uint64_t return_address = 0x00007500b000ffffULL;
+  Label frame1_sp;
+  stack_section
+    // frame 0
+    .D64(0x00007400bfffffffULL)         // just below module1
+    .D64(0x00007400c0010000ULL)         // just past module1
+    .D64(0x00007500afffffffULL)         // just below module2
+    .D64(0x00007500b0010000ULL)         // just past module2
+    .D64(return_address)                // last byte of module2
+    // frame 1
+    .Mark(&frame1_sp)
+    .Append(32, 0);                     // end of stack
+
+  RegionFromSection();
+
+  raw_context.rip = 0x00007400c0000200ULL;
+  raw_context.rbp = 0;
+  raw_context.rsp = stack_section.start().Value();
+
+  StackFrameSymbolizer frame_symbolizer(&supplier, &resolver);
+  StackwalkerAMD64 walker(&system_info, &raw_context, &stack_region, &modules,
+                          &frame_symbolizer);
+  vector<const CodeModule*> modules_without_symbols;
+  vector<const CodeModule*> modules_with_corrupt_symbols;
+  ASSERT_TRUE(walker.Walk(&call_stack, &modules_without_symbols,
+                          &modules_with_corrupt_symbols));
+  frames = call_stack.frames();
+  ASSERT_EQ(2U, frames->size());
+
+  StackFrameAMD64 *frame1 = static_cast<StackFrameAMD64 *>(frames->at(1));
+  EXPECT_EQ(StackFrame::FRAME_TRUST_SCAN, frame1->trust);
+  EXPECT_EQ(return_address, frame1->context.rip);
+  EXPECT_EQ(frame1_sp.Value(), frame1->context.rsp);
+}
+
+TEST_F(GetCallerFrame, ScanOutsideStack) {
+  // When the stack pointer lies outside the stack region, no words can be
+  // read, and the scan finds no caller.
+  stack_section.start() = 0x8000000080000000ULL;
+  stack_section.Append(32, 0);
+  RegionFromSection();
+
+  raw_context.rip = 0x00007400c0000200ULL;
+  raw_context.rbp = 0;
+  raw_context.rsp = 0x8000000090000000ULL;
+
+  StackFrameSymbolizer frame_symbolizer(&supplier, &resolver);
+  StackwalkerAMD64 walker(&system_info, &raw_context, &stack_region, &modules,
+                          &frame_symbolizer);
+  vector<const CodeModule*> modules_without_symbols;
+  vector<const CodeModule*> modules_with_corrupt_symbols;
+  ASSERT_TRUE(walker.Walk(&call_stack, &modules_without_symbols,
+                          &modules_with_corrupt_symbols));
+  frames = call_stack.frames();
+  ASSERT_EQ(1U, frames->size());
+}
+
 TEST_F(GetCallerFrame, ScanWithFunctionSymbols) {
   // During stack scanning, if a potential return address
   // is located within a loaded module that has symbols,
@@ -742,7 +803,7 @@ struct CFIFixture: public StackwalkerAMD64Fixture {
     // Provide a bunch of STACK CFI records; we'll walk to the caller
     // from every point in this series, expecting to find the same set
     // of register values.
-    SetModuleSymbols(&module1,
+    module1_symbols =
                      // The youngest frame's function.
                      "FUNC 4000 1000 10 enchiridion\n"
                      // Initially, just a return address.
@@ -761,7 +822,8 @@ struct CFIFixture: public StackwalkerAMD64Fixture {
                      // The calling function.
                      "FUNC 5000 1000 10 epictetus\n"
                      // Mark it as end of stack.
-                     "STACK CFI INIT 5000 1000 .cfa: $rsp .ra 0\n");
+                     "STACK CFI INIT 5000 1000 .cfa: $rsp .ra 0\n";
+    SetModuleSymbols(&module1, module1_symbols);
 
     // Provide some distinctive values for the caller's registers.
     expected.rsp = 0x8000000080000000ULL;
@@ -787,8 +849,14 @@ struct CFIFixture: public StackwalkerAMD64Fixture {
     raw_context.rsp = stack_section.start().Value();
 
     StackFrameSymbolizer frame_symbolizer(&supplier, &resolver);
+    CheckWalk(&frame_symbolizer);
+  }
+
+  // As above, with stack_region and raw_context.rsp already set up, and
+  // symbolizing frames with FRAME_SYMBOLIZER.
+  void CheckWalk(StackFrameSymbolizer *frame_symbolizer) {
     StackwalkerAMD64 walker(&system_info, &raw_context, &stack_region, &modules,
-                            &frame_symbolizer);
+                            frame_symbolizer);
     vector<const CodeModule*> modules_without_symbols;
     vector<const CodeModule*> modules_with_corrupt_symbols;
     ASSERT_TRUE(walker.Walk(&call_stack, &modules_without_symbols,
@@ -828,6 +896,9 @@ struct CFIFixture: public StackwalkerAMD64Fixture {
 
   // The values we expect to find for the caller's registers.
   MDRawContextAMD64 expected;
+
+  // The symbols supplied for module1.
+  string module1_symbols;
 };
 
 class CFI: public CFIFixture, public Test { };
@@ -931,3 +1002,39 @@ TEST_F(CFI, At4006) {
   raw_context.r13 = 0x00007400c0005510ULL; // return address
   CheckWalk();
 }
+
+// A frame filled in from the symbolizer's memo must still have its module
+// loaded, so that its CFI can be found, even after the resolver has
+// unloaded the module to make room for another.
+TEST_F(CFI, MemoizedFrameAfterEviction) {
+  Label frame1_rsp = expected.rsp;
+  stack_section
+    .D64(0x00007400c0005510ULL) // return address
+    .Mark(&frame1_rsp);         // This effectively sets stack_section.start().
+  raw_context.rip = 0x00007400c0004000ULL;
+  RegionFromSection();
+  raw_context.rsp = stack_section.start().Value();
+  SetModuleSymbols(&module2, "FUNC 100 10 0 hypatia\n");
+
+  // Keep only the most recently loaded module.
+  resolver.set_symbol_data_budget(1);
+  StackFrameSymbolizer frame_symbolizer(&supplier, &resolver);
+  frame_symbolizer.set_memoize_frames(true);
+  CheckWalk(&frame_symbolizer);
+  EXPECT_EQ(0U, frame_symbolizer.memo_hits());
+
+  StackFrame other;
+  other.instruction = 0x00007500b0000104ULL;
+  ASSERT_EQ(StackFrameSymbolizer::kNoError,
+            frame_symbolizer.FillSourceLineInfo(&modules, NULL, &system_info,
+                                                &other));
+  EXPECT_EQ("hypatia", other.function_name);
+  EXPECT_EQ(1U, resolver.module_cache_evictions());
+
+  // Both frames come from the memo, and module1 is loaded again for its CFI.
+  // The resolver parsed the first buffer in place, so supply a fresh one.
+  SetModuleSymbols(&module1, module1_symbols);
+  CheckWalk(&frame_symbolizer);
+  EXPECT_EQ(2U, frame_symbolizer.memo_hits());
+  EXPECT_EQ(2U, resolver.module_cache_evictions());
+}
@@ -88,15 +88,18 @@ StackFrameARM64* StackwalkerARM64::GetCallerByCFIFrameInfo(
     "pc",  NULL
   };
 
+  static const RegisterTable register_table =
+      CFIFrameInfo::MakeRegisterTable(register_names);
+
   // Populate a dictionary with the valid register values in last_frame.
-  CFIFrameInfo::RegisterValueMap<uint64_t> callee_registers;
+  RegisterDictionary<uint64_t> callee_registers(&register_table);
   for (int i = 0; register_names[i]; i++) {
     if (last_frame->context_validity & StackFrameARM64::RegisterValidFlag(i))
-      callee_registers[register_names[i]] = last_frame->context.iregs[i];
+      callee_registers.Set(i, last_frame->context.iregs[i]);
   }
 
   // Use the STACK CFI data to recover the caller's register values.
-  CFIFrameInfo::RegisterValueMap<uint64_t> caller_registers;
+  RegisterDictionary<uint64_t> caller_registers(&register_table);
   if (!cfi_frame_info->FindCallerRegs(callee_registers, *memory_,
                                       &caller_registers)) {
     return NULL;
@@ -104,13 +107,10 @@ StackFrameARM64* StackwalkerARM64::GetCallerByCFIFrameInfo(
   // Construct a new stack frame given the values the CFI recovered.
   scoped_ptr<StackFrameARM64> frame(new StackFrameARM64());
   for (int i = 0; register_names[i]; i++) {
-    CFIFrameInfo::RegisterValueMap<uint64_t>::iterator entry =
-      caller_registers.find(register_names[i]);
-    if (entry != caller_registers.end()) {
+    if (caller_registers.Get(i, &frame->context.iregs[i])) {
       // We recovered the value of this register; fill the context with the
       // value from caller_registers.
       frame->context_validity |= StackFrameARM64::RegisterValidFlag(i);
-      frame->context.iregs[i] = entry->second;
     } else if (19 <= i && i <= 29 && (last_frame->context_validity &
                                       StackFrameARM64::RegisterValidFlag(i))) {
       // If the STACK CFI data doesn't mention some callee-saves register, and
@@ -124,21 +124,15 @@ StackFrameARM64* StackwalkerARM64::GetCallerByCFIFrameInfo(
   }
   // If the CFI doesn't recover the PC explicitly, then use .ra.
   if (!(frame->context_validity & StackFrameARM64::CONTEXT_VALID_PC)) {
-    CFIFrameInfo::RegisterValueMap<uint64_t>::iterator entry =
-      caller_registers.find(".ra");
-    if (entry != caller_registers.end()) {
+    if (caller_registers.Get(".ra",
+                             &frame->context.iregs[MD_CONTEXT_ARM64_REG_PC]))
       frame->context_validity |= StackFrameARM64::CONTEXT_VALID_PC;
-      frame->context.iregs[MD_CONTEXT_ARM64_REG_PC] = entry->second;
-    }
   }
   // If the CFI doesn't recover the SP explicitly, then use .cfa.
   if (!(frame->context_validity & StackFrameARM64::CONTEXT_VALID_SP)) {
-    CFIFrameInfo::RegisterValueMap<uint64_t>::iterator entry =
-      caller_registers.find(".cfa");
-    if (entry != caller_registers.end()) {
+    if (caller_registers.Get(".cfa",
+                             &frame->context.iregs[MD_CONTEXT_ARM64_REG_SP]))
       frame->context_validity |= StackFrameARM64::CONTEXT_VALID_SP;
-      frame->context.iregs[MD_CONTEXT_ARM64_REG_SP] = entry->second;
-    }
   }
 
   // If we didn't recover the PC and the SP, then the frame isn't very useful.
@@ -107,49 +107,41 @@ StackFrameMIPS* StackwalkerMIPS::GetCallerByCFIFrameInfo(
     const vector<StackFrame*>& frames,
     CFIFrameInfo* cfi_frame_info) {
   StackFrameMIPS* last_frame = static_cast<StackFrameMIPS*>(frames.back());
+  static const RegisterTable register_table =
+      CFIFrameInfo::MakeRegisterTable(kRegisterNames);
 
   if (context_->context_flags & MD_CONTEXT_MIPS) {
     uint32_t pc = 0;
 
     // Populate a dictionary with the valid register values in last_frame.
-    CFIFrameInfo::RegisterValueMap<uint32_t> callee_registers;
+    RegisterDictionary<uint32_t> callee_registers(&register_table);
     // Use the STACK CFI data to recover the caller's register values.
-    CFIFrameInfo::RegisterValueMap<uint32_t> caller_registers;
+    RegisterDictionary<uint32_t> caller_registers(&register_table);
 
-    for (int i = 0; kRegisterNames[i]; ++i) {
-      caller_registers[kRegisterNames[i]] = last_frame->context.iregs[i];
-      callee_registers[kRegisterNames[i]] = last_frame->context.iregs[i];
-    }
+    for (int i = 0; kRegisterNames[i]; ++i)
+      callee_registers.Set(i, last_frame->context.iregs[i]);
 
     if (!cfi_frame_info->FindCallerRegs(callee_registers, *memory_,
         &caller_registers))  {
       return NULL;
     }
 
-    CFIFrameInfo::RegisterValueMap<uint32_t>::const_iterator entry =
-        caller_registers.find(".cfa");
+    uint32_t value;
+    if (caller_registers.Get(".cfa", &value))
+      caller_registers.Set("$sp", value);
 
-    if (entry != caller_registers.end()) {
-      caller_registers["$sp"] = entry->second;
+    if (caller_registers.Get(".ra", &value)) {
+      caller_registers.Set("$ra", value);
+      pc = value - 2 * sizeof(pc);
     }
-
-    entry = caller_registers.find(".ra");
-    if (entry != caller_registers.end()) {
-      caller_registers["$ra"] = entry->second;
-      pc = entry->second - 2 * sizeof(pc);
-    }
-    caller_registers["$pc"] = pc;
     // Construct a new stack frame given the values the CFI recovered.
     scoped_ptr<StackFrameMIPS> frame(new StackFrameMIPS());
 
     for (int i = 0; kRegisterNames[i]; ++i) {
-      CFIFrameInfo::RegisterValueMap<uint32_t>::const_iterator caller_entry =
-          caller_registers.find(kRegisterNames[i]);
-
-      if (caller_entry != caller_registers.end()) {
+      if (caller_registers.Get(i, &value)) {
         // The value of this register is recovered; fill the context with the
         // value from caller_registers.
-        frame->context.iregs[i] = caller_entry->second;
+        frame->context.iregs[i] = value;
         frame->context_validity |= StackFrameMIPS::RegisterValidFlag(i);
       } else if (((i >= INDEX_MIPS_REG_S0 && i <= INDEX_MIPS_REG_S7) ||
           (i > INDEX_MIPS_REG_GP && i < INDEX_MIPS_REG_RA)) &&
@@ -165,11 +157,13 @@ StackFrameMIPS* StackwalkerMIPS::GetCallerByCFIFrameInfo(
       }
     }
 
-    frame->context.epc = caller_registers["$pc"];
-    frame->instruction = caller_registers["$pc"];
+    frame->context.epc = pc;
+    frame->instruction = pc;
     frame->context_validity |= StackFrameMIPS::CONTEXT_VALID_PC;
 
-    frame->context.iregs[MD_CONTEXT_MIPS_REG_RA] = caller_registers["$ra"];
+    value = 0;
+    caller_registers.Get("$ra", &value);
+    frame->context.iregs[MD_CONTEXT_MIPS_REG_RA] = value;
     frame->context_validity |= StackFrameMIPS::CONTEXT_VALID_RA;
 
     frame->trust = StackFrame::FRAME_TRUST_CFI;
@@ -179,44 +173,34 @@ StackFrameMIPS* StackwalkerMIPS::GetCallerByCFIFrameInfo(
     uint64_t pc = 0;
 
     // Populate a dictionary with the valid register values in last_frame.
-    CFIFrameInfo::RegisterValueMap<uint64_t> callee_registers;
+    RegisterDictionary<uint64_t> callee_registers(&register_table);
     // Use the STACK CFI data to recover the caller's register values.
-    CFIFrameInfo::RegisterValueMap<uint64_t> caller_registers;
+    RegisterDictionary<uint64_t> caller_registers(&register_table);
 
-    for (int i = 0; kRegisterNames[i]; ++i) {
-      caller_registers[kRegisterNames[i]] = last_frame->context.iregs[i];
-      callee_registers[kRegisterNames[i]] = last_frame->context.iregs[i];
-    }
+    for (int i = 0; kRegisterNames[i]; ++i)
+      callee_registers.Set(i, last_frame->context.iregs[i]);
 
     if (!cfi_frame_info->FindCallerRegs(callee_registers, *memory_,
         &caller_registers))  {
       return NULL;
     }
 
-    CFIFrameInfo::RegisterValueMap<uint64_t>::const_iterator entry =
-        caller_registers.find(".cfa");
+    uint64_t value;
+    if (caller_registers.Get(".cfa", &value))
+      caller_registers.Set("$sp", value);
 
-    if (entry != caller_registers.end()) {
-      caller_registers["$sp"] = entry->second;
+    if (caller_registers.Get(".ra", &value)) {
+      caller_registers.Set("$ra", value);
+      pc = value - 2 * sizeof(pc);
     }
-
-    entry = caller_registers.find(".ra");
-    if (entry != caller_registers.end()) {
-      caller_registers["$ra"] = entry->second;
-      pc = entry->second - 2 * sizeof(pc);
-    }
-    caller_registers["$pc"] = pc;
     // Construct a new stack frame given the values the CFI recovered.
     scoped_ptr<StackFrameMIPS> frame(new StackFrameMIPS());
 
     for (int i = 0; kRegisterNames[i]; ++i) {
-      CFIFrameInfo::RegisterValueMap<uint64_t>::const_iterator caller_entry =
-          caller_registers.find(kRegisterNames[i]);
-
-      if (caller_entry != caller_registers.end()) {
+      if (caller_registers.Get(i, &value)) {
         // The value of this register is recovered; fill the context with the
         // value from caller_registers.
-        frame->context.iregs[i] = caller_entry->second;
+        frame->context.iregs[i] = value;
         frame->context_validity |= StackFrameMIPS::RegisterValidFlag(i);
       } else if (((i >= INDEX_MIPS_REG_S0 && i <= INDEX_MIPS_REG_S7) ||
           (i >= INDEX_MIPS_REG_GP && i < INDEX_MIPS_REG_RA)) &&
@@ -232,11 +216,13 @@ StackFrameMIPS* StackwalkerMIPS::GetCallerByCFIFrameInfo(
       }
     }
 
-    frame->context.epc = caller_registers["$pc"];
-    frame->instruction = caller_registers["$pc"];
+    frame->context.epc = pc;
+    frame->instruction = pc;
     frame->context_validity |= StackFrameMIPS::CONTEXT_VALID_PC;
 
-    frame->context.iregs[MD_CONTEXT_MIPS_REG_RA] = caller_registers["$ra"];
+    value = 0;
+    caller_registers.Get("$ra", &value);
+    frame->context.iregs[MD_CONTEXT_MIPS_REG_RA] = value;
     frame->context_validity |= StackFrameMIPS::CONTEXT_VALID_RA;
 
     frame->trust = StackFrame::FRAME_TRUST_CFI;
@@ -116,7 +116,7 @@ class MockCodeModule: public google_breakpad::CodeModule {
   string debug_identifier() const { return code_file_; }
   string version()          const { return version_; }
   google_breakpad::CodeModule *Copy() const {
-    abort(); // Tests won't use this.
+    return new MockCodeModule(base_address_, size_, code_file_, version_);
   }
   virtual bool is_unloaded() const { return false; }
   virtual uint64_t shrink_down_delta() const { return 0; }
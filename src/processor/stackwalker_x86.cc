@@ -90,9 +90,7 @@ StackwalkerX86::StackwalkerX86(const SystemInfo* system_info,
                                const CodeModules* modules,
                                StackFrameSymbolizer* resolver_helper)
     : Stackwalker(system_info, memory, modules, resolver_helper),
-      context_(context),
-      cfi_walker_(cfi_register_map_,
-                  (sizeof(cfi_register_map_) / sizeof(cfi_register_map_[0]))) {
+      context_(context) {
   if (memory_ && memory_->GetBase() + memory_->GetSize() - 1 > 0xffffffff) {
     // The x86 is a 32-bit CPU, the limits of the supplied stack are invalid.
     // Mark memory_ = NULL, which will cause stackwalking to fail.
@@ -519,8 +517,13 @@ StackFrameX86* StackwalkerX86::GetCallerByCFIFrameInfo(
   StackFrameX86* last_frame = static_cast<StackFrameX86*>(frames.back());
   last_frame->cfi_frame_info = cfi_frame_info;
 
+  // One walker, and so one register table, serves every stack walk.
+  static const CFIWalker cfi_walker(
+      cfi_register_map_,
+      sizeof(cfi_register_map_) / sizeof(cfi_register_map_[0]));
+
   scoped_ptr<StackFrameX86> frame(new StackFrameX86());
-  if (!cfi_walker_
+  if (!cfi_walker
       .FindCallerRegisters(*memory_, *cfi_frame_info,
                            last_frame->context, last_frame->context_validity,
                            &frame->context, &frame->context_validity))
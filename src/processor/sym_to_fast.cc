@@ -0,0 +1,190 @@
+// Copyright (c) 2026 Google Inc.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google Inc. nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// sym_to_fast.cc: Convert text symbol files to the serialized format loaded
+// by FastSourceLineResolver.
+//
+// Each symbol file named on the command line, and each .sym file found
+// under each directory named on the command line, is parsed and written
+// next to itself with a .fast extension, which is where FastSymbolSupplier
+// looks for it.
+
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <string>
+
+#include "common/path_helper.h"
+#include "common/using_std_string.h"
+#include "processor/fast_symbol_supplier.h"
+#include "processor/logging.h"
+
+namespace {
+
+using google_breakpad::FastSymbolSupplier;
+
+struct Options {
+  bool skip_existing;
+};
+
+struct Counts {
+  int converted;
+  int skipped;
+  int failed;
+};
+
+bool IsSymbolFile(const string& path) {
+  const size_t extension_length =
+      strlen(FastSymbolSupplier::kSymbolFileExtension);
+  return path.size() > extension_length &&
+         path.compare(path.size() - extension_length, extension_length,
+                      FastSymbolSupplier::kSymbolFileExtension) == 0;
+}
+
+void ConvertFile(const Options& options, const string& path, Counts* counts) {
+  if (options.skip_existing) {
+    struct stat symbol_stat, serialized_stat;
+    string serialized_path = FastSymbolSupplier::SerializedSymbolFilePath(path);
+    if (stat(path.c_str(), &symbol_stat) == 0 &&
+        stat(serialized_path.c_str(), &serialized_stat) == 0 &&
+        serialized_stat.st_mtime >= symbol_stat.st_mtime) {
+      ++counts->skipped;
+      return;
+    }
+  }
+
+  if (FastSymbolSupplier::ConvertSymbolFile(path)) {
+    ++counts->converted;
+  } else {
+    fprintf(stderr, "Could not convert %s\n", path.c_str());
+    ++counts->failed;
+  }
+}
+
+// Converts every symbol file under |path|, or |path| itself if it is not a
+// directory.
+void ConvertPath(const Options& options, const string& path, Counts* counts) {
+  struct stat path_stat;
+  if (stat(path.c_str(), &path_stat) != 0) {
+    fprintf(stderr, "Could not stat %s\n", path.c_str());
+    ++counts->failed;
+    return;
+  }
+
+  if (!S_ISDIR(path_stat.st_mode)) {
+    ConvertFile(options, path, counts);
+    return;
+  }
+
+  DIR* dir = opendir(path.c_str());
+  if (!dir) {
+    fprintf(stderr, "Could not open directory %s\n", path.c_str());
+    ++counts->failed;
+    return;
+  }
+
+  struct dirent* entry;
+  while ((entry = readdir(dir)) != NULL) {
+    if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0)
+      continue;
+
+    string entry_path = path + "/" + entry->d_name;
+    struct stat entry_stat;
+    if (stat(entry_path.c_str(), &entry_stat) != 0)
+      continue;
+    if (S_ISDIR(entry_stat.st_mode)) {
+      ConvertPath(options, entry_path, counts);
+    } else if (IsSymbolFile(entry_path)) {
+      ConvertFile(options, entry_path, counts);
+    }
+  }
+  closedir(dir);
+}
+
+}  // namespace
+
+static void Usage(int argc, const char *argv[], bool error) {
+  fprintf(error ? stderr : stdout,
+          "Usage: %s [options] <symbol-file-or-directory> [...]\n"
+          "\n"
+          "Write the serialized form of each symbol file, and of each .sym\n"
+          "file under each directory, next to it with a .fast extension\n"
+          "\n"
+          "Options:\n"
+          "\n"
+          "  -u         Skip symbol files whose serialized form is up to date\n",
+          google_breakpad::BaseName(argv[0]).c_str());
+}
+
+static void SetupOptions(int argc, const char *argv[], Options* options) {
+  int ch;
+
+  options->skip_existing = false;
+
+  while ((ch = getopt(argc, (char * const *)argv, "hu")) != -1) {
+    switch (ch) {
+      case 'h':
+        Usage(argc, argv, false);
+        exit(0);
+        break;
+
+      case 'u':
+        options->skip_existing = true;
+        break;
+
+      case '?':
+        Usage(argc, argv, true);
+        exit(1);
+        break;
+    }
+  }
+
+  if ((argc - optind) == 0) {
+    fprintf(stderr, "%s: Missing symbol file or directory\n", argv[0]);
+    Usage(argc, argv, true);
+    exit(1);
+  }
+}
+
+int main(int argc, const char* argv[]) {
+  Options options;
+  SetupOptions(argc, argv, &options);
+
+  Counts counts = { 0, 0, 0 };
+  for (int argi = optind; argi < argc; ++argi)
+    ConvertPath(options, argv[argi], &counts);
+
+  printf("%d converted, %d up to date, %d failed\n",
+         counts.converted, counts.skipped, counts.failed);
+  return counts.failed == 0 ? 0 : 1;
+}
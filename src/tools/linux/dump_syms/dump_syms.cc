@@ -29,6 +29,7 @@
 
 #include <paths.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <unistd.h>
 
 #include <cstring>
@@ -49,6 +50,11 @@ int usage(const char* self) {
   fprintf(stderr, "  -c    Do not generate CFI section\n");
   fprintf(stderr, "  -r    Do not handle inter-compilation unit references\n");
   fprintf(stderr, "  -v    Print all warnings to stderr\n");
+  fprintf(stderr, "  -j <threads>\n"
+                  "        Read debugging information on this many threads\n");
+  fprintf(stderr, "  -t <directory>\n"
+                  "        Keep functions read so far in temporary files in\n"
+                  "        this directory, to bound memory use\n");
   return 1;
 }
 
@@ -59,6 +65,8 @@ int main(int argc, char **argv) {
   bool cfi = true;
   bool handle_inter_cu_refs = true;
   bool log_to_stderr = false;
+  unsigned int num_threads = 1;
+  string temp_directory;
   int arg_index = 1;
   while (arg_index < argc && strlen(argv[arg_index]) > 0 &&
          argv[arg_index][0] == '-') {
@@ -70,6 +78,18 @@ int main(int argc, char **argv) {
       handle_inter_cu_refs = false;
     } else if (strcmp("-v", argv[arg_index]) == 0) {
       log_to_stderr = true;
+    } else if (strcmp("-j", argv[arg_index]) == 0) {
+      if (arg_index + 1 >= argc)
+        return usage(argv[0]);
+      char* end;
+      long threads = strtol(argv[++arg_index], &end, 10);
+      if (*end != '\0' || threads < 1)
+        return usage(argv[0]);
+      num_threads = static_cast<unsigned int>(threads);
+    } else if (strcmp("-t", argv[arg_index]) == 0) {
+      if (arg_index + 1 >= argc)
+        return usage(argv[0]);
+      temp_directory = argv[++arg_index];
     } else {
       printf("2.4 %s\n", argv[arg_index]);
       return usage(argv[0]);
@@ -103,6 +123,8 @@ int main(int argc, char **argv) {
   } else {
     SymbolData symbol_data = cfi ? ALL_SYMBOL_DATA : NO_CFI;
     google_breakpad::DumpOptions options(symbol_data, handle_inter_cu_refs);
+    options.num_threads = num_threads;
+    options.temp_directory = temp_directory;
     if (!WriteSymbolFile(binary, debug_dirs, options, std::cout)) {
       fprintf(saved_stderr, "Failed to write symbol file.\n");
       return 1;